@@ -0,0 +1,642 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Bins por eixo na busca da divisão SAH.
+static const uint32_t binsSAH = 16;
+// Folhas com mais objetos que isso só quando não há como dividir (centros todos iguais).
+static const uint32_t maxObjetosFolha = 8;
+// Custo de visitar um nó em relação ao de testar um objeto.
+static const float custoTravessia = 1.0f;
+// Profundidade maxima da pilha das buscas (cada nó empilha no maximo 4 filhos).
+static const int tamanhoPilha = 256;
+
+struct Caixa {
+    float minimo[3];
+    float maximo[3];
+};
+
+static Caixa caixaVazia()
+{
+    Caixa caixa;
+    for (int eixo = 0; eixo < 3; eixo++) {
+        caixa.minimo[eixo] = INFINITY;
+        caixa.maximo[eixo] = -INFINITY;
+    }
+    return caixa;
+}
+
+static void expande(Caixa& caixa, const Caixa& outra)
+{
+    for (int eixo = 0; eixo < 3; eixo++) {
+        caixa.minimo[eixo] = std::min(caixa.minimo[eixo], outra.minimo[eixo]);
+        caixa.maximo[eixo] = std::max(caixa.maximo[eixo], outra.maximo[eixo]);
+    }
+}
+
+static void expande(Caixa& caixa, const float* ponto)
+{
+    for (int eixo = 0; eixo < 3; eixo++) {
+        caixa.minimo[eixo] = std::min(caixa.minimo[eixo], ponto[eixo]);
+        caixa.maximo[eixo] = std::max(caixa.maximo[eixo], ponto[eixo]);
+    }
+}
+
+static float areaSuperficie(const Caixa& caixa)
+{
+    float dx = caixa.maximo[0] - caixa.minimo[0];
+    float dy = caixa.maximo[1] - caixa.minimo[1];
+    float dz = caixa.maximo[2] - caixa.minimo[2];
+    if (dx < 0.0f) {
+        return 0.0f;
+    }
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static Caixa caixaObjeto(const VolumesEnvolventes& volumes, uint32_t i)
+{
+    Caixa caixa;
+    caixa.minimo[0] = volumes.centroX[i] - volumes.extensaoX[i];
+    caixa.minimo[1] = volumes.centroY[i] - volumes.extensaoY[i];
+    caixa.minimo[2] = volumes.centroZ[i] - volumes.extensaoZ[i];
+    caixa.maximo[0] = volumes.centroX[i] + volumes.extensaoX[i];
+    caixa.maximo[1] = volumes.centroY[i] + volumes.extensaoY[i];
+    caixa.maximo[2] = volumes.centroZ[i] + volumes.extensaoZ[i];
+    return caixa;
+}
+
+static Caixa caixaFilho(const NoBVH4& no, int k)
+{
+    Caixa caixa;
+    caixa.minimo[0] = no.minX[k];
+    caixa.minimo[1] = no.minY[k];
+    caixa.minimo[2] = no.minZ[k];
+    caixa.maximo[0] = no.maxX[k];
+    caixa.maximo[1] = no.maxY[k];
+    caixa.maximo[2] = no.maxZ[k];
+    return caixa;
+}
+
+static void defineCaixaFilho(NoBVH4& no, int k, const Caixa& caixa)
+{
+    no.minX[k] = caixa.minimo[0];
+    no.minY[k] = caixa.minimo[1];
+    no.minZ[k] = caixa.minimo[2];
+    no.maxX[k] = caixa.maximo[0];
+    no.maxY[k] = caixa.maximo[1];
+    no.maxZ[k] = caixa.maximo[2];
+}
+
+// Bits dos filhos ocupados.
+static int filhosValidos(const NoBVH4& no)
+{
+    return (no.quantidade[0] ? 1 : 0) | (no.quantidade[1] ? 2 : 0) | (no.quantidade[2] ? 4 : 0) | (no.quantidade[3] ? 8 : 0);
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Construção
+
+// Nó da arvore binaria intermediaria. Nós internos também guardam o intervalo de objetos da subarvore.
+struct NoBinario {
+    Caixa caixa;
+    int32_t filhos[2];     // -1 nas folhas.
+    uint32_t primeiro;
+    uint32_t quantidade;
+    int32_t subarvore;     // >= 0: marcador; a subarvore foi construida à parte por uma tarefa.
+};
+
+struct DadosConstrucao {
+    std::vector<Caixa> caixas;     // Por objeto.
+    std::vector<float> centros;    // 3 por objeto.
+    uint32_t* objetos;
+};
+
+struct TarefaSubarvore {
+    uint32_t primeiro;
+    uint32_t quantidade;
+};
+
+// Constroi a subarvore dos objetos [primeiro, primeiro + quantidade) e retorna o indice da raiz dela.
+// Com "tarefas", intervalos com até "limiarTarefa" objetos viram marcadores para construir em paralelo.
+static int32_t constroiNo(DadosConstrucao& dados, std::vector<NoBinario>& nos, uint32_t primeiro, uint32_t quantidade,
+                          uint32_t limiarTarefa, std::vector<TarefaSubarvore>* tarefas)
+{
+    uint32_t* objetos = dados.objetos + primeiro;
+    Caixa caixa = caixaVazia();
+    Caixa centros = caixaVazia();
+    for (uint32_t i = 0; i < quantidade; i++) {
+        expande(caixa, dados.caixas[objetos[i]]);
+        expande(centros, &dados.centros[objetos[i] * 3]);
+    }
+
+    int32_t indice = (int32_t)nos.size();
+    NoBinario no;
+    no.caixa = caixa;
+    no.filhos[0] = no.filhos[1] = -1;
+    no.primeiro = primeiro;
+    no.quantidade = quantidade;
+    no.subarvore = -1;
+
+    if (tarefas && quantidade <= limiarTarefa) {
+        no.subarvore = (int32_t)tarefas->size();
+        tarefas->push_back(TarefaSubarvore{ primeiro, quantidade });
+        nos.push_back(no);
+        return indice;
+    }
+    nos.push_back(no);
+    if (quantidade == 1) {
+        return indice;
+    }
+
+    // Para cada eixo, os centros vão para "binsSAH" intervalos iguais; a divisão entre os bins b - 1 e b
+    // custa area(esquerda) * objetos(esquerda) + area(direita) * objetos(direita).
+    int melhorEixo = -1;
+    uint32_t melhorDivisao = 0;
+    float melhorCusto = INFINITY;
+    for (int eixo = 0; eixo < 3; eixo++) {
+        float extensao = centros.maximo[eixo] - centros.minimo[eixo];
+        if (extensao <= 0.0f) {
+            continue;
+        }
+        float escala = (float)binsSAH / extensao;
+
+        Caixa caixasBin[binsSAH];
+        uint32_t contagem[binsSAH] = {};
+        for (uint32_t b = 0; b < binsSAH; b++) {
+            caixasBin[b] = caixaVazia();
+        }
+        for (uint32_t i = 0; i < quantidade; i++) {
+            uint32_t o = objetos[i];
+            uint32_t b = std::min(binsSAH - 1, (uint32_t)((dados.centros[o * 3 + eixo] - centros.minimo[eixo]) * escala));
+            expande(caixasBin[b], dados.caixas[o]);
+            contagem[b]++;
+        }
+
+        float areaDireita[binsSAH];
+        uint32_t contagemDireita[binsSAH];
+        Caixa acumulada = caixaVazia();
+        uint32_t n = 0;
+        for (uint32_t b = binsSAH - 1; b > 0; b--) {
+            expande(acumulada, caixasBin[b]);
+            n += contagem[b];
+            areaDireita[b] = areaSuperficie(acumulada);
+            contagemDireita[b] = n;
+        }
+        acumulada = caixaVazia();
+        n = 0;
+        for (uint32_t b = 1; b < binsSAH; b++) {
+            expande(acumulada, caixasBin[b - 1]);
+            n += contagem[b - 1];
+            if (n == 0 || contagemDireita[b] == 0) {
+                continue;
+            }
+            float custo = areaSuperficie(acumulada) * n + areaDireita[b] * contagemDireita[b];
+            if (custo < melhorCusto) {
+                melhorCusto = custo;
+                melhorEixo = eixo;
+                melhorDivisao = b;
+            }
+        }
+    }
+
+    uint32_t numEsquerda;
+    if (melhorEixo >= 0) {
+        // Folha quando testar todos os objetos sai mais barato que descer mais um nivel.
+        float custoDivisao = custoTravessia + melhorCusto / areaSuperficie(caixa);
+        if (quantidade <= maxObjetosFolha && (float)quantidade <= custoDivisao) {
+            return indice;
+        }
+
+        float escala = (float)binsSAH / (centros.maximo[melhorEixo] - centros.minimo[melhorEixo]);
+        float minimo = centros.minimo[melhorEixo];
+        const float* c = dados.centros.data();
+        uint32_t* meio = std::partition(objetos, objetos + quantidade, [&](uint32_t o) {
+            return std::min(binsSAH - 1, (uint32_t)((c[o * 3 + melhorEixo] - minimo) * escala)) < melhorDivisao;
+        });
+        numEsquerda = (uint32_t)(meio - objetos);
+    }
+    else {
+        // Todos os centros no mesmo ponto: divide ao meio só se a folha ficaria grande demais.
+        if (quantidade <= maxObjetosFolha) {
+            return indice;
+        }
+        numEsquerda = quantidade / 2;
+    }
+
+    int32_t esquerdo = constroiNo(dados, nos, primeiro, numEsquerda, limiarTarefa, tarefas);
+    int32_t direito = constroiNo(dados, nos, primeiro + numEsquerda, quantidade - numEsquerda, limiarTarefa, tarefas);
+    nos[indice].filhos[0] = esquerdo;
+    nos[indice].filhos[1] = direito;
+    return indice;
+}
+
+// Referencia a um nó binario: a arvore de cima ou a de uma das tarefas.
+struct RefNo {
+    const std::vector<NoBinario>* arvore;
+    int32_t indice;
+};
+
+static RefNo resolve(RefNo ref, const std::vector<std::vector<NoBinario>>& subarvores)
+{
+    const NoBinario& no = (*ref.arvore)[ref.indice];
+    if (no.subarvore >= 0) {
+        return RefNo{ &subarvores[no.subarvore], 0 };
+    }
+    return ref;
+}
+
+static const NoBinario& noBinario(RefNo ref)
+{
+    return (*ref.arvore)[ref.indice];
+}
+
+// Achata a subarvore binaria em nós de 4 filhos: o filho interno de maior area é trocado pelos dois
+// filhos dele até o nó ter 4 filhos ou só folhas. Os nós saem em pre-ordem (filhos depois do pai).
+static uint32_t colapsa(BVH& bvh, RefNo raiz, const std::vector<std::vector<NoBinario>>& subarvores)
+{
+    const NoBinario& r = noBinario(raiz);
+    RefNo candidatos[4];
+    int numCandidatos = 0;
+    if (r.filhos[0] < 0) {
+        candidatos[numCandidatos++] = raiz;
+    }
+    else {
+        candidatos[numCandidatos++] = resolve(RefNo{ raiz.arvore, r.filhos[0] }, subarvores);
+        candidatos[numCandidatos++] = resolve(RefNo{ raiz.arvore, r.filhos[1] }, subarvores);
+    }
+    while (numCandidatos < 4) {
+        int maior = -1;
+        float maiorArea = -1.0f;
+        for (int k = 0; k < numCandidatos; k++) {
+            const NoBinario& c = noBinario(candidatos[k]);
+            if (c.filhos[0] >= 0 && areaSuperficie(c.caixa) > maiorArea) {
+                maiorArea = areaSuperficie(c.caixa);
+                maior = k;
+            }
+        }
+        if (maior < 0) {
+            break;
+        }
+        RefNo aberto = candidatos[maior];
+        const NoBinario& a = noBinario(aberto);
+        candidatos[maior] = resolve(RefNo{ aberto.arvore, a.filhos[0] }, subarvores);
+        candidatos[numCandidatos++] = resolve(RefNo{ aberto.arvore, a.filhos[1] }, subarvores);
+    }
+
+    uint32_t indice = (uint32_t)bvh.nos.size();
+    NoBVH4 vazio;
+    for (int k = 0; k < 4; k++) {
+        defineCaixaFilho(vazio, k, caixaVazia());
+        vazio.filho[k] = -1;
+        vazio.quantidade[k] = 0;
+    }
+    bvh.nos.push_back(vazio);
+    bvh.inicioNo.push_back(r.primeiro);
+
+    for (int k = 0; k < numCandidatos; k++) {
+        const NoBinario& c = noBinario(candidatos[k]);
+        int32_t filho = c.filhos[0] < 0 ? ~(int32_t)c.primeiro : (int32_t)colapsa(bvh, candidatos[k], subarvores);
+        // Só depois da recursão: o push_back dos filhos pode ter realocado "nos".
+        NoBVH4& no = bvh.nos[indice];
+        defineCaixaFilho(no, k, c.caixa);
+        no.filho[k] = filho;
+        no.quantidade[k] = c.quantidade;
+    }
+    return indice;
+}
+
+void constroiBVH(BVH& bvh, const VolumesEnvolventes& volumes, PoolThreads* pool)
+{
+    uint32_t numObjetos = (uint32_t)volumes.quantidade;
+    bvh.nos.clear();
+    bvh.inicioNo.clear();
+    bvh.objetos.resize(numObjetos);
+    if (numObjetos == 0) {
+        return;
+    }
+
+    DadosConstrucao dados;
+    dados.caixas.resize(numObjetos);
+    dados.centros.resize((size_t)numObjetos * 3);
+    dados.objetos = bvh.objetos.data();
+    for (uint32_t i = 0; i < numObjetos; i++) {
+        dados.caixas[i] = caixaObjeto(volumes, i);
+        dados.centros[i * 3] = volumes.centroX[i];
+        dados.centros[i * 3 + 1] = volumes.centroY[i];
+        dados.centros[i * 3 + 2] = volumes.centroZ[i];
+        bvh.objetos[i] = i;
+    }
+
+    // Os niveis de cima são construidos aqui; abaixo de "limiar" objetos cada subarvore vira uma tarefa
+    // (uns 8 por thread, para o roubo de trabalho equilibrar subarvores de tamanhos diferentes).
+    // Os intervalos das tarefas são disjuntos, então cada uma particiona a sua parte de "objetos".
+    std::vector<NoBinario> topo;
+    std::vector<TarefaSubarvore> tarefas;
+    bool paralelo = pool && pool->numThreads() > 1;
+    uint32_t limiar = paralelo ? std::max(numObjetos / (pool->numThreads() * 8), 1024u) : 0;
+    constroiNo(dados, topo, 0, numObjetos, limiar, paralelo ? &tarefas : nullptr);
+
+    std::vector<std::vector<NoBinario>> subarvores(tarefas.size());
+    if (!tarefas.empty()) {
+        pool->paraCada((unsigned int)tarefas.size(), [&](unsigned int t, unsigned int) {
+            constroiNo(dados, subarvores[t], tarefas[t].primeiro, tarefas[t].quantidade, 0, nullptr);
+        });
+    }
+
+    bvh.nos.reserve(numObjetos / 2 + 1);
+    bvh.inicioNo.reserve(numObjetos / 2 + 1);
+    colapsa(bvh, resolve(RefNo{ &topo, 0 }, subarvores), subarvores);
+}
+
+// Caixa que envolve os 4 filhos de um nó. As posições vazias guardam a caixa vazia (+inf, -inf), que
+// não muda o minimo nem o maximo.
+static Caixa caixaNo(const NoBVH4& no)
+{
+    Caixa caixa;
+    caixa.minimo[0] = std::min(std::min(no.minX[0], no.minX[1]), std::min(no.minX[2], no.minX[3]));
+    caixa.minimo[1] = std::min(std::min(no.minY[0], no.minY[1]), std::min(no.minY[2], no.minY[3]));
+    caixa.minimo[2] = std::min(std::min(no.minZ[0], no.minZ[1]), std::min(no.minZ[2], no.minZ[3]));
+    caixa.maximo[0] = std::max(std::max(no.maxX[0], no.maxX[1]), std::max(no.maxX[2], no.maxX[3]));
+    caixa.maximo[1] = std::max(std::max(no.maxY[0], no.maxY[1]), std::max(no.maxY[2], no.maxY[3]));
+    caixa.maximo[2] = std::max(std::max(no.maxZ[0], no.maxZ[1]), std::max(no.maxZ[2], no.maxZ[3]));
+    return caixa;
+}
+
+void reajustaBVH(BVH& bvh, const VolumesEnvolventes& volumes)
+{
+    const float* cx = volumes.centroX.data();
+    const float* cy = volumes.centroY.data();
+    const float* cz = volumes.centroZ.data();
+    const float* ex = volumes.extensaoX.data();
+    const float* ey = volumes.extensaoY.data();
+    const float* ez = volumes.extensaoZ.data();
+    const uint32_t* objetos = bvh.objetos.data();
+
+    // De trás para frente: os filhos de um nó já estão prontos quando ele é recalculado.
+    for (size_t n = bvh.nos.size(); n-- > 0;) {
+        NoBVH4& no = bvh.nos[n];
+        for (int k = 0; k < 4; k++) {
+            if (no.quantidade[k] == 0) {
+                continue;
+            }
+            Caixa caixa;
+            if (no.filho[k] < 0) {
+                caixa = caixaVazia();
+                uint32_t primeiro = ~no.filho[k];
+                for (uint32_t i = primeiro; i < primeiro + no.quantidade[k]; i++) {
+                    uint32_t o = objetos[i];
+                    caixa.minimo[0] = std::min(caixa.minimo[0], cx[o] - ex[o]);
+                    caixa.minimo[1] = std::min(caixa.minimo[1], cy[o] - ey[o]);
+                    caixa.minimo[2] = std::min(caixa.minimo[2], cz[o] - ez[o]);
+                    caixa.maximo[0] = std::max(caixa.maximo[0], cx[o] + ex[o]);
+                    caixa.maximo[1] = std::max(caixa.maximo[1], cy[o] + ey[o]);
+                    caixa.maximo[2] = std::max(caixa.maximo[2], cz[o] + ez[o]);
+                }
+            }
+            else {
+                caixa = caixaNo(bvh.nos[no.filho[k]]);
+            }
+            defineCaixaFilho(no, k, caixa);
+        }
+    }
+}
+
+float custoSAH(const BVH& bvh)
+{
+    if (bvh.nos.empty()) {
+        return 0.0f;
+    }
+
+    Caixa raiz = caixaNo(bvh.nos[0]);
+
+    // A chance de um raio que atinge a raiz atingir uma caixa é a razão entre as areas.
+    double custo = custoTravessia;
+    for (const NoBVH4& no : bvh.nos) {
+        for (int k = 0; k < 4; k++) {
+            if (no.quantidade[k] == 0) {
+                continue;
+            }
+            float area = areaSuperficie(caixaFilho(no, k));
+            custo += area * (no.filho[k] < 0 ? (float)no.quantidade[k] : custoTravessia);
+        }
+    }
+    return (float)(custo / std::max(areaSuperficie(raiz), 1e-20f));
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Descarte pelo frustum
+
+// Mesmo teste (e mesma ordem das operações) do descartaFrustum com volumeCaixa.
+static bool caixaVisivel(const Frustum& frustum, const VolumesEnvolventes& volumes, uint32_t i)
+{
+    for (const Vec4& p : frustum.planos) {
+        float distancia = p.x * volumes.centroX[i] + p.y * volumes.centroY[i] + p.z * volumes.centroZ[i] + p.w;
+        float alcance = std::fabs(p.x) * volumes.extensaoX[i] + std::fabs(p.y) * volumes.extensaoY[i] + std::fabs(p.z) * volumes.extensaoZ[i];
+        if (distancia + alcance < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Testa as 4 caixas do nó: "fora" recebe os bits das que estão inteiramente fora de algum plano e
+// "dentro" os das que estão inteiramente dentro de todos.
+static void testaFrustumNo(const NoBVH4& no, const Frustum& frustum, int& fora, int& dentro)
+{
+#if SIMD_X86
+    const __m128 meio = _mm_set1_ps(0.5f);
+    const __m128 semSinal = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 minX = _mm_load_ps(no.minX), minY = _mm_load_ps(no.minY), minZ = _mm_load_ps(no.minZ);
+    __m128 maxX = _mm_load_ps(no.maxX), maxY = _mm_load_ps(no.maxY), maxZ = _mm_load_ps(no.maxZ);
+    __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), meio), ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), meio);
+    __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), meio), ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), meio);
+    __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), meio), ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), meio);
+
+    __m128 maskFora = _mm_setzero_ps();
+    __m128 maskDentro = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const Vec4& p : frustum.planos) {
+        __m128 a = _mm_set1_ps(p.x), b = _mm_set1_ps(p.y), c = _mm_set1_ps(p.z);
+        __m128 distancia = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, cx), _mm_mul_ps(b, cy)), _mm_mul_ps(c, cz)), _mm_set1_ps(p.w));
+        __m128 alcance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(a, semSinal), ex), _mm_mul_ps(_mm_and_ps(b, semSinal), ey)),
+                                    _mm_mul_ps(_mm_and_ps(c, semSinal), ez));
+        maskFora = _mm_or_ps(maskFora, _mm_cmplt_ps(_mm_add_ps(distancia, alcance), _mm_setzero_ps()));
+        maskDentro = _mm_and_ps(maskDentro, _mm_cmpge_ps(_mm_sub_ps(distancia, alcance), _mm_setzero_ps()));
+    }
+    fora = _mm_movemask_ps(maskFora);
+    dentro = _mm_movemask_ps(maskDentro);
+#else
+    fora = 0;
+    dentro = 0xF;
+    for (int k = 0; k < 4; k++) {
+        float cx = (no.minX[k] + no.maxX[k]) * 0.5f, ex = (no.maxX[k] - no.minX[k]) * 0.5f;
+        float cy = (no.minY[k] + no.maxY[k]) * 0.5f, ey = (no.maxY[k] - no.minY[k]) * 0.5f;
+        float cz = (no.minZ[k] + no.maxZ[k]) * 0.5f, ez = (no.maxZ[k] - no.minZ[k]) * 0.5f;
+        for (const Vec4& p : frustum.planos) {
+            float distancia = p.x * cx + p.y * cy + p.z * cz + p.w;
+            float alcance = std::fabs(p.x) * ex + std::fabs(p.y) * ey + std::fabs(p.z) * ez;
+            if (distancia + alcance < 0.0f) fora |= 1 << k;
+            if (distancia - alcance < 0.0f) dentro &= ~(1 << k);
+        }
+    }
+#endif
+}
+
+size_t descartaFrustumBVH(const BVH& bvh, const VolumesEnvolventes& volumes, const Frustum& frustum, uint32_t* visiveis)
+{
+    if (bvh.nos.empty()) {
+        return 0;
+    }
+
+    size_t numVisiveis = 0;
+    uint32_t pilha[tamanhoPilha];
+    int topo = 0;
+    pilha[topo++] = 0;
+    while (topo > 0) {
+        const NoBVH4& no = bvh.nos[pilha[--topo]];
+        int fora, dentro;
+        testaFrustumNo(no, frustum, fora, dentro);
+        int restantes = filhosValidos(no) & ~fora;
+
+        while (restantes) {
+            int k = primeiroBitLigado((uint64_t)restantes);
+            restantes &= restantes - 1;
+            int32_t filho = no.filho[k];
+
+            if (dentro & (1 << k)) {
+                // Subarvore inteira dentro: os objetos dela são contiguos em "objetos".
+                uint32_t primeiro = filho < 0 ? (uint32_t)~filho : bvh.inicioNo[filho];
+                std::copy(bvh.objetos.begin() + primeiro, bvh.objetos.begin() + primeiro + no.quantidade[k], visiveis + numVisiveis);
+                numVisiveis += no.quantidade[k];
+            }
+            else if (filho < 0) {
+                uint32_t primeiro = ~filho;
+                for (uint32_t i = primeiro; i < primeiro + no.quantidade[k]; i++) {
+                    uint32_t objeto = bvh.objetos[i];
+                    if (caixaVisivel(frustum, volumes, objeto)) {
+                        visiveis[numVisiveis++] = objeto;
+                    }
+                }
+            }
+            else if (topo < tamanhoPilha) {
+                pilha[topo++] = (uint32_t)filho;
+            }
+        }
+    }
+    return numVisiveis;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Raios
+
+Raio raioDoCursor(double cursorX, double cursorY, int largura, int altura, const Mat4& projecaoVisao)
+{
+    // Pixel para coordenadas normalizadas (y do cursor cresce para baixo).
+    float x = (float)(2.0 * (cursorX + 0.5) / largura - 1.0);
+    float y = (float)(1.0 - 2.0 * (cursorY + 0.5) / altura);
+
+    Mat4 inversaPV = inversa(projecaoVisao);
+    Vec4 perto = inversaPV * Vec4(x, y, -1.0f, 1.0f);
+    Vec4 longe = inversaPV * Vec4(x, y, 1.0f, 1.0f);
+    Vec3 origem = vec3(perto * (1.0f / perto.w));
+    Vec3 fim = vec3(longe * (1.0f / longe.w));
+
+    Raio raio;
+    raio.origem = origem;
+    raio.direcao = normaliza(fim - origem);
+    return raio;
+}
+
+// Teste das placas (slabs): o raio está dentro da caixa entre o maior t de entrada e o menor t de saida.
+static bool intersectaCaixa(const Caixa& caixa, const float* origem, const float* inverso, float tMaximo, float& tEntrada)
+{
+    float t0 = 0.0f, t1 = tMaximo;
+    for (int eixo = 0; eixo < 3; eixo++) {
+        float a = (caixa.minimo[eixo] - origem[eixo]) * inverso[eixo];
+        float b = (caixa.maximo[eixo] - origem[eixo]) * inverso[eixo];
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+    }
+    tEntrada = t0;
+    return t0 <= t1;
+}
+
+int32_t intersectaRaioBVH(const BVH& bvh, const VolumesEnvolventes& volumes, const Raio& raio, float* distancia)
+{
+    if (bvh.nos.empty()) {
+        return -1;
+    }
+
+    const float origem[3] = { raio.origem.x, raio.origem.y, raio.origem.z };
+    const float inverso[3] = { 1.0f / raio.direcao.x, 1.0f / raio.direcao.y, 1.0f / raio.direcao.z };
+    int32_t melhor = -1;
+    float tMelhor = INFINITY;
+
+    // Pilha com o t de entrada de cada nó: nós que começam depois do melhor objeto são pulados.
+    struct Pendente {
+        uint32_t no;
+        float t;
+    };
+    Pendente pilha[tamanhoPilha];
+    int topo = 0;
+    pilha[topo++] = Pendente{ 0, 0.0f };
+    while (topo > 0) {
+        Pendente atual = pilha[--topo];
+        if (atual.t > tMelhor) {
+            continue;
+        }
+        const NoBVH4& no = bvh.nos[atual.no];
+
+        // Filhos atingidos, ordenados pelo t de entrada.
+        int atingidos[4];
+        float tAtingidos[4];
+        int numAtingidos = 0;
+        for (int k = 0; k < 4; k++) {
+            float t;
+            if (no.quantidade[k] == 0 || !intersectaCaixa(caixaFilho(no, k), origem, inverso, tMelhor, t)) {
+                continue;
+            }
+            int j = numAtingidos++;
+            while (j > 0 && tAtingidos[j - 1] > t) {
+                atingidos[j] = atingidos[j - 1];
+                tAtingidos[j] = tAtingidos[j - 1];
+                j--;
+            }
+            atingidos[j] = k;
+            tAtingidos[j] = t;
+        }
+
+        // Folhas do mais proximo ao mais distante (cada acerto encurta o raio para as seguintes) e depois
+        // os nós internos, os mais distantes empilhados primeiro para o mais proximo sair antes.
+        for (int j = 0; j < numAtingidos; j++) {
+            int k = atingidos[j];
+            if (no.filho[k] >= 0 || tAtingidos[j] > tMelhor) {
+                continue;
+            }
+            uint32_t primeiro = ~no.filho[k];
+            for (uint32_t i = primeiro; i < primeiro + no.quantidade[k]; i++) {
+                float t;
+                uint32_t objeto = bvh.objetos[i];
+                if (intersectaCaixa(caixaObjeto(volumes, objeto), origem, inverso, tMelhor, t) && t < tMelhor) {
+                    tMelhor = t;
+                    melhor = (int32_t)objeto;
+                }
+            }
+        }
+        for (int j = numAtingidos - 1; j >= 0; j--) {
+            int k = atingidos[j];
+            if (no.filho[k] >= 0 && tAtingidos[j] <= tMelhor && topo < tamanhoPilha) {
+                pilha[topo++] = Pendente{ (uint32_t)no.filho[k], tAtingidos[j] };
+            }
+        }
+    }
+
+    if (distancia) {
+        *distancia = tMelhor;
+    }
+    return melhor;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Hierarquia de volumes envolventes (BVH) sobre as caixas de VolumesEnvolventes, para descarte pelo
+// frustum e seleção por raio em cenas grandes, onde testar todos os objetos (DescarteFrustum) já não escala.
+// A construção usa a heuristica de area de superficie (SAH) com os centros agrupados em bins; as
+// subarvores de baixo são construidas em paralelo. A arvore binaria é depois achatada em nós de 4 filhos,
+// com as 4 caixas em SoA dentro do nó para serem testadas juntas com SSE.
+// Quando os objetos se movem, reajustaBVH recalcula só as caixas (a estrutura continua a mesma).
+
+#include "DescarteFrustum.h"
+#include "Matematica.h"
+#include "PoolThreads.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 128 bytes: 96 de caixas e 32 de filhos (alinhado em 16 para carregar cada linha num registro SSE).
+struct alignas(16) NoBVH4 {
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    int32_t filho[4];          // >= 0: indice do nó filho. < 0: folha com os objetos [~filho, ~filho + quantidade).
+    uint32_t quantidade[4];    // Objetos na subarvore do filho (0 = posição vazia).
+};
+
+struct BVH {
+    std::vector<NoBVH4> nos;           // nos[0] é a raiz; os filhos sempre têm indice maior que o pai.
+    std::vector<uint32_t> inicioNo;    // Primeira posição em "objetos" da subarvore de cada nó.
+    std::vector<uint32_t> objetos;     // Indices dos objetos na ordem das folhas (cada subarvore é contigua).
+};
+
+// Constroi sobre as caixas dos objetos (volumeCaixa). Com "pool", as subarvores são divididas entre as threads.
+void constroiBVH(BVH& bvh, const VolumesEnvolventes& volumes, PoolThreads* pool = nullptr);
+
+// Recalcula as caixas de todos os nós depois que os volumes mudaram, sem mudar a arvore.
+void reajustaBVH(BVH& bvh, const VolumesEnvolventes& volumes);
+
+// Custo SAH da arvore (objetos testados + nós visitados por um raio aleatorio, relativo à raiz).
+// Cresce quando os objetos se movem muito depois da construção; serve para decidir quando reconstruir.
+float custoSAH(const BVH& bvh);
+
+// Mesmo resultado do descartaFrustum com volumeCaixa, mas sem ordem definida. Subarvores inteiramente
+// dentro do frustum entram sem testar os objetos.
+size_t descartaFrustumBVH(const BVH& bvh, const VolumesEnvolventes& volumes, const Frustum& frustum, uint32_t* visiveis);
+
+struct Raio {
+    Vec3 origem;
+    Vec3 direcao;
+};
+
+// Raio que sai do plano perto pela posição do cursor (em pixels, origem no canto superior esquerdo,
+// como o glfwGetCursorPos) numa janela de "largura" x "altura".
+Raio raioDoCursor(double cursorX, double cursorY, int largura, int altura, const Mat4& projecaoVisao);
+
+// Objeto cuja caixa o raio atinge primeiro, ou -1. "distancia" recebe o t do ponto atingido (em unidades
+// de "direcao").
+int32_t intersectaRaioBVH(const BVH& bvh, const VolumesEnvolventes& volumes, const Raio& raio, float* distancia = nullptr);
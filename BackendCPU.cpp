@@ -0,0 +1,181 @@
+#include "BackendCPU.h"
+
+#include <iostream>
+
+void BackendCPU::defineViewport(int largura, int altura)
+{
+    executaAdiados();
+    if (largura != quadro.largura || altura != quadro.altura) {
+        redimensionaFramebuffer(quadro, largura, altura);
+    }
+    if (multiAmostragem && (largura != quadroMSAA.largura || altura != quadroMSAA.altura)) {
+        redimensionaFramebufferMSAA(quadroMSAA, largura, altura);
+    }
+}
+
+void BackendCPU::limpa(float r, float g, float b, float a)
+{
+    executaAdiados();
+    if (multiAmostragem) {
+        limpaFramebufferMSAA(quadroMSAA, r, g, b, a);
+    }
+    else {
+        limpaFramebuffer(quadro, r, g, b, a);
+    }
+}
+
+void BackendCPU::defineMultiAmostragem(bool habilitada)
+{
+    executaAdiados();
+    multiAmostragem = habilitada;
+    if (habilitada) {
+        redimensionaFramebufferMSAA(quadroMSAA, quadro.largura, quadro.altura);
+    }
+}
+
+void BackendCPU::defineTesteProfundidade(bool habilitado)
+{
+    estado.testeProfundidade = habilitado;
+}
+
+void BackendCPU::definePrepassProfundidade(bool habilitado)
+{
+    if (!habilitado) {
+        executaAdiados();
+    }
+    prepass = habilitado;
+}
+
+unsigned int BackendCPU::criaMalha(const DescricaoMalha& descricao)
+{
+    MalhaCPU malha;
+    malha.stride = descricao.stride;
+    malha.numVertices = descricao.numVertices;
+    malha.numAtributos = descricao.numAtributos;
+    for (unsigned int i = 0; i < descricao.numAtributos; i++) {
+        malha.atributos[i] = descricao.atributos[i];
+    }
+    malha.vertices.assign(descricao.vertices, descricao.vertices + (size_t)descricao.numVertices * descricao.stride);
+    if (descricao.indices) {
+        malha.indices.assign(descricao.indices, descricao.indices + descricao.numIndices);
+    }
+
+    malhas.push_back(malha);
+    return (unsigned int)malhas.size() - 1;
+}
+
+unsigned int BackendCPU::criaPrograma(const DescricaoPrograma& descricao)
+{
+    ProgramaCPU programa;
+    programa.vertex = descricao.vertexCPU;
+    programa.vertexLote = descricao.vertexLoteCPU;
+    programa.fragment = descricao.fragmentCPU;
+    programa.fragmentLote = descricao.fragmentLoteCPU;
+    programa.numVaryings = descricao.numVaryings;
+
+    // Sem os shaders em C++ o GLSL é interpretado.
+    std::unique_ptr<ProgramaGLSLCPU> glsl;
+    if (programa.vertex == nullptr && programa.vertexLote == nullptr && descricao.fonteVertex && descricao.fonteFragment) {
+        std::string erro;
+        glsl.reset(new ProgramaGLSLCPU());
+        if (compilaProgramaGLSL(*glsl, descricao.fonteVertex, descricao.fonteFragment, erro)) {
+            configuraProgramaCPU(*glsl, programa);
+        }
+        else {
+            std::cout << "ERRO::SHADER::INTERPRETADOR_GLSL\n" << erro << std::endl;
+            glsl.reset();
+        }
+    }
+
+    programas.push_back(programa);
+    programasGLSL.push_back(std::move(glsl));
+    return (unsigned int)programas.size() - 1;
+}
+
+void BackendCPU::executaDesenho(unsigned int programa, unsigned int malha, const EstadoRasterizacao& estadoDesenho)
+{
+    const MalhaCPU& m = malhas[malha];
+
+    // O formato dos vertices é da malha (VAO); o programa GLSL lê os atributos pela location.
+    if (programasGLSL[programa]) {
+        for (unsigned int i = 0; i < m.numAtributos; i++) {
+            defineAtributoGLSL(*programasGLSL[programa], m.atributos[i].location, m.atributos[i].componentes, m.atributos[i].deslocamento);
+        }
+    }
+
+    const unsigned int* indices = m.indices.empty() ? nullptr : m.indices.data();
+    if (multiAmostragem) {
+        desenhaTriangulosTilesMSAA(quadroMSAA, programas[programa], estadoDesenho, m.vertices.data(), m.stride, m.numVertices,
+                                   indices, (unsigned int)m.indices.size(), pool, bins, &contadores);
+    }
+    else {
+        desenhaTriangulosTiles(quadro, programas[programa], estadoDesenho, m.vertices.data(), m.stride, m.numVertices,
+                               indices, (unsigned int)m.indices.size(), pool, bins, &contadores);
+    }
+}
+
+void BackendCPU::desenha(unsigned int programa, unsigned int malha)
+{
+    const ProgramaCPU& p = programas[programa];
+
+    // Programa sem shaders em C++ e com GLSL que o interpretador não aceitou.
+    if ((p.vertex == nullptr && p.vertexLote == nullptr) || (p.fragment == nullptr && p.fragmentLote == nullptr)) {
+        return;
+    }
+
+    if (prepass && estado.testeProfundidade && estado.escreveProfundidade) {
+        adiados.push_back({ programa, malha, estado });
+        return;
+    }
+
+    // Os adiados foram chamados antes: desenha-los depois mudaria o resultado (transparencias, por exemplo).
+    executaAdiados();
+    executaDesenho(programa, malha, estado);
+}
+
+void BackendCPU::finalizaQuadro()
+{
+    // Sem pre-pass os desenhos na CPU são sincronos: só falta o resolve da multiamostragem.
+    executaAdiados();
+    if (multiAmostragem) {
+        resolveMSAA(quadroMSAA, quadro);
+    }
+    quadroCapturado = captura;
+}
+
+bool BackendCPU::lePixels(std::vector<uint32_t>& destino, int& largura, int& altura, bool /*espera*/)
+{
+    // O quadro já está na memoria: "espera" não muda nada.
+    if (!quadroCapturado) {
+        return false;
+    }
+    destino.assign(quadro.cor.begin(), quadro.cor.end());
+    largura = quadro.largura;
+    altura = quadro.altura;
+    quadroCapturado = false;
+    return true;
+}
+
+void BackendCPU::executaAdiados()
+{
+    if (adiados.empty()) {
+        return;
+    }
+
+    // 1. Só profundidade: o vertex shader roda, o fragment shader não.
+    for (const DesenhoAdiado& d : adiados) {
+        EstadoRasterizacao profundidade = d.estado;
+        profundidade.escreveCor = false;
+        executaDesenho(d.programa, d.malha, profundidade);
+    }
+
+    // 2. Cor só onde a profundidade é igual à mais proxima; o resto é descartado pela hierarquia.
+    for (const DesenhoAdiado& d : adiados) {
+        EstadoRasterizacao cor = d.estado;
+        cor.escreveProfundidade = false;
+        cor.profundidadeMenorIgual = true;
+        executaDesenho(d.programa, d.malha, cor);
+    }
+
+    adiados.clear();
+}
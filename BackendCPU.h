@@ -0,0 +1,86 @@
+#pragma once
+
+// Backend em software: desenha no FramebufferCPU, sem GPU e sem janela.
+// Os desenhos são divididos em tiles e rasterizados por todas as threads do pool.
+// Programas sem os shaders em C++ têm o codigo GLSL compilado para o InterpretadorGLSL.
+
+#include "BackendRenderizacao.h"
+#include "InterpretadorGLSL.h"
+#include "RasterizadorTiles.h"
+#include "RasterizadorMSAA.h"
+
+#include <memory>
+#include <vector>
+
+class BackendCPU : public BackendRenderizacao {
+public:
+    // "numThreads" = 0 usa todos os nucleos.
+    explicit BackendCPU(unsigned int numThreads = 0) : pool(numThreads) {}
+
+    const char* nome() const override { return "CPU"; }
+    void defineViewport(int largura, int altura) override;
+    void limpa(float r, float g, float b, float a) override;
+    void defineTesteProfundidade(bool habilitado) override;
+    unsigned int criaMalha(const DescricaoMalha& malha) override;
+    unsigned int criaPrograma(const DescricaoPrograma& programa) override;
+    void desenha(unsigned int programa, unsigned int malha) override;
+    void finalizaQuadro() override;
+    void defineCaptura(bool habilitada) override { captura = habilitada; }
+    bool lePixels(std::vector<uint32_t>& destino, int& largura, int& altura, bool espera) override;
+
+    // Opções só da CPU.
+    // Profundidade hierarquica: descarta tiles e blocos escondidos antes do teste por pixel.
+    void defineHierarquiaZ(bool habilitada) { estado.hierarquiaZ = habilitada; }
+    // Pre-pass de profundidade: os desenhos com teste de profundidade ficam guardados até o finalizaQuadro,
+    // que desenha primeiro só a profundidade e depois a cor com GL_LEQUAL (cada pixel é sombreado uma vez).
+    void definePrepassProfundidade(bool habilitado);
+    // MSAA 4x: os desenhos vão para o FramebufferMSAA e o finalizaQuadro faz o resolve no framebuffer().
+    void defineMultiAmostragem(bool habilitada);
+
+    // Framebuffer com as amostras (só com multiamostragem).
+    const FramebufferMSAA& framebufferMSAA() const { return quadroMSAA; }
+
+    // Imagem resultante (linha 0 embaixo, RGBA8). Acesso direto, sem a copia do lePixels: só é valida
+    // até o proximo desenho.
+    const FramebufferCPU& framebuffer() const { return quadro; }
+
+    const EstatisticasRasterizacao& estatisticas() const { return contadores; }
+
+private:
+    // Copia dos dados, como o glBufferData faz com o VBO.
+    struct MalhaCPU {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        unsigned int stride;
+        unsigned int numVertices;
+        AtributoMalha atributos[maxAtributosMalha];     // Usados só pelos programas GLSL.
+        unsigned int numAtributos;
+    };
+
+    // Desenho guardado para o pre-pass, com o estado do momento da chamada.
+    struct DesenhoAdiado {
+        unsigned int programa;
+        unsigned int malha;
+        EstadoRasterizacao estado;
+    };
+
+    void executaDesenho(unsigned int programa, unsigned int malha, const EstadoRasterizacao& estadoDesenho);
+    // Desenha os adiados (pre-pass e cor). Chamado no finalizaQuadro e antes de tudo que não pode ser
+    // adiado (limpa, desenhos sem escrita de profundidade, troca de framebuffer), para manter a ordem.
+    void executaAdiados();
+
+    PoolThreads pool;
+    BinsTiles bins;
+    FramebufferCPU quadro;
+    FramebufferMSAA quadroMSAA;
+    bool multiAmostragem = false;
+    EstadoRasterizacao estado;
+    EstatisticasRasterizacao contadores;
+    std::vector<MalhaCPU> malhas;
+    std::vector<ProgramaCPU> programas;
+    std::vector<std::unique_ptr<ProgramaGLSLCPU>> programasGLSL;    // Nulo nos programas em C++.
+    bool prepass = false;
+    std::vector<DesenhoAdiado> adiados;
+    bool captura = false;
+    bool quadroCapturado = false;     // finalizaQuadro com captura e lePixels ainda não chamado.
+};
@@ -0,0 +1,170 @@
+#include <glad/glad.h>
+
+#include "BackendGL.h"
+
+// Usado para escrever no console com C++
+#include <iostream>
+
+BackendGL::~BackendGL()
+{
+    for (const MalhaGL& malha : malhas) {
+        glDeleteVertexArrays(1, &malha.VAO);
+        glDeleteBuffers(1, &malha.VBO);
+        glDeleteBuffers(1, &malha.EBO);
+    }
+    for (unsigned int programa : programas) {
+        glDeleteProgram(programa);
+    }
+    if (leitura.largura > 0) {
+        destroiLeituraPixels(leitura);
+    }
+}
+
+void BackendGL::defineViewport(int largura, int altura)
+{
+    glViewport(0, 0, largura, altura);
+    larguraViewport = largura;
+    alturaViewport = altura;
+}
+
+void BackendGL::limpa(float r, float g, float b, float a)
+{
+    glClearColor(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void BackendGL::defineTesteProfundidade(bool habilitado)
+{
+    if (habilitado) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    else {
+        glDisable(GL_DEPTH_TEST);
+    }
+}
+
+unsigned int BackendGL::criaMalha(const DescricaoMalha& malha)
+{
+    MalhaGL gl;
+    gl.indexada = (malha.indices != nullptr);
+    gl.numElementos = gl.indexada ? malha.numIndices : malha.numVertices;
+
+    glGenVertexArrays(1, &gl.VAO);
+    glGenBuffers(1, &gl.VBO);
+    glGenBuffers(1, &gl.EBO);
+
+    glBindVertexArray(gl.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gl.VBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)malha.numVertices * malha.stride * sizeof(float), malha.vertices, GL_STATIC_DRAW);
+
+    if (gl.indexada) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)malha.numIndices * sizeof(unsigned int), malha.indices, GL_STATIC_DRAW);
+    }
+
+    for (unsigned int i = 0; i < malha.numAtributos; i++) {
+        const AtributoMalha& atributo = malha.atributos[i];
+        glVertexAttribPointer(atributo.location, (GLint)atributo.componentes, GL_FLOAT, GL_FALSE,
+                              (GLsizei)(malha.stride * sizeof(float)), (void*)(atributo.deslocamento * sizeof(float)));
+        glEnableVertexAttribArray(atributo.location);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    malhas.push_back(gl);
+    return (unsigned int)malhas.size() - 1;
+}
+
+// Mostra o log de compilação ou vinculação em caso de erro.
+static void verificaShader(unsigned int objeto, bool programa, const char* nome)
+{
+    int sucesso;
+    char infoLog[512];
+
+    if (programa) {
+        glGetProgramiv(objeto, GL_LINK_STATUS, &sucesso);
+    }
+    else {
+        glGetShaderiv(objeto, GL_COMPILE_STATUS, &sucesso);
+    }
+
+    if (!sucesso) {
+        if (programa) {
+            glGetProgramInfoLog(objeto, 512, NULL, infoLog);
+        }
+        else {
+            glGetShaderInfoLog(objeto, 512, NULL, infoLog);
+        }
+        std::cout << "Erro durante a compilação do " << nome << " \n" << infoLog << std::endl;
+    }
+}
+
+unsigned int BackendGL::criaPrograma(const DescricaoPrograma& descricao)
+{
+    unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &descricao.fonteVertex, NULL);
+    glCompileShader(vs);
+    verificaShader(vs, false, "Vertex Shader");
+
+    unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fs, 1, &descricao.fonteFragment, NULL);
+    glCompileShader(fs);
+    verificaShader(fs, false, "Fragment Shader");
+
+    unsigned int programa = glCreateProgram();
+    glAttachShader(programa, vs);
+    glAttachShader(programa, fs);
+    glLinkProgram(programa);
+    verificaShader(programa, true, "Program Shader");
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    programas.push_back(programa);
+    return (unsigned int)programas.size() - 1;
+}
+
+void BackendGL::desenha(unsigned int programa, unsigned int malha)
+{
+    const MalhaGL& gl = malhas[malha];
+
+    glUseProgram(programas[programa]);
+    glBindVertexArray(gl.VAO);
+    if (gl.indexada) {
+        glDrawElements(GL_TRIANGLES, (GLsizei)gl.numElementos, GL_UNSIGNED_INT, (void*)0);
+    }
+    else {
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)gl.numElementos);
+    }
+}
+
+void BackendGL::finalizaQuadro()
+{
+    if (captura) {
+        // Quadros pendentes com o tamanho antigo são perdidos quando a janela muda de tamanho.
+        if (leitura.largura != larguraViewport || leitura.altura != alturaViewport) {
+            if (leitura.largura > 0) {
+                destroiLeituraPixels(leitura);
+            }
+            criaLeituraPixels(leitura, larguraViewport, alturaViewport);
+        }
+        iniciaLeituraPixels(leitura);
+    }
+    glFinish();
+}
+
+void BackendGL::defineCaptura(bool habilitada)
+{
+    captura = habilitada;
+    if (!captura && leitura.largura > 0) {
+        destroiLeituraPixels(leitura);
+    }
+}
+
+bool BackendGL::lePixels(std::vector<uint32_t>& destino, int& largura, int& altura, bool espera)
+{
+    largura = leitura.largura;
+    altura = leitura.altura;
+    return terminaLeituraPixels(leitura, destino, espera);
+}
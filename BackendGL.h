@@ -0,0 +1,40 @@
+#pragma once
+
+// Backend OpenGL: precisa de um contexto ativo (janela GLFW criada e Glad inicializado).
+
+#include "BackendRenderizacao.h"
+#include "LeituraPixelsGL.h"
+
+#include <vector>
+
+class BackendGL : public BackendRenderizacao {
+public:
+    ~BackendGL();
+
+    const char* nome() const override { return "OpenGL"; }
+    void defineViewport(int largura, int altura) override;
+    void limpa(float r, float g, float b, float a) override;
+    void defineTesteProfundidade(bool habilitado) override;
+    unsigned int criaMalha(const DescricaoMalha& malha) override;
+    unsigned int criaPrograma(const DescricaoPrograma& programa) override;
+    void desenha(unsigned int programa, unsigned int malha) override;
+    void finalizaQuadro() override;
+    // A captura lê o framebuffer ligado em GL_READ_FRAMEBUFFER no finalizaQuadro, com PBOs (LeituraPixelsGL.h).
+    // Se 3 quadros capturados ainda não foram lidos, o quadro atual não é capturado.
+    void defineCaptura(bool habilitada) override;
+    bool lePixels(std::vector<uint32_t>& destino, int& largura, int& altura, bool espera) override;
+
+private:
+    struct MalhaGL {
+        unsigned int VAO, VBO, EBO;
+        unsigned int numElementos;
+        bool indexada;
+    };
+
+    std::vector<MalhaGL> malhas;
+    std::vector<unsigned int> programas;
+    int larguraViewport = 0;
+    int alturaViewport = 0;
+    bool captura = false;
+    LeituraPixels leitura;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+// Interface comum de renderização: o mesmo desenho pode ir para o OpenGL (GPU) ou para o
+// rasterizador em software (CPU), escolhido na inicialização.
+
+#include "RasterizadorCPU.h"
+
+#include <cstdint>
+#include <vector>
+
+// Atributo de vertice, como no glVertexAttribPointer (tamanhos em floats).
+struct AtributoMalha {
+    unsigned int location = 0;
+    unsigned int componentes = 3;
+    unsigned int deslocamento = 0;
+};
+
+const unsigned int maxAtributosMalha = 4;
+
+// Dados de uma malha no mesmo formato enviado ao VBO/EBO (vertices intercalados em float).
+struct DescricaoMalha {
+    const float* vertices = nullptr;
+    unsigned int numVertices = 0;
+    unsigned int stride = 3;                            // Floats por vertice.
+    AtributoMalha atributos[maxAtributosMalha];
+    unsigned int numAtributos = 0;
+    const unsigned int* indices = nullptr;              // Nulo: desenha os vertices em sequência.
+    unsigned int numIndices = 0;
+};
+
+// Programa de shader: codigo GLSL para a GPU e o equivalente em C++ para a CPU.
+struct DescricaoPrograma {
+    const char* fonteVertex = nullptr;
+    const char* fonteFragment = nullptr;
+    ShaderVerticeCPU vertexCPU = nullptr;
+    ShaderVerticeLoteCPU vertexLoteCPU = nullptr;       // Opcional: versão vetorizada (ShaderLote.h).
+    ShaderFragmentoCPU fragmentCPU = nullptr;
+    ShaderFragmentoLoteCPU fragmentLoteCPU = nullptr;   // Opcional: versão vetorizada (ShaderLote.h).
+    int numVaryings = 0;
+};
+
+class BackendRenderizacao {
+public:
+    virtual ~BackendRenderizacao() {}
+
+    virtual const char* nome() const = 0;
+
+    // Tamanho da area de desenho em pixels.
+    virtual void defineViewport(int largura, int altura) = 0;
+
+    // Limpa cor e profundidade.
+    virtual void limpa(float r, float g, float b, float a) = 0;
+
+    // Habilita o teste de profundidade (GL_DEPTH_TEST com GL_LESS).
+    virtual void defineTesteProfundidade(bool habilitado) = 0;
+
+    // Envia uma malha e retorna o identificador usado em "desenha".
+    virtual unsigned int criaMalha(const DescricaoMalha& malha) = 0;
+
+    // Compila um programa e retorna o identificador usado em "desenha".
+    virtual unsigned int criaPrograma(const DescricaoPrograma& programa) = 0;
+
+    // Desenha todos os triângulos da malha com o programa.
+    virtual void desenha(unsigned int programa, unsigned int malha) = 0;
+
+    // Espera todos os desenhos do quadro terminarem.
+    virtual void finalizaQuadro() = 0;
+
+    // Com a captura ligada, cada finalizaQuadro guarda uma copia da imagem para lePixels.
+    virtual void defineCaptura(bool habilitada) = 0;
+
+    // Entrega o quadro capturado mais antigo que ainda não foi lido (RGBA8, linha 0 embaixo); falso se nenhum
+    // está pronto. Na CPU a copia é imediata. No OpenGL a leitura é assincrona e o quadro só fica pronto
+    // 1 ou 2 quadros depois, a não ser com "espera".
+    virtual bool lePixels(std::vector<uint32_t>& destino, int& largura, int& altura, bool espera) = 0;
+};
@@ -0,0 +1,2258 @@
+#include "Benchmark.h"
+#include "OtimizacaoMalha.h"
+#include "FormatoVertice.h"
+#include "FilaRenderizacao.h"
+#include "RasterizadorCPU.h"
+#include "RasterizadorTiles.h"
+#include "RasterizadorMSAA.h"
+#include "CoberturaSIMD.h"
+#include "BackendCPU.h"
+#include "ShaderLote.h"
+#include "TexturaCPU.h"
+#include "InterpretadorGLSL.h"
+#include "CodificadorImagem.h"
+#include "GravadorQuadros.h"
+#include "Matematica.h"
+#include "TransformacoesSoA.h"
+#include "HierarquiaCena.h"
+#include "DescarteFrustum.h"
+#include "BVH.h"
+#include "OclusaoCPU.h"
+#include "NivelDetalhe.h"
+#include "Meshlets.h"
+#include "MundoECS.h"
+#include "SistemaTarefas.h"
+
+// Usado para escrever no console com C++
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+
+double tempoAtualMs()
+{
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Gerador congruente linear das cenas sinteticas: avança a semente e retorna os 24 bits de cima.
+static unsigned int aleatorio(unsigned int& semente)
+{
+    semente = semente * 1664525u + 1013904223u;
+    return semente >> 8;
+}
+
+// Imprime o ACMR de uma malha antes e depois da otimização.
+static void relatorioACMR(const char* nome, MalhaIndexada& malha)
+{
+    size_t numVertices = malha.vertices.size() / malha.componentes;
+    float antes = calculaACMR(malha.indices.data(), malha.indices.size(), numVertices);
+
+    double inicio = tempoAtualMs();
+    otimizaMalha(malha);
+    double tempo = tempoAtualMs() - inicio;
+
+    numVertices = malha.vertices.size() / malha.componentes;
+    float depois = calculaACMR(malha.indices.data(), malha.indices.size(), numVertices);
+
+    std::cout << std::left << std::setw(26) << nome
+              << " triangulos: " << std::setw(8) << malha.indices.size() / 3
+              << " ACMR antes: " << std::setw(6) << antes
+              << " depois: " << std::setw(6) << depois
+              << " (" << tempo << " ms)" << std::endl;
+}
+
+// ACMR (cache de vertices pós-transformação) em malhas de teste.
+static void benchmarkCacheVertices()
+{
+    std::cout << "== Cache de vertices (FIFO de " << tamanhoCachePadrao << " entradas) ==" << std::endl;
+    std::cout << std::setprecision(3) << std::fixed;
+
+    MalhaIndexada malha;
+
+    geraMalhaGrade(malha, 200, 200);
+    relatorioACMR("Grade 200x200", malha);
+
+    geraMalhaGrade(malha, 200, 200);
+    embaralhaTriangulos(malha.indices.data(), malha.indices.size(), 1234);
+    relatorioACMR("Grade 200x200 embaralhada", malha);
+
+    geraMalhaEsfera(malha, 128, 64);
+    relatorioACMR("Esfera 128x64", malha);
+
+    geraMalhaEsfera(malha, 128, 64);
+    embaralhaTriangulos(malha.indices.data(), malha.indices.size(), 4321);
+    relatorioACMR("Esfera 128x64 embaralhada", malha);
+
+    std::cout << std::defaultfloat << std::setprecision(4) << std::endl;
+}
+
+// Memoria e erro do formato de vertice compacto em relação ao formato em float.
+static void benchmarkFormatoVertice()
+{
+    std::cout << "== Formato de vertice compacto ==" << std::endl;
+
+    const unsigned int tamanhos[][2] = { { 64, 32 }, { 256, 128 }, { 1024, 512 } };
+
+    for (const auto& tamanho : tamanhos) {
+        std::vector<VerticeCompleto> completos;
+        geraEsferaVerticesCompletos(completos, tamanho[0], tamanho[1]);
+        std::vector<VerticeCompacto> compactos(completos.size());
+
+        double inicio = tempoAtualMs();
+        compactaVertices(completos.data(), completos.size(), compactos.data());
+        double tempo = tempoAtualMs() - inicio;
+
+        // Maior erro de cada atributo depois de decodificar.
+        float erroPosicao = 0.0f, erroNormalGraus = 0.0f, erroUV = 0.0f;
+        for (size_t i = 0; i < completos.size(); i++) {
+            float normal[3];
+            decodificaNormalOctaedrica(compactos[i].normal, normal);
+            float cosseno = normal[0] * completos[i].normal[0] + normal[1] * completos[i].normal[1] + normal[2] * completos[i].normal[2];
+            cosseno = cosseno > 1.0f ? 1.0f : cosseno;
+            erroNormalGraus = std::fmax(erroNormalGraus, std::acos(cosseno) * 57.2957795f);
+
+            for (int k = 0; k < 3; k++) {
+                erroPosicao = std::fmax(erroPosicao, std::fabs(halfParaFloat(compactos[i].posicao[k]) - completos[i].posicao[k]));
+            }
+            for (int k = 0; k < 2; k++) {
+                erroUV = std::fmax(erroUV, std::fabs(decodificaUV(compactos[i].uv[k]) - completos[i].uv[k]));
+            }
+        }
+
+        double bytesCompletos = (double)completos.size() * sizeof(VerticeCompleto);
+        double bytesCompactos = (double)compactos.size() * sizeof(VerticeCompacto);
+
+        std::cout << "Esfera " << tamanho[0] << "x" << tamanho[1] << " (" << completos.size() << " vertices): "
+                  << (size_t)(bytesCompletos / 1024.0) << " KB -> " << (size_t)(bytesCompactos / 1024.0) << " KB"
+                  << ", codificação " << tempo << " ms" << std::endl;
+        std::cout << "    erro maximo: posição " << erroPosicao << ", normal " << erroNormalGraus
+                  << " graus, UV " << erroUV << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+static void imprimeEstatisticasFila(const char* nome, const EstatisticasFila& e)
+{
+    std::cout << nome << "programa " << e.trocasPrograma << ", VAO " << e.trocasVAO
+              << ", textura " << e.trocasTextura << ", desenhos " << e.chamadasDesenho << std::endl;
+}
+
+// Trocas de estado na ordem do codigo contra a ordem da chave de 64 bits.
+static void benchmarkFilaRenderizacao()
+{
+    std::cout << "== Fila de renderização ==" << std::endl;
+
+    const unsigned int numPacotes = 20000;
+    FilaRenderizacao fila;
+    unsigned int semente = 12345;
+
+    // Cena sintetica: 8 programas, 64 VAOs e 32 texturas em ordem aleatoria.
+    for (unsigned int i = 0; i < numPacotes; i++) {
+        unsigned int valor = aleatorio(semente);
+        PacoteDesenho pacote;
+        pacote.programa = 1 + valor % 8;
+        pacote.VAO = 1 + (semente >> 12) % 64;
+        pacote.textura = 1 + (semente >> 20) % 32;
+        pacote.profundidade = (float)((semente >> 4) % 1000) / 1000.0f;
+        pacote.indexado = true;
+        pacote.primeiro = (int)(i % 100) * 36;
+        pacote.contagem = 36;
+        adicionaPacote(fila, pacote);
+    }
+
+    EstatisticasFila antes = simulaFila(fila);
+
+    double inicio = tempoAtualMs();
+    ordenaFila(fila);
+    double tempoOrdenacao = tempoAtualMs() - inicio;
+
+    EstatisticasFila depois = simulaFila(fila);
+
+    std::cout << numPacotes << " pacotes, radix sort em " << tempoOrdenacao << " ms" << std::endl;
+    imprimeEstatisticasFila("Ordem do codigo: ", antes);
+    imprimeEstatisticasFila("Ordenada:        ", depois);
+    std::cout << std::endl;
+}
+
+// Shaders de teste do rasterizador: posição (x, y, z) e cor (r, g, b) interpolada.
+static void vertexShaderCorCPU(const float* atributos, const void* /*uniforms*/, float* posicao, float* varyings)
+{
+    posicao[0] = atributos[0];
+    posicao[1] = atributos[1];
+    posicao[2] = atributos[2];
+    posicao[3] = 1.0f;
+    varyings[0] = atributos[3];
+    varyings[1] = atributos[4];
+    varyings[2] = atributos[5];
+}
+
+static void fragmentShaderCorCPU(const float* varyings, const void* /*uniforms*/, float* cor)
+{
+    cor[0] = varyings[0];
+    cor[1] = varyings[1];
+    cor[2] = varyings[2];
+    cor[3] = 1.0f;
+}
+
+// Cenas de teste do rasterizador (6 floats por vertice: posição e cor).
+// Camadas de retângulos cobrindo a tela inteira (muita sobreposição).
+static void geraCenaTelaCheia(std::vector<float>& vertices, int camadas)
+{
+    vertices.clear();
+    for (int c = 0; c < camadas; c++) {
+        float z = 0.9f - 1.8f * (float)c / (float)camadas;
+        const float canto[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+        for (int v = 0; v < 6; v++) {
+            float cor = (float)c / (float)camadas;
+            const float vertice[6] = { canto[v][0], canto[v][1], z, cor, 1.0f - cor, 0.5f };
+            vertices.insert(vertices.end(), vertice, vertice + 6);
+        }
+    }
+}
+
+// Triângulos pequenos espalhados pela tela ("tamanho" em NDC).
+static void geraCenaTriangulos(std::vector<float>& vertices, int quantidade, float tamanho, unsigned int semente)
+{
+    vertices.clear();
+    for (int t = 0; t < quantidade; t++) {
+        float x = (float)(aleatorio(semente) % 2000) / 1000.0f - 1.0f;
+        float y = (float)(aleatorio(semente) % 2000) / 1000.0f - 1.0f;
+        float z = (float)((semente >> 4) % 1000) / 1000.0f * 1.8f - 0.9f;
+
+        const float vertice[3][6] = {
+            { x, y, z, 1.0f, 0.0f, 0.0f },
+            { x + tamanho, y, z, 0.0f, 1.0f, 0.0f },
+            { x, y + tamanho, z, 0.0f, 0.0f, 1.0f }
+        };
+        vertices.insert(vertices.end(), &vertice[0][0], &vertice[0][0] + 18);
+    }
+}
+
+// Mede uma cena no rasterizador; imprime ms por quadro e milhões de pixels por segundo.
+static void medeCenaCPU(const char* nome, FramebufferCPU& framebuffer, const std::vector<float>& vertices, bool profundidade)
+{
+    ProgramaCPU programa;
+    programa.vertex = vertexShaderCorCPU;
+    programa.fragment = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    EstadoRasterizacao estado;
+    estado.testeProfundidade = profundidade;
+
+    const int quadros = 5;
+    EstatisticasRasterizacao estatisticas;
+    double inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        limpaFramebuffer(framebuffer, 0.0f, 0.0f, 0.0f, 1.0f);
+        desenhaTriangulosCPU(framebuffer, programa, estado, vertices.data(), 6, (unsigned int)(vertices.size() / 6), nullptr, 0, &estatisticas);
+    }
+    double tempo = (tempoAtualMs() - inicio) / quadros;
+
+    std::cout << std::left << std::setw(30) << nome << tempo << " ms/quadro, "
+              << (double)estatisticas.fragmentos / quadros / (tempo * 1000.0) << " Mpixels/s" << std::endl;
+}
+
+// Vazão do rasterizador em software a 1080p.
+static void benchmarkRasterizadorCPU()
+{
+    std::cout << "== Rasterizador em software (1920x1080) ==" << std::endl;
+
+    FramebufferCPU framebuffer;
+    redimensionaFramebuffer(framebuffer, 1920, 1080);
+    std::vector<float> vertices;
+
+    geraCenaTelaCheia(vertices, 8);
+    medeCenaCPU("Tela cheia, 8 camadas", framebuffer, vertices, false);
+
+    geraCenaTriangulos(vertices, 20000, 0.05f, 1);
+    medeCenaCPU("20 mil triângulos medios", framebuffer, vertices, true);
+
+    geraCenaTriangulos(vertices, 200000, 0.005f, 2);
+    medeCenaCPU("200 mil triângulos pequenos", framebuffer, vertices, true);
+
+    std::cout << std::endl;
+}
+
+// Cobertura dos blocos 8x8 com cada nivel de SIMD suportado (escalar, SSE4.1, AVX2),
+// com triângulos pequenos, medios e de tela cheia.
+static void benchmarkCoberturaSIMD()
+{
+    std::cout << "== Cobertura de blocos 8x8 com SIMD (1920x1080, CPU com " << nomeNivelSIMD(melhorNivelSIMD()) << ") ==" << std::endl;
+
+    FramebufferCPU framebuffer;
+    redimensionaFramebuffer(framebuffer, 1920, 1080);
+    std::vector<float> pequenos, medios, telaCheia;
+    geraCenaTriangulos(pequenos, 200000, 0.005f, 2);
+    geraCenaTriangulos(medios, 20000, 0.05f, 1);
+    geraCenaTelaCheia(telaCheia, 8);
+
+    NivelSIMD nivelOriginal = nivelCobertura();
+    for (int nivel = simdEscalar; nivel <= melhorNivelSIMD(); nivel++) {
+        selecionaNivelCobertura((NivelSIMD)nivel);
+        std::cout << nomeNivelSIMD((NivelSIMD)nivel) << ":" << std::endl;
+        medeCenaCPU("  Triângulos pequenos", framebuffer, pequenos, true);
+        medeCenaCPU("  Triângulos medios", framebuffer, medios, true);
+        medeCenaCPU("  Tela cheia", framebuffer, telaCheia, false);
+
+        // Só a cobertura, sem fragment shader: blocos de um triângulo que cruza a tela.
+        TrianguloPreparado triangulo;
+        VerticeTransformado v[3] = {};
+        const float posicoes[3][2] = { { -1.0f, -1.0f }, { 1.0f, -0.8f }, { -0.2f, 1.0f } };
+        for (int i = 0; i < 3; i++) {
+            v[i].posicao[0] = posicoes[i][0];
+            v[i].posicao[1] = posicoes[i][1];
+            v[i].posicao[3] = 1.0f;
+        }
+        preparaTriangulo(v[0], v[1], v[2], 0, framebuffer.largura, framebuffer.altura, triangulo);
+
+        const int repeticoes = 20;
+        uint64_t pixels = 0;
+        double inicio = tempoAtualMs();
+        for (int r = 0; r < repeticoes; r++) {
+            for (int by = 0; by < framebuffer.altura; by += 8) {
+                for (int bx = 0; bx < framebuffer.largura; bx += 8) {
+                    uint64_t mascara = coberturaBloco8x8(triangulo, bx, by);
+                    while (mascara != 0) {
+                        mascara &= mascara - 1;
+                        pixels++;
+                    }
+                }
+            }
+        }
+        double tempo = (tempoAtualMs() - inicio) / repeticoes;
+        double blocos = (double)(framebuffer.largura / 8) * (framebuffer.altura / 8);
+        std::cout << std::left << std::setw(30) << "  Só cobertura" << tempo << " ms/quadro, "
+                  << blocos * 64.0 / (tempo * 1000.0) << " Mpixels testados/s (" << pixels / repeticoes << " cobertos)" << std::endl;
+    }
+    selecionaNivelCobertura(nivelOriginal);
+
+    std::cout << std::endl;
+}
+
+// Recorta (se preciso), prepara e soma a cobertura de cada triângulo em "contagem" (uma entrada por pixel).
+static void contaCobertura(const std::vector<float>& vertices, int largura, int altura, bool bandaGuarda, std::vector<uint8_t>& contagem)
+{
+    BandaGuarda banda = calculaBandaGuarda(largura, altura, bandaGuarda);
+    contagem.assign((size_t)largura * altura, 0);
+    VerticeTransformado recortados[7][3];
+
+    for (size_t t = 0; t + 9 <= vertices.size(); t += 9) {
+        VerticeTransformado v[3] = {};
+        for (int i = 0; i < 3; i++) {
+            v[i].posicao[0] = vertices[t + i * 3 + 0];
+            v[i].posicao[1] = vertices[t + i * 3 + 1];
+            v[i].posicao[2] = vertices[t + i * 3 + 2];
+            v[i].posicao[3] = 1.0f;
+        }
+        if (trianguloForaVolume(v[0], v[1], v[2])) {
+            continue;
+        }
+        int numTriangulos = 1;
+        const VerticeTransformado* triangulos[7][3] = { { &v[0], &v[1], &v[2] } };
+        unsigned int planos = planosCruzados(v[0], v[1], v[2], banda);
+        if (planos != 0) {
+            numTriangulos = recortaTriangulo(v[0], v[1], v[2], 0, banda, planos, recortados);
+            for (int r = 0; r < numTriangulos; r++) {
+                triangulos[r][0] = &recortados[r][0];
+                triangulos[r][1] = &recortados[r][1];
+                triangulos[r][2] = &recortados[r][2];
+            }
+        }
+
+        for (int r = 0; r < numTriangulos; r++) {
+            TrianguloPreparado triangulo;
+            if (!preparaTriangulo(*triangulos[r][0], *triangulos[r][1], *triangulos[r][2], 0, largura, altura, triangulo)) {
+                continue;
+            }
+            for (int by = triangulo.minY & ~7; by <= triangulo.maxY; by += 8) {
+                for (int bx = triangulo.minX & ~7; bx <= triangulo.maxX; bx += 8) {
+                    uint64_t mascara = coberturaBloco8x8(triangulo, bx, by);
+                    while (mascara != 0) {
+                        int bit = primeiroBitLigado(mascara);
+                        mascara &= mascara - 1;
+                        int px = bx + (bit & 7), py = by + (bit >> 3);
+                        if (px < largura && py < altura) {
+                            contagem[(size_t)py * largura + px]++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Estanqueidade: duas malhas que cobrem a tela inteira com arestas compartilhadas (grade com vertices
+// deslocados e leque de triângulos finos). Cada pixel tem de ser coberto exatamente uma vez: sem frestas
+// entre triângulos vizinhos e sem pixels desenhados duas vezes nas arestas.
+static void benchmarkEstanqueidade()
+{
+    std::cout << "== Estanqueidade da rasterização (vertices em 16.8, regra topo-esquerda, 1920x1080) ==" << std::endl;
+
+    const int largura = 1920, altura = 1080;
+    unsigned int semente = 11;
+    auto unitario = [&semente]() { return (float)aleatorio(semente) / 16777216.0f; };
+
+    // Grade de 160x90 celulas em NDC -1.3 a 1.3, com os vertices internos deslocados até 1/8 da celula
+    // (as celulas continuam convexas, então as duas diagonais dão triângulos sem sobreposição).
+    const int colunas = 160, linhas = 90;
+    std::vector<float> pontos;
+    for (int j = 0; j <= linhas; j++) {
+        for (int i = 0; i <= colunas; i++) {
+            float dx = (i > 0 && i < colunas) ? (unitario() - 0.5f) * 0.25f : 0.0f;
+            float dy = (j > 0 && j < linhas) ? (unitario() - 0.5f) * 0.25f : 0.0f;
+            pontos.push_back(-1.3f + 2.6f * ((float)i + dx) / colunas);
+            pontos.push_back(-1.3f + 2.6f * ((float)j + dy) / linhas);
+        }
+    }
+    std::vector<float> grade;
+    auto adiciona = [](std::vector<float>& malha, const float* p, float z) {
+        malha.push_back(p[0]);
+        malha.push_back(p[1]);
+        malha.push_back(z);
+    };
+    for (int j = 0; j < linhas; j++) {
+        for (int i = 0; i < colunas; i++) {
+            const float* p00 = &pontos[((size_t)j * (colunas + 1) + i) * 2];
+            const float* p10 = p00 + 2;
+            const float* p01 = &pontos[((size_t)(j + 1) * (colunas + 1) + i) * 2];
+            const float* p11 = p01 + 2;
+            // Diagonal alternada para ter arestas em todas as direções.
+            const float* quad[2][3] = { { p00, p10, p11 }, { p00, p11, p01 } };
+            const float* quadInvertido[2][3] = { { p00, p10, p01 }, { p10, p11, p01 } };
+            for (int t = 0; t < 2; t++) {
+                for (int k = 0; k < 3; k++) {
+                    adiciona(grade, ((i + j) % 2 ? quadInvertido : quad)[t][k], 0.0f);
+                }
+            }
+        }
+    }
+
+    // Leque: 4000 triângulos finos de um ponto interno até o contorno de um quadrado maior que a tela.
+    std::vector<float> leque;
+    const int numContorno = 4000;
+    const float centro[2] = { 0.123456f, -0.0654321f };
+    std::vector<float> contorno;
+    for (int k = 0; k < numContorno; k++) {
+        float s = 8.0f * (float)k / numContorno;
+        int lado = (int)s;
+        float f = s - (float)lado;
+        const float cantos[5][2] = { { -1.2f, -1.2f }, { 1.2f, -1.2f }, { 1.2f, 1.2f }, { -1.2f, 1.2f }, { -1.2f, -1.2f } };
+        int segmento = lado / 2;
+        float u = ((float)(lado % 2) + f) * 0.5f;
+        contorno.push_back(cantos[segmento][0] + (cantos[segmento + 1][0] - cantos[segmento][0]) * u);
+        contorno.push_back(cantos[segmento][1] + (cantos[segmento + 1][1] - cantos[segmento][1]) * u);
+    }
+    for (int k = 0; k < numContorno; k++) {
+        adiciona(leque, centro, 0.0f);
+        adiciona(leque, &contorno[(size_t)k * 2], 0.0f);
+        adiciona(leque, &contorno[(size_t)((k + 1) % numContorno) * 2], 0.0f);
+    }
+
+    const std::vector<float>* malhas[2] = { &grade, &leque };
+    const char* nomes[2] = { "Grade deslocada", "Leque de triângulos finos" };
+    std::vector<uint8_t> contagem;
+    for (int m = 0; m < 2; m++) {
+        for (int banda = 1; banda >= 0; banda--) {
+            contaCobertura(*malhas[m], largura, altura, banda != 0, contagem);
+            size_t vazios = 0, repetidos = 0;
+            for (uint8_t c : contagem) {
+                vazios += c == 0;
+                repetidos += c > 1;
+            }
+            std::cout << std::left << std::setw(28) << nomes[m] << std::setw(22) << (banda ? "(banda de guarda)" : "(recorte na tela)")
+                      << malhas[m]->size() / 9 << " triângulos, " << vazios << " pixels sem cobertura, "
+                      << repetidos << " cobertos mais de uma vez" << (vazios == 0 && repetidos == 0 ? "" : " (não estanque!)") << std::endl;
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+// Custo do recorte numa cena com muitos triângulos saindo da tela: banda de guarda contra recorte na tela.
+static void benchmarkBandaGuarda()
+{
+    std::cout << "== Banda de guarda (1920x1080, 100 mil triângulos, centros em NDC -1.5 a 1.5) ==" << std::endl;
+
+    std::vector<float> vertices;
+    unsigned int semente = 9;
+    auto unitario = [&semente]() { return (float)aleatorio(semente) / 16777216.0f; };
+    for (int t = 0; t < 100000; t++) {
+        float x = unitario() * 3.0f - 1.5f;
+        float y = unitario() * 3.0f - 1.5f;
+        float z = unitario() * 1.8f - 0.9f;
+        for (int k = 0; k < 3; k++) {
+            const float vertice[6] = { x + (unitario() - 0.5f) * 0.4f, y + (unitario() - 0.5f) * 0.4f, z, 1.0f, 0.5f, 0.25f };
+            vertices.insert(vertices.end(), vertice, vertice + 6);
+        }
+    }
+    unsigned int numVertices = (unsigned int)(vertices.size() / 6);
+
+    ProgramaCPU programa;
+    programa.vertex = vertexShaderCorCPU;
+    programa.fragment = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    FramebufferCPU framebuffer;
+    redimensionaFramebuffer(framebuffer, 1920, 1080);
+
+    std::vector<VerticeTransformado> transformados(numVertices);
+    transformaVertices(programa, vertices.data(), 6, nullptr, numVertices, transformados.data());
+
+    for (int bandaGuarda = 0; bandaGuarda < 2; bandaGuarda++) {
+        BandaGuarda banda = calculaBandaGuarda(framebuffer.largura, framebuffer.altura, bandaGuarda != 0);
+
+        // Só a frente: teste de planos, recorte e preparação (sem rasterizar).
+        const int repeticoes = 5;
+        uint64_t recortados = 0, preparados = 0;
+        VerticeTransformado saida[7][3];
+        TrianguloPreparado triangulo;
+        double inicio = tempoAtualMs();
+        for (int r = 0; r < repeticoes; r++) {
+            for (unsigned int i = 0; i + 2 < numVertices; i += 3) {
+                const VerticeTransformado& a = transformados[i];
+                const VerticeTransformado& b = transformados[i + 1];
+                const VerticeTransformado& c = transformados[i + 2];
+                if (trianguloForaVolume(a, b, c)) {
+                    continue;
+                }
+                unsigned int planos = planosCruzados(a, b, c, banda);
+                if (planos == 0) {
+                    preparados += preparaTriangulo(a, b, c, 3, framebuffer.largura, framebuffer.altura, triangulo);
+                    continue;
+                }
+                recortados++;
+                int n = recortaTriangulo(a, b, c, 3, banda, planos, saida);
+                for (int k = 0; k < n; k++) {
+                    preparados += preparaTriangulo(saida[k][0], saida[k][1], saida[k][2], 3, framebuffer.largura, framebuffer.altura, triangulo);
+                }
+            }
+        }
+        double tempoFrente = (tempoAtualMs() - inicio) / repeticoes;
+
+        // Quadro inteiro.
+        EstadoRasterizacao estado;
+        estado.testeProfundidade = true;
+        estado.bandaGuarda = bandaGuarda != 0;
+        EstatisticasRasterizacao estatisticas;
+        inicio = tempoAtualMs();
+        for (int r = 0; r < repeticoes; r++) {
+            limpaFramebuffer(framebuffer, 0.0f, 0.0f, 0.0f, 1.0f);
+            desenhaTriangulosCPU(framebuffer, programa, estado, vertices.data(), 6, numVertices, nullptr, 0, &estatisticas);
+        }
+        double tempoQuadro = (tempoAtualMs() - inicio) / repeticoes;
+
+        std::cout << std::left << std::setw(20) << (bandaGuarda ? "Banda de guarda" : "Recorte na tela")
+                  << recortados / repeticoes << " recortados, " << preparados / repeticoes << " preparados, "
+                  << "frente " << tempoFrente << " ms, quadro " << tempoQuadro << " ms" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Escalabilidade da rasterização em tiles de 1 até N threads, a 1080p e 4K.
+static void benchmarkTilesThreads()
+{
+    std::cout << "== Rasterização em tiles " << tamanhoTile << "x" << tamanhoTile << " com varias threads ==" << std::endl;
+
+    ProgramaCPU programa;
+    programa.vertex = vertexShaderCorCPU;
+    programa.fragment = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    EstadoRasterizacao estado;
+    estado.testeProfundidade = true;
+
+    // Cena mista: camadas de tela cheia e muitos triângulos medios.
+    std::vector<float> telaCheia, triangulos;
+    geraCenaTelaCheia(telaCheia, 4);
+    geraCenaTriangulos(triangulos, 50000, 0.05f, 3);
+    telaCheia.insert(telaCheia.end(), triangulos.begin(), triangulos.end());
+    unsigned int numVertices = (unsigned int)(telaCheia.size() / 6);
+
+    // 1, 2, 4, ... até o numero de nucleos da maquina.
+    std::vector<unsigned int> numThreads;
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2) {
+        numThreads.push_back(threads);
+    }
+    numThreads.push_back(maxThreads);
+
+    const int resolucoes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    for (const auto& resolucao : resolucoes) {
+        FramebufferCPU framebuffer;
+        redimensionaFramebuffer(framebuffer, resolucao[0], resolucao[1]);
+
+        double tempoUmaThread = 0.0;
+        for (unsigned int threads : numThreads) {
+            PoolThreads pool(threads);
+            BinsTiles bins;
+
+            const int quadros = 3;
+            EstatisticasRasterizacao estatisticas;
+            double inicio = tempoAtualMs();
+            for (int q = 0; q < quadros; q++) {
+                limpaFramebuffer(framebuffer, 0.0f, 0.0f, 0.0f, 1.0f);
+                desenhaTriangulosTiles(framebuffer, programa, estado, telaCheia.data(), 6, numVertices, nullptr, 0, pool, bins, &estatisticas);
+            }
+            double tempo = (tempoAtualMs() - inicio) / quadros;
+            if (threads == 1) {
+                tempoUmaThread = tempo;
+            }
+
+            std::cout << resolucao[0] << "x" << resolucao[1] << " " << std::right << std::setw(3) << threads << std::left << " threads: "
+                      << tempo << " ms/quadro, " << (double)estatisticas.fragmentos / quadros / (tempo * 1000.0)
+                      << " Mpixels/s, aceleração " << tempoUmaThread / tempo << "x" << std::endl;
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+// Embaralha a ordem dos triângulos da cena (ordem de desenho qualquer, nem de frente para trás nem ao contrario).
+static void embaralhaCena(std::vector<float>& vertices, unsigned int semente)
+{
+    const size_t floatsPorTriangulo = 18;
+    size_t numTriangulos = vertices.size() / floatsPorTriangulo;
+    for (size_t i = numTriangulos; i > 1; i--) {
+        size_t j = aleatorio(semente) % i;
+        std::swap_ranges(&vertices[(i - 1) * floatsPorTriangulo], &vertices[i * floatsPorTriangulo], &vertices[j * floatsPorTriangulo]);
+    }
+}
+
+// Descarte antecipado pela profundidade hierarquica numa cena com muita sobreposição (1080p),
+// sem hierarquia, com hierarquia e com hierarquia mais pre-pass de profundidade.
+static void benchmarkProfundidadeHierarquica()
+{
+    std::cout << "== Profundidade hierarquica (1920x1080, 16 camadas de tela cheia + 20 mil triângulos) ==" << std::endl;
+
+    std::vector<float> cena, triangulos;
+    geraCenaTelaCheia(cena, 16);
+    geraCenaTriangulos(triangulos, 20000, 0.1f, 4);
+    cena.insert(cena.end(), triangulos.begin(), triangulos.end());
+    embaralhaCena(cena, 5);
+
+    DescricaoMalha malha;
+    malha.vertices = cena.data();
+    malha.numVertices = (unsigned int)(cena.size() / 6);
+    malha.stride = 6;
+
+    DescricaoPrograma programa;
+    programa.vertexCPU = vertexShaderCorCPU;
+    programa.fragmentCPU = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    BackendCPU backend;
+    unsigned int idMalha = backend.criaMalha(malha);
+    unsigned int idPrograma = backend.criaPrograma(programa);
+    backend.defineViewport(1920, 1080);
+    backend.defineTesteProfundidade(true);
+
+    const char* nomes[3] = { "Sem hierarquia", "Com hierarquia", "Hierarquia + pre-pass" };
+    uint64_t testadosSemHierarquia = 0;
+    std::vector<uint32_t> referencia;
+
+    for (int modo = 0; modo < 3; modo++) {
+        backend.defineHierarquiaZ(modo > 0);
+        backend.definePrepassProfundidade(modo == 2);
+
+        const int quadros = 3;
+        EstatisticasRasterizacao antes = backend.estatisticas();
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            backend.limpa(0.0f, 0.0f, 0.0f, 1.0f);
+            backend.desenha(idPrograma, idMalha);
+            backend.finalizaQuadro();
+        }
+        double tempo = (tempoAtualMs() - inicio) / quadros;
+
+        const EstatisticasRasterizacao& depois = backend.estatisticas();
+        uint64_t testados = (depois.fragmentosTestados - antes.fragmentosTestados) / quadros;
+        uint64_t tiles = (depois.tilesDescartadosZ - antes.tilesDescartadosZ) / quadros;
+        uint64_t blocos = (depois.blocosDescartadosZ - antes.blocosDescartadosZ) / quadros;
+        if (modo == 0) {
+            testadosSemHierarquia = testados;
+            referencia = backend.framebuffer().cor;
+        }
+
+        // A imagem tem que ser a mesma. Com pre-pass, os pixels onde dois triângulos têm a mesma profundidade
+        // ficam com a cor do ultimo desenhado (GL_LEQUAL) em vez do primeiro, como na GPU.
+        size_t diferentes = 0;
+        for (size_t i = 0; i < referencia.size(); i++) {
+            diferentes += backend.framebuffer().cor[i] != referencia[i];
+        }
+
+        std::cout << std::left << std::setw(24) << nomes[modo] << tempo << " ms/quadro, " << testados << " fragmentos testados ("
+                  << 100.0 * (1.0 - (double)testados / (double)testadosSemHierarquia) << "% descartados cedo), "
+                  << tiles << " tiles e " << blocos << " blocos descartados, " << diferentes << " pixels diferentes" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Shader com textura e iluminação (ambiente + difusa + especular de Blinn-Phong) nas duas versões.
+struct UniformsIluminacao {
+    const TexturaCPU* textura;
+    float luz[3];          // Direção normalizada.
+    float meio[3];         // normalize(luz + visão), com a visão em (0, 0, 1).
+    float repeticoes;      // Repetições da textura.
+};
+
+// Atributos: posição, normal e uv (VerticeCompleto); varyings: normal e uv.
+static void vertexShaderIluminadoCPU(const float* atributos, const void* /*uniforms*/, float* posicao, float* varyings)
+{
+    posicao[0] = atributos[0];
+    posicao[1] = atributos[1];
+    posicao[2] = atributos[2];
+    posicao[3] = 1.0f;
+    for (int i = 0; i < 5; i++) {
+        varyings[i] = atributos[3 + i];
+    }
+}
+
+static void fragmentShaderIluminadoCPU(const float* varyings, const void* uniforms, float* cor)
+{
+    const UniformsIluminacao* u = static_cast<const UniformsIluminacao*>(uniforms);
+
+    float comprimento = std::sqrt(varyings[0] * varyings[0] + varyings[1] * varyings[1] + varyings[2] * varyings[2]);
+    float n[3] = { varyings[0] / comprimento, varyings[1] / comprimento, varyings[2] / comprimento };
+    float difusa = std::max(n[0] * u->luz[0] + n[1] * u->luz[1] + n[2] * u->luz[2], 0.0f);
+    float especular = std::max(n[0] * u->meio[0] + n[1] * u->meio[1] + n[2] * u->meio[2], 0.0f);
+    for (int i = 0; i < 5; i++) {
+        especular *= especular;     // pow(x, 32)
+    }
+
+    float texel[4];
+    amostraTextura(*u->textura, varyings[3] * u->repeticoes, varyings[4] * u->repeticoes, texel);
+    for (int c = 0; c < 3; c++) {
+        cor[c] = texel[c] * (0.15f + 0.85f * difusa) + 0.3f * especular;
+    }
+    cor[3] = 1.0f;
+}
+
+struct FragmentShaderIluminadoLote {
+    typedef UniformsIluminacao Uniforms;
+
+    static void executa(LoteFragmentos& lote, const Uniforms* u)
+    {
+        Vec3Lote n = normaliza({ lote.varyings[0], lote.varyings[1], lote.varyings[2] });
+        FloatLote difusa = maximo(produtoEscalar(n, espalha(u->luz[0], u->luz[1], u->luz[2])), espalha(0.0f));
+        FloatLote especular = potenciaInteira(maximo(produtoEscalar(n, espalha(u->meio[0], u->meio[1], u->meio[2])), espalha(0.0f)), 32);
+
+        Vec4Lote texel = amostraTexturaLote(*u->textura, { lote.varyings[3] * u->repeticoes, lote.varyings[4] * u->repeticoes });
+        FloatLote luz = difusa * 0.85f + 0.15f;
+        FloatLote brilho = especular * 0.3f;
+        lote.cor.x = texel.x * luz + brilho;
+        lote.cor.y = texel.y * luz + brilho;
+        lote.cor.z = texel.z * luz + brilho;
+        lote.cor.w = espalha(1.0f);
+    }
+};
+
+// Fragment shader de um pixel por vez contra o vetorizado, com textura e luz, a 1080p.
+static void benchmarkShaderLote()
+{
+    std::cout << "== Fragment shader vetorizado (lotes de " << fragmentosPorLote << ", textura + iluminação, 1920x1080) ==" << std::endl;
+
+    // Textura xadrez de 512x512.
+    const int lado = 512;
+    std::vector<uint32_t> texels((size_t)lado * lado);
+    for (int y = 0; y < lado; y++) {
+        for (int x = 0; x < lado; x++) {
+            bool claro = ((x / 32) + (y / 32)) % 2 == 0;
+            texels[(size_t)y * lado + x] = claro ? 0xFFE0E0E0u : 0xFF2040A0u;
+        }
+    }
+    TexturaCPU textura;
+    criaTexturaCPU(textura, texels.data(), lado, lado);
+
+    UniformsIluminacao uniforms;
+    uniforms.textura = &textura;
+    float luz[3] = { 0.5f, 0.7f, 0.5f };
+    float comprimento = std::sqrt(luz[0] * luz[0] + luz[1] * luz[1] + luz[2] * luz[2]);
+    float meio[3] = { luz[0] / comprimento, luz[1] / comprimento, luz[2] / comprimento + 1.0f };
+    float comprimentoMeio = std::sqrt(meio[0] * meio[0] + meio[1] * meio[1] + meio[2] * meio[2]);
+    for (int i = 0; i < 3; i++) {
+        uniforms.luz[i] = luz[i] / comprimento;
+        uniforms.meio[i] = meio[i] / comprimentoMeio;
+    }
+    uniforms.repeticoes = 8.0f;
+
+    // Esfera na frente de um plano de fundo que cobre a tela, ja em coordenadas de recorte.
+    std::vector<VerticeCompleto> esfera;
+    geraEsferaVerticesCompletos(esfera, 64, 32);
+    MalhaIndexada indicesEsfera;
+    geraMalhaEsfera(indicesEsfera, 64, 32);
+
+    std::vector<float> vertices;
+    for (const VerticeCompleto& v : esfera) {
+        const float vertice[8] = {
+            v.posicao[0] * 0.9f * 1080.0f / 1920.0f, v.posicao[1] * 0.9f, -v.posicao[2] * 0.5f,
+            v.normal[0], v.normal[1], v.normal[2], v.uv[0], v.uv[1]
+        };
+        vertices.insert(vertices.end(), vertice, vertice + 8);
+    }
+    std::vector<unsigned int> indices = indicesEsfera.indices;
+
+    unsigned int base = (unsigned int)(vertices.size() / 8);
+    const float fundo[4][8] = {
+        { -1.0f, -1.0f, 0.9f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f },
+        { 1.0f, -1.0f, 0.9f, 0.0f, 0.0f, 1.0f, 2.0f, 0.0f },
+        { 1.0f, 1.0f, 0.9f, 0.0f, 0.0f, 1.0f, 2.0f, 2.0f },
+        { -1.0f, 1.0f, 0.9f, 0.0f, 0.0f, 1.0f, 0.0f, 2.0f }
+    };
+    vertices.insert(vertices.end(), &fundo[0][0], &fundo[0][0] + 32);
+    const unsigned int indicesFundo[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+    indices.insert(indices.end(), indicesFundo, indicesFundo + 6);
+
+    ProgramaCPU programa;
+    programa.vertex = vertexShaderIluminadoCPU;
+    programa.fragment = fragmentShaderIluminadoCPU;
+    programa.numVaryings = 5;
+    programa.uniforms = &uniforms;
+
+    EstadoRasterizacao estado;
+    estado.testeProfundidade = true;
+
+    FramebufferCPU framebuffer;
+    redimensionaFramebuffer(framebuffer, 1920, 1080);
+
+    double tempoEscalar = 0.0;
+    for (int vetorizado = 0; vetorizado < 2; vetorizado++) {
+        programa.fragmentLote = vetorizado ? executaShaderLote<FragmentShaderIluminadoLote> : nullptr;
+
+        const int quadros = 3;
+        EstatisticasRasterizacao estatisticas;
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            limpaFramebuffer(framebuffer, 0.0f, 0.0f, 0.0f, 1.0f);
+            desenhaTriangulosCPU(framebuffer, programa, estado, vertices.data(), 8, (unsigned int)(vertices.size() / 8),
+                                 indices.data(), (unsigned int)indices.size(), &estatisticas);
+        }
+        double tempo = (tempoAtualMs() - inicio) / quadros;
+        if (!vetorizado) {
+            tempoEscalar = tempo;
+        }
+
+        std::cout << std::left << std::setw(30) << (vetorizado ? "Lotes SoA (com mipmaps)" : "Um pixel por vez (nivel 0)")
+                  << tempo << " ms/quadro, " << (double)estatisticas.fragmentos / quadros / (tempo * 1000.0)
+                  << " Mpixels/s, aceleração " << tempoEscalar / tempo << "x" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Vazão do InterpretadorGLSL com os shaders do formato compacto (funções do usuario, normalize, dot).
+static void benchmarkInterpretadorGLSL()
+{
+    std::cout << "== Interpretador GLSL (bytecode em lotes de " << fragmentosPorLote << ") ==" << std::endl;
+
+    ProgramaGLSLCPU glsl;
+    std::string erro;
+    if (!compilaProgramaGLSL(glsl, vertexShaderCompactoSource, fragmentShaderCompactoSource, erro)) {
+        std::cout << "ERRO::SHADER::INTERPRETADOR_GLSL\n" << erro << std::endl;
+        return;
+    }
+    defineAtributoGLSL(glsl, 0, 3, 0);
+    defineAtributoGLSL(glsl, 1, 4, 3);
+    defineAtributoGLSL(glsl, 2, 2, 7);
+    ProgramaCPU programa;
+    configuraProgramaCPU(glsl, programa);
+
+    // Atributos pseudo-aleatorios entre -1 e 1.
+    const unsigned int numVertices = 1 << 20;
+    const unsigned int stride = 9;
+    std::vector<float> vertices((size_t)numVertices * stride);
+    unsigned int semente = 3;
+    for (float& v : vertices) {
+        v = (float)aleatorio(semente) / 8388608.0f - 1.0f;
+    }
+
+    std::vector<VerticeTransformado> transformados(numVertices);
+    double inicio = tempoAtualMs();
+    transformaVertices(programa, vertices.data(), stride, nullptr, numVertices, transformados.data());
+    double tempoVertex = tempoAtualMs() - inicio;
+
+    // Fragment shader: as varyings de cada lote vêm dos vertices transformados.
+    const unsigned int numLotes = numVertices / fragmentosPorLote;
+    LoteFragmentos lote;
+    lote.vivos = 0xFF;
+    float soma = 0.0f;
+    inicio = tempoAtualMs();
+    for (unsigned int i = 0; i < numLotes; i++) {
+        for (int v = 0; v < glsl.numVaryings; v++) {
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                lote.varyings[v].v[l] = transformados[(size_t)i * fragmentosPorLote + l].varyings[v];
+            }
+        }
+        programa.fragmentLote(lote, programa.uniforms);
+        soma += lote.cor.x.v[0];
+    }
+    double tempoFragment = tempoAtualMs() - inicio;
+
+    const ShaderBytecode* shaders[2] = { &glsl.vertex, &glsl.fragment };
+    const double tempos[2] = { tempoVertex, tempoFragment };
+    const char* nomes[2] = { "Vertex shader", "Fragment shader" };
+    for (int s = 0; s < 2; s++) {
+        double invocacoesPorSegundo = numVertices / (tempos[s] / 1000.0);
+        std::cout << std::left << std::setw(18) << nomes[s]
+                  << shaders[s]->instrucoes.size() << " instruções, " << shaders[s]->numRegistros << " registradores, "
+                  << invocacoesPorSegundo / 1e6 << " M invocações/s, "
+                  << invocacoesPorSegundo * shaders[s]->instrucoes.size() / 1e9 << " G instruções/s" << std::endl;
+    }
+
+    // Evita que o compilador descarte o laço do fragment shader.
+    if (soma == 12345.0f) {
+        std::cout << soma << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Vertex shader da esfera: posição multiplicada pela matriz e a normal (igual à posição) como cor.
+struct UniformsEsfera {
+    float mvp[16];         // Por coluna, como no glUniformMatrix4fv.
+};
+
+static void vertexShaderEsferaCPU(const float* atributos, const void* uniforms, float* posicao, float* varyings)
+{
+    const float* m = static_cast<const UniformsEsfera*>(uniforms)->mvp;
+    for (int i = 0; i < 4; i++) {
+        posicao[i] = m[i] * atributos[0] + m[4 + i] * atributos[1] + m[8 + i] * atributos[2] + m[12 + i];
+    }
+    for (int i = 0; i < 3; i++) {
+        varyings[i] = atributos[i] * 0.5f + 0.5f;
+    }
+}
+
+struct VertexShaderEsferaLote {
+    typedef UniformsEsfera Uniforms;
+    static const int numAtributos = 3;
+    static const int numVaryings = 3;
+
+    static void executa(LoteVertices& lote, const Uniforms* uniforms)
+    {
+        const float* m = uniforms->mvp;
+        const FloatLote& x = lote.atributos[0];
+        const FloatLote& y = lote.atributos[1];
+        const FloatLote& z = lote.atributos[2];
+        lote.posicao.x = x * m[0] + y * m[4] + z * m[8] + m[12];
+        lote.posicao.y = x * m[1] + y * m[5] + z * m[9] + m[13];
+        lote.posicao.z = x * m[2] + y * m[6] + z * m[10] + m[14];
+        lote.posicao.w = x * m[3] + y * m[7] + z * m[11] + m[15];
+        for (int i = 0; i < 3; i++) {
+            lote.varyings[i] = lote.atributos[i] * 0.5f + 0.5f;
+        }
+    }
+};
+
+// Estagio de vertices da rasterização em tiles: invocações do vertex shader por triângulo com o cache de
+// vertices transformados (comparadas com o ACMR do cache FIFO) e vazão do vertex shader escalar e em lote.
+static void benchmarkEstagioVertices()
+{
+    std::cout << "== Estagio de vertices (cache de mapeamento direto com " << tamanhoCacheTransformados << " entradas) ==" << std::endl;
+
+    // Rotação em y, escala de 0.9 e z entre -0.5 e 0.5.
+    UniformsEsfera uniforms = {};
+    const float angulo = 0.5f;
+    uniforms.mvp[0] = 0.9f * std::cos(angulo);
+    uniforms.mvp[2] = -0.5f * std::sin(angulo);
+    uniforms.mvp[5] = 0.9f;
+    uniforms.mvp[8] = 0.9f * std::sin(angulo);
+    uniforms.mvp[10] = 0.5f * std::cos(angulo);
+    uniforms.mvp[15] = 1.0f;
+
+    ProgramaCPU programa;
+    programa.vertex = vertexShaderEsferaCPU;
+    programa.vertexLote = executaShaderVerticeLote<VertexShaderEsferaLote>;
+    programa.fragment = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+    programa.uniforms = &uniforms;
+
+    EstadoRasterizacao estado;
+    estado.testeProfundidade = true;
+    FramebufferCPU framebuffer;
+    redimensionaFramebuffer(framebuffer, 1920, 1080);
+    PoolThreads pool(std::max(1u, std::thread::hardware_concurrency()));
+    BinsTiles bins;
+
+    // A mesma esfera na ordem de geração, otimizada para o cache e embaralhada.
+    const char* nomes[3] = { "Esfera original", "Esfera otimizada", "Esfera embaralhada" };
+    MalhaIndexada malha;
+    for (int modo = 0; modo < 3; modo++) {
+        geraMalhaEsfera(malha, 512, 256);
+        if (modo == 1) {
+            otimizaMalha(malha);
+        }
+        else if (modo == 2) {
+            embaralhaTriangulos(malha.indices.data(), malha.indices.size(), 77);
+        }
+        unsigned int numVertices = (unsigned int)(malha.vertices.size() / 3);
+        unsigned int numIndices = (unsigned int)malha.indices.size();
+        float acmr = calculaACMR(malha.indices.data(), numIndices, numVertices);
+
+        const int quadros = 3;
+        EstatisticasRasterizacao estatisticas;
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            limpaFramebuffer(framebuffer, 0.0f, 0.0f, 0.0f, 1.0f);
+            desenhaTriangulosTiles(framebuffer, programa, estado, malha.vertices.data(), 3, numVertices,
+                                   malha.indices.data(), numIndices, pool, bins, &estatisticas);
+        }
+        double tempo = (tempoAtualMs() - inicio) / quadros;
+
+        std::cout << std::left << std::setw(20) << nomes[modo] << (double)estatisticas.invocacoesVertex / (double)estatisticas.triangulos
+                  << " invocações/triângulo (ACMR FIFO " << acmr << ", sem cache 3.0), " << tempo << " ms/quadro" << std::endl;
+    }
+
+    // Vazão: todos os vertices da esfera, um vertice por chamada, em lotes de 8 e em lotes divididos entre as threads.
+    unsigned int numVertices = (unsigned int)(malha.vertices.size() / 3);
+    std::vector<VerticeTransformado> transformados(numVertices);
+    ProgramaCPU escalar = programa;
+    escalar.vertexLote = nullptr;
+
+    const int repeticoes = 10;
+    const unsigned int verticesPorTarefa = 4096;
+    unsigned int numTarefas = (numVertices + verticesPorTarefa - 1) / verticesPorTarefa;
+    const char* modos[3] = { "Escalar", "Lote de 8", "Lote de 8 + threads" };
+    for (int modo = 0; modo < 3; modo++) {
+        double inicio = tempoAtualMs();
+        for (int r = 0; r < repeticoes; r++) {
+            if (modo == 0) {
+                transformaVertices(escalar, malha.vertices.data(), 3, nullptr, numVertices, transformados.data());
+            }
+            else if (modo == 1) {
+                transformaVertices(programa, malha.vertices.data(), 3, nullptr, numVertices, transformados.data());
+            }
+            else {
+                pool.paraCada(numTarefas, [&](unsigned int tarefa, unsigned int) {
+                    unsigned int primeiro = tarefa * verticesPorTarefa;
+                    unsigned int quantidade = std::min(numVertices - primeiro, verticesPorTarefa);
+                    transformaVertices(programa, &malha.vertices[(size_t)primeiro * 3], 3, nullptr, quantidade, &transformados[primeiro]);
+                });
+            }
+        }
+        double tempo = (tempoAtualMs() - inicio) / repeticoes;
+
+        std::cout << std::left << std::setw(20) << modos[modo] << tempo << " ms para " << numVertices << " vertices, "
+                  << numVertices / (tempo * 1000.0) << " M vertices/s" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Bytes do framebuffer sem multiamostragem (cor, profundidade e profundidade hierarquica).
+static size_t bytesFramebuffer(const FramebufferCPU& framebuffer)
+{
+    return framebuffer.cor.size() * sizeof(uint32_t) + framebuffer.profundidade.size() * sizeof(float)
+         + (framebuffer.minimoBloco.size() + framebuffer.maximoBloco.size() + framebuffer.maximoTile.size()) * sizeof(float);
+}
+
+// Resolve do SSAA 4x: media de cada bloco de 2x2 pixels da imagem grande.
+static void reduzSuperAmostragem(const FramebufferCPU& grande, FramebufferCPU& destino)
+{
+    for (int y = 0; y < destino.altura; y++) {
+        const uint32_t* linha0 = &grande.cor[(size_t)(2 * y) * grande.largura];
+        const uint32_t* linha1 = linha0 + grande.largura;
+        for (int x = 0; x < destino.largura; x++) {
+            const uint32_t amostras[4] = { linha0[2 * x], linha0[2 * x + 1], linha1[2 * x], linha1[2 * x + 1] };
+            uint32_t resultado = 0;
+            for (int c = 0; c < 4; c++) {
+                uint32_t soma = 2;
+                for (int s = 0; s < 4; s++) {
+                    soma += (amostras[s] >> (c * 8)) & 0xFF;
+                }
+                resultado |= (soma / 4) << (c * 8);
+            }
+            destino.cor[(size_t)y * destino.largura + x] = resultado;
+        }
+    }
+}
+
+// MSAA 4x (sombreia uma vez por pixel, cor e profundidade comprimidas) contra SSAA 4x (imagem 2x2 maior reduzida) em 1080p:
+// tempo por quadro, memoria e fragmentos sombreados. A diferença media para o SSAA mostra que a borda fica igual.
+static void benchmarkMultiAmostragem()
+{
+    std::cout << "== Multiamostragem (1920x1080, 4 camadas de tela cheia + 50 mil triângulos) ==" << std::endl;
+
+    std::vector<float> cena, triangulos;
+    geraCenaTelaCheia(cena, 4);
+    geraCenaTriangulos(triangulos, 50000, 0.05f, 9);
+    cena.insert(cena.end(), triangulos.begin(), triangulos.end());
+
+    DescricaoMalha malha;
+    malha.vertices = cena.data();
+    malha.numVertices = (unsigned int)(cena.size() / 6);
+    malha.stride = 6;
+
+    DescricaoPrograma programa;
+    programa.vertexCPU = vertexShaderCorCPU;
+    programa.fragmentCPU = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    const int largura = 1920, altura = 1080;
+    const char* nomes[3] = { "Sem AA", "MSAA 4x", "SSAA 4x" };
+    std::vector<uint32_t> imagens[3];
+    size_t bytesTotais[3];
+    FramebufferCPU reduzido;
+    redimensionaFramebuffer(reduzido, largura, altura);
+
+    for (int modo = 0; modo < 3; modo++) {
+        BackendCPU backend;
+        unsigned int idMalha = backend.criaMalha(malha);
+        unsigned int idPrograma = backend.criaPrograma(programa);
+        backend.defineViewport(modo == 2 ? 2 * largura : largura, modo == 2 ? 2 * altura : altura);
+        backend.defineTesteProfundidade(true);
+        backend.defineMultiAmostragem(modo == 1);
+
+        const int quadros = 3;
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            backend.limpa(0.0f, 0.0f, 0.0f, 1.0f);
+            backend.desenha(idPrograma, idMalha);
+            backend.finalizaQuadro();
+            if (modo == 2) {
+                reduzSuperAmostragem(backend.framebuffer(), reduzido);
+            }
+        }
+        double tempo = (tempoAtualMs() - inicio) / quadros;
+
+        // Com MSAA o framebuffer() só recebe o resolve (a cor); a profundidade é a das amostras.
+        const FramebufferCPU& quadro = backend.framebuffer();
+        size_t bytesCor = quadro.cor.size() * sizeof(uint32_t);
+        size_t bytesProfundidade = bytesFramebuffer(quadro) - bytesCor;
+        if (modo == 1) {
+            bytesCor += bytesCorMSAA(backend.framebufferMSAA());
+            bytesProfundidade = bytesProfundidadeMSAA(backend.framebufferMSAA());
+        }
+        imagens[modo] = modo == 2 ? reduzido.cor : quadro.cor;
+        bytesTotais[modo] = bytesCor + bytesProfundidade;
+
+        std::cout << std::left << std::setw(10) << nomes[modo] << tempo << " ms/quadro, cor " << bytesCor / (1024.0 * 1024.0)
+                  << " MB, profundidade " << bytesProfundidade / (1024.0 * 1024.0) << " MB, "
+                  << backend.estatisticas().fragmentos / quadros << " fragmentos sombreados";
+        if (modo == 1) {
+            size_t expandidos = pixelsExpandidosMSAA(backend.framebufferMSAA());
+            size_t expandidosZ = pixelsProfundidadeExpandidaMSAA(backend.framebufferMSAA());
+            std::cout << ", " << expandidos << " pixels expandidos (" << 100.0 * expandidos / ((double)largura * altura) << "%), "
+                      << expandidosZ << " com a profundidade expandida (" << 100.0 * expandidosZ / ((double)largura * altura) << "%)";
+        }
+        std::cout << std::endl;
+    }
+
+    // Diferença media por canal (0 a 255) para a imagem do SSAA.
+    for (int modo = 0; modo < 2; modo++) {
+        double soma = 0.0;
+        for (size_t i = 0; i < imagens[modo].size(); i++) {
+            for (int c = 0; c < 3; c++) {
+                soma += std::abs((int)((imagens[modo][i] >> (c * 8)) & 0xFF) - (int)((imagens[2][i] >> (c * 8)) & 0xFF));
+            }
+        }
+        std::cout << nomes[modo] << " contra SSAA 4x: diferença media de " << soma / (imagens[modo].size() * 3.0) << " por canal" << std::endl;
+    }
+    std::cout << "Memoria total: MSAA 4x " << bytesTotais[1] / (1024.0 * 1024.0) << " MB, SSAA 4x " << bytesTotais[2] / (1024.0 * 1024.0)
+              << " MB (" << 100.0 * bytesTotais[1] / bytesTotais[2] << "%)" << std::endl;
+
+    std::cout << std::endl;
+}
+
+static void benchmarkGravacaoQuadros()
+{
+    const int largura = 3840, altura = 2160;
+    std::cout << "== Gravação de quadros (" << largura << "x" << altura << ", tela cheia + 20 mil triângulos, sem gravar no disco) ==" << std::endl;
+
+    std::vector<float> cena, triangulos;
+    geraCenaTelaCheia(cena, 2);
+    geraCenaTriangulos(triangulos, 20000, 0.05f, 11);
+    cena.insert(cena.end(), triangulos.begin(), triangulos.end());
+
+    DescricaoMalha malha;
+    malha.vertices = cena.data();
+    malha.numVertices = (unsigned int)(cena.size() / 6);
+    malha.stride = 6;
+
+    DescricaoPrograma programa;
+    programa.vertexCPU = vertexShaderCorCPU;
+    programa.fragmentCPU = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    BackendCPU backend;
+    unsigned int idMalha = backend.criaMalha(malha);
+    unsigned int idPrograma = backend.criaPrograma(programa);
+    backend.defineViewport(largura, altura);
+    backend.defineTesteProfundidade(true);
+    backend.defineCaptura(true);
+
+    // Só a codificação, numa thread, para ter o custo por quadro de cada formato.
+    backend.limpa(0.0f, 0.0f, 0.0f, 1.0f);
+    backend.desenha(idPrograma, idMalha);
+    backend.finalizaQuadro();
+    const FramebufferCPU& quadro = backend.framebuffer();
+    double bytesRGB = (double)largura * altura * 3;
+    const FormatoImagem formatos[2] = { imagemPNG, imagemEXR };
+    for (FormatoImagem formato : formatos) {
+        std::vector<uint8_t> arquivo;
+        double inicio = tempoAtualMs();
+        codificaImagem(formato, quadro.cor.data(), largura, altura, arquivo);
+        double tempo = tempoAtualMs() - inicio;
+        // O EXR guarda 2 bytes por canal: a razão é sobre o tamanho sem compressão de cada formato.
+        double bruto = formato == imagemEXR ? 2.0 * bytesRGB : bytesRGB;
+        std::cout << std::left << std::setw(26) << (formato == imagemEXR ? "Codifica EXR (1 thread)" : "Codifica PNG (1 thread)")
+                  << tempo << " ms, " << arquivo.size() / (1024.0 * 1024.0) << " MB (" << 100.0 * arquivo.size() / bruto
+                  << "% do original), " << bytesRGB / (1024.0 * 1024.0) / (tempo / 1000.0) << " MB/s de pixels" << std::endl;
+    }
+    std::vector<uint32_t> descarte;
+    int w, h;
+    backend.lePixels(descarte, w, h, false);
+
+    // Laço completo: renderização + leitura + codificação.
+    const char* nomes[4] = { "Só renderização", "PNG sincrono", "PNG em segundo plano", "EXR em segundo plano" };
+    const int quadros = 6;
+    for (int modo = 0; modo < 4; modo++) {
+        GravadorQuadros gravador;
+        std::vector<uint8_t> arquivo;
+
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            backend.limpa(0.0f, 0.0f, 0.0f, 1.0f);
+            backend.desenha(idPrograma, idMalha);
+            backend.finalizaQuadro();
+
+            std::vector<uint32_t> pixels = gravador.bufferLivre();
+            backend.lePixels(pixels, w, h, true);
+            if (modo == 1) {
+                codificaPNG(pixels.data(), w, h, arquivo);
+            }
+            else if (modo >= 2) {
+                gravador.enfileira(std::move(pixels), w, h, modo == 3 ? imagemEXR : imagemPNG, std::string());
+            }
+        }
+        gravador.esperaTodos();
+        double tempo = tempoAtualMs() - inicio;
+
+        std::cout << std::left << std::setw(26) << nomes[modo] << 1000.0 * quadros / tempo << " quadros/s ("
+                  << tempo / quadros << " ms/quadro";
+        if (modo >= 2) {
+            std::cout << ", " << gravador.numThreads() << " thread(s) de codificação";
+        }
+        std::cout << ")" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Tempo medio por operação (ns) de "repeticoes" execuções de "executa", que faz "operacoes" operações.
+template <class Funcao>
+static double nsPorOperacao(Funcao executa, size_t operacoes, int repeticoes)
+{
+    executa();
+    double inicio = tempoAtualMs();
+    for (int r = 0; r < repeticoes; r++) {
+        executa();
+    }
+    return (tempoAtualMs() - inicio) * 1.0e6 / ((double)operacoes * repeticoes);
+}
+
+static void imprimeTempoMatematica(const char* nome, double referencia, double simd, double lote)
+{
+    std::cout << std::left << std::setw(28) << nome << "escalar " << referencia << " ns, " << nomeMatematicaSIMD()
+              << " " << simd << " ns (" << referencia / simd << "x)";
+    if (lote > 0.0) {
+        std::cout << ", lote AVX2 " << lote << " ns (" << referencia / lote << "x)";
+    }
+    std::cout << std::endl;
+}
+
+static void benchmarkMatematica()
+{
+    bool avx2 = SIMD_X86 && recursosCPU().avx2 && recursosCPU().fma;
+    std::cout << "== Matematica (" << nomeMatematicaSIMD() << (avx2 ? ", lotes com AVX2+FMA" : "") << ") ==" << std::endl;
+
+    // Matrizes de transformação com escala e rotação variadas (inversiveis e bem condicionadas).
+    const size_t numMatrizes = 1024;
+    std::vector<Mat4> a(numMatrizes), b(numMatrizes), produto(numMatrizes);
+    unsigned int semente = 21;
+    for (size_t i = 0; i < numMatrizes; i++) {
+        float v[7];
+        for (int k = 0; k < 7; k++) {
+            v[k] = (float)(aleatorio(semente) % 2000) / 1000.0f - 1.0f;
+        }
+        a[i] = translacao(Vec3(v[0], v[1], v[2])) * rotacao(v[3] * 3.0f, Vec3(v[4], v[5], 1.0f)) * escala(Vec3(1.5f + v[6], 1.0f, 2.0f));
+        b[i] = perspectiva(0.8f + 0.2f * v[0], 1.5f, 0.1f, 100.0f) * olharPara(Vec3(v[1], v[2], 5.0f), Vec3(0, 0, 0), Vec3(0, 1, 0));
+    }
+
+    // mat4 x mat4
+    double referencia = nsPorOperacao([&] {
+        for (size_t i = 0; i < numMatrizes; i++) produto[i] = multiplicaReferencia(a[i], b[i]);
+    }, numMatrizes, 2000);
+    double simd = nsPorOperacao([&] {
+        for (size_t i = 0; i < numMatrizes; i++) produto[i] = a[i] * b[i];
+    }, numMatrizes, 2000);
+    double lote = 0.0;
+#if MATEMATICA_SSE
+    if (avx2) {
+        lote = nsPorOperacao([&] { multiplicaLoteMat4AVX2(a.data(), b.data(), produto.data(), numMatrizes); }, numMatrizes, 2000);
+    }
+#endif
+    imprimeTempoMatematica("mat4 x mat4", referencia, simd, lote);
+
+    // mat4 x vec4 em lote (1 MB de vetores, maior que a L2)
+    const size_t numVetores = 1 << 16;
+    std::vector<Vec4> vetores(numVetores), transformados(numVetores);
+    for (size_t i = 0; i < numVetores; i++) {
+        vetores[i] = Vec4((float)(i % 37), (float)(i % 101) * 0.5f, (float)(i % 13) - 6.0f, 1.0f);
+    }
+    const Mat4 m = b[0];
+    referencia = nsPorOperacao([&] {
+        for (size_t i = 0; i < numVetores; i++) transformados[i] = transformaReferencia(m, vetores[i]);
+    }, numVetores, 100);
+    simd = nsPorOperacao([&] {
+        for (size_t i = 0; i < numVetores; i++) transformados[i] = m * vetores[i];
+    }, numVetores, 100);
+    lote = 0.0;
+#if MATEMATICA_SSE
+    if (avx2) {
+        lote = nsPorOperacao([&] { transformaLoteVec4AVX2(m, vetores.data(), transformados.data(), numVetores); }, numVetores, 100);
+    }
+#endif
+    imprimeTempoMatematica("mat4 x vec4 (lote de 64K)", referencia, simd, lote);
+
+    // Inversa, com o erro de a * inversa(a) para a identidade.
+    std::vector<Mat4> inversas(numMatrizes);
+    referencia = nsPorOperacao([&] {
+        for (size_t i = 0; i < numMatrizes; i++) inversas[i] = inversaReferencia(a[i]);
+    }, numMatrizes, 2000);
+    simd = nsPorOperacao([&] {
+        for (size_t i = 0; i < numMatrizes; i++) inversas[i] = inversa(a[i]);
+    }, numMatrizes, 2000);
+    imprimeTempoMatematica("inversa", referencia, simd, 0.0);
+
+    float erro = 0.0f;
+    const Mat4 identidade = identidadeMat4();
+    for (size_t i = 0; i < numMatrizes; i++) {
+        Mat4 p = a[i] * inversas[i];
+        for (int c = 0; c < 4; c++) {
+            Vec4 d = p.c[c] - identidade.c[c];
+            erro = std::max(erro, std::max(std::max(std::fabs(d.x), std::fabs(d.y)), std::max(std::fabs(d.z), std::fabs(d.w))));
+        }
+    }
+    std::cout << "Erro maximo de a * inversa(a): " << erro << std::endl;
+
+    std::cout << std::endl;
+}
+
+// Composição de 1 milhão de transformações (posição, quaternion e escala em SoA) nas matrizes 3x4 das
+// instâncias, a cada quadro e numa thread so. Também mede um lote que cabe na cache, para separar o custo
+// das contas do custo de memoria (44 bytes lidos e 52 escritos por objeto).
+static void benchmarkTransformacoes()
+{
+    std::cout << "== Transformações SoA: 1 milhão de objetos, 1 thread ==" << std::endl;
+
+    const size_t numObjetos = 1000000;
+    const size_t objetosCache = 4096;
+    TransformacoesSoA transformacoes;
+    redimensionaTransformacoes(transformacoes, numObjetos);
+    unsigned int semente = 42;
+    for (size_t i = 0; i < numObjetos; i++) {
+        float v[8];
+        for (int k = 0; k < 8; k++) {
+            v[k] = (float)(aleatorio(semente) % 2000) / 1000.0f - 1.0f;
+        }
+        Quat rotacao = quatEixoAngulo(normaliza(Vec3(v[3], v[4], 1.0f)), v[5] * 3.0f);
+        defineTransformacao(transformacoes, i, Vec3(v[0] * 100.0f, v[1] * 100.0f, v[2] * 100.0f), rotacao,
+                            Vec3(1.5f + v[6], 1.0f + 0.5f * v[7], 0.5f));
+        transformacoes.cor[i] = semente;
+    }
+    std::vector<InstanciaTriangulo> instancias(numObjetos);
+
+    NivelSIMD original = nivelTransformacoes();
+    std::streamsize precisao = std::cout.precision();
+    const NivelSIMD niveis[] = { simdEscalar, simdAVX2 };
+    for (NivelSIMD nivel : niveis) {
+        if (nivel > melhorNivelSIMD()) {
+            continue;
+        }
+        selecionaNivelTransformacoes(nivel);
+
+        // O primeiro quadro também serve para as paginas do destino já estarem mapeadas.
+        compoeInstancias(transformacoes, 0, numObjetos, instancias.data());
+        const int quadros = 20;
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            compoeInstancias(transformacoes, 0, numObjetos, instancias.data());
+        }
+        double msQuadro = (tempoAtualMs() - inicio) / quadros;
+
+        const int repeticoes = 2000;
+        inicio = tempoAtualMs();
+        for (int r = 0; r < repeticoes; r++) {
+            compoeInstancias(transformacoes, 0, objetosCache, instancias.data());
+        }
+        double nsCache = (tempoAtualMs() - inicio) * 1e6 / ((double)repeticoes * objetosCache);
+
+        compoeInstancias(transformacoes, 0, numObjetos, instancias.data());
+        float erro = 0.0f;
+        for (size_t i = 0; i < numObjetos; i++) {
+            const Mat4 matriz = matrizTransformacao(transformacoes, i);
+            const float* referencia = matriz.dados();
+            for (int linha = 0; linha < 3; linha++) {
+                for (int coluna = 0; coluna < 4; coluna++) {
+                    float d = instancias[i].transformacao[linha * 4 + coluna] - referencia[coluna * 4 + linha];
+                    erro = std::max(erro, std::fabs(d));
+                }
+            }
+        }
+
+        std::cout << std::left << std::setw(8) << nomeNivelSIMD(nivel) << std::right << std::fixed << std::setprecision(2)
+                  << msQuadro << " ms/quadro (" << numObjetos * 96.0 / (msQuadro * 1e6) << " GB/s), em cache "
+                  << nsCache << " ns/objeto, erro maximo " << std::defaultfloat << erro << std::endl;
+    }
+    selecionaNivelTransformacoes(original);
+    std::cout << std::setprecision(precisao);
+
+    std::cout << std::endl;
+}
+
+// Hierarquia de 500 mil nós (arvore aleatoria: cada nó é filho de um nó anterior qualquer). Mede a
+// atualização completa e a de 1% dos nós mudando por quadro, com 1 thread e com todas, e compara o
+// resultado incremental com uma atualização completa feita do zero.
+static void benchmarkHierarquia()
+{
+    std::cout << "== Hierarquia de cena: 500 mil nós, 1% mudando por quadro ==" << std::endl;
+
+    const uint32_t numNos = 500000;
+    const uint32_t mudancasPorQuadro = numNos / 100;
+    unsigned int semente = 7;
+    auto localAleatorio = [&semente]() {
+        float angulo = (float)(aleatorio(semente) % 6283) / 1000.0f;
+        Vec3 posicao((float)(aleatorio(semente) % 200) / 100.0f - 1.0f, (float)(aleatorio(semente) % 200) / 100.0f - 1.0f, 0.5f);
+        return translacao(posicao) * rotacao(angulo, Vec3(0.0f, 1.0f, 1.0f));
+    };
+
+    HierarquiaCena cena;
+    adicionaNo(cena, semPai, identidadeMat4());
+    for (uint32_t i = 1; i < numNos; i++) {
+        adicionaNo(cena, (int32_t)(aleatorio(semente) % i), localAleatorio());
+    }
+    double inicio = tempoAtualMs();
+    organizaHierarquia(cena);
+    std::cout << "Organização em largura: " << tempoAtualMs() - inicio << " ms, " << numNiveis(cena) << " niveis" << std::endl;
+
+    // Uma lista de mudanças por quadro, a mesma para todas as medições.
+    const int quadros = 20;
+    std::vector<uint32_t> nosMudados(quadros * mudancasPorQuadro);
+    std::vector<Mat4> locaisMudados(nosMudados.size());
+    for (size_t i = 0; i < nosMudados.size(); i++) {
+        nosMudados[i] = aleatorio(semente) % numNos;
+        locaisMudados[i] = localAleatorio();
+    }
+
+    std::vector<unsigned int> numThreads = { 1 };
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (maxThreads > 1) {
+        numThreads.push_back(maxThreads);
+    }
+
+    for (unsigned int threads : numThreads) {
+        PoolThreads pool(threads);
+        PoolThreads* usado = threads > 1 ? &pool : nullptr;
+
+        HierarquiaCena copia = cena;
+        inicio = tempoAtualMs();
+        size_t completas = atualizaHierarquia(copia, usado);
+        double tempoCompleta = tempoAtualMs() - inicio;
+
+        size_t recalculadas = 0;
+        inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            for (uint32_t k = 0; k < mudancasPorQuadro; k++) {
+                size_t m = (size_t)q * mudancasPorQuadro + k;
+                defineLocal(copia, nosMudados[m], locaisMudados[m]);
+            }
+            recalculadas += atualizaHierarquia(copia, usado);
+        }
+        double tempoIncremental = (tempoAtualMs() - inicio) / quadros;
+
+        // Referencia: todos os nós sujos de uma vez, com os locais finais.
+        HierarquiaCena referencia = copia;
+        std::fill(referencia.sujo.begin(), referencia.sujo.end(), (uint8_t)1);
+        atualizaHierarquia(referencia);
+        size_t diferentes = 0;
+        for (uint32_t i = 0; i < numNos; i++) {
+            if (std::memcmp(&copia.mundo[i], &referencia.mundo[i], sizeof(Mat4)) != 0) {
+                diferentes++;
+            }
+        }
+
+        std::cout << std::right << std::setw(3) << threads << std::left << " threads: completa " << tempoCompleta << " ms ("
+                  << completas << " matrizes), 1% sujo " << tempoIncremental << " ms/quadro (" << recalculadas / quadros
+                  << " matrizes), " << diferentes << " diferenças" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Descarte pelo frustum de 1 milhão de objetos espalhados num cubo de 1000 unidades em volta da camera,
+// com esferas e com caixas, escalar contra AVX2 e com varias threads. Depois a lista de visiveis é usada
+// para compor as matrizes das instâncias, como no desenho.
+static void benchmarkDescarteFrustum()
+{
+    std::cout << "== Descarte pelo frustum: 1 milhão de objetos ==" << std::endl;
+
+    const size_t numObjetos = 1000000;
+    VolumesEnvolventes volumes;
+    redimensionaVolumes(volumes, numObjetos);
+    TransformacoesSoA transformacoes;
+    redimensionaTransformacoes(transformacoes, numObjetos);
+    unsigned int semente = 99;
+    for (size_t i = 0; i < numObjetos; i++) {
+        float v[4];
+        for (int k = 0; k < 4; k++) {
+            v[k] = (float)(aleatorio(semente) % 20000) / 10000.0f - 1.0f;
+        }
+        Vec3 centro(v[0] * 500.0f, v[1] * 500.0f, v[2] * 500.0f);
+        Vec3 meiaExtensao(1.5f + v[3], 1.0f, 1.5f - v[3]);
+        if (i % 2 == 0) {
+            defineEsfera(volumes, i, centro, comprimento(meiaExtensao));
+        }
+        else {
+            defineCaixa(volumes, i, centro - meiaExtensao, centro + meiaExtensao);
+        }
+        defineTransformacao(transformacoes, i, centro, Quat(), meiaExtensao);
+    }
+
+    Mat4 projecaoVisao = perspectiva(1.0f, 16.0f / 9.0f, 0.1f, 300.0f) * olharPara(Vec3(0, 0, 0), Vec3(0.3f, 0.1f, -1.0f), Vec3(0, 1, 0));
+    Frustum frustum = extraiFrustum(projecaoVisao);
+
+    std::vector<uint32_t> visiveis(numObjetos), referencia(numObjetos);
+    const int quadros = 10;
+    const char* nomesTipo[] = { "esferas", "caixas" };
+    NivelSIMD original = nivelDescarte();
+    for (TipoVolume tipo : { volumeEsfera, volumeCaixa }) {
+        selecionaNivelDescarte(simdEscalar);
+        size_t numReferencia = descartaFrustum(frustum, volumes, tipo, 0, numObjetos, referencia.data());
+
+        const NivelSIMD niveis[] = { simdEscalar, simdAVX2 };
+        for (NivelSIMD nivel : niveis) {
+            if (nivel > melhorNivelSIMD()) {
+                continue;
+            }
+            selecionaNivelDescarte(nivel);
+
+            size_t numVisiveis = 0;
+            double inicio = tempoAtualMs();
+            for (int q = 0; q < quadros; q++) {
+                numVisiveis = descartaFrustum(frustum, volumes, tipo, 0, numObjetos, visiveis.data());
+            }
+            double tempo = (tempoAtualMs() - inicio) / quadros;
+            bool igual = numVisiveis == numReferencia && std::equal(visiveis.begin(), visiveis.begin() + numVisiveis, referencia.begin());
+
+            std::cout << std::left << std::setw(8) << nomesTipo[tipo] << std::setw(8) << nomeNivelSIMD(nivel) << tempo << " ms/quadro, "
+                      << numVisiveis << " visiveis" << (igual ? "" : " (lista diferente do escalar!)") << std::endl;
+        }
+    }
+    selecionaNivelDescarte(original);
+
+    // 1, 2, 4, ... até o numero de nucleos da maquina, com o melhor nivel. A lista tem que ser a mesma.
+    std::vector<unsigned int> numThreads;
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2) {
+        numThreads.push_back(threads);
+    }
+    numThreads.push_back(maxThreads);
+    size_t numReferencia = descartaFrustum(frustum, volumes, volumeCaixa, 0, numObjetos, referencia.data());
+    for (unsigned int threads : numThreads) {
+        PoolThreads pool(threads);
+        size_t numVisiveis = 0;
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            numVisiveis = descartaFrustumParalelo(frustum, volumes, volumeCaixa, visiveis.data(), pool);
+        }
+        double tempo = (tempoAtualMs() - inicio) / quadros;
+        bool igual = numVisiveis == numReferencia && std::equal(visiveis.begin(), visiveis.begin() + numVisiveis, referencia.begin());
+        std::cout << "caixas, " << std::right << std::setw(3) << threads << std::left << " threads: " << tempo << " ms/quadro, "
+                  << numVisiveis << " visiveis" << (igual ? "" : " (lista diferente de 1 thread!)") << std::endl;
+    }
+
+    // Caminho do desenho: só as instâncias visiveis são compostas (e seriam enviadas).
+    size_t numVisiveis = descartaFrustum(frustum, volumes, volumeCaixa, 0, numObjetos, visiveis.data());
+    std::vector<InstanciaTriangulo> instancias(numObjetos);
+    compoeInstanciasLista(transformacoes, visiveis.data(), numVisiveis, instancias.data());
+    double inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        numVisiveis = descartaFrustum(frustum, volumes, volumeCaixa, 0, numObjetos, visiveis.data());
+        compoeInstanciasLista(transformacoes, visiveis.data(), numVisiveis, instancias.data());
+    }
+    double tempoVisiveis = (tempoAtualMs() - inicio) / quadros;
+    inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        compoeInstancias(transformacoes, 0, numObjetos, instancias.data());
+    }
+    double tempoTodos = (tempoAtualMs() - inicio) / quadros;
+    std::cout << "Descarte + composição das visiveis: " << tempoVisiveis << " ms/quadro, composição de todos: "
+              << tempoTodos << " ms/quadro" << std::endl;
+
+    std::cout << std::endl;
+}
+
+static void benchmarkBVH()
+{
+    std::cout << "== BVH: cidade com 1 milhão de prédios ==" << std::endl;
+
+    // Grade de 1000 x 1000 lotes de 10 unidades, cada um com um prédio de base e altura aleatorias.
+    const int lado = 1000;
+    const size_t numObjetos = (size_t)lado * lado;
+    VolumesEnvolventes volumes;
+    redimensionaVolumes(volumes, numObjetos);
+    unsigned int semente = 45;
+    auto intervalo = [&semente](float minimo, float maximo) {
+        return minimo + (maximo - minimo) * (float)(aleatorio(semente) % 10000) / 10000.0f;
+    };
+    for (int z = 0; z < lado; z++) {
+        for (int x = 0; x < lado; x++) {
+            float base = intervalo(3.0f, 8.0f);
+            float altura = intervalo(5.0f, 60.0f);
+            Vec3 canto(x * 10.0f - 5000.0f, 0.0f, z * 10.0f - 5000.0f);
+            defineCaixa(volumes, (size_t)z * lado + x, canto, canto + Vec3(base, altura, base));
+        }
+    }
+
+    // Construção com 1 thread e com todas.
+    std::vector<unsigned int> numThreads = { 1 };
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (maxThreads > 1) {
+        numThreads.push_back(maxThreads);
+    }
+    BVH bvh;
+    for (unsigned int threads : numThreads) {
+        PoolThreads pool(threads);
+        double inicio = tempoAtualMs();
+        constroiBVH(bvh, volumes, &pool);
+        double tempo = tempoAtualMs() - inicio;
+        std::cout << "Construção, " << std::right << std::setw(3) << threads << std::left << " threads: " << tempo << " ms, "
+                  << bvh.nos.size() << " nós, custo SAH " << custoSAH(bvh) << std::endl;
+    }
+
+    // Camera no nivel da rua: a lista tem que ter os mesmos objetos do descarte linear.
+    Mat4 projecaoVisao = perspectiva(1.0f, 16.0f / 9.0f, 0.1f, 800.0f) * olharPara(Vec3(0, 2, 0), Vec3(300.0f, 10.0f, -400.0f), Vec3(0, 1, 0));
+    Frustum frustum = extraiFrustum(projecaoVisao);
+    std::vector<uint32_t> visiveis(numObjetos), referencia(numObjetos);
+    const int quadros = 10;
+    size_t numReferencia = 0, numVisiveis = 0;
+    double inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        numReferencia = descartaFrustum(frustum, volumes, volumeCaixa, 0, numObjetos, referencia.data());
+    }
+    double tempoLinear = (tempoAtualMs() - inicio) / quadros;
+    inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        numVisiveis = descartaFrustumBVH(bvh, volumes, frustum, visiveis.data());
+    }
+    double tempoBVH = (tempoAtualMs() - inicio) / quadros;
+    std::sort(visiveis.begin(), visiveis.begin() + numVisiveis);
+    bool igual = numVisiveis == numReferencia && std::equal(visiveis.begin(), visiveis.begin() + numVisiveis, referencia.begin());
+    std::cout << "Frustum: linear (" << nomeNivelSIMD(nivelDescarte()) << ") " << tempoLinear << " ms, BVH " << tempoBVH << " ms, "
+              << numVisiveis << " visiveis" << (igual ? "" : " (lista diferente do linear!)") << std::endl;
+
+    // Raios pelo cursor em pixels aleatorios de uma janela 1280 x 720; uma amostra é conferida com a
+    // busca por força bruta.
+    const int numRaios = 100000;
+    std::vector<Raio> raios(numRaios);
+    for (Raio& raio : raios) {
+        raio = raioDoCursor(intervalo(0.0f, 1280.0f), intervalo(0.0f, 720.0f), 1280, 720, projecaoVisao);
+    }
+    auto forcaBruta = [&](const Raio& raio) {
+        int32_t melhor = -1;
+        float tMelhor = INFINITY;
+        for (size_t i = 0; i < numObjetos; i++) {
+            float t0 = 0.0f, t1 = tMelhor;
+            const float origem[3] = { raio.origem.x, raio.origem.y, raio.origem.z };
+            const float direcao[3] = { raio.direcao.x, raio.direcao.y, raio.direcao.z };
+            const float centro[3] = { volumes.centroX[i], volumes.centroY[i], volumes.centroZ[i] };
+            const float extensao[3] = { volumes.extensaoX[i], volumes.extensaoY[i], volumes.extensaoZ[i] };
+            for (int eixo = 0; eixo < 3; eixo++) {
+                float a = (centro[eixo] - extensao[eixo] - origem[eixo]) / direcao[eixo];
+                float b = (centro[eixo] + extensao[eixo] - origem[eixo]) / direcao[eixo];
+                t0 = std::max(t0, std::min(a, b));
+                t1 = std::min(t1, std::max(a, b));
+            }
+            if (t0 <= t1 && t0 < tMelhor) {
+                tMelhor = t0;
+                melhor = (int32_t)i;
+            }
+        }
+        return melhor;
+    };
+    int atingidos = 0;
+    inicio = tempoAtualMs();
+    for (const Raio& raio : raios) {
+        atingidos += intersectaRaioBVH(bvh, volumes, raio) >= 0 ? 1 : 0;
+    }
+    double tempoRaios = tempoAtualMs() - inicio;
+    int diferentes = 0;
+    for (int r = 0; r < 20; r++) {
+        diferentes += intersectaRaioBVH(bvh, volumes, raios[r]) != forcaBruta(raios[r]) ? 1 : 0;
+    }
+    std::cout << "Raios: " << numRaios / (tempoRaios / 1000.0) / 1e6 << " milhões/s, " << atingidos << " atingiram algum prédio, "
+              << diferentes << " de 20 diferentes da força bruta" << std::endl;
+
+    // 10% dos prédios se movem um pouco a cada quadro; depois de 30 quadros compara a arvore reajustada
+    // com uma reconstruida.
+    const int quadrosMovimento = 30;
+    double tempoReajuste = 0.0;
+    for (int q = 0; q < quadrosMovimento; q++) {
+        for (size_t i = q % 10; i < numObjetos; i += 10) {
+            volumes.centroX[i] += intervalo(-2.0f, 2.0f);
+            volumes.centroZ[i] += intervalo(-2.0f, 2.0f);
+        }
+        inicio = tempoAtualMs();
+        reajustaBVH(bvh, volumes);
+        tempoReajuste += tempoAtualMs() - inicio;
+    }
+    numVisiveis = descartaFrustumBVH(bvh, volumes, frustum, visiveis.data());
+    numReferencia = descartaFrustum(frustum, volumes, volumeCaixa, 0, numObjetos, referencia.data());
+    std::sort(visiveis.begin(), visiveis.begin() + numVisiveis);
+    igual = numVisiveis == numReferencia && std::equal(visiveis.begin(), visiveis.begin() + numVisiveis, referencia.begin());
+    float custoReajustada = custoSAH(bvh);
+    PoolThreads pool(maxThreads);
+    constroiBVH(bvh, volumes, &pool);
+    std::cout << "Reajuste (10% movidos por quadro): " << tempoReajuste / quadrosMovimento << " ms/quadro, custo SAH "
+              << custoReajustada << " contra " << custoSAH(bvh) << " reconstruida" << (igual ? "" : " (lista diferente do linear!)") << std::endl;
+
+    std::cout << std::endl;
+}
+
+static void benchmarkOclusao()
+{
+    std::cout << "== Descarte por oclusão: cidade com 40 mil prédios, buffer 256x128 ==" << std::endl;
+
+    // Grade de 200 x 200 lotes de 10 unidades; a camera anda pela rua do meio, entre os prédios.
+    const int lado = 200;
+    const size_t numObjetos = (size_t)lado * lado;
+    VolumesEnvolventes volumes;
+    redimensionaVolumes(volumes, numObjetos);
+    unsigned int semente = 46;
+    auto intervalo = [&semente](float minimo, float maximo) {
+        return minimo + (maximo - minimo) * (float)(aleatorio(semente) % 10000) / 10000.0f;
+    };
+    for (int z = 0; z < lado; z++) {
+        for (int x = 0; x < lado; x++) {
+            float base = intervalo(6.0f, 8.0f);
+            float altura = intervalo(5.0f, 60.0f);
+            Vec3 canto(x * 10.0f - 1000.0f + 1.0f, 0.0f, z * 10.0f - 1000.0f + 1.0f);
+            defineCaixa(volumes, (size_t)z * lado + x, canto, canto + Vec3(base, altura, base));
+        }
+    }
+
+    const int quadros = 60;
+    const size_t maxOclusores = 64;
+    std::vector<uint32_t> candidatos(numObjetos), visiveis(numObjetos), oclusores(maxOclusores), referencia;
+    BufferOclusao buffer;
+    redimensionaOclusao(buffer);
+
+    NivelSIMD original = nivelOclusao();
+    const NivelSIMD niveis[] = { simdEscalar, simdAVX2 };
+    for (NivelSIMD nivel : niveis) {
+        if (nivel > melhorNivelSIMD()) {
+            continue;
+        }
+        selecionaNivelOclusao(nivel);
+
+        size_t totalCandidatos = 0, totalVisiveis = 0;
+        uint32_t totalTriangulos = 0;
+        double tempoOclusores = 0.0, tempoTeste = 0.0;
+        std::vector<uint32_t> resultado;
+        for (int q = 0; q < quadros; q++) {
+            // Camera na altura de uma pessoa, andando e girando devagar.
+            float angulo = q * 0.05f;
+            Vec3 camera(0.0f, 2.0f, 400.0f - q * 5.0f);
+            Mat4 projecaoVisao = perspectiva(1.0f, 16.0f / 9.0f, 0.1f, 2000.0f) *
+                                 olharPara(camera, camera + Vec3(std::sin(angulo), 0.0f, -std::cos(angulo)), Vec3(0, 1, 0));
+            Frustum frustum = extraiFrustum(projecaoVisao);
+            size_t numCandidatos = descartaFrustum(frustum, volumes, volumeCaixa, 0, numObjetos, candidatos.data());
+
+            double inicio = tempoAtualMs();
+            limpaOclusao(buffer, projecaoVisao);
+            size_t numOclusores = escolheOclusores(volumes, candidatos.data(), numCandidatos, camera, maxOclusores, oclusores.data());
+            for (size_t k = 0; k < numOclusores; k++) {
+                uint32_t i = oclusores[k];
+                Vec3 centro(volumes.centroX[i], volumes.centroY[i], volumes.centroZ[i]);
+                Vec3 extensao(volumes.extensaoX[i], volumes.extensaoY[i], volumes.extensaoZ[i]);
+                rasterizaCaixaOclusora(buffer, centro - extensao, centro + extensao);
+            }
+            double meio = tempoAtualMs();
+            size_t numVisiveis = descartaOclusao(buffer, volumes, candidatos.data(), numCandidatos, visiveis.data());
+            double fim = tempoAtualMs();
+
+            tempoOclusores += meio - inicio;
+            tempoTeste += fim - meio;
+            totalCandidatos += numCandidatos;
+            totalVisiveis += numVisiveis;
+            totalTriangulos += buffer.triangulosOclusores;
+            resultado.insert(resultado.end(), visiveis.begin(), visiveis.begin() + numVisiveis);
+        }
+        if (referencia.empty()) {
+            referencia = resultado;
+        }
+
+        std::cout << std::left << std::setw(8) << nomeNivelSIMD(nivel) << "oclusores " << tempoOclusores / quadros << " ms + teste "
+                  << tempoTeste / quadros << " ms/quadro, " << totalTriangulos / quadros << " triângulos" << std::endl;
+        std::cout << "        " << totalCandidatos / quadros << " desenhos depois do frustum, " << totalVisiveis / quadros
+                  << " depois da oclusão (" << 100.0 * (totalCandidatos - totalVisiveis) / std::max<size_t>(totalCandidatos, 1)
+                  << "% descartados)" << (resultado == referencia ? "" : " (lista diferente do escalar!)") << std::endl;
+    }
+    selecionaNivelOclusao(original);
+
+    std::cout << std::endl;
+}
+
+// Esfera com ondulações (o simplificador não tem o que fazer numa esfera lisa).
+static void geraEsferaOndulada(MalhaIndexada& malha, unsigned int fatias, unsigned int aneis)
+{
+    geraMalhaEsfera(malha, fatias, aneis);
+    for (size_t v = 0; v < malha.vertices.size() / 3; v++) {
+        float* p = &malha.vertices[v * 3];
+        float theta = std::atan2(p[2], p[0]);
+        float phi = std::acos(std::max(-1.0f, std::min(1.0f, p[1])));
+        float raio = 1.0f + 0.05f * std::sin(8.0f * theta) * std::sin(6.0f * phi);
+        p[0] *= raio;
+        p[1] *= raio;
+        p[2] *= raio;
+    }
+}
+
+static void benchmarkNivelDetalhe()
+{
+    std::cout << "== Niveis de detalhe: simplificação e seleção ==" << std::endl;
+
+    MalhaIndexada malha;
+    geraEsferaOndulada(malha, 256, 128);
+    MalhaLOD lod;
+    double inicio = tempoAtualMs();
+    geraCadeiaLOD(malha, lod, 8);
+    double tempoSimplificacao = tempoAtualMs() - inicio;
+    std::cout << "Simplificação de " << malha.indices.size() / 3 << " triângulos em " << lod.numNiveis << " niveis: "
+              << tempoSimplificacao << " ms" << std::endl;
+    for (int nivel = 0; nivel < lod.numNiveis; nivel++) {
+        const NivelLOD& n = lod.niveis[nivel];
+        std::cout << "  LOD " << nivel << ": " << std::left << std::setw(7) << n.numIndices / 3 << " triângulos, erro "
+                  << std::setw(12) << n.erro << " ACMR "
+                  << calculaACMR(lod.malha.indices.data() + n.primeiroIndice, n.numIndices, lod.malha.vertices.size() / 3) << std::endl;
+    }
+
+    // 10 mil objetos numa grade; a camera fica parada na borda tremendo um pouco (o caso em que um objeto
+    // perto do limite trocaria de nivel a cada quadro sem histerese).
+    const int lado = 100;
+    const size_t numObjetos = (size_t)lado * lado;
+    VolumesEnvolventes volumes;
+    redimensionaVolumes(volumes, numObjetos);
+    for (int z = 0; z < lado; z++) {
+        for (int x = 0; x < lado; x++) {
+            defineEsfera(volumes, (size_t)z * lado + x, Vec3(x * 3.0f, 0.0f, -z * 3.0f), lod.raio);
+        }
+    }
+    const float campoVisao = 1.0f;
+    const float escalaTela = escalaErroTela(campoVisao, 1080);
+    const float limitePixels = 1.0f;
+    const int quadros = 120;
+    std::vector<uint32_t> visiveis(numObjetos);
+
+    for (float histerese : { 0.0f, 0.25f }) {
+        std::vector<uint8_t> niveis(numObjetos, 0), anteriores(numObjetos, 0);
+        size_t triangulosLOD = 0, triangulosCompletos = 0, trocas = 0, totalVisiveis = 0;
+        double tempoSelecao = 0.0;
+        for (int q = 0; q < quadros; q++) {
+            Vec3 camera(lado * 1.5f + std::sin(q * 1.3f), 3.0f, 5.0f + std::cos(q * 1.7f));
+            Mat4 projecaoVisao = perspectiva(campoVisao, 16.0f / 9.0f, 0.1f, 2000.0f) *
+                                 olharPara(camera, camera + Vec3(0.0f, -0.1f, -1.0f), Vec3(0, 1, 0));
+            size_t numVisiveis = descartaFrustum(extraiFrustum(projecaoVisao), volumes, volumeEsfera, 0, numObjetos, visiveis.data());
+
+            inicio = tempoAtualMs();
+            selecionaLODs(lod, volumes, visiveis.data(), numVisiveis, camera, escalaTela, limitePixels, histerese, niveis.data());
+            tempoSelecao += tempoAtualMs() - inicio;
+
+            for (size_t k = 0; k < numVisiveis; k++) {
+                uint32_t i = visiveis[k];
+                triangulosLOD += lod.niveis[niveis[i]].numIndices / 3;
+                triangulosCompletos += lod.niveis[0].numIndices / 3;
+                trocas += (q > 0 && niveis[i] != anteriores[i]) ? 1 : 0;
+                anteriores[i] = niveis[i];
+            }
+            totalVisiveis += numVisiveis;
+        }
+
+        std::cout << "Histerese " << std::setw(5) << histerese << totalVisiveis / quadros << " objetos/quadro, seleção "
+                  << tempoSelecao / quadros << " ms, " << trocas / (quadros - 1) << " trocas de nivel/quadro" << std::endl;
+        std::cout << "               triângulos/quadro: " << triangulosLOD / quadros << " com LOD, " << triangulosCompletos / quadros
+                  << " sem (" << (double)triangulosCompletos / std::max<size_t>(triangulosLOD, 1) << "x)" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Meshlets de uma esfera densa e uma grade de 64 copias vistas de dentro: triângulos enviados depois do
+// descarte por objeto (frustum da esfera inteira) e depois do descarte por meshlet (frustum e cone).
+static void benchmarkMeshlets()
+{
+    std::cout << "== Meshlets: 64 vertices / 124 triângulos, descarte por frustum e cone ==" << std::endl;
+
+    MalhaIndexada malha;
+    geraEsferaOndulada(malha, 256, 128);
+    embaralhaTriangulos(malha.indices.data(), malha.indices.size(), 48);
+    const size_t triangulosMalha = malha.indices.size() / 3;
+
+    const int lado = 8;
+    const size_t numObjetos = (size_t)lado * lado;
+    VolumesEnvolventes objetos;
+    redimensionaVolumes(objetos, numObjetos);
+    for (int z = 0; z < lado; z++) {
+        for (int x = 0; x < lado; x++) {
+            defineEsfera(objetos, (size_t)z * lado + x, Vec3(x * 3.0f, 0.0f, -z * 3.0f), 1.05f);
+        }
+    }
+    const int quadros = 60;
+    std::vector<uint32_t> objetosVisiveis(numObjetos);
+
+    for (float pesoCone : { 0.0f, 0.5f, 1.0f }) {
+        MalhaMeshlets meshlets;
+        double inicio = tempoAtualMs();
+        constroiMeshlets(malha, meshlets, maxVerticesMeshlet, maxTriangulosMeshlet, pesoCone);
+        double tempoConstrucao = tempoAtualMs() - inicio;
+
+        size_t numMeshlets = meshlets.meshlets.size(), somaVertices = 0, conesUteis = 0;
+        for (size_t m = 0; m < numMeshlets; m++) {
+            somaVertices += meshlets.meshlets[m].numVertices;
+            conesUteis += meshlets.corteCone[m] < 1.0f ? 1 : 0;
+        }
+        std::cout << "Peso do cone " << std::left << std::setw(4) << pesoCone << numMeshlets << " meshlets em " << tempoConstrucao
+                  << " ms, " << (double)triangulosMalha / numMeshlets << " triângulos e " << (double)somaVertices / numMeshlets
+                  << " vertices por meshlet, " << 100.0 * conesUteis / numMeshlets << "% com cone, ACMR "
+                  << calculaACMR(meshlets.malha.indices.data(), meshlets.malha.indices.size(), meshlets.malha.vertices.size() / 3) << std::endl;
+
+        std::vector<uint32_t> visiveis(numMeshlets);
+        std::vector<int> primeiros(numMeshlets), contagens(numMeshlets);
+        size_t triangulosObjetos = 0, triangulosEnviados = 0, intervalos = 0;
+        double tempoDescarte = 0.0;
+        for (int q = 0; q < quadros; q++) {
+            float angulo = q * 6.2831853f / quadros;
+            Vec3 camera(lado * 1.5f - 1.5f, 1.5f, -lado * 1.5f + 1.5f);
+            Mat4 projecaoVisao = perspectiva(1.0f, 16.0f / 9.0f, 0.1f, 200.0f) *
+                                 olharPara(camera, camera + Vec3(std::cos(angulo), -0.3f, std::sin(angulo)), Vec3(0, 1, 0));
+            size_t numObjetosVisiveis = descartaFrustum(extraiFrustum(projecaoVisao), objetos, volumeEsfera, 0, numObjetos, objetosVisiveis.data());
+
+            inicio = tempoAtualMs();
+            for (size_t k = 0; k < numObjetosVisiveis; k++) {
+                uint32_t i = objetosVisiveis[k];
+                Vec3 posicao(objetos.centroX[i], objetos.centroY[i], objetos.centroZ[i]);
+                Frustum frustumLocal = extraiFrustum(projecaoVisao * translacao(posicao));
+                size_t numVisiveis = descartaMeshlets(meshlets, frustumLocal, camera - posicao, visiveis.data());
+                intervalos += intervalosMeshlets(meshlets, visiveis.data(), numVisiveis, primeiros.data(), contagens.data());
+                for (size_t v = 0; v < numVisiveis; v++) {
+                    triangulosEnviados += meshlets.meshlets[visiveis[v]].numTriangulos;
+                }
+            }
+            tempoDescarte += tempoAtualMs() - inicio;
+            triangulosObjetos += numObjetosVisiveis * triangulosMalha;
+        }
+
+        std::cout << "                 triângulos/quadro: " << triangulosMalha * numObjetos << " na cena, " << triangulosObjetos / quadros
+                  << " depois do descarte por objeto, " << triangulosEnviados / quadros << " enviados ("
+                  << 100.0 * triangulosEnviados / std::max<size_t>(triangulosObjetos, 1) << "%), " << intervalos / quadros
+                  << " intervalos, descarte " << tempoDescarte / quadros << " ms" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+// Componentes do benchmark do ECS.
+struct PosicaoECS { float x, y, z; };
+struct VelocidadeECS { float x, y, z; };
+struct AceleracaoECS { float x, y, z; };
+struct MarcadorECS { uint32_t grupo; };
+
+// Integração de um chunk: velocidade += aceleração * dt, posição += velocidade * dt.
+static void integraChunk(const VistaChunk& chunk, uint32_t tipoPosicao, uint32_t tipoVelocidade, uint32_t tipoAceleracao, float dt)
+{
+    PosicaoECS* posicoes = arrayComponente<PosicaoECS>(chunk, tipoPosicao);
+    VelocidadeECS* velocidades = arrayComponente<VelocidadeECS>(chunk, tipoVelocidade);
+    const AceleracaoECS* aceleracoes = arrayComponente<AceleracaoECS>(chunk, tipoAceleracao);
+    for (uint32_t i = 0; i < chunk.quantidade; i++) {
+        velocidades[i].x += aceleracoes[i].x * dt;
+        velocidades[i].y += aceleracoes[i].y * dt;
+        velocidades[i].z += aceleracoes[i].z * dt;
+        posicoes[i].x += velocidades[i].x * dt;
+        posicoes[i].y += velocidades[i].y * dt;
+        posicoes[i].z += velocidades[i].z * dt;
+    }
+}
+
+// 1 milhão de entidades com posição, velocidade e aceleração (um quarto com um componente a mais, então a
+// consulta passa por dois arquetipos): acesso por entidade, por chunk e por chunk em varias threads.
+static void benchmarkECS()
+{
+    std::cout << "== ECS: 1 milhão de entidades com 3 componentes, chunks de 16 KB ==" << std::endl;
+
+    MundoECS mundo;
+    uint32_t tipoPosicao = registraComponente<PosicaoECS>(mundo);
+    uint32_t tipoVelocidade = registraComponente<VelocidadeECS>(mundo);
+    uint32_t tipoAceleracao = registraComponente<AceleracaoECS>(mundo);
+    uint32_t tipoMarcador = registraComponente<MarcadorECS>(mundo);
+    AssinaturaECS movimento = bitComponente(tipoPosicao) | bitComponente(tipoVelocidade) | bitComponente(tipoAceleracao);
+
+    const size_t numEntidades = 1000000;
+    std::vector<Entidade> entidades(numEntidades);
+    double inicio = tempoAtualMs();
+    criaEntidades(mundo, movimento, numEntidades * 3 / 4, entidades.data());
+    criaEntidades(mundo, movimento | bitComponente(tipoMarcador), numEntidades - numEntidades * 3 / 4, entidades.data() + numEntidades * 3 / 4);
+    double tempoCriacao = tempoAtualMs() - inicio;
+
+    unsigned int semente = 49;
+    auto sinalUnitario = [&semente]() { return (float)(aleatorio(semente) % 2000) / 1000.0f - 1.0f; };
+    for (const Entidade& entidade : entidades) {
+        VelocidadeECS* velocidade = componente<VelocidadeECS>(mundo, entidade, tipoVelocidade);
+        AceleracaoECS* aceleracao = componente<AceleracaoECS>(mundo, entidade, tipoAceleracao);
+        *velocidade = VelocidadeECS{ sinalUnitario(), sinalUnitario(), sinalUnitario() };
+        *aceleracao = AceleracaoECS{ sinalUnitario(), -9.8f, sinalUnitario() };
+    }
+
+    std::vector<VistaChunk> chunks;
+    consultaChunks(mundo, movimento, 0, chunks);
+    std::cout << "Criação: " << tempoCriacao << " ms, " << mundo.arquetipos.size() << " arquetipos, " << chunks.size() << " chunks, "
+              << mundo.arquetipos[0]->capacidade << " entidades por chunk" << std::endl;
+
+    const int quadros = 10;
+    const float dt = 1.0f / 60.0f;
+
+    inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        paraCadaChunk(mundo, movimento, 0, [&](const VistaChunk& chunk) {
+            integraChunk(chunk, tipoPosicao, tipoVelocidade, tipoAceleracao, dt);
+        });
+    }
+    double tempoChunk = (tempoAtualMs() - inicio) / quadros;
+    std::cout << std::left << std::setw(24) << "Por chunk:" << tempoChunk << " ms/quadro (" << numEntidades / (tempoChunk * 1000.0)
+              << " M entidades/s)" << std::endl;
+
+    // Referencia: cada acesso busca o arquetipo, o chunk e a linha da entidade.
+    inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        for (const Entidade& entidade : entidades) {
+            PosicaoECS* posicao = componente<PosicaoECS>(mundo, entidade, tipoPosicao);
+            VelocidadeECS* velocidade = componente<VelocidadeECS>(mundo, entidade, tipoVelocidade);
+            const AceleracaoECS* aceleracao = componente<AceleracaoECS>(mundo, entidade, tipoAceleracao);
+            velocidade->x += aceleracao->x * dt;
+            velocidade->y += aceleracao->y * dt;
+            velocidade->z += aceleracao->z * dt;
+            posicao->x += velocidade->x * dt;
+            posicao->y += velocidade->y * dt;
+            posicao->z += velocidade->z * dt;
+        }
+    }
+    double tempoEntidade = (tempoAtualMs() - inicio) / quadros;
+    std::cout << std::setw(24) << "Por entidade:" << tempoEntidade << " ms/quadro (" << tempoEntidade / tempoChunk
+              << "x mais lento)" << std::endl;
+
+    // 1, 2, 4, ... até o numero de nucleos da maquina.
+    std::vector<unsigned int> numThreads;
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2) {
+        numThreads.push_back(threads);
+    }
+    numThreads.push_back(maxThreads);
+
+    for (unsigned int threads : numThreads) {
+        PoolThreads pool(threads);
+        inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            paraCadaChunkParalelo(mundo, movimento, 0, pool, [&](const VistaChunk& chunk, unsigned int) {
+                integraChunk(chunk, tipoPosicao, tipoVelocidade, tipoAceleracao, dt);
+            });
+        }
+        double tempo = (tempoAtualMs() - inicio) / quadros;
+
+        SistemaTarefas sistema(threads);
+        inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            paraCadaChunkParalelo(mundo, movimento, 0, sistema, [&](const VistaChunk& chunk, unsigned int) {
+                integraChunk(chunk, tipoPosicao, tipoVelocidade, tipoAceleracao, dt);
+            });
+        }
+        double tempoTarefas = (tempoAtualMs() - inicio) / quadros;
+
+        std::cout << "Por chunk, " << std::right << std::setw(3) << threads << std::left << " threads: " << tempo
+                  << " ms/quadro (PoolThreads), " << tempoTarefas << " ms/quadro (SistemaTarefas), aceleração "
+                  << tempoChunk / tempo << "x / " << tempoChunk / tempoTarefas << "x" << std::endl;
+    }
+
+    // Só as entidades marcadas (um arquetipo) e a troca de arquetipo de 10 mil entidades.
+    size_t marcadas = 0;
+    paraCadaChunk(mundo, bitComponente(tipoMarcador), 0, [&](const VistaChunk& chunk) { marcadas += chunk.quantidade; });
+    inicio = tempoAtualMs();
+    for (size_t i = 0; i < 10000; i++) {
+        adicionaComponente(mundo, entidades[i * 50], tipoMarcador);
+    }
+    double tempoTroca = tempoAtualMs() - inicio;
+    std::cout << "Consulta do marcador: " << marcadas << " entidades; 10 mil trocas de arquetipo: " << tempoTroca << " ms" << std::endl;
+
+    std::cout << std::endl;
+}
+
+// Trabalho sintetico de uma tarefa pequena: "passos" iterações de um gerador pseudo-aleatorio.
+static uint32_t trabalhoSintetico(uint32_t semente, int passos)
+{
+    for (int i = 0; i < passos; i++) {
+        semente = (semente * 1664525u + 1013904223u) ^ (semente >> 13);
+    }
+    return semente;
+}
+
+static void tarefaSintetica(void* dados, unsigned int /*thread*/)
+{
+    uint32_t* valor = (uint32_t*)dados;
+    *valor = trabalhoSintetico(*valor, 200);
+}
+
+// Um estagio do quadro sintetico: cada tarefa processa uma fatia de "valores".
+struct EstagioQuadro {
+    uint32_t* valores;
+    size_t inicio, fim;
+};
+
+static void tarefaEstagioQuadro(void* dados, unsigned int /*thread*/)
+{
+    EstagioQuadro* estagio = (EstagioQuadro*)dados;
+    for (size_t i = estagio->inicio; i < estagio->fim; i++) {
+        estagio->valores[i] = trabalhoSintetico(estagio->valores[i], 20);
+    }
+}
+
+// Escalabilidade do sistema de tarefas de 1 a 64 threads (acima do numero de nucleos as threads dividem os
+// nucleos): tarefas independentes de ~1 us, paraCada com blocos pequenos (comparado ao PoolThreads) e um
+// quadro com três estagios dependentes (descarte -> transformações -> gravação de comandos).
+static void benchmarkSistemaTarefas()
+{
+    std::cout << "== Sistema de tarefas (filas Chase-Lev, roubo de trabalho) de 1 a 64 threads, "
+              << std::max(1u, std::thread::hardware_concurrency()) << " nucleos ==" << std::endl;
+
+    const size_t numTarefas = 100000;
+    const size_t numElementos = 1 << 22;
+    const size_t tamanhoBloco = 1024;
+    const int quadros = 100;
+    const size_t tarefasPorEstagio = 64;
+    const size_t elementosQuadro = tarefasPorEstagio * 64;
+    std::vector<uint32_t> valores(std::max(numTarefas, numElementos));
+    std::vector<uint32_t> valoresQuadro(elementosQuadro * 3);
+
+    double tempoTarefas1 = 0.0, tempoParaCada1 = 0.0, tempoPool1 = 0.0, tempoQuadro1 = 0.0;
+    for (unsigned int threads = 1; threads <= 64; threads *= 2) {
+        SistemaTarefas sistema(threads);
+
+        // Tarefas independentes submetidas pela thread principal.
+        for (size_t i = 0; i < numTarefas; i++) {
+            valores[i] = (uint32_t)i;
+        }
+        double inicio = tempoAtualMs();
+        ContadorTarefas contador;
+        for (size_t i = 0; i < numTarefas; i++) {
+            sistema.submete(tarefaSintetica, &valores[i], &contador);
+        }
+        sistema.espera(contador);
+        double tempoTarefas = tempoAtualMs() - inicio;
+
+        // paraCada fino: poucos nanossegundos por elemento.
+        inicio = tempoAtualMs();
+        sistema.paraCada(numElementos, tamanhoBloco, [&](size_t primeiro, size_t fim, unsigned int) {
+            for (size_t i = primeiro; i < fim; i++) {
+                valores[i] = trabalhoSintetico((uint32_t)i, 4);
+            }
+        });
+        double tempoParaCada = tempoAtualMs() - inicio;
+
+        // O mesmo com o PoolThreads (uma tarefa por bloco).
+        double tempoPool;
+        {
+            PoolThreads pool(threads);
+            inicio = tempoAtualMs();
+            pool.paraCada((unsigned int)(numElementos / tamanhoBloco), [&](unsigned int bloco, unsigned int) {
+                for (size_t i = bloco * tamanhoBloco; i < (bloco + 1) * tamanhoBloco; i++) {
+                    valores[i] = trabalhoSintetico((uint32_t)i, 4);
+                }
+            });
+            tempoPool = tempoAtualMs() - inicio;
+        }
+
+        // Quadro: os três estagios são submetidos de uma vez e as dependencias seguram cada um.
+        std::vector<EstagioQuadro> estagios(tarefasPorEstagio * 3);
+        for (size_t e = 0; e < 3; e++) {
+            for (size_t t = 0; t < tarefasPorEstagio; t++) {
+                EstagioQuadro& estagio = estagios[e * tarefasPorEstagio + t];
+                estagio.valores = valoresQuadro.data() + e * elementosQuadro;
+                estagio.inicio = t * (elementosQuadro / tarefasPorEstagio);
+                estagio.fim = (t + 1) * (elementosQuadro / tarefasPorEstagio);
+            }
+        }
+        inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            ContadorTarefas descarte, transformacoes, gravacao;
+            for (size_t t = 0; t < tarefasPorEstagio; t++) {
+                sistema.submete(tarefaEstagioQuadro, &estagios[t], &descarte);
+            }
+            for (size_t t = 0; t < tarefasPorEstagio; t++) {
+                sistema.submete(tarefaEstagioQuadro, &estagios[tarefasPorEstagio + t], &transformacoes, &descarte);
+            }
+            for (size_t t = 0; t < tarefasPorEstagio; t++) {
+                sistema.submete(tarefaEstagioQuadro, &estagios[2 * tarefasPorEstagio + t], &gravacao, &transformacoes);
+            }
+            sistema.espera(gravacao);
+            sistema.espera(transformacoes);
+            sistema.espera(descarte);
+        }
+        double tempoQuadro = (tempoAtualMs() - inicio) / quadros;
+
+        if (threads == 1) {
+            tempoTarefas1 = tempoTarefas;
+            tempoParaCada1 = tempoParaCada;
+            tempoPool1 = tempoPool;
+            tempoQuadro1 = tempoQuadro;
+        }
+
+        std::cout << std::right << std::setw(3) << threads << std::left << " threads: tarefas " << tempoTarefas << " ms ("
+                  << numTarefas / (tempoTarefas * 1000.0) << " M/s, " << tempoTarefas1 / tempoTarefas << "x), quadro " << tempoQuadro
+                  << " ms (" << tempoQuadro1 / tempoQuadro << "x), " << sistema.tarefasRoubadas() << " roubos" << std::endl;
+        std::cout << "             paraCada " << tempoParaCada << " ms (" << tempoParaCada1 / tempoParaCada << "x), PoolThreads "
+                  << tempoPool << " ms (" << tempoPool1 / tempoPool << "x)" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+void executaBenchmarks()
+{
+    benchmarkCacheVertices();
+    benchmarkFormatoVertice();
+    benchmarkFilaRenderizacao();
+    benchmarkRasterizadorCPU();
+    benchmarkCoberturaSIMD();
+    benchmarkEstanqueidade();
+    benchmarkBandaGuarda();
+    benchmarkProfundidadeHierarquica();
+    benchmarkShaderLote();
+    benchmarkInterpretadorGLSL();
+    benchmarkEstagioVertices();
+    benchmarkMultiAmostragem();
+    benchmarkGravacaoQuadros();
+    benchmarkMatematica();
+    benchmarkTransformacoes();
+    benchmarkHierarquia();
+    benchmarkDescarteFrustum();
+    benchmarkBVH();
+    benchmarkOclusao();
+    benchmarkNivelDetalhe();
+    benchmarkMeshlets();
+    benchmarkECS();
+    benchmarkSistemaTarefas();
+    benchmarkTilesThreads();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// Benchmarks e relatorios de desempenho.
+// Executados com "Teste.exe --benchmark" (não precisam de GPU nem de janela).
+void executaBenchmarks();
+
+// Tempo atual em milissegundos (relogio monotônico), usado nas medições.
+double tempoAtualMs();
+
+// Benchmarks que precisam de um contexto OpenGL ativo.
+// Executados com "Teste.exe --benchmark-gl" depois de criar a janela.
+void executaBenchmarksGL();
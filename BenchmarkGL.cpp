@@ -0,0 +1,910 @@
+#include <glad/glad.h>
+
+#include "Benchmark.h"
+#include "FormatoVertice.h"
+#include "Instancias.h"
+#include "BufferStreaming.h"
+#include "BackendGL.h"
+#include "BackendCPU.h"
+#include "InterpretadorGLSL.h"
+#include "LeituraPixelsGL.h"
+#include "GravadorQuadros.h"
+#include "TransformacoesSoA.h"
+#include "NivelDetalhe.h"
+
+// Usado para escrever no console com C++
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+// Shaders do triângulo da janela principal (main.cpp).
+extern const char* vertexShaderSource;
+extern const char* fragmentShaderSource;
+
+// Compila e vincula um programa de shader, imprimindo o log em caso de erro.
+static unsigned int criaPrograma(const char* fonteVertex, const char* fonteFragment)
+{
+    int sucesso;
+    char infoLog[512];
+
+    unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &fonteVertex, NULL);
+    glCompileShader(vs);
+    glGetShaderiv(vs, GL_COMPILE_STATUS, &sucesso);
+    if (!sucesso) {
+        glGetShaderInfoLog(vs, 512, NULL, infoLog);
+        std::cout << "Erro durante a compilação do Vertex Shader \n" << infoLog << std::endl;
+    }
+
+    unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fs, 1, &fonteFragment, NULL);
+    glCompileShader(fs);
+    glGetShaderiv(fs, GL_COMPILE_STATUS, &sucesso);
+    if (!sucesso) {
+        glGetShaderInfoLog(fs, 512, NULL, infoLog);
+        std::cout << "Erro durante a compilação do Fragment Shader \n" << infoLog << std::endl;
+    }
+
+    unsigned int programa = glCreateProgram();
+    glAttachShader(programa, vs);
+    glAttachShader(programa, fs);
+    glLinkProgram(programa);
+    glGetProgramiv(programa, GL_LINK_STATUS, &sucesso);
+    if (!sucesso) {
+        glGetProgramInfoLog(programa, 512, NULL, infoLog);
+        std::cout << "Erro durante a vinculação do Program Shader \n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    return programa;
+}
+
+// Mede o tempo medio de envio de um VBO (glBufferData + glFinish).
+static double medeEnvioBuffer(const void* dados, size_t bytes, int repeticoes)
+{
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    // Primeiro envio fora da medição (alocação inicial do driver).
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, dados, GL_STATIC_DRAW);
+    glFinish();
+
+    double inicio = tempoAtualMs();
+    for (int i = 0; i < repeticoes; i++) {
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, dados, GL_STATIC_DRAW);
+        glFinish();
+    }
+    double tempo = (tempoAtualMs() - inicio) / repeticoes;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    return tempo;
+}
+
+// Tempo de envio do formato em float contra o formato compacto.
+static void benchmarkEnvioFormatoVertice()
+{
+    std::cout << "== Envio de VBO: float x compacto ==" << std::endl;
+
+    std::vector<VerticeCompleto> completos;
+    geraEsferaVerticesCompletos(completos, 1024, 512);
+    std::vector<VerticeCompacto> compactos(completos.size());
+    compactaVertices(completos.data(), completos.size(), compactos.data());
+
+    size_t bytesCompletos = completos.size() * sizeof(VerticeCompleto);
+    size_t bytesCompactos = compactos.size() * sizeof(VerticeCompacto);
+
+    double tempoCompletos = medeEnvioBuffer(completos.data(), bytesCompletos, 20);
+    double tempoCompactos = medeEnvioBuffer(compactos.data(), bytesCompactos, 20);
+
+    std::cout << "Float:    " << bytesCompletos / (1024.0 * 1024.0) << " MB em " << tempoCompletos << " ms" << std::endl;
+    std::cout << "Compacto: " << bytesCompactos / (1024.0 * 1024.0) << " MB em " << tempoCompactos << " ms" << std::endl;
+
+    // Desenha a esfera compacta uma vez para validar a decodificação nos shaders.
+    unsigned int programa = criaPrograma(vertexShaderCompactoSource, fragmentShaderCompactoSource);
+    unsigned int vao, vbo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytesCompactos, compactos.data(), GL_STATIC_DRAW);
+    configuraAtributosCompactos();
+    glUseProgram(programa);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)compactos.size());
+    glFinish();
+    std::cout << "Desenho com o formato compacto: " << (glGetError() == GL_NO_ERROR ? "OK" : "ERRO") << std::endl;
+
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteProgram(programa);
+    std::cout << std::endl;
+}
+
+// Shaders do caminho sem instâncias: transformação e cor chegam por uniform a cada desenho.
+static const char* vertexShaderPorObjetoSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"uniform vec4 uLinhas[3];\n"
+"void main()\n"
+"{\n"
+"   vec4 p = vec4(aPos, 1.0);\n"
+"   gl_Position = vec4(dot(uLinhas[0], p), dot(uLinhas[1], p), dot(uLinhas[2], p), 1.0);\n"
+"}\n\0";
+
+static const char* fragmentShaderPorObjetoSource = "#version 330 core\n"
+"uniform vec4 uCor;\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"    FragColor = uCor;\n"
+"}\n\0";
+
+// 100 mil triângulos: um glDrawArrays por objeto contra um unico glDrawArraysInstanced.
+static void benchmarkInstancias()
+{
+    std::cout << "== Instâncias: 100 mil triângulos ==" << std::endl;
+
+    const unsigned int numObjetos = 100000;
+    const int quadros = 10;
+    const float triangulo[] = {
+        -0.5f, -0.5f, 0.0f,
+         0.5f, -0.5f, 0.0f,
+         0.0f,  0.5f, 0.0f
+    };
+
+    // Instâncias espalhadas numa grade cobrindo a janela.
+    std::vector<InstanciaTriangulo> instancias(numObjetos);
+    for (unsigned int i = 0; i < numObjetos; i++) {
+        float x = -1.0f + 2.0f * (float)(i % 400) / 400.0f;
+        float y = -1.0f + 2.0f * (float)(i / 400) / 250.0f;
+        defineTransformacao2D(instancias[i], x, y, 0.01f, (float)i * 0.01f);
+        instancias[i].cor[0] = (uint8_t)(i * 7);
+        instancias[i].cor[1] = (uint8_t)(i * 13);
+        instancias[i].cor[2] = (uint8_t)(i * 29);
+        instancias[i].cor[3] = 255;
+    }
+
+    unsigned int vao, vbo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangulo), triangulo, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // Caminho 1: um desenho por objeto.
+    unsigned int programaPorObjeto = criaPrograma(vertexShaderPorObjetoSource, fragmentShaderPorObjetoSource);
+    int uLinhas = glGetUniformLocation(programaPorObjeto, "uLinhas");
+    int uCor = glGetUniformLocation(programaPorObjeto, "uCor");
+
+    glFinish();
+    double cpuPorObjeto = 0.0;
+    double inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        double inicioCPU = tempoAtualMs();
+        glUseProgram(programaPorObjeto);
+        glBindVertexArray(vao);
+        for (unsigned int i = 0; i < numObjetos; i++) {
+            const InstanciaTriangulo& inst = instancias[i];
+            glUniform4fv(uLinhas, 3, inst.transformacao);
+            glUniform4f(uCor, inst.cor[0] / 255.0f, inst.cor[1] / 255.0f, inst.cor[2] / 255.0f, 1.0f);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        cpuPorObjeto += tempoAtualMs() - inicioCPU;
+        glFinish();
+    }
+    double totalPorObjeto = (tempoAtualMs() - inicio) / quadros;
+    cpuPorObjeto /= quadros;
+
+    // Caminho 2: uma unica chamada com instâncias (os dados são reenviados a cada quadro).
+    unsigned int programaInstancias = criaPrograma(vertexShaderInstanciasSource, fragmentShaderInstanciasSource);
+    LoteInstancias lote;
+    criaLoteInstancias(lote, vao, numObjetos);
+
+    glFinish();
+    double cpuInstancias = 0.0;
+    inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        double inicioCPU = tempoAtualMs();
+        atualizaInstancias(lote, instancias.data(), numObjetos);
+        glUseProgram(programaInstancias);
+        desenhaInstancias(lote, vao, 3);
+        cpuInstancias += tempoAtualMs() - inicioCPU;
+        glFinish();
+    }
+    double totalInstancias = (tempoAtualMs() - inicio) / quadros;
+    cpuInstancias /= quadros;
+
+    // Caminho 3: as mesmas transformações em SoA, compostas a cada quadro direto no VBO mapeado.
+    TransformacoesSoA transformacoes;
+    redimensionaTransformacoes(transformacoes, numObjetos);
+    for (unsigned int i = 0; i < numObjetos; i++) {
+        float x = -1.0f + 2.0f * (float)(i % 400) / 400.0f;
+        float y = -1.0f + 2.0f * (float)(i / 400) / 250.0f;
+        defineTransformacao(transformacoes, i, Vec3(x, y, 0.0f), quatEixoAngulo(Vec3(0, 0, 1), (float)i * 0.01f),
+                            Vec3(0.01f, 0.01f, 0.01f));
+        std::memcpy(&transformacoes.cor[i], instancias[i].cor, 4);
+    }
+
+    glFinish();
+    double cpuMapeado = 0.0;
+    inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        double inicioCPU = tempoAtualMs();
+        InstanciaTriangulo* destino = mapeiaInstancias(lote, numObjetos);
+        if (destino) {
+            compoeInstancias(transformacoes, 0, numObjetos, destino);
+            desmapeiaInstancias(lote);
+        }
+        glUseProgram(programaInstancias);
+        desenhaInstancias(lote, vao, 3);
+        cpuMapeado += tempoAtualMs() - inicioCPU;
+        glFinish();
+    }
+    double totalMapeado = (tempoAtualMs() - inicio) / quadros;
+    cpuMapeado /= quadros;
+
+    std::cout << "Um desenho por objeto: " << totalPorObjeto << " ms/quadro (CPU " << cpuPorObjeto << " ms), "
+              << numObjetos / (cpuPorObjeto / 1000.0) << " desenhos/s" << std::endl;
+    std::cout << "Instâncias:            " << totalInstancias << " ms/quadro (CPU " << cpuInstancias << " ms), "
+              << numObjetos / (cpuInstancias / 1000.0) << " objetos/s" << std::endl;
+    std::cout << "SoA no VBO mapeado:    " << totalMapeado << " ms/quadro (CPU " << cpuMapeado << " ms, "
+              << nomeNivelSIMD(nivelTransformacoes()) << "), " << numObjetos / (cpuMapeado / 1000.0) << " objetos/s" << std::endl;
+    std::cout << std::endl;
+
+    destroiLoteInstancias(lote);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteProgram(programaPorObjeto);
+    glDeleteProgram(programaInstancias);
+}
+
+// Shaders dos pontos usados no benchmark de streaming.
+static const char* vertexShaderPontosSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(aPos, 1.0);\n"
+"}\n\0";
+
+static const char* fragmentShaderPontosSource = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"    FragColor = vec4(1.0, 1.0, 1.0, 1.0);\n"
+"}\n\0";
+
+// Modos de envio comparados no benchmark de streaming.
+enum ModoStreaming {
+    streamingOrfao,           // glBufferData(NULL) + glBufferSubData a cada quadro.
+    streamingMapeamento,      // Anel com glMapBufferRange sem sincronização.
+    streamingPersistente      // Anel com mapeamento persistente (ARB_buffer_storage).
+};
+
+// Envia "bytesPorQuadro" de particulas por quadro e desenha como pontos; retorna MB/s.
+static double medeStreaming(ModoStreaming modo, const std::vector<float>& particulas, int quadros, unsigned int programa)
+{
+    size_t bytesPorQuadro = particulas.size() * sizeof(float);
+    GLsizei numPontos = (GLsizei)(particulas.size() / 3);
+
+    unsigned int vao, vboOrfao = 0;
+    BufferAnel anel;
+    glGenVertexArrays(1, &vao);
+
+    if (modo == streamingOrfao) {
+        glGenBuffers(1, &vboOrfao);
+    }
+    else {
+        criaBufferAnel(anel, bytesPorQuadro, modo == streamingPersistente);
+    }
+
+    glUseProgram(programa);
+    glBindVertexArray(vao);
+    glEnableVertexAttribArray(0);
+    glFinish();
+
+    double inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        size_t deslocamento = 0;
+
+        if (modo == streamingOrfao) {
+            glBindBuffer(GL_ARRAY_BUFFER, vboOrfao);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytesPorQuadro, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytesPorQuadro, particulas.data());
+        }
+        else {
+            void* destino = alocaBufferAnel(anel, bytesPorQuadro, 16, &deslocamento);
+            std::memcpy(destino, particulas.data(), bytesPorQuadro);
+            concluiEscritaBufferAnel(anel);
+            glBindBuffer(GL_ARRAY_BUFFER, anel.buffer);
+        }
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)deslocamento);
+        glDrawArrays(GL_POINTS, 0, numPontos);
+
+        if (modo != streamingOrfao) {
+            finalizaQuadroBufferAnel(anel);
+        }
+    }
+    glFinish();
+    double tempo = tempoAtualMs() - inicio;
+
+    bool persistente = anel.persistente;
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteVertexArrays(1, &vao);
+    if (modo == streamingOrfao) {
+        glDeleteBuffers(1, &vboOrfao);
+    }
+    else {
+        destroiBufferAnel(anel);
+    }
+
+    if (modo == streamingPersistente && !persistente) {
+        std::cout << "(ARB_buffer_storage indisponivel, usando glMapBufferRange) ";
+    }
+
+    return (double)bytesPorQuadro * quadros / (1024.0 * 1024.0) / (tempo / 1000.0);
+}
+
+// MB/s enviados por quadro: anel com fences contra glBufferData "orfão".
+static void benchmarkStreaming()
+{
+    std::cout << "== Streaming de geometria dinâmica ==" << std::endl;
+
+    const int quadros = 200;
+    const size_t tamanhos[] = { 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+    unsigned int programa = criaPrograma(vertexShaderPontosSource, fragmentShaderPontosSource);
+
+    for (size_t bytes : tamanhos) {
+        std::vector<float> particulas(bytes / sizeof(float) / 3 * 3);
+        for (size_t i = 0; i < particulas.size(); i++) {
+            particulas[i] = (float)((i * 2654435761u) % 2000) / 1000.0f - 1.0f;
+        }
+
+        std::cout << bytes / 1024 << " KB por quadro:" << std::endl;
+        std::cout << "    glBufferData orfão:   " << medeStreaming(streamingOrfao, particulas, quadros, programa) << " MB/s" << std::endl;
+        std::cout << "    anel glMapBufferRange: " << medeStreaming(streamingMapeamento, particulas, quadros, programa) << " MB/s" << std::endl;
+        std::cout << "    anel persistente:      " << medeStreaming(streamingPersistente, particulas, quadros, programa) << " MB/s" << std::endl;
+    }
+
+    glDeleteProgram(programa);
+    std::cout << std::endl;
+}
+
+// Shaders da cena de comparação: posição e cor interpolada, em GLSL e em C++.
+static const char* vertexShaderCorSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec3 aCor;\n"
+"out vec3 Cor;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(aPos, 1.0);\n"
+"   Cor = aCor;\n"
+"}\n\0";
+
+static const char* fragmentShaderCorSource = "#version 330 core\n"
+"in vec3 Cor;\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"    FragColor = vec4(Cor, 1.0);\n"
+"}\n\0";
+
+static void vertexShaderCorCPU(const float* atributos, const void* /*uniforms*/, float* posicao, float* varyings)
+{
+    posicao[0] = atributos[0];
+    posicao[1] = atributos[1];
+    posicao[2] = atributos[2];
+    posicao[3] = 1.0f;
+    varyings[0] = atributos[3];
+    varyings[1] = atributos[4];
+    varyings[2] = atributos[5];
+}
+
+static void fragmentShaderCorCPU(const float* varyings, const void* /*uniforms*/, float* cor)
+{
+    cor[0] = varyings[0];
+    cor[1] = varyings[1];
+    cor[2] = varyings[2];
+    cor[3] = 1.0f;
+}
+
+// Desenha a mesma cena nos dois backends e compara pixel a pixel.
+static void benchmarkComparaBackends()
+{
+    std::cout << "== Comparação OpenGL x CPU ==" << std::endl;
+
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    int largura = viewport[2];
+    int altura = viewport[3];
+
+    // Triângulos sobrepostos em profundidades diferentes, um deles saindo da tela.
+    const float vertices[] = {
+        -0.8f, -0.8f,  0.5f,   1.0f, 0.0f, 0.0f,
+         0.8f, -0.6f,  0.5f,   0.0f, 1.0f, 0.0f,
+         0.0f,  0.9f,  0.5f,   0.0f, 0.0f, 1.0f,
+        -0.9f,  0.7f,  0.2f,   1.0f, 1.0f, 0.0f,
+         0.6f,  0.8f, -0.3f,   0.0f, 1.0f, 1.0f,
+         0.1f, -0.9f,  0.9f,   1.0f, 0.0f, 1.0f,
+        -1.5f, -0.2f,  0.0f,   1.0f, 1.0f, 1.0f,
+         1.4f, -0.1f,  0.0f,   0.5f, 0.5f, 0.5f,
+         0.0f, -1.6f,  0.0f,   0.2f, 0.4f, 0.8f
+    };
+    const unsigned int indices[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    DescricaoMalha malha;
+    malha.vertices = vertices;
+    malha.numVertices = 9;
+    malha.stride = 6;
+    malha.atributos[0].location = 0;
+    malha.atributos[0].componentes = 3;
+    malha.atributos[0].deslocamento = 0;
+    malha.atributos[1].location = 1;
+    malha.atributos[1].componentes = 3;
+    malha.atributos[1].deslocamento = 3;
+    malha.numAtributos = 2;
+    malha.indices = indices;
+    malha.numIndices = 9;
+
+    DescricaoPrograma programa;
+    programa.fonteVertex = vertexShaderCorSource;
+    programa.fonteFragment = fragmentShaderCorSource;
+    programa.vertexCPU = vertexShaderCorCPU;
+    programa.fragmentCPU = fragmentShaderCorCPU;
+    programa.numVaryings = 3;
+
+    BackendGL gl;
+    BackendCPU cpu;
+    BackendRenderizacao* backends[2] = { &gl, &cpu };
+
+    for (BackendRenderizacao* backend : backends) {
+        unsigned int idMalha = backend->criaMalha(malha);
+        unsigned int idPrograma = backend->criaPrograma(programa);
+        backend->defineViewport(largura, altura);
+        backend->defineTesteProfundidade(true);
+        backend->limpa(0.0f, 0.0f, 0.0f, 1.0f);
+        backend->desenha(idPrograma, idMalha);
+        backend->finalizaQuadro();
+    }
+
+    // Lê o back buffer do OpenGL (mesma orientação do FramebufferCPU: linha 0 embaixo).
+    std::vector<uint32_t> pixelsGL((size_t)largura * altura);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, largura, altura, GL_RGBA, GL_UNSIGNED_BYTE, pixelsGL.data());
+    glDisable(GL_DEPTH_TEST);
+
+    // Pixels diferentes: cobertura diferente ou cor com diferença maior que 2/255.
+    const std::vector<uint32_t>& pixelsCPU = cpu.framebuffer().cor;
+    size_t diferentes = 0;
+    for (size_t i = 0; i < pixelsGL.size(); i++) {
+        for (int c = 0; c < 3; c++) {
+            int a = (pixelsGL[i] >> (c * 8)) & 0xFF;
+            int b = (pixelsCPU[i] >> (c * 8)) & 0xFF;
+            if (a - b > 2 || b - a > 2) {
+                diferentes++;
+                break;
+            }
+        }
+    }
+
+    std::cout << largura << "x" << altura << ": " << diferentes << " pixels diferentes ("
+              << 100.0 * diferentes / pixelsGL.size() << "%)" << std::endl;
+    std::cout << std::endl;
+}
+
+// Uniform vec4 (ou array de vec4) usado nos testes de conformidade.
+struct UniformConformidade {
+    const char* nome;
+    int numVec4;
+    const float* valores;
+};
+
+// Desenha os triângulos com o programa GLSL no OpenGL e no InterpretadorGLSL e retorna os pixels diferentes
+// (cobertura diferente ou cor com diferença maior que 2/255).
+static size_t comparaShaderGLSL(const char* fonteVertex, const char* fonteFragment,
+                                const std::vector<float>& vertices, unsigned int stride,
+                                const std::vector<AtributoMalha>& atributos,
+                                const UniformConformidade* uniforms, int numUniforms,
+                                int largura, int altura)
+{
+    unsigned int numVertices = (unsigned int)(vertices.size() / stride);
+
+    // OpenGL.
+    unsigned int programaGL = criaPrograma(fonteVertex, fonteFragment);
+    unsigned int VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    for (const AtributoMalha& atributo : atributos) {
+        glVertexAttribPointer(atributo.location, (GLint)atributo.componentes, GL_FLOAT, GL_FALSE,
+                              (GLsizei)(stride * sizeof(float)), (void*)(atributo.deslocamento * sizeof(float)));
+        glEnableVertexAttribArray(atributo.location);
+    }
+
+    glUseProgram(programaGL);
+    for (int i = 0; i < numUniforms; i++) {
+        glUniform4fv(glGetUniformLocation(programaGL, uniforms[i].nome), uniforms[i].numVec4, uniforms[i].valores);
+    }
+    glDisable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)numVertices);
+
+    std::vector<uint32_t> pixelsGL((size_t)largura * altura);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, largura, altura, GL_RGBA, GL_UNSIGNED_BYTE, pixelsGL.data());
+
+    glBindVertexArray(0);
+    glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(programaGL);
+
+    // CPU com o mesmo GLSL interpretado.
+    ProgramaGLSLCPU glsl;
+    std::string erro;
+    if (!compilaProgramaGLSL(glsl, fonteVertex, fonteFragment, erro)) {
+        std::cout << "ERRO::SHADER::INTERPRETADOR_GLSL\n" << erro << std::endl;
+        return pixelsGL.size();
+    }
+    for (const AtributoMalha& atributo : atributos) {
+        defineAtributoGLSL(glsl, atributo.location, atributo.componentes, atributo.deslocamento);
+    }
+    for (int i = 0; i < numUniforms; i++) {
+        defineUniformGLSL(glsl, uniforms[i].nome, uniforms[i].valores, uniforms[i].numVec4 * 4);
+    }
+
+    ProgramaCPU programa;
+    configuraProgramaCPU(glsl, programa);
+    FramebufferCPU framebuffer;
+    redimensionaFramebuffer(framebuffer, largura, altura);
+    limpaFramebuffer(framebuffer, 0.0f, 0.0f, 0.0f, 1.0f);
+    EstadoRasterizacao estado;
+    desenhaTriangulosCPU(framebuffer, programa, estado, vertices.data(), stride, numVertices, nullptr, 0);
+
+    size_t diferentes = 0;
+    for (size_t i = 0; i < pixelsGL.size(); i++) {
+        for (int c = 0; c < 3; c++) {
+            int a = (pixelsGL[i] >> (c * 8)) & 0xFF;
+            int b = (framebuffer.cor[i] >> (c * 8)) & 0xFF;
+            if (a - b > 2 || b - a > 2) {
+                diferentes++;
+                break;
+            }
+        }
+    }
+    return diferentes;
+}
+
+// Conformidade do InterpretadorGLSL: cada shader do projeto desenhado no OpenGL e na CPU.
+// Os atributos são valores pseudo-aleatorios entre -1 e 1 (os fora da tela são recortados igual nos dois).
+static void benchmarkConformidadeGLSL()
+{
+    std::cout << "== Conformidade do interpretador GLSL (OpenGL x CPU) ==" << std::endl;
+
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    int largura = viewport[2];
+    int altura = viewport[3];
+
+    const unsigned int numTriangulos = 32;
+    unsigned int semente = 7;
+    auto aleatorio = [&semente]() {
+        semente = semente * 1664525u + 1013904223u;
+        return (float)(semente >> 8) / 8388608.0f - 1.0f;
+    };
+    auto geraVertices = [&](unsigned int stride) {
+        std::vector<float> vertices((size_t)numTriangulos * 3 * stride);
+        for (float& v : vertices) v = aleatorio();
+        return vertices;
+    };
+    auto atributo = [](unsigned int location, unsigned int componentes, unsigned int deslocamento) {
+        AtributoMalha a;
+        a.location = location;
+        a.componentes = componentes;
+        a.deslocamento = deslocamento;
+        return a;
+    };
+
+    const float linhas[12] = {
+        0.8f, 0.2f, 0.0f, 0.1f,
+       -0.2f, 0.7f, 0.0f, -0.1f,
+        0.0f, 0.0f, 0.5f, 0.0f
+    };
+    const float cor[4] = { 0.9f, 0.5f, 0.25f, 1.0f };
+    const UniformConformidade uniformsPorObjeto[2] = { { "uLinhas", 3, linhas }, { "uCor", 1, cor } };
+
+    struct Caso {
+        const char* nome;
+        const char* fonteVertex;
+        const char* fonteFragment;
+        unsigned int stride;
+        std::vector<AtributoMalha> atributos;
+        const UniformConformidade* uniforms;
+        int numUniforms;
+    };
+    const Caso casos[] = {
+        { "Triângulo (main)", vertexShaderSource, fragmentShaderSource, 3, { atributo(0, 3, 0) }, nullptr, 0 },
+        { "Cor por vertice", vertexShaderCorSource, fragmentShaderCorSource, 6, { atributo(0, 3, 0), atributo(1, 3, 3) }, nullptr, 0 },
+        { "Formato compacto", vertexShaderCompactoSource, fragmentShaderCompactoSource, 9,
+          { atributo(0, 3, 0), atributo(1, 4, 3), atributo(2, 2, 7) }, nullptr, 0 },
+        { "Instâncias", vertexShaderInstanciasSource, fragmentShaderInstanciasSource, 19,
+          { atributo(0, 3, 0), atributo(3, 4, 3), atributo(4, 4, 7), atributo(5, 4, 11), atributo(6, 4, 15) }, nullptr, 0 },
+        { "Por objeto (uniforms)", vertexShaderPorObjetoSource, fragmentShaderPorObjetoSource, 3, { atributo(0, 3, 0) }, uniformsPorObjeto, 2 },
+        { "Pontos", vertexShaderPontosSource, fragmentShaderPontosSource, 3, { atributo(0, 3, 0) }, nullptr, 0 }
+    };
+
+    for (const Caso& caso : casos) {
+        std::vector<float> vertices = geraVertices(caso.stride);
+        size_t diferentes = comparaShaderGLSL(caso.fonteVertex, caso.fonteFragment, vertices, caso.stride, caso.atributos,
+                                              caso.uniforms, caso.numUniforms, largura, altura);
+        std::cout << caso.nome << ": " << diferentes << " pixels diferentes ("
+                  << 100.0 * diferentes / ((size_t)largura * altura) << "%)" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Renderização em 4K num framebuffer fora da tela, com leitura dos pixels e codificação PNG.
+static void benchmarkLeituraPixels()
+{
+    const int largura = 3840, altura = 2160;
+    std::cout << "== Leitura de pixels (" << largura << "x" << altura << " fora da tela, PNG sem gravar no disco) ==" << std::endl;
+
+    unsigned int fbo, rboCor, rboProfundidade;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGenRenderbuffers(1, &rboCor);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboCor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, largura, altura);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rboCor);
+    glGenRenderbuffers(1, &rboProfundidade);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboProfundidade);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, largura, altura);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboProfundidade);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERRO::FRAMEBUFFER::INCOMPLETO" << std::endl;
+    }
+
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // Muitos triângulos pequenos sobre um fundo em degradê, para a imagem não ser trivial de comprimir.
+    std::vector<float> vertices;
+    const float fundo[6][6] = {
+        { -1, -1, 0.9f, 0.1f, 0.1f, 0.3f }, { 1, -1, 0.9f, 0.3f, 0.1f, 0.1f }, { 1, 1, 0.9f, 0.6f, 0.6f, 0.2f },
+        { -1, -1, 0.9f, 0.1f, 0.1f, 0.3f }, { 1, 1, 0.9f, 0.6f, 0.6f, 0.2f }, { -1, 1, 0.9f, 0.1f, 0.5f, 0.5f }
+    };
+    vertices.insert(vertices.end(), &fundo[0][0], &fundo[0][0] + 36);
+    unsigned int semente = 5;
+    for (int t = 0; t < 20000; t++) {
+        semente = semente * 1664525u + 1013904223u;
+        float x = (float)((semente >> 8) % 2000) / 1000.0f - 1.0f;
+        semente = semente * 1664525u + 1013904223u;
+        float y = (float)((semente >> 8) % 2000) / 1000.0f - 1.0f;
+        float z = (float)((semente >> 4) % 1000) / 1000.0f * 1.6f - 0.8f;
+        const float triangulo[3][6] = {
+            { x, y, z, 1.0f, 0.0f, 0.0f }, { x + 0.05f, y, z, 0.0f, 1.0f, 0.0f }, { x, y + 0.05f, z, 0.0f, 0.0f, 1.0f }
+        };
+        vertices.insert(vertices.end(), &triangulo[0][0], &triangulo[0][0] + 18);
+    }
+
+    DescricaoMalha malha;
+    malha.vertices = vertices.data();
+    malha.numVertices = (unsigned int)(vertices.size() / 6);
+    malha.stride = 6;
+    malha.atributos[0].location = 0;
+    malha.atributos[0].componentes = 3;
+    malha.atributos[0].deslocamento = 0;
+    malha.atributos[1].location = 1;
+    malha.atributos[1].componentes = 3;
+    malha.atributos[1].deslocamento = 3;
+    malha.numAtributos = 2;
+
+    DescricaoPrograma programa;
+    programa.fonteVertex = vertexShaderCorSource;
+    programa.fonteFragment = fragmentShaderCorSource;
+
+    BackendGL gl;
+    unsigned int idMalha = gl.criaMalha(malha);
+    unsigned int idPrograma = gl.criaPrograma(programa);
+    gl.defineViewport(largura, altura);
+    gl.defineTesteProfundidade(true);
+
+    LeituraPixels leitura;
+    criaLeituraPixels(leitura, largura, altura);
+
+    const char* nomes[5] = { "Só renderização", "glReadPixels sincrono", "PBO assincrono",
+                             "Sincrono + PNG", "PBO + PNG em segundo plano" };
+    const int quadros = 12;
+    for (int modo = 0; modo < 5; modo++) {
+        GravadorQuadros gravador;
+        std::vector<uint32_t> pixels((size_t)largura * altura);
+        std::vector<uint8_t> arquivo;
+        int lidos = 0;
+
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            gl.limpa(0.0f, 0.0f, 0.0f, 1.0f);
+            gl.desenha(idPrograma, idMalha);
+
+            if (modo == 1 || modo == 3) {
+                // O glReadPixels sem PBO espera a GPU terminar o quadro e copia na hora.
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+                glReadPixels(0, 0, largura, altura, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                lidos++;
+                if (modo == 3) {
+                    codificaPNG(pixels.data(), largura, altura, arquivo);
+                }
+            }
+            else if (modo == 2 || modo == 4) {
+                // Os quadros já copiados saem primeiro e liberam os PBOs; com os 3 ocupados espera o mais antigo.
+                for (;;) {
+                    if (modo == 4 && pixels.empty()) {
+                        pixels = gravador.bufferLivre();
+                    }
+                    if (!terminaLeituraPixels(leitura, pixels, leitura.pendentes == buffersLeituraPixels)) {
+                        break;
+                    }
+                    lidos++;
+                    if (modo == 4) {
+                        gravador.enfileira(std::move(pixels), largura, altura, imagemPNG, std::string());
+                    }
+                }
+                iniciaLeituraPixels(leitura);
+            }
+        }
+        // Os quadros que ainda estão nos PBOs.
+        while (leitura.pendentes > 0) {
+            if (pixels.empty()) {
+                pixels = gravador.bufferLivre();
+            }
+            terminaLeituraPixels(leitura, pixels, true);
+            lidos++;
+            if (modo == 4) {
+                gravador.enfileira(std::move(pixels), largura, altura, imagemPNG, std::string());
+            }
+        }
+        glFinish();
+        gravador.esperaTodos();
+        double tempo = tempoAtualMs() - inicio;
+
+        std::cout << nomes[modo] << ": " << 1000.0 * quadros / tempo << " quadros/s ("
+                  << tempo / quadros << " ms/quadro, " << lidos << " quadros lidos)" << std::endl;
+    }
+
+    destroiLeituraPixels(leitura);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &rboCor);
+    glDeleteRenderbuffers(1, &rboProfundidade);
+    glDeleteFramebuffers(1, &fbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glDisable(GL_DEPTH_TEST);
+    std::cout << std::endl;
+}
+
+// Shaders da cena de niveis de detalhe: posição transformada por uma matriz por objeto.
+static const char* vertexShaderLODSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"uniform mat4 uProjecaoVisaoModelo;\n"
+"out float Altura;\n"
+"void main()\n"
+"{\n"
+"   gl_Position = uProjecaoVisaoModelo * vec4(aPos, 1.0);\n"
+"   Altura = aPos.y * 0.5 + 0.5;\n"
+"}\n\0";
+
+static const char* fragmentShaderLODSource = "#version 330 core\n"
+"in float Altura;\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"    FragColor = vec4(Altura, 0.5, 1.0 - Altura, 1.0);\n"
+"}\n\0";
+
+// Tempo de quadro de uma grade de esferas densas com todos os objetos no nivel 0 e com o nivel escolhido
+// pelo erro na tela. Todos os niveis estão no mesmo VBO/EBO; só muda o intervalo de indices do desenho.
+static void benchmarkNivelDetalhe()
+{
+    std::cout << "== Niveis de detalhe: 2500 esferas de 16 mil triângulos ==" << std::endl;
+
+    MalhaIndexada esfera;
+    geraMalhaEsfera(esfera, 128, 64);
+    MalhaLOD lod;
+    geraCadeiaLOD(esfera, lod, 6);
+
+    unsigned int vao, vbo, ebo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, lod.malha.vertices.size() * sizeof(float), lod.malha.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, lod.malha.indices.size() * sizeof(unsigned int), lod.malha.indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, lod.malha.componentes * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    const int lado = 50;
+    const size_t numObjetos = (size_t)lado * lado;
+    VolumesEnvolventes volumes;
+    redimensionaVolumes(volumes, numObjetos);
+    std::vector<uint32_t> objetos(numObjetos);
+    for (int z = 0; z < lado; z++) {
+        for (int x = 0; x < lado; x++) {
+            size_t i = (size_t)z * lado + x;
+            defineEsfera(volumes, i, Vec3(x * 3.0f, 0.0f, -z * 3.0f), lod.raio);
+            objetos[i] = (uint32_t)i;
+        }
+    }
+
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const float campoVisao = 1.0f;
+    Vec3 camera(lado * 1.5f, 3.0f, 5.0f);
+    Mat4 projecaoVisao = perspectiva(campoVisao, (float)viewport[2] / std::max(viewport[3], 1), 0.1f, 500.0f) *
+                         olharPara(camera, camera + Vec3(0.0f, -0.1f, -1.0f), Vec3(0, 1, 0));
+
+    unsigned int programa = criaPrograma(vertexShaderLODSource, fragmentShaderLODSource);
+    int uProjecaoVisaoModelo = glGetUniformLocation(programa, "uProjecaoVisaoModelo");
+    glEnable(GL_DEPTH_TEST);
+
+    const int quadros = 10;
+    for (int usaLOD = 0; usaLOD < 2; usaLOD++) {
+        std::vector<uint8_t> niveis(numObjetos, 0);
+        size_t triangulos = 0;
+        double cpu = 0.0;
+        glFinish();
+        double inicio = tempoAtualMs();
+        for (int q = 0; q < quadros; q++) {
+            double inicioCPU = tempoAtualMs();
+            if (usaLOD) {
+                selecionaLODs(lod, volumes, objetos.data(), numObjetos, camera, escalaErroTela(campoVisao, viewport[3]), 1.0f, 0.25f, niveis.data());
+            }
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUseProgram(programa);
+            glBindVertexArray(vao);
+            for (size_t i = 0; i < numObjetos; i++) {
+                const NivelLOD& nivel = lod.niveis[niveis[i]];
+                Mat4 matriz = projecaoVisao * translacao(Vec3(volumes.centroX[i], volumes.centroY[i], volumes.centroZ[i]));
+                glUniformMatrix4fv(uProjecaoVisaoModelo, 1, GL_FALSE, matriz.dados());
+                glDrawElements(GL_TRIANGLES, (GLsizei)nivel.numIndices, GL_UNSIGNED_INT, (void*)(nivel.primeiroIndice * sizeof(unsigned int)));
+                triangulos += nivel.numIndices / 3;
+            }
+            cpu += tempoAtualMs() - inicioCPU;
+            glFinish();
+        }
+        double total = (tempoAtualMs() - inicio) / quadros;
+
+        std::cout << (usaLOD ? "Com LOD: " : "Sem LOD: ") << total << " ms/quadro (CPU " << cpu / quadros << " ms), "
+                  << triangulos / quadros << " triângulos/quadro" << std::endl;
+    }
+    std::cout << std::endl;
+
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    glDeleteProgram(programa);
+}
+
+void executaBenchmarksGL()
+{
+    benchmarkComparaBackends();
+    benchmarkConformidadeGLSL();
+    benchmarkEnvioFormatoVertice();
+    benchmarkInstancias();
+    benchmarkNivelDetalhe();
+    benchmarkStreaming();
+    benchmarkLeituraPixels();
+}
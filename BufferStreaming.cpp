@@ -0,0 +1,148 @@
+#include "BufferStreaming.h"
+
+// Constantes do ARB_buffer_storage (GL 4.4), caso o cabeçalho não tenha.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+void criaBufferAnel(BufferAnel& anel, size_t tamanhoPorQuadro, bool permitePersistente)
+{
+    anel.tamanhoRegiao = tamanhoPorQuadro;
+    anel.regiaoAtual = 0;
+    anel.deslocamento = 0;
+    anel.mapeado = nullptr;
+    anel.mapeamentoAberto = false;
+    for (unsigned int i = 0; i < regioesBufferAnel; i++) {
+        anel.fences[i] = 0;
+    }
+
+    GLsizeiptr tamanhoTotal = (GLsizeiptr)(tamanhoPorQuadro * regioesBufferAnel);
+
+    glGenBuffers(1, &anel.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, anel.buffer);
+
+    anel.persistente = permitePersistente && GLAD_GL_ARB_buffer_storage && glBufferStorage != NULL;
+
+    if (anel.persistente) {
+        // Armazenamento imutavel, mapeado uma vez durante toda a vida do buffer.
+        // Coerente: o que a CPU escreve fica visivel para a GPU sem glFlushMappedBufferRange.
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, tamanhoTotal, NULL, flags);
+        anel.mapeado = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, tamanhoTotal, flags);
+
+        if (anel.mapeado == nullptr) {
+            // Driver recusou o mapeamento: volta para o caminho com glMapBufferRange por alocação.
+            glDeleteBuffers(1, &anel.buffer);
+            glGenBuffers(1, &anel.buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, anel.buffer);
+            anel.persistente = false;
+        }
+    }
+
+    if (!anel.persistente) {
+        glBufferData(GL_ARRAY_BUFFER, tamanhoTotal, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void* alocaBufferAnel(BufferAnel& anel, size_t bytes, size_t alinhamento, size_t* deslocamentoBuffer)
+{
+    // Alinha o inicio da alocação (alinhamento precisa ser potência de 2).
+    size_t inicio = (anel.deslocamento + alinhamento - 1) & ~(alinhamento - 1);
+    if (inicio + bytes > anel.tamanhoRegiao) {
+        return nullptr;
+    }
+
+    anel.deslocamento = inicio + bytes;
+    size_t posicao = (size_t)anel.regiaoAtual * anel.tamanhoRegiao + inicio;
+    if (deslocamentoBuffer) {
+        *deslocamentoBuffer = posicao;
+    }
+
+    if (anel.persistente) {
+        return anel.mapeado + posicao;
+    }
+
+    // Só um mapeamento por vez no mesmo buffer.
+    concluiEscritaBufferAnel(anel);
+
+    // Sem sincronização: o fence da região já garante que a GPU terminou de ler este trecho.
+    // Invalidate: o conteudo antigo não precisa ser preservado.
+    glBindBuffer(GL_ARRAY_BUFFER, anel.buffer);
+    void* ponteiro = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)posicao, (GLsizeiptr)bytes,
+                                      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    anel.mapeamentoAberto = (ponteiro != nullptr);
+    return ponteiro;
+}
+
+void concluiEscritaBufferAnel(BufferAnel& anel)
+{
+    if (anel.mapeamentoAberto) {
+        glBindBuffer(GL_ARRAY_BUFFER, anel.buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        anel.mapeamentoAberto = false;
+    }
+}
+
+// Espera a GPU sinalizar o fence e o apaga.
+static void esperaFence(GLsync& fence)
+{
+    if (fence == 0) {
+        return;
+    }
+
+    // O primeiro teste envia os comandos pendentes, senão o fence pode nunca ser alcançado.
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true) {
+        GLenum resultado = glClientWaitSync(fence, flags, 1000000);  // 1 ms
+        if (resultado == GL_ALREADY_SIGNALED || resultado == GL_CONDITION_SATISFIED || resultado == GL_WAIT_FAILED) {
+            break;
+        }
+        flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = 0;
+}
+
+void finalizaQuadroBufferAnel(BufferAnel& anel)
+{
+    concluiEscritaBufferAnel(anel);
+
+    // Protege a região usada neste quadro até a GPU terminar os desenhos já enviados.
+    if (anel.fences[anel.regiaoAtual] != 0) {
+        glDeleteSync(anel.fences[anel.regiaoAtual]);
+    }
+    anel.fences[anel.regiaoAtual] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // Avança para a proxima região; só espera se a GPU estiver 3 quadros atrasada.
+    anel.regiaoAtual = (anel.regiaoAtual + 1) % regioesBufferAnel;
+    anel.deslocamento = 0;
+    esperaFence(anel.fences[anel.regiaoAtual]);
+}
+
+void destroiBufferAnel(BufferAnel& anel)
+{
+    concluiEscritaBufferAnel(anel);
+
+    for (unsigned int i = 0; i < regioesBufferAnel; i++) {
+        if (anel.fences[i] != 0) {
+            glDeleteSync(anel.fences[i]);
+            anel.fences[i] = 0;
+        }
+    }
+
+    if (anel.persistente) {
+        glBindBuffer(GL_ARRAY_BUFFER, anel.buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        anel.mapeado = nullptr;
+    }
+
+    glDeleteBuffers(1, &anel.buffer);
+    anel.buffer = 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Buffer de streaming para geometria que muda a cada quadro (UI, particulas).
+// Um VBO dividido em 3 regiões (uma por quadro em voo): a CPU escreve numa região enquanto a GPU
+// lê as outras. Cada região é protegida por um fence (glFenceSync) antes de ser reutilizada.
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Numero de regiões do anel (triple buffering).
+const unsigned int regioesBufferAnel = 3;
+
+struct BufferAnel {
+    unsigned int buffer = 0;
+    size_t tamanhoRegiao = 0;
+    unsigned int regiaoAtual = 0;
+    size_t deslocamento = 0;          // Bytes já alocados na região atual.
+    bool persistente = false;         // ARB_buffer_storage: buffer mapeado uma unica vez.
+    char* mapeado = nullptr;          // Inicio do mapeamento persistente.
+    bool mapeamentoAberto = false;    // Sem ARB_buffer_storage: existe um glMapBufferRange pendente.
+    GLsync fences[regioesBufferAnel] = {};
+};
+
+// Cria o anel com "tamanhoPorQuadro" bytes por região.
+// Usa mapeamento persistente e coerente quando ARB_buffer_storage existe e "permitePersistente" é verdadeiro.
+void criaBufferAnel(BufferAnel& anel, size_t tamanhoPorQuadro, bool permitePersistente = true);
+
+// Reserva "bytes" na região atual e retorna o ponteiro para escrita (NULL se a região estiver cheia).
+// "deslocamentoBuffer" recebe a posição dentro do VBO, usada no glVertexAttribPointer/glDrawArrays.
+void* alocaBufferAnel(BufferAnel& anel, size_t bytes, size_t alinhamento, size_t* deslocamentoBuffer);
+
+// Deve ser chamada depois de escrever e antes de desenhar (desfaz o glMapBufferRange sem mapeamento persistente).
+void concluiEscritaBufferAnel(BufferAnel& anel);
+
+// Marca o fim do quadro: protege a região atual com um fence e espera a proxima região ficar livre.
+void finalizaQuadroBufferAnel(BufferAnel& anel);
+
+void destroiBufferAnel(BufferAnel& anel);
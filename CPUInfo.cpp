@@ -0,0 +1,88 @@
+#include "CPUInfo.h"
+
+#if SIMD_X86 && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+#if SIMD_X86
+// Executa a instrução CPUID (folha e subfolha) e devolve EAX, EBX, ECX e EDX.
+static void executaCPUID(unsigned int folha, unsigned int subfolha, unsigned int registradores[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)folha, (int)subfolha);
+    for (int i = 0; i < 4; i++) {
+        registradores[i] = (unsigned int)r[i];
+    }
+#else
+    __cpuid_count(folha, subfolha, registradores[0], registradores[1], registradores[2], registradores[3]);
+#endif
+}
+
+// Le o registrador XCR0: diz se o sistema operacional salva os registradores AVX (YMM) nas trocas de contexto.
+static unsigned long long leXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+static RecursosCPU detectaRecursos()
+{
+    RecursosCPU recursos;
+
+#if SIMD_X86
+    unsigned int r[4];
+    executaCPUID(0, 0, r);
+    unsigned int maiorFolha = r[0];
+
+    executaCPUID(1, 0, r);
+    recursos.sse41 = (r[2] & (1u << 19)) != 0;
+    bool osxsave = (r[2] & (1u << 27)) != 0;
+    bool avx = (r[2] & (1u << 28)) != 0;
+    bool fma = (r[2] & (1u << 12)) != 0;
+
+    // AVX só pode ser usado se o sistema salva os estados XMM (bit 1) e YMM (bit 2).
+    bool estadoAVX = osxsave && (leXCR0() & 0x6) == 0x6;
+
+    if (maiorFolha >= 7) {
+        executaCPUID(7, 0, r);
+        recursos.avx2 = avx && estadoAVX && (r[1] & (1u << 5)) != 0;
+    }
+    recursos.fma = fma && estadoAVX;
+#endif
+
+    return recursos;
+}
+
+const RecursosCPU& recursosCPU()
+{
+    static const RecursosCPU recursos = detectaRecursos();
+    return recursos;
+}
+
+NivelSIMD melhorNivelSIMD()
+{
+    const RecursosCPU& recursos = recursosCPU();
+    if (recursos.avx2) {
+        return simdAVX2;
+    }
+    if (recursos.sse41) {
+        return simdSSE41;
+    }
+    return simdEscalar;
+}
+
+const char* nomeNivelSIMD(NivelSIMD nivel)
+{
+    switch (nivel) {
+    case simdAVX2: return "AVX2";
+    case simdSSE41: return "SSE4.1";
+    default: return "escalar";
+    }
+}
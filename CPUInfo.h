@@ -0,0 +1,107 @@
+#pragma once
+
+// Detecção dos recursos SIMD do processador (CPUID), para escolher o codigo mais rapido em tempo de execução.
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// No GCC/Clang, funções com intrinsics de AVX2/SSE4.1 precisam declarar o conjunto de instruções
+// (o resto do programa continua compilado para x86-64 basico). No MSVC os intrinsics já estão sempre disponiveis.
+#if defined(__GNUC__) || defined(__clang__)
+#define ALVO_AVX2 __attribute__((target("avx2,fma")))
+#define ALVO_SSE41 __attribute__((target("sse4.1")))
+#else
+#define ALVO_AVX2
+#define ALVO_SSE41
+#endif
+
+// Arquitetura x86 (SSE/AVX disponiveis para compilar).
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+
+struct RecursosCPU {
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+};
+
+// Recursos do processador atual (detectados uma unica vez).
+const RecursosCPU& recursosCPU();
+
+// Nivel de SIMD usado pelos kernels com varias implementações.
+enum NivelSIMD {
+    simdEscalar = 0,
+    simdSSE41 = 1,
+    simdAVX2 = 2
+};
+
+// Melhor nivel suportado pelo processador.
+NivelSIMD melhorNivelSIMD();
+
+const char* nomeNivelSIMD(NivelSIMD nivel);
+
+const int numNiveisSIMD = simdAVX2 + 1;
+
+// Implementação que só existe quando SIMD_X86 (nula nas outras arquiteturas), para as tabelas do DespachoSIMD.
+#if SIMD_X86
+#define IMPLEMENTACAO_X86(funcao) (funcao)
+#else
+#define IMPLEMENTACAO_X86(funcao) nullptr
+#endif
+
+// Tabela das implementações de um kernel, uma por NivelSIMD (nula quando o nivel não tem versão propria:
+// usa a do nivel abaixo). Começa no melhor nivel do processador; seleciona troca o nivel, limitado a ele.
+template <typename Funcao>
+class DespachoSIMD {
+public:
+    DespachoSIMD(Funcao escalar, Funcao sse41, Funcao avx2)
+        : implementacoes{ escalar, sse41, avx2 }
+    {
+        seleciona(melhorNivelSIMD());
+    }
+
+    // Retorna o nivel efetivo.
+    NivelSIMD seleciona(NivelSIMD nivel)
+    {
+        nivelAtual = nivel > melhorNivelSIMD() ? melhorNivelSIMD() : nivel;
+        int usado = nivelAtual;
+        while (usado > simdEscalar && implementacoes[usado] == nullptr) {
+            usado--;
+        }
+        funcaoAtual = implementacoes[usado];
+        return nivelAtual;
+    }
+
+    NivelSIMD nivel() const { return nivelAtual; }
+    Funcao funcao() const { return funcaoAtual; }
+
+private:
+    Funcao implementacoes[numNiveisSIMD];
+    NivelSIMD nivelAtual;
+    Funcao funcaoAtual;
+};
+
+// Posição do bit ligado menos significativo (valor não pode ser zero).
+inline int primeiroBitLigado(uint64_t valor)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long indice;
+    _BitScanForward64(&indice, valor);
+    return (int)indice;
+#elif defined(_MSC_VER)
+    unsigned long indice;
+    if (_BitScanForward(&indice, (unsigned long)valor)) {
+        return (int)indice;
+    }
+    _BitScanForward(&indice, (unsigned long)(valor >> 32));
+    return (int)indice + 32;
+#else
+    return __builtin_ctzll(valor);
+#endif
+}
@@ -0,0 +1,136 @@
+#include "CoberturaSIMD.h"
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+// As arestas são inteiros de 64 bits com a regra de preenchimento já somada: o pixel está dentro quando os
+// 3 valores são >= 0, ou seja, quando o bit de sinal do OU dos três é zero.
+
+static uint64_t coberturaEscalar(const TrianguloPreparado& t, int x0, int y0)
+{
+    uint64_t mascara = 0;
+    for (int y = 0; y < 8; y++) {
+        int64_t linha0 = t.arestaB[0] * (y0 + y) + t.arestaC[0];
+        int64_t linha1 = t.arestaB[1] * (y0 + y) + t.arestaC[1];
+        int64_t linha2 = t.arestaB[2] * (y0 + y) + t.arestaC[2];
+
+        for (int x = 0; x < 8; x++) {
+            int64_t e0 = t.arestaA[0] * (x0 + x) + linha0;
+            int64_t e1 = t.arestaA[1] * (x0 + x) + linha1;
+            int64_t e2 = t.arestaA[2] * (x0 + x) + linha2;
+            if ((e0 | e1 | e2) >= 0) {
+                mascara |= 1ull << (y * 8 + x);
+            }
+        }
+    }
+    return mascara;
+}
+
+#if SIMD_X86
+// As versões SIMD andam pelo bloco com lanes de 32 bits: valor no canto (x0, y0) e somas de A por coluna e de
+// B por linha. A e B são multiplos de 2^bitsSubpixel, então E >= 0 equivale a floor(E / 2^bitsSubpixel) >= 0
+// e os passos divididos são exatos. O canto é limitado a +-2^30: com os passos do bloco menores que 2^30, um
+// canto além do limite tem o mesmo sinal no bloco todo, e o limitado também. O resultado é igual ao escalar.
+struct ArestaBloco {
+    int32_t canto, passoX, passoY;
+};
+
+static bool preparaArestasBloco(const TrianguloPreparado& t, int x0, int y0, ArestaBloco arestas[3])
+{
+    const int64_t limite = 1 << 30;
+    for (int e = 0; e < 3; e++) {
+        int64_t passoX = t.arestaA[e] >> bitsSubpixel;
+        int64_t passoY = t.arestaB[e] >> bitsSubpixel;
+        // Arestas maiores que a banda de guarda permite: fica com o escalar.
+        if (8 * ((passoX < 0 ? -passoX : passoX) + (passoY < 0 ? -passoY : passoY)) >= limite) {
+            return false;
+        }
+        int64_t canto = (t.arestaA[e] * x0 + t.arestaB[e] * y0 + t.arestaC[e]) >> bitsSubpixel;
+        canto = canto < -limite ? -limite : (canto > limite ? limite : canto);
+        arestas[e].canto = (int32_t)canto;
+        arestas[e].passoX = (int32_t)passoX;
+        arestas[e].passoY = (int32_t)passoY;
+    }
+    return true;
+}
+
+ALVO_SSE41 static uint64_t coberturaSSE41(const TrianguloPreparado& t, int x0, int y0)
+{
+    ArestaBloco arestas[3];
+    if (!preparaArestasBloco(t, x0, y0, arestas)) {
+        return coberturaEscalar(t, x0, y0);
+    }
+
+    // Colunas 0 a 3 e 4 a 7 da linha atual de cada aresta.
+    __m128i baixo[3], alto[3], passoY[3];
+    for (int e = 0; e < 3; e++) {
+        __m128i passoX = _mm_set1_epi32(arestas[e].passoX);
+        baixo[e] = _mm_add_epi32(_mm_set1_epi32(arestas[e].canto), _mm_mullo_epi32(passoX, _mm_setr_epi32(0, 1, 2, 3)));
+        alto[e] = _mm_add_epi32(baixo[e], _mm_slli_epi32(passoX, 2));
+        passoY[e] = _mm_set1_epi32(arestas[e].passoY);
+    }
+
+    uint64_t mascara = 0;
+    for (int y = 0; y < 8; y++) {
+        __m128i sinaisBaixo = _mm_or_si128(_mm_or_si128(baixo[0], baixo[1]), baixo[2]);
+        __m128i sinaisAlto = _mm_or_si128(_mm_or_si128(alto[0], alto[1]), alto[2]);
+        // Bit ligado = algum valor negativo (fora).
+        uint64_t fora = (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(sinaisBaixo))
+                      | ((uint64_t)_mm_movemask_ps(_mm_castsi128_ps(sinaisAlto)) << 4);
+        mascara |= (~fora & 0xFF) << (y * 8);
+        for (int e = 0; e < 3; e++) {
+            baixo[e] = _mm_add_epi32(baixo[e], passoY[e]);
+            alto[e] = _mm_add_epi32(alto[e], passoY[e]);
+        }
+    }
+    return mascara;
+}
+
+ALVO_AVX2 static uint64_t coberturaAVX2(const TrianguloPreparado& t, int x0, int y0)
+{
+    ArestaBloco arestas[3];
+    if (!preparaArestasBloco(t, x0, y0, arestas)) {
+        return coberturaEscalar(t, x0, y0);
+    }
+
+    // Uma linha do bloco por registrador.
+    __m256i linha[3], passoY[3];
+    for (int e = 0; e < 3; e++) {
+        linha[e] = _mm256_add_epi32(_mm256_set1_epi32(arestas[e].canto),
+                                    _mm256_mullo_epi32(_mm256_set1_epi32(arestas[e].passoX), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+        passoY[e] = _mm256_set1_epi32(arestas[e].passoY);
+    }
+
+    uint64_t mascara = 0;
+    for (int y = 0; y < 8; y++) {
+        __m256i sinais = _mm256_or_si256(_mm256_or_si256(linha[0], linha[1]), linha[2]);
+        uint64_t fora = (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(sinais));
+        mascara |= (~fora & 0xFF) << (y * 8);
+        for (int e = 0; e < 3; e++) {
+            linha[e] = _mm256_add_epi32(linha[e], passoY[e]);
+        }
+    }
+    return mascara;
+}
+#endif
+
+typedef uint64_t (*FuncaoCobertura)(const TrianguloPreparado& triangulo, int x0, int y0);
+
+static DespachoSIMD<FuncaoCobertura> despachoCobertura(coberturaEscalar, IMPLEMENTACAO_X86(coberturaSSE41),
+                                                       IMPLEMENTACAO_X86(coberturaAVX2));
+
+uint64_t coberturaBloco8x8(const TrianguloPreparado& triangulo, int x0, int y0)
+{
+    return despachoCobertura.funcao()(triangulo, x0, y0);
+}
+
+NivelSIMD selecionaNivelCobertura(NivelSIMD nivel)
+{
+    return despachoCobertura.seleciona(nivel);
+}
+
+NivelSIMD nivelCobertura()
+{
+    return despachoCobertura.nivel();
+}
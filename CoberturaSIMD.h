@@ -0,0 +1,30 @@
+#pragma once
+
+// Cobertura de blocos de 8x8 pixels: avalia as 3 arestas do triângulo em varios pixels por instrução.
+// AVX2 (8 pixels por instrução) ou SSE4.1 (4 pixels), escolhido em tempo de execução pelo CPUID.
+
+#include "RasterizadorCPU.h"
+#include "CPUInfo.h"
+
+#include <cstdint>
+
+// Mascara de cobertura do bloco com canto inferior esquerdo em (x0, y0): bit (y * 8 + x) ligado
+// quando o centro do pixel (x0 + x, y0 + y) está dentro do triângulo (mesma regra de preenchimento).
+uint64_t coberturaBloco8x8(const TrianguloPreparado& triangulo, int x0, int y0);
+
+// Mascara (bits y * 8 + x) dos pixels do bloco dentro do retângulo [minX, maxX] x [minY, maxY].
+inline uint64_t mascaraRetanguloBloco(int bx, int by, int minX, int minY, int maxX, int maxY)
+{
+    int c0 = minX - bx > 0 ? minX - bx : 0, c1 = maxX - bx < 7 ? maxX - bx : 7;
+    int l0 = minY - by > 0 ? minY - by : 0, l1 = maxY - by < 7 ? maxY - by : 7;
+    uint64_t colunas = ((1ull << (c1 + 1)) - 1) & ~((1ull << c0) - 1);
+    uint64_t mascara = 0;
+    for (int l = l0; l <= l1; l++) {
+        mascara |= colunas << (l * 8);
+    }
+    return mascara;
+}
+
+// Troca a implementação usada (limitada ao que o processador suporta). Retorna o nivel efetivo.
+NivelSIMD selecionaNivelCobertura(NivelSIMD nivel);
+NivelSIMD nivelCobertura();
@@ -0,0 +1,559 @@
+#include "CodificadorImagem.h"
+#include "FormatoVertice.h"
+
+#include <cstring>
+#include <fstream>
+// Usado para escrever no console com C++
+#include <iostream>
+
+// ---------------------------------------------------------------------------------------------
+// Deflate (RFC 1951) com codigos de Huffman fixos.
+
+// Base e bits extras dos codigos de comprimento (257 a 285) e de distancia (0 a 29).
+static const uint16_t baseComprimento[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                              35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t extrasComprimento[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                               3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t baseDistancia[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                            513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t extrasDistancia[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7,
+                                             8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+const int janelaDeflate = 32768;
+const int bitsHashDeflate = 15;
+const int minimoCasamento = 3;
+const int maximoCasamento = 258;
+
+// O deflate escreve os bits do menos para o mais significativo, mas os codigos de Huffman vão do
+// mais significativo para o menos: as tabelas já guardam os codigos invertidos.
+static uint32_t inverteBits(uint32_t codigo, int bits)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < bits; i++) {
+        r = (r << 1) | ((codigo >> i) & 1);
+    }
+    return r;
+}
+
+struct TabelasDeflate {
+    uint16_t codigoLiteral[288];
+    uint8_t bitsLiteral[288];
+    uint8_t codigoDistancia[30];
+    // Comprimento (3 a 258) e distancia (1 a 32768) para o indice do codigo.
+    uint8_t indiceComprimento[maximoCasamento + 1];
+    uint8_t indiceDistancia[janelaDeflate + 1];
+
+    TabelasDeflate()
+    {
+        // Tabela fixa da seção 3.2.6 da RFC 1951.
+        for (int s = 0; s < 288; s++) {
+            uint32_t codigo;
+            int bits;
+            if (s < 144)      { codigo = 0x30 + s;          bits = 8; }
+            else if (s < 256) { codigo = 0x190 + (s - 144); bits = 9; }
+            else if (s < 280) { codigo = s - 256;           bits = 7; }
+            else              { codigo = 0xC0 + (s - 280);  bits = 8; }
+            codigoLiteral[s] = (uint16_t)inverteBits(codigo, bits);
+            bitsLiteral[s] = (uint8_t)bits;
+        }
+        for (int d = 0; d < 30; d++) {
+            codigoDistancia[d] = (uint8_t)inverteBits(d, 5);
+        }
+        for (int c = 0; c < 29; c++) {
+            int fim = c == 28 ? maximoCasamento : baseComprimento[c + 1] - 1;
+            for (int l = baseComprimento[c]; l <= fim; l++) {
+                indiceComprimento[l] = (uint8_t)c;
+            }
+        }
+        for (int c = 0; c < 30; c++) {
+            int fim = c == 29 ? janelaDeflate : baseDistancia[c + 1] - 1;
+            for (int d = baseDistancia[c]; d <= fim; d++) {
+                indiceDistancia[d] = (uint8_t)c;
+            }
+        }
+    }
+};
+
+static const TabelasDeflate& tabelasDeflate()
+{
+    static const TabelasDeflate tabelas;
+    return tabelas;
+}
+
+struct EscritorBits {
+    std::vector<uint8_t>& saida;
+    uint64_t acumulado = 0;
+    int bits = 0;
+
+    explicit EscritorBits(std::vector<uint8_t>& destino) : saida(destino) {}
+
+    void escreve(uint32_t valor, int n)
+    {
+        acumulado |= (uint64_t)valor << bits;
+        bits += n;
+        while (bits >= 8) {
+            saida.push_back((uint8_t)acumulado);
+            acumulado >>= 8;
+            bits -= 8;
+        }
+    }
+
+    void completaByte()
+    {
+        if (bits > 0) {
+            escreve(0, 8 - bits);
+        }
+    }
+};
+
+static void escreveBlocosSemCompressao(const uint8_t* dados, size_t tamanho, std::vector<uint8_t>& saida)
+{
+    size_t posicao = 0;
+    do {
+        size_t n = tamanho - posicao < 65535 ? tamanho - posicao : 65535;
+        bool ultimo = posicao + n == tamanho;
+        // BFINAL e BTYPE = 00 ocupam um byte inteiro, seguidos de LEN e NLEN.
+        saida.push_back(ultimo ? 1 : 0);
+        saida.push_back((uint8_t)n);
+        saida.push_back((uint8_t)(n >> 8));
+        saida.push_back((uint8_t)~n);
+        saida.push_back((uint8_t)(~n >> 8));
+        saida.insert(saida.end(), dados + posicao, dados + posicao + n);
+        posicao += n;
+    } while (posicao < tamanho);
+}
+
+static inline uint32_t hashTresBytes(const uint8_t* p)
+{
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - bitsHashDeflate);
+}
+
+static void escreveDeflate(const uint8_t* dados, size_t tamanho, std::vector<uint8_t>& saida, int nivel)
+{
+    if (nivel <= 0) {
+        escreveBlocosSemCompressao(dados, tamanho, saida);
+        return;
+    }
+
+    const TabelasDeflate& t = tabelasDeflate();
+
+    // Nivel 1 segue o deflate_fast do zlib: cadeia curta e só as posições de casamentos curtos entram no hash.
+    int maxCadeia = nivel == 1 ? 4 : 64;
+    int maxInsercao = nivel == 1 ? 16 : maximoCasamento;
+
+    std::vector<int32_t> cabeca((size_t)1 << bitsHashDeflate, -1);
+    std::vector<int32_t> anterior(janelaDeflate, -1);
+
+    EscritorBits escritor(saida);
+    // Um bloco só, final, com Huffman fixo.
+    escritor.escreve(1, 1);
+    escritor.escreve(1, 2);
+
+    int32_t n = (int32_t)tamanho;
+    int32_t i = 0;
+    while (i < n) {
+        int melhor = 0;
+        int32_t distancia = 0;
+
+        if (i + minimoCasamento <= n) {
+            uint32_t h = hashTresBytes(dados + i);
+            int limite = n - i < maximoCasamento ? n - i : maximoCasamento;
+
+            int32_t candidato = cabeca[h];
+            for (int cadeia = maxCadeia; candidato >= 0 && i - candidato <= janelaDeflate && cadeia > 0; cadeia--) {
+                const uint8_t* a = dados + candidato;
+                const uint8_t* b = dados + i;
+                // O byte logo depois do melhor atual decide rapido se o candidato pode ser maior.
+                if (a[melhor] == b[melhor] && a[0] == b[0]) {
+                    int l = 1;
+                    while (l < limite && a[l] == b[l]) {
+                        l++;
+                    }
+                    if (l > melhor) {
+                        melhor = l;
+                        distancia = i - candidato;
+                        if (l == limite) {
+                            break;
+                        }
+                    }
+                }
+                int32_t proximo = anterior[candidato & (janelaDeflate - 1)];
+                if (proximo >= candidato) {
+                    break;
+                }
+                candidato = proximo;
+            }
+
+            anterior[i & (janelaDeflate - 1)] = cabeca[h];
+            cabeca[h] = i;
+        }
+
+        if (melhor >= minimoCasamento) {
+            int c = t.indiceComprimento[melhor];
+            escritor.escreve(t.codigoLiteral[257 + c], t.bitsLiteral[257 + c]);
+            escritor.escreve(melhor - baseComprimento[c], extrasComprimento[c]);
+            int d = t.indiceDistancia[distancia];
+            escritor.escreve(t.codigoDistancia[d], 5);
+            escritor.escreve(distancia - baseDistancia[d], extrasDistancia[d]);
+
+            if (melhor <= maxInsercao) {
+                for (int k = 1; k < melhor && i + k + minimoCasamento <= n; k++) {
+                    uint32_t h = hashTresBytes(dados + i + k);
+                    anterior[(i + k) & (janelaDeflate - 1)] = cabeca[h];
+                    cabeca[h] = i + k;
+                }
+            }
+            i += melhor;
+        }
+        else {
+            escritor.escreve(t.codigoLiteral[dados[i]], t.bitsLiteral[dados[i]]);
+            i++;
+        }
+    }
+
+    // Fim do bloco.
+    escritor.escreve(t.codigoLiteral[256], t.bitsLiteral[256]);
+    escritor.completaByte();
+}
+
+static uint32_t adler32(const uint8_t* dados, size_t tamanho)
+{
+    uint32_t a = 1, b = 0;
+    while (tamanho > 0) {
+        // 5552 bytes é o maximo antes de b passar de 32 bits.
+        size_t n = tamanho < 5552 ? tamanho : 5552;
+        tamanho -= n;
+        for (size_t i = 0; i < n; i++) {
+            a += dados[i];
+            b += a;
+        }
+        dados += n;
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void escreve32BE(std::vector<uint8_t>& saida, uint32_t v)
+{
+    saida.push_back((uint8_t)(v >> 24));
+    saida.push_back((uint8_t)(v >> 16));
+    saida.push_back((uint8_t)(v >> 8));
+    saida.push_back((uint8_t)v);
+}
+
+void comprimeZlib(const uint8_t* dados, size_t tamanho, std::vector<uint8_t>& saida, int nivel)
+{
+    // CMF = deflate com janela de 32K; FLG com FCHECK para (CMF * 256 + FLG) ser multiplo de 31.
+    saida.push_back(0x78);
+    saida.push_back(0x01);
+    escreveDeflate(dados, tamanho, saida, nivel);
+    escreve32BE(saida, adler32(dados, tamanho));
+}
+
+// ---------------------------------------------------------------------------------------------
+// PNG
+
+static uint32_t atualizaCRC32(uint32_t crc, const uint8_t* dados, size_t tamanho)
+{
+    static const struct TabelaCRC {
+        uint32_t v[256];
+        TabelaCRC()
+        {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                v[n] = c;
+            }
+        }
+    } tabela;
+
+    crc = ~crc;
+    for (size_t i = 0; i < tamanho; i++) {
+        crc = tabela.v[(crc ^ dados[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void escreveChunkPNG(std::vector<uint8_t>& saida, const char* tipo, const uint8_t* dados, size_t tamanho)
+{
+    escreve32BE(saida, (uint32_t)tamanho);
+    size_t inicio = saida.size();
+    saida.insert(saida.end(), tipo, tipo + 4);
+    saida.insert(saida.end(), dados, dados + tamanho);
+    // O CRC cobre o tipo e os dados.
+    escreve32BE(saida, atualizaCRC32(0, saida.data() + inicio, tamanho + 4));
+}
+
+static inline uint8_t preditorPaeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+// Linha de RGBA8 para RGB.
+static void linhaRGB(const uint32_t* pixels, int largura, uint8_t* rgb)
+{
+    for (int x = 0; x < largura; x++) {
+        uint32_t p = pixels[x];
+        rgb[x * 3 + 0] = (uint8_t)p;
+        rgb[x * 3 + 1] = (uint8_t)(p >> 8);
+        rgb[x * 3 + 2] = (uint8_t)(p >> 16);
+    }
+}
+
+void codificaPNG(const uint32_t* pixels, int largura, int altura, std::vector<uint8_t>& saida,
+                 bool linhaZeroEmbaixo, int nivel)
+{
+    const int bpp = 3;
+    size_t bytesLinha = (size_t)largura * bpp;
+
+    // Cada linha ganha o byte do filtro na frente.
+    std::vector<uint8_t> filtrado((bytesLinha + 1) * altura);
+    std::vector<uint8_t> linhas(bytesLinha * 2);
+    uint8_t* atual = linhas.data();
+    uint8_t* acima = linhas.data() + bytesLinha;
+    std::memset(acima, 0, bytesLinha);
+
+    for (int y = 0; y < altura; y++) {
+        int origem = linhaZeroEmbaixo ? altura - 1 - y : y;
+        linhaRGB(pixels + (size_t)origem * largura, largura, atual);
+
+        // Escolhe o filtro com a menor soma dos residuos (com sinal), a heuristica da especificação.
+        uint32_t soma[5] = {};
+        for (size_t i = 0; i < bytesLinha; i++) {
+            int a = i >= bpp ? atual[i - bpp] : 0;
+            int b = acima[i];
+            int c = i >= bpp ? acima[i - bpp] : 0;
+            int x = atual[i];
+            int8_t r[5] = { (int8_t)x, (int8_t)(x - a), (int8_t)(x - b), (int8_t)(x - ((a + b) >> 1)),
+                            (int8_t)(x - preditorPaeth(a, b, c)) };
+            for (int f = 0; f < 5; f++) {
+                soma[f] += r[f] < 0 ? -r[f] : r[f];
+            }
+        }
+        int filtro = 0;
+        for (int f = 1; f < 5; f++) {
+            if (soma[f] < soma[filtro]) {
+                filtro = f;
+            }
+        }
+
+        uint8_t* destino = filtrado.data() + (bytesLinha + 1) * y;
+        destino[0] = (uint8_t)filtro;
+        destino++;
+        for (size_t i = 0; i < bytesLinha; i++) {
+            int a = i >= bpp ? atual[i - bpp] : 0;
+            int b = acima[i];
+            int c = i >= bpp ? acima[i - bpp] : 0;
+            int x = atual[i];
+            switch (filtro) {
+            case 0: destino[i] = (uint8_t)x; break;
+            case 1: destino[i] = (uint8_t)(x - a); break;
+            case 2: destino[i] = (uint8_t)(x - b); break;
+            case 3: destino[i] = (uint8_t)(x - ((a + b) >> 1)); break;
+            default: destino[i] = (uint8_t)(x - preditorPaeth(a, b, c)); break;
+            }
+        }
+
+        uint8_t* troca = atual;
+        atual = acima;
+        acima = troca;
+    }
+
+    std::vector<uint8_t> comprimido;
+    comprimido.reserve(filtrado.size() / 2);
+    comprimeZlib(filtrado.data(), filtrado.size(), comprimido, nivel);
+
+    static const uint8_t assinatura[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    saida.clear();
+    saida.reserve(comprimido.size() + 64);
+    saida.insert(saida.end(), assinatura, assinatura + 8);
+
+    // IHDR: 8 bits por canal, tipo de cor 2 (RGB), sem entrelaçamento.
+    std::vector<uint8_t> cabecalho;
+    escreve32BE(cabecalho, (uint32_t)largura);
+    escreve32BE(cabecalho, (uint32_t)altura);
+    const uint8_t resto[5] = { 8, 2, 0, 0, 0 };
+    cabecalho.insert(cabecalho.end(), resto, resto + 5);
+    escreveChunkPNG(saida, "IHDR", cabecalho.data(), cabecalho.size());
+
+    escreveChunkPNG(saida, "IDAT", comprimido.data(), comprimido.size());
+    escreveChunkPNG(saida, "IEND", nullptr, 0);
+}
+
+// ---------------------------------------------------------------------------------------------
+// OpenEXR
+
+static void escreve32LE(std::vector<uint8_t>& saida, uint32_t v)
+{
+    saida.push_back((uint8_t)v);
+    saida.push_back((uint8_t)(v >> 8));
+    saida.push_back((uint8_t)(v >> 16));
+    saida.push_back((uint8_t)(v >> 24));
+}
+
+static void escreveAtributoEXR(std::vector<uint8_t>& saida, const char* nome, const char* tipo,
+                               const std::vector<uint8_t>& valor)
+{
+    saida.insert(saida.end(), nome, nome + std::strlen(nome) + 1);
+    saida.insert(saida.end(), tipo, tipo + std::strlen(tipo) + 1);
+    escreve32LE(saida, (uint32_t)valor.size());
+    saida.insert(saida.end(), valor.begin(), valor.end());
+}
+
+static std::vector<uint8_t> valorFloatEXR(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, 4);
+    std::vector<uint8_t> v;
+    escreve32LE(v, bits);
+    return v;
+}
+
+void codificaEXR(const uint32_t* pixels, int largura, int altura, std::vector<uint8_t>& saida,
+                 bool linhaZeroEmbaixo, int nivel)
+{
+    // ZIP_COMPRESSION: 16 scanlines por bloco.
+    const int linhasBloco = 16;
+    int numBlocos = (altura + linhasBloco - 1) / linhasBloco;
+
+    uint16_t half[256];
+    for (int i = 0; i < 256; i++) {
+        half[i] = floatParaHalf(i / 255.0f);
+    }
+
+    saida.clear();
+    // Numero magico e versão 2 (scanlines, uma parte).
+    const uint8_t magico[8] = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 };
+    saida.insert(saida.end(), magico, magico + 8);
+
+    // Canais em ordem alfabetica: tipo HALF (1), pLinear 0, amostragem 1x1.
+    std::vector<uint8_t> canais;
+    for (const char* nome : { "B", "G", "R" }) {
+        canais.push_back((uint8_t)nome[0]);
+        canais.push_back(0);
+        escreve32LE(canais, 1);
+        escreve32LE(canais, 0);
+        escreve32LE(canais, 1);
+        escreve32LE(canais, 1);
+    }
+    canais.push_back(0);
+    escreveAtributoEXR(saida, "channels", "chlist", canais);
+    escreveAtributoEXR(saida, "compression", "compression", std::vector<uint8_t>(1, 3));
+
+    std::vector<uint8_t> janela;
+    escreve32LE(janela, 0);
+    escreve32LE(janela, 0);
+    escreve32LE(janela, (uint32_t)(largura - 1));
+    escreve32LE(janela, (uint32_t)(altura - 1));
+    escreveAtributoEXR(saida, "dataWindow", "box2i", janela);
+    escreveAtributoEXR(saida, "displayWindow", "box2i", janela);
+    escreveAtributoEXR(saida, "lineOrder", "lineOrder", std::vector<uint8_t>(1, 0));
+    escreveAtributoEXR(saida, "pixelAspectRatio", "float", valorFloatEXR(1.0f));
+    std::vector<uint8_t> centro(8, 0);
+    escreveAtributoEXR(saida, "screenWindowCenter", "v2f", centro);
+    escreveAtributoEXR(saida, "screenWindowWidth", "float", valorFloatEXR(1.0f));
+    saida.push_back(0);
+
+    // Tabela de deslocamentos (64 bits por bloco), preenchida no fim.
+    size_t tabela = saida.size();
+    saida.resize(tabela + (size_t)numBlocos * 8);
+
+    size_t bytesLinha = (size_t)largura * 3 * 2;
+    std::vector<uint8_t> bruto(bytesLinha * linhasBloco);
+    std::vector<uint8_t> reordenado(bruto.size());
+    std::vector<uint8_t> comprimido;
+
+    for (int bloco = 0; bloco < numBlocos; bloco++) {
+        int y0 = bloco * linhasBloco;
+        int linhas = altura - y0 < linhasBloco ? altura - y0 : linhasBloco;
+        size_t tamanho = bytesLinha * linhas;
+
+        // Dentro da linha: todos os B, depois todos os G e todos os R.
+        for (int l = 0; l < linhas; l++) {
+            int y = y0 + l;
+            int origem = linhaZeroEmbaixo ? altura - 1 - y : y;
+            const uint32_t* linha = pixels + (size_t)origem * largura;
+            uint8_t* destino = bruto.data() + bytesLinha * l;
+            for (int c = 0; c < 3; c++) {
+                int deslocamento = 16 - c * 8;     // B, G, R.
+                uint8_t* canal = destino + (size_t)c * largura * 2;
+                for (int x = 0; x < largura; x++) {
+                    uint16_t h = half[(linha[x] >> deslocamento) & 0xFF];
+                    canal[x * 2] = (uint8_t)h;
+                    canal[x * 2 + 1] = (uint8_t)(h >> 8);
+                }
+            }
+        }
+
+        // Como no OpenEXR: bytes pares na primeira metade, impares na segunda, e depois a diferença
+        // de cada byte para o anterior (os bytes altos dos halves quase não mudam e viram zeros).
+        size_t metade = (tamanho + 1) / 2;
+        for (size_t i = 0; i < tamanho; i++) {
+            reordenado[(i & 1) ? metade + i / 2 : i / 2] = bruto[i];
+        }
+        int anteriorByte = reordenado[0];
+        for (size_t i = 1; i < tamanho; i++) {
+            int atual = reordenado[i];
+            reordenado[i] = (uint8_t)(atual - anteriorByte + (128 + 256));
+            anteriorByte = atual;
+        }
+
+        comprimido.clear();
+        comprimeZlib(reordenado.data(), tamanho, comprimido, nivel);
+
+        uint64_t posicao = saida.size();
+        std::memcpy(&saida[tabela + (size_t)bloco * 8], &posicao, 8);
+
+        escreve32LE(saida, (uint32_t)y0);
+        // Bloco que não diminui vai sem compressão (o leitor reconhece pelo tamanho).
+        if (comprimido.size() < tamanho) {
+            escreve32LE(saida, (uint32_t)comprimido.size());
+            saida.insert(saida.end(), comprimido.begin(), comprimido.end());
+        }
+        else {
+            escreve32LE(saida, (uint32_t)tamanho);
+            saida.insert(saida.end(), bruto.begin(), bruto.begin() + tamanho);
+        }
+    }
+}
+
+void codificaImagem(FormatoImagem formato, const uint32_t* pixels, int largura, int altura,
+                    std::vector<uint8_t>& saida, bool linhaZeroEmbaixo)
+{
+    if (formato == imagemEXR) {
+        codificaEXR(pixels, largura, altura, saida, linhaZeroEmbaixo);
+    }
+    else {
+        codificaPNG(pixels, largura, altura, saida, linhaZeroEmbaixo);
+    }
+}
+
+const char* extensaoImagem(FormatoImagem formato)
+{
+    return formato == imagemEXR ? ".exr" : ".png";
+}
+
+bool gravaArquivo(const char* caminho, const std::vector<uint8_t>& dados)
+{
+    std::ofstream arquivo(caminho, std::ios::binary);
+    if (!arquivo) {
+        std::cout << "ERRO::ARQUIVO::NAO_FOI_POSSIVEL_CRIAR " << caminho << std::endl;
+        return false;
+    }
+    arquivo.write(reinterpret_cast<const char*>(dados.data()), (std::streamsize)dados.size());
+    if (!arquivo) {
+        std::cout << "ERRO::ARQUIVO::FALHA_NA_ESCRITA " << caminho << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Gravação do framebuffer em PNG (8 bits) e OpenEXR (half float), sem bibliotecas externas.
+// Os dois formatos usam o mesmo compressor deflate (LZ77 com cadeia de hash e codigos de Huffman fixos):
+// comprime menos que o zlib no nivel maximo, mas é rapido o bastante para gravar todos os quadros.
+// O canal alfa é descartado: a imagem sai em RGB.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum FormatoImagem {
+    imagemPNG,
+    imagemEXR
+};
+
+// Nivel de compressão: 0 = blocos sem compressão, 1 = rapido, 2 = procura mais longa.
+const int nivelCompressaoPadrao = 1;
+
+// Stream zlib (cabeçalho, deflate e Adler-32) com os bytes de "dados".
+void comprimeZlib(const uint8_t* dados, size_t tamanho, std::vector<uint8_t>& saida, int nivel = nivelCompressaoPadrao);
+
+// "pixels" em RGBA8 (R no byte menos significativo), como no FramebufferCPU e no glReadPixels.
+// "linhaZeroEmbaixo": a primeira linha do buffer é a de baixo da imagem (convenção do OpenGL).
+void codificaPNG(const uint32_t* pixels, int largura, int altura, std::vector<uint8_t>& saida,
+                 bool linhaZeroEmbaixo = true, int nivel = nivelCompressaoPadrao);
+
+// EXR em scanlines com compressão ZIP (blocos de 16 linhas) e canais B, G, R em half float.
+// Os valores são só divididos por 255 (o framebuffer não é sRGB).
+void codificaEXR(const uint32_t* pixels, int largura, int altura, std::vector<uint8_t>& saida,
+                 bool linhaZeroEmbaixo = true, int nivel = nivelCompressaoPadrao);
+
+void codificaImagem(FormatoImagem formato, const uint32_t* pixels, int largura, int altura,
+                    std::vector<uint8_t>& saida, bool linhaZeroEmbaixo = true);
+
+const char* extensaoImagem(FormatoImagem formato);
+
+// Grava os bytes no arquivo; retorna falso (com mensagem no console) se não conseguir.
+bool gravaArquivo(const char* caminho, const std::vector<uint8_t>& dados);
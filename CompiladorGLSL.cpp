@@ -0,0 +1,1302 @@
+#include "CompiladorGLSL.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <algorithm>
+
+// Registradores antes da compactação: variaveis crescem a partir de 0 e temporarios descem a partir daqui.
+static const int topoRegistrosBrutos = 0x7FFF;
+
+// Niveis de blocos e expressões aninhados (parenteses, argumentos, atribuições encadeadas): cada nivel é
+// uma recursão do compilador, então o limite impede que um shader estoure a pilha.
+static const int maxAninhamento = 256;
+
+enum TipoToken {
+    tokenFim,
+    tokenNome,
+    tokenNumero,
+    tokenSimbolo
+};
+
+struct Token {
+    TipoToken tipo = tokenFim;
+    std::string texto;
+    float valor = 0.0f;
+    int linha = 0;
+};
+
+// Divide o codigo em tokens. Linhas do pré-processador (#version) e comentarios são ignorados.
+static bool separaTokens(const char* fonte, std::vector<Token>& tokens, std::string& erro)
+{
+    static const char* simbolosDuplos[] = { "==", "!=", "<=", ">=", "&&", "||", "+=", "-=", "*=", "/=", "++", "--" };
+    int linha = 1;
+    const char* p = fonte;
+
+    while (*p) {
+        if (*p == '\n') {
+            linha++;
+            p++;
+            continue;
+        }
+        if (std::isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        if (*p == '#' || (p[0] == '/' && p[1] == '/')) {
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        if (p[0] == '/' && p[1] == '*') {
+            p += 2;
+            while (*p && !(p[0] == '*' && p[1] == '/')) {
+                if (*p == '\n') linha++;
+                p++;
+            }
+            if (*p) p += 2;
+            continue;
+        }
+
+        Token token;
+        token.linha = linha;
+        if (std::isalpha((unsigned char)*p) || *p == '_') {
+            const char* inicio = p;
+            while (std::isalnum((unsigned char)*p) || *p == '_') p++;
+            token.tipo = tokenNome;
+            token.texto.assign(inicio, (size_t)(p - inicio));
+        }
+        else if (std::isdigit((unsigned char)*p) || (*p == '.' && std::isdigit((unsigned char)p[1]))) {
+            char* fim;
+            token.tipo = tokenNumero;
+            token.valor = std::strtof(p, &fim);
+            token.texto.assign(p, (size_t)(fim - p));
+            p = fim;
+            // Sufixos 1.0f e 1u.
+            if (*p == 'f' || *p == 'F' || *p == 'u' || *p == 'U') p++;
+        }
+        else {
+            token.tipo = tokenSimbolo;
+            token.texto.assign(p, 1);
+            for (const char* duplo : simbolosDuplos) {
+                if (p[0] == duplo[0] && p[1] == duplo[1]) {
+                    token.texto = duplo;
+                    break;
+                }
+            }
+            if (token.texto.size() == 1 && !std::strchr("(){}[];,.+-*/=<>!?:", *p)) {
+                erro = "linha " + std::to_string(linha) + ": caractere inesperado '" + token.texto + "'";
+                return false;
+            }
+            p += token.texto.size();
+        }
+        tokens.push_back(token);
+    }
+
+    Token fim;
+    fim.linha = linha;
+    tokens.push_back(fim);
+    return true;
+}
+
+// Tipo de um valor: "tamanho" floats; matrizes têm "dimensao" colunas de "dimensao" linhas (por coluna).
+struct Tipo {
+    int tamanho = 0;
+    int dimensao = 0;
+};
+
+static bool tipoPorNome(const std::string& nome, Tipo& tipo)
+{
+    static const struct { const char* nome; int tamanho; int dimensao; } tipos[] = {
+        { "void", 0, 0 }, { "float", 1, 0 }, { "int", 1, 0 }, { "uint", 1, 0 }, { "bool", 1, 0 },
+        { "vec2", 2, 0 }, { "vec3", 3, 0 }, { "vec4", 4, 0 },
+        { "ivec2", 2, 0 }, { "ivec3", 3, 0 }, { "ivec4", 4, 0 },
+        { "bvec2", 2, 0 }, { "bvec3", 3, 0 }, { "bvec4", 4, 0 },
+        { "mat2", 4, 2 }, { "mat3", 9, 3 }, { "mat4", 16, 4 }
+    };
+    for (const auto& t : tipos) {
+        if (nome == t.nome) {
+            tipo.tamanho = t.tamanho;
+            tipo.dimensao = t.dimensao;
+            return true;
+        }
+    }
+    return false;
+}
+
+static Tipo tipoEscalar(int tamanho)
+{
+    Tipo tipo;
+    tipo.tamanho = tamanho;
+    return tipo;
+}
+
+// Resultado de uma expressão: o registrador (ou constante) de cada componente.
+// Swizzles só reordenam a lista, sem gerar instruções.
+struct Valor {
+    Tipo tipo;
+    uint16_t registros[16] = {};
+    bool atribuivel = false;
+};
+
+struct Variavel {
+    Tipo tipo;
+    int tamanhoArray = 0;
+    uint16_t base = 0;
+    bool somenteLeitura = false;
+};
+
+struct Funcao {
+    Tipo retorno;
+    std::vector<Tipo> tiposParametros;
+    std::vector<std::string> nomesParametros;
+    size_t inicioCorpo = 0;
+};
+
+// Funções do usuario são expandidas no ponto da chamada; o valor de retorno vai para "resultado".
+struct ChamadaFuncao {
+    Valor resultado;
+    bool retornou = false;
+};
+
+static int numOperandos(uint16_t operacao)
+{
+    switch (operacao) {
+    case opMove: case opAbsoluto: case opPiso: case opRaiz: case opInversoRaiz:
+    case opSeno: case opCosseno: case opExp2: case opLog2:
+        return 1;
+    case opSeleciona:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+static bool leOperando(const InstrucaoBytecode& instrucao, uint16_t registro)
+{
+    int n = numOperandos(instrucao.operacao);
+    return instrucao.a == registro || (n > 1 && instrucao.b == registro) || (n > 2 && instrucao.c == registro);
+}
+
+struct Compilador {
+    TipoShader tipoShader;
+    ShaderBytecode& shader;
+    std::vector<Token> tokens;
+    size_t posicao = 0;
+
+    bool falhou = false;
+    std::string mensagem;
+
+    std::vector<std::map<std::string, Variavel>> escopos;
+    std::map<std::string, Funcao> funcoes;
+    std::vector<ChamadaFuncao> chamadas;
+    std::set<std::string> funcoesExpandidas;
+    std::map<float, uint16_t> constantesLiterais;
+
+    int proximoRegistro = 0;
+    int topoTemporario = topoRegistrosBrutos;
+    int menorTemporario = topoRegistrosBrutos;
+    int aninhamento = 0;
+
+    Compilador(TipoShader tipo, ShaderBytecode& saida) : tipoShader(tipo), shader(saida) {}
+
+    // Tokens
+
+    const Token& atual()
+    {
+        static const Token fim;
+        return falhou ? fim : tokens[posicao];
+    }
+
+    bool eh(const char* texto)
+    {
+        const Token& t = atual();
+        return t.tipo != tokenFim && t.tipo != tokenNumero && t.texto == texto;
+    }
+
+    bool consome(const char* texto)
+    {
+        if (eh(texto)) {
+            posicao++;
+            return true;
+        }
+        return false;
+    }
+
+    void espera(const char* texto)
+    {
+        if (!consome(texto)) {
+            falha(std::string("esperado '") + texto + "'");
+        }
+    }
+
+    std::string nome()
+    {
+        if (atual().tipo != tokenNome) {
+            falha("esperado um nome");
+            return std::string();
+        }
+        return tokens[posicao++].texto;
+    }
+
+    void falha(const std::string& texto)
+    {
+        if (!falhou) {
+            const Token& t = tokens[std::min(posicao, tokens.size() - 1)];
+            mensagem = "linha " + std::to_string(t.linha) + ": " + texto + (t.texto.empty() ? "" : " (perto de '" + t.texto + "')");
+            falhou = true;
+        }
+    }
+
+    // Falha sem entrar quando o limite de aninhamento já foi atingido; quem entra chama saiAninhamento.
+    bool entraAninhamento()
+    {
+        if (aninhamento >= maxAninhamento) {
+            falha("aninhamento maior que " + std::to_string(maxAninhamento) + " niveis");
+            return false;
+        }
+        aninhamento++;
+        return true;
+    }
+
+    void saiAninhamento()
+    {
+        aninhamento--;
+    }
+
+    // Registradores e constantes
+
+    uint16_t novoRegistro()
+    {
+        if (proximoRegistro >= menorTemporario) {
+            falha("shader grande demais");
+            return 0;
+        }
+        return (uint16_t)proximoRegistro++;
+    }
+
+    uint16_t novoTemporario()
+    {
+        if (topoTemporario - 1 <= proximoRegistro) {
+            falha("shader grande demais");
+            return 0;
+        }
+        topoTemporario--;
+        menorTemporario = std::min(menorTemporario, topoTemporario);
+        return (uint16_t)topoTemporario;
+    }
+
+    uint16_t constante(float valor)
+    {
+        auto existente = constantesLiterais.find(valor);
+        if (existente != constantesLiterais.end()) {
+            return existente->second;
+        }
+        uint16_t indice = (uint16_t)(shader.constantes.size() | operandoConstante);
+        shader.constantes.push_back(espalha(valor));
+        constantesLiterais[valor] = indice;
+        return indice;
+    }
+
+    void emite(OperacaoBytecode operacao, uint16_t destino, uint16_t a, uint16_t b, uint16_t c)
+    {
+        InstrucaoBytecode instrucao = { (uint16_t)operacao, destino, a, b, c };
+        shader.instrucoes.push_back(instrucao);
+    }
+
+    void emite(OperacaoBytecode operacao, uint16_t destino, uint16_t a, uint16_t b) { emite(operacao, destino, a, b, a); }
+    void emite(OperacaoBytecode operacao, uint16_t destino, uint16_t a) { emite(operacao, destino, a, a, a); }
+
+    Valor valorNovo(Tipo tipo)
+    {
+        Valor v;
+        v.tipo = tipo;
+        for (int i = 0; i < tipo.tamanho; i++) {
+            v.registros[i] = novoTemporario();
+        }
+        return v;
+    }
+
+    Valor valorConstante(float valor)
+    {
+        Valor v;
+        v.tipo = tipoEscalar(1);
+        v.registros[0] = constante(valor);
+        return v;
+    }
+
+    // Operações por componente; um escalar é repetido para o tamanho do outro operando.
+    Valor componentes(OperacaoBytecode operacao, const Valor& a, const Valor& b)
+    {
+        int tamanho = std::max(a.tipo.tamanho, b.tipo.tamanho);
+        if (a.tipo.tamanho != b.tipo.tamanho && a.tipo.tamanho != 1 && b.tipo.tamanho != 1) {
+            falha("tamanhos incompativeis");
+            return valorConstante(0.0f);
+        }
+        Valor r = valorNovo(a.tipo.tamanho >= b.tipo.tamanho ? a.tipo : b.tipo);
+        for (int i = 0; i < tamanho; i++) {
+            emite(operacao, r.registros[i], a.registros[a.tipo.tamanho == 1 ? 0 : i], b.registros[b.tipo.tamanho == 1 ? 0 : i]);
+        }
+        return r;
+    }
+
+    Valor unaria(OperacaoBytecode operacao, const Valor& a)
+    {
+        Valor r = valorNovo(a.tipo);
+        for (int i = 0; i < a.tipo.tamanho; i++) {
+            emite(operacao, r.registros[i], a.registros[i]);
+        }
+        return r;
+    }
+
+    Valor soma(const Valor& a, const Valor& b) { return componentes(opSoma, a, b); }
+    Valor subtrai(const Valor& a, const Valor& b) { return componentes(opSubtrai, a, b); }
+    Valor multiplicaComponentes(const Valor& a, const Valor& b) { return componentes(opMultiplica, a, b); }
+
+    Valor produtoEscalar(const Valor& a, const Valor& b)
+    {
+        if (a.tipo.tamanho != b.tipo.tamanho || a.tipo.dimensao != 0) {
+            falha("dot com tamanhos diferentes");
+            return valorConstante(0.0f);
+        }
+        Valor r = valorNovo(tipoEscalar(1));
+        emite(opMultiplica, r.registros[0], a.registros[0], b.registros[0]);
+        for (int i = 1; i < a.tipo.tamanho; i++) {
+            uint16_t termo = novoTemporario();
+            emite(opMultiplica, termo, a.registros[i], b.registros[i]);
+            emite(opSoma, r.registros[0], r.registros[0], termo);
+        }
+        return r;
+    }
+
+    // '*' do GLSL: matriz x vetor, vetor x matriz, matriz x matriz ou por componente.
+    Valor multiplica(const Valor& a, const Valor& b)
+    {
+        int n = a.tipo.dimensao ? a.tipo.dimensao : b.tipo.dimensao;
+        if (a.tipo.dimensao && b.tipo.dimensao) {
+            if (a.tipo.dimensao != b.tipo.dimensao) {
+                falha("matrizes de tamanhos diferentes");
+                return valorConstante(0.0f);
+            }
+            Valor r = valorNovo(a.tipo);
+            for (int coluna = 0; coluna < n; coluna++) {
+                for (int linha = 0; linha < n; linha++) {
+                    Valor linhaA, colunaB;
+                    linhaA.tipo = colunaB.tipo = tipoEscalar(n);
+                    for (int k = 0; k < n; k++) {
+                        linhaA.registros[k] = a.registros[k * n + linha];
+                        colunaB.registros[k] = b.registros[coluna * n + k];
+                    }
+                    emite(opMove, r.registros[coluna * n + linha], produtoEscalar(linhaA, colunaB).registros[0]);
+                }
+            }
+            return r;
+        }
+        if (a.tipo.dimensao && b.tipo.tamanho == n) {
+            Valor r = valorNovo(tipoEscalar(n));
+            for (int linha = 0; linha < n; linha++) {
+                Valor linhaA;
+                linhaA.tipo = tipoEscalar(n);
+                for (int k = 0; k < n; k++) {
+                    linhaA.registros[k] = a.registros[k * n + linha];
+                }
+                emite(opMove, r.registros[linha], produtoEscalar(linhaA, b).registros[0]);
+            }
+            return r;
+        }
+        if (b.tipo.dimensao && a.tipo.tamanho == n) {
+            Valor r = valorNovo(tipoEscalar(n));
+            for (int coluna = 0; coluna < n; coluna++) {
+                Valor colunaB;
+                colunaB.tipo = tipoEscalar(n);
+                for (int k = 0; k < n; k++) {
+                    colunaB.registros[k] = b.registros[coluna * n + k];
+                }
+                emite(opMove, r.registros[coluna], produtoEscalar(a, colunaB).registros[0]);
+            }
+            return r;
+        }
+        return multiplicaComponentes(a, b);
+    }
+
+    Valor normaliza(const Valor& a)
+    {
+        Valor inverso = unaria(opInversoRaiz, produtoEscalar(a, a));
+        return multiplicaComponentes(a, inverso);
+    }
+
+    // Variaveis
+
+    Variavel* procura(const std::string& nome)
+    {
+        for (size_t i = escopos.size(); i > 0; i--) {
+            auto encontrada = escopos[i - 1].find(nome);
+            if (encontrada != escopos[i - 1].end()) {
+                return &encontrada->second;
+            }
+        }
+        return nullptr;
+    }
+
+    Variavel& declara(const std::string& nome, Tipo tipo, int tamanhoArray = 0)
+    {
+        if (escopos.back().count(nome)) {
+            falha("'" + nome + "' já foi declarado");
+        }
+        Variavel& v = escopos.back()[nome];
+        v.tipo = tipo;
+        v.tamanhoArray = tamanhoArray;
+        int total = tipo.tamanho * std::max(tamanhoArray, 1);
+        v.base = total > 0 ? novoRegistro() : 0;
+        for (int i = 1; i < total; i++) {
+            novoRegistro();
+        }
+        return v;
+    }
+
+    Valor valorVariavel(const Variavel& v, int elemento)
+    {
+        Valor r;
+        r.tipo = v.tipo;
+        for (int i = 0; i < v.tipo.tamanho; i++) {
+            r.registros[i] = (uint16_t)(v.base + elemento * v.tipo.tamanho + i);
+        }
+        r.atribuivel = !v.somenteLeitura;
+        return r;
+    }
+
+    // Copia "origem" para os registradores de "destino" (componente a componente).
+    void copia(const Valor& destino, const Valor& origem)
+    {
+        if (origem.tipo.tamanho != destino.tipo.tamanho && origem.tipo.tamanho != 1) {
+            falha("atribuição com tamanhos diferentes");
+            return;
+        }
+        // Se a origem usa algum registrador do destino (v.xy = v.yx), copia antes para temporarios.
+        Valor fonte = origem;
+        bool sobrepoe = false;
+        for (int i = 0; i < origem.tipo.tamanho; i++) {
+            for (int j = 0; j < destino.tipo.tamanho; j++) {
+                sobrepoe |= origem.registros[i] == destino.registros[j];
+            }
+        }
+        if (sobrepoe) {
+            fonte = unaria(opMove, origem);
+        }
+        for (int i = 0; i < destino.tipo.tamanho; i++) {
+            emite(opMove, destino.registros[i], fonte.registros[fonte.tipo.tamanho == 1 ? 0 : i]);
+        }
+    }
+
+    // Declarações globais
+
+    void declaracaoGlobal(const std::string& qualificador, int location)
+    {
+        Tipo tipo;
+        std::string nomeTipo = nome();
+        if (!tipoPorNome(nomeTipo, tipo) || tipo.tamanho == 0) {
+            falha("tipo não suportado '" + nomeTipo + "'");
+            return;
+        }
+        std::string nomeVariavel = nome();
+        int tamanhoArray = 0;
+        if (consome("[")) {
+            if (atual().tipo != tokenNumero) {
+                falha("tamanho do array deve ser um numero");
+                return;
+            }
+            tamanhoArray = (int)tokens[posicao++].valor;
+            espera("]");
+        }
+        espera(";");
+        if (falhou) {
+            return;
+        }
+
+        VariavelShader interface;
+        interface.nome = nomeVariavel;
+        interface.componentes = tipo.tamanho * std::max(tamanhoArray, 1);
+        interface.location = location;
+
+        if (qualificador == "uniform") {
+            // Uniforms ficam no banco de constantes (zerados até o defineUniformGLSL).
+            Variavel& v = escopos.back()[nomeVariavel];
+            v.tipo = tipo;
+            v.tamanhoArray = tamanhoArray;
+            v.base = (uint16_t)(shader.constantes.size() | operandoConstante);
+            v.somenteLeitura = true;
+            interface.registro = (uint16_t)shader.constantes.size();
+            shader.constantes.resize(shader.constantes.size() + interface.componentes, espalha(0.0f));
+            shader.uniforms.push_back(interface);
+            return;
+        }
+
+        Variavel& v = declara(nomeVariavel, tipo, tamanhoArray);
+        interface.registro = v.base;
+        if (qualificador == "in") {
+            v.somenteLeitura = true;
+            shader.entradas.push_back(interface);
+        }
+        else {
+            shader.saidas.push_back(interface);
+        }
+    }
+
+    void declaracoesGlobais()
+    {
+        while (!falhou && atual().tipo != tokenFim) {
+            if (consome("precision")) {
+                while (!falhou && !consome(";")) posicao++;
+                continue;
+            }
+
+            int location = -1;
+            if (consome("layout")) {
+                espera("(");
+                while (!falhou && !consome(")")) {
+                    std::string chave = nome();
+                    if (consome("=")) {
+                        if (chave == "location") location = (int)atual().valor;
+                        posicao++;
+                    }
+                    consome(",");
+                }
+            }
+
+            consome("flat");
+            consome("smooth");
+            if (consome("in")) {
+                declaracaoGlobal("in", location);
+            }
+            else if (consome("out")) {
+                declaracaoGlobal("out", location);
+            }
+            else if (consome("uniform")) {
+                declaracaoGlobal("uniform", location);
+            }
+            else {
+                declaracaoFuncao();
+            }
+        }
+    }
+
+    // Guarda a assinatura e a posição do corpo; o corpo é compilado a cada chamada.
+    void declaracaoFuncao()
+    {
+        Funcao funcao;
+        std::string nomeTipo = nome();
+        if (!tipoPorNome(nomeTipo, funcao.retorno)) {
+            falha("tipo desconhecido '" + nomeTipo + "'");
+            return;
+        }
+        std::string nomeFuncao = nome();
+        espera("(");
+        while (!falhou && !consome(")")) {
+            consome("in");
+            consome("const");
+            Tipo tipo;
+            std::string tipoParametro = nome();
+            if (tipoParametro == "void" && consome(")")) {
+                break;
+            }
+            if (!tipoPorNome(tipoParametro, tipo) || tipo.tamanho == 0) {
+                falha("tipo de parametro não suportado '" + tipoParametro + "'");
+                return;
+            }
+            funcao.tiposParametros.push_back(tipo);
+            funcao.nomesParametros.push_back(nome());
+            consome(",");
+        }
+        if (consome(";")) {
+            return;     // Protótipo.
+        }
+
+        if (funcoes.count(nomeFuncao)) {
+            falha("função '" + nomeFuncao + "' já foi definida");
+            return;
+        }
+        funcao.inicioCorpo = posicao;
+        espera("{");
+        for (int profundidade = 1; !falhou && profundidade > 0; posicao++) {
+            if (atual().tipo == tokenFim) {
+                falha("fim inesperado do codigo");
+                return;
+            }
+            if (eh("{")) profundidade++;
+            if (eh("}")) profundidade--;
+        }
+        funcoes[nomeFuncao] = funcao;
+    }
+
+    // Instruções
+
+    void bloco()
+    {
+        if (!entraAninhamento()) {
+            return;
+        }
+        espera("{");
+        escopos.push_back(std::map<std::string, Variavel>());
+        while (!falhou && !consome("}")) {
+            if (atual().tipo == tokenFim) {
+                falha("esperado '}'");
+                break;
+            }
+            if (chamadas.back().retornou) {
+                pulaInstrucao();
+            }
+            else {
+                instrucao();
+            }
+        }
+        escopos.pop_back();
+        saiAninhamento();
+    }
+
+    // Depois de um return o resto da função é ignorado.
+    void pulaInstrucao()
+    {
+        int profundidade = 0;
+        while (!falhou && atual().tipo != tokenFim) {
+            if (eh("{")) profundidade++;
+            if (eh("}")) {
+                if (profundidade == 0) return;
+                profundidade--;
+                if (profundidade == 0) {
+                    posicao++;
+                    return;
+                }
+            }
+            if (eh(";") && profundidade == 0) {
+                posicao++;
+                return;
+            }
+            posicao++;
+        }
+    }
+
+    void instrucao()
+    {
+        // Temporarios só vivem dentro da instrução.
+        int marca = topoTemporario;
+
+        if (eh("{")) {
+            bloco();
+        }
+        else if (consome("return")) {
+            // Indice, não referencia: as chamadas dentro da expressão crescem o vetor.
+            size_t chamada = chamadas.size() - 1;
+            if (!consome(";")) {
+                Valor v = expressao();
+                espera(";");
+                if (chamadas[chamada].resultado.tipo.tamanho != v.tipo.tamanho) {
+                    falha("tipo de retorno diferente");
+                }
+                else {
+                    copia(chamadas[chamada].resultado, v);
+                }
+            }
+            chamadas[chamada].retornou = true;
+        }
+        else if (eh("if") || eh("for") || eh("while") || eh("do") || eh("discard")) {
+            falha("'" + atual().texto + "' não é suportado");
+        }
+        else if (ehDeclaracao()) {
+            consome("const");
+            Tipo tipo;
+            tipoPorNome(nome(), tipo);
+            do {
+                std::string nomeVariavel = nome();
+                Valor inicial;
+                bool temInicial = consome("=");
+                if (temInicial) {
+                    inicial = expressao();
+                }
+                Variavel& v = declara(nomeVariavel, tipo);
+                if (temInicial) {
+                    copia(valorVariavel(v, 0), inicial);
+                }
+            } while (!falhou && consome(","));
+            espera(";");
+        }
+        else {
+            expressao();
+            espera(";");
+        }
+
+        topoTemporario = marca;
+    }
+
+    bool ehDeclaracao()
+    {
+        Tipo tipo;
+        size_t p = posicao;
+        if (eh("const")) p++;
+        return tokens[p].tipo == tokenNome && tipoPorNome(tokens[p].texto, tipo) && tokens[p + 1].tipo == tokenNome;
+    }
+
+    // Expressões (do menor para o maior nivel de precedencia)
+
+    Valor expressao()
+    {
+        if (!entraAninhamento()) {
+            return valorConstante(0.0f);
+        }
+        Valor r = atribuicao();
+        saiAninhamento();
+        return r;
+    }
+
+    Valor atribuicao()
+    {
+        Valor esquerdo = ternario();
+        const char* operadores[] = { "=", "+=", "-=", "*=", "/=" };
+        for (const char* operador : operadores) {
+            if (!consome(operador)) {
+                continue;
+            }
+            if (!esquerdo.atribuivel) {
+                falha("lado esquerdo não pode ser atribuido");
+                return esquerdo;
+            }
+            Valor direito = expressao();
+            Valor resultado = direito;
+            switch (operador[0]) {
+            case '+': resultado = soma(esquerdo, direito); break;
+            case '-': resultado = subtrai(esquerdo, direito); break;
+            case '*': resultado = multiplica(esquerdo, direito); break;
+            case '/': resultado = componentes(opDivide, esquerdo, direito); break;
+            }
+            copia(esquerdo, resultado);
+            return esquerdo;
+        }
+        return esquerdo;
+    }
+
+    Valor ternario()
+    {
+        Valor condicao = ou();
+        if (!consome("?")) {
+            return condicao;
+        }
+        Valor seVerdadeiro = expressao();
+        espera(":");
+        Valor seFalso = expressao();
+        if (seVerdadeiro.tipo.tamanho != seFalso.tipo.tamanho || condicao.tipo.tamanho != 1) {
+            falha("tipos diferentes no operador ?:");
+            return seVerdadeiro;
+        }
+        Valor r = valorNovo(seVerdadeiro.tipo);
+        for (int i = 0; i < r.tipo.tamanho; i++) {
+            emite(opSeleciona, r.registros[i], seVerdadeiro.registros[i], seFalso.registros[i], condicao.registros[0]);
+        }
+        return r;
+    }
+
+    // Booleanos são 0.0 ou 1.0: "e" é o minimo e "ou" é o maximo.
+    Valor ou()
+    {
+        Valor r = e();
+        while (!falhou && consome("||")) {
+            r = componentes(opMaximo, r, e());
+        }
+        return r;
+    }
+
+    Valor e()
+    {
+        Valor r = igualdade();
+        while (!falhou && consome("&&")) {
+            r = componentes(opMinimo, r, igualdade());
+        }
+        return r;
+    }
+
+    // Comparação de vetores: verdadeiro se todos os componentes são iguais.
+    Valor igualdade()
+    {
+        Valor r = relacional();
+        while (!falhou) {
+            bool igual = consome("==");
+            if (!igual && !consome("!=")) {
+                break;
+            }
+            Valor comparacao = componentes(igual ? opIgual : opDiferente, r, relacional());
+            r.tipo = tipoEscalar(1);
+            r.atribuivel = false;
+            r.registros[0] = comparacao.registros[0];
+            for (int i = 1; i < comparacao.tipo.tamanho; i++) {
+                r = componentes(igual ? opMinimo : opMaximo, r, valorComponente(comparacao, i));
+            }
+        }
+        return r;
+    }
+
+    Valor relacional()
+    {
+        Valor r = aditiva();
+        while (!falhou) {
+            if (consome("<")) r = componentes(opMenor, r, aditiva());
+            else if (consome("<=")) r = componentes(opMenorIgual, r, aditiva());
+            else if (consome(">")) { Valor direito = aditiva(); r = componentes(opMenor, direito, r); }
+            else if (consome(">=")) { Valor direito = aditiva(); r = componentes(opMenorIgual, direito, r); }
+            else break;
+        }
+        return r;
+    }
+
+    Valor aditiva()
+    {
+        Valor r = multiplicativa();
+        while (!falhou) {
+            if (consome("+")) r = soma(r, multiplicativa());
+            else if (consome("-")) r = subtrai(r, multiplicativa());
+            else break;
+        }
+        return r;
+    }
+
+    Valor multiplicativa()
+    {
+        Valor r = unaria();
+        while (!falhou) {
+            if (consome("*")) r = multiplica(r, unaria());
+            else if (consome("/")) r = componentes(opDivide, r, unaria());
+            else break;
+        }
+        return r;
+    }
+
+    // Os prefixos são lidos em laço e aplicados de dentro para fora, sem recursão.
+    Valor unaria()
+    {
+        std::vector<char> prefixos;
+        while (!falhou && (eh("-") || eh("+") || eh("!"))) {
+            prefixos.push_back(tokens[posicao++].texto[0]);
+        }
+        Valor r = posfixa();
+        for (size_t i = prefixos.size(); i-- > 0;) {
+            if (prefixos[i] == '-') r = subtrai(valorConstante(0.0f), r);
+            else if (prefixos[i] == '!') r = subtrai(valorConstante(1.0f), r);
+        }
+        return r;
+    }
+
+    Valor valorComponente(const Valor& v, int indice)
+    {
+        Valor r;
+        r.tipo = tipoEscalar(1);
+        r.registros[0] = v.registros[indice];
+        r.atribuivel = v.atribuivel;
+        return r;
+    }
+
+    Valor posfixa()
+    {
+        Valor r = primaria();
+        while (!falhou) {
+            if (consome(".")) {
+                std::string campo = nome();
+                if (campo.size() > 4 || r.tipo.dimensao != 0) {
+                    falha("swizzle invalido '" + campo + "'");
+                    break;
+                }
+                Valor s;
+                s.tipo = tipoEscalar((int)campo.size());
+                s.atribuivel = r.atribuivel;
+                int usados = 0;
+                for (size_t i = 0; i < campo.size(); i++) {
+                    int indice = indiceComponente(campo[i]);
+                    if (indice < 0 || indice >= r.tipo.tamanho) {
+                        falha("swizzle invalido '" + campo + "'");
+                        break;
+                    }
+                    // Componente repetido (v.xx) pode ser lido, mas não atribuido.
+                    if (usados & (1 << indice)) {
+                        s.atribuivel = false;
+                    }
+                    usados |= 1 << indice;
+                    s.registros[i] = r.registros[indice];
+                }
+                r = s;
+            }
+            else if (consome("[")) {
+                // Só indices constantes: coluna de matriz ou componente de vetor.
+                if (atual().tipo != tokenNumero) {
+                    falha("indice deve ser um numero");
+                    break;
+                }
+                int indice = (int)tokens[posicao++].valor;
+                espera("]");
+                int lado = r.tipo.dimensao ? r.tipo.dimensao : 1;
+                int quantidade = r.tipo.dimensao ? r.tipo.dimensao : r.tipo.tamanho;
+                if (indice < 0 || indice >= quantidade) {
+                    falha("indice fora do limite");
+                    break;
+                }
+                Valor s;
+                s.tipo = tipoEscalar(lado);
+                s.atribuivel = r.atribuivel;
+                for (int i = 0; i < lado; i++) {
+                    s.registros[i] = r.registros[indice * lado + i];
+                }
+                r = s;
+            }
+            else {
+                break;
+            }
+        }
+        return r;
+    }
+
+    static int indiceComponente(char c)
+    {
+        const char* grupos[] = { "xyzw", "rgba", "stpq" };
+        for (const char* grupo : grupos) {
+            const char* encontrado = std::strchr(grupo, c);
+            if (encontrado) return (int)(encontrado - grupo);
+        }
+        return -1;
+    }
+
+    Valor primaria()
+    {
+        const Token& token = atual();
+        if (token.tipo == tokenNumero) {
+            posicao++;
+            return valorConstante(token.valor);
+        }
+        if (consome("(")) {
+            Valor r = expressao();
+            espera(")");
+            r.atribuivel = false;
+            return r;
+        }
+        if (token.tipo != tokenNome) {
+            falha("expressão invalida");
+            return valorConstante(0.0f);
+        }
+
+        std::string identificador = nome();
+        if (identificador == "true") return valorConstante(1.0f);
+        if (identificador == "false") return valorConstante(0.0f);
+
+        if (eh("(")) {
+            std::vector<Valor> argumentos;
+            posicao++;
+            while (!falhou && !consome(")")) {
+                argumentos.push_back(expressao());
+                if (!eh(")")) espera(",");
+            }
+            Tipo tipo;
+            if (tipoPorNome(identificador, tipo)) {
+                return construtor(tipo, argumentos);
+            }
+            auto funcao = funcoes.find(identificador);
+            if (funcao != funcoes.end()) {
+                return chamaFuncao(identificador, funcao->second, argumentos);
+            }
+            return embutida(identificador, argumentos);
+        }
+
+        Variavel* v = procura(identificador);
+        if (v == nullptr) {
+            falha("'" + identificador + "' não foi declarado");
+            return valorConstante(0.0f);
+        }
+        int elemento = 0;
+        if (v->tamanhoArray > 0) {
+            espera("[");
+            if (atual().tipo != tokenNumero) {
+                falha("indice de array deve ser um numero");
+                return valorConstante(0.0f);
+            }
+            elemento = (int)tokens[posicao++].valor;
+            espera("]");
+            if (elemento < 0 || elemento >= v->tamanhoArray) {
+                falha("indice fora do array '" + identificador + "'");
+                return valorConstante(0.0f);
+            }
+        }
+        return valorVariavel(*v, elemento);
+    }
+
+    // vecN(...), matN(...), float(...): junta os componentes dos argumentos.
+    Valor construtor(Tipo tipo, const std::vector<Valor>& argumentos)
+    {
+        std::vector<uint16_t> lista;
+        for (const Valor& a : argumentos) {
+            lista.insert(lista.end(), a.registros, a.registros + a.tipo.tamanho);
+        }
+        if (lista.empty()) {
+            falha("construtor sem argumentos");
+            return valorConstante(0.0f);
+        }
+
+        Valor r;
+        r.tipo = tipo;
+        if (tipo.dimensao && argumentos.size() == 1 && argumentos[0].tipo.tamanho == 1) {
+            // mat4(1.0): diagonal.
+            for (int i = 0; i < tipo.tamanho; i++) {
+                r.registros[i] = (i % (tipo.dimensao + 1) == 0) ? lista[0] : constante(0.0f);
+            }
+        }
+        else if (tipo.dimensao && argumentos.size() == 1 && argumentos[0].tipo.dimensao) {
+            // mat3(mat4): canto superior esquerdo; o que falta vem da identidade.
+            int origem = argumentos[0].tipo.dimensao;
+            for (int c = 0; c < tipo.dimensao; c++) {
+                for (int l = 0; l < tipo.dimensao; l++) {
+                    r.registros[c * tipo.dimensao + l] = (c < origem && l < origem) ? lista[c * origem + l] : constante(c == l ? 1.0f : 0.0f);
+                }
+            }
+        }
+        else if (lista.size() == 1) {
+            for (int i = 0; i < tipo.tamanho; i++) r.registros[i] = lista[0];
+        }
+        else if ((int)lista.size() >= tipo.tamanho) {
+            for (int i = 0; i < tipo.tamanho; i++) r.registros[i] = lista[i];
+        }
+        else {
+            falha("componentes insuficientes no construtor");
+            return valorConstante(0.0f);
+        }
+        return r;
+    }
+
+    Valor chamaFuncao(const std::string& nomeFuncao, const Funcao& funcao, const std::vector<Valor>& argumentos)
+    {
+        if (argumentos.size() != funcao.tiposParametros.size()) {
+            falha("numero de argumentos errado");
+            return valorConstante(0.0f);
+        }
+        // O corpo é expandido no ponto da chamada: uma função que já está sendo expandida nunca terminaria.
+        if (funcoesExpandidas.count(nomeFuncao)) {
+            falha("recursão não é suportada ('" + nomeFuncao + "')");
+            return valorConstante(0.0f);
+        }
+        funcoesExpandidas.insert(nomeFuncao);
+
+        // A função só enxerga as variaveis globais e os parametros (copias dos argumentos).
+        std::vector<std::map<std::string, Variavel>> locais(escopos.begin() + 1, escopos.end());
+        escopos.resize(1);
+        escopos.push_back(std::map<std::string, Variavel>());
+        for (size_t i = 0; i < argumentos.size(); i++) {
+            if (argumentos[i].tipo.tamanho != funcao.tiposParametros[i].tamanho) {
+                falha("tipo do argumento " + std::to_string(i + 1) + " diferente");
+                break;
+            }
+            Variavel& parametro = declara(funcao.nomesParametros[i], funcao.tiposParametros[i]);
+            copia(valorVariavel(parametro, 0), argumentos[i]);
+        }
+
+        ChamadaFuncao chamada;
+        chamada.resultado = valorNovo(funcao.retorno);
+        chamadas.push_back(chamada);
+
+        size_t retorno = posicao;
+        posicao = funcao.inicioCorpo;
+        bloco();
+        posicao = retorno;
+
+        Valor resultado = chamadas.back().resultado;
+        chamadas.pop_back();
+        funcoesExpandidas.erase(nomeFuncao);
+        escopos.resize(1);
+        escopos.insert(escopos.end(), locais.begin(), locais.end());
+        return resultado;
+    }
+
+    Valor embutida(const std::string& nomeFuncao, const std::vector<Valor>& a)
+    {
+        struct Unaria { const char* nome; OperacaoBytecode operacao; };
+        static const Unaria unarias[] = {
+            { "abs", opAbsoluto }, { "floor", opPiso }, { "sqrt", opRaiz }, { "inversesqrt", opInversoRaiz },
+            { "sin", opSeno }, { "cos", opCosseno }, { "exp2", opExp2 }, { "log2", opLog2 }
+        };
+        struct Binaria { const char* nome; OperacaoBytecode operacao; };
+        static const Binaria binarias[] = { { "min", opMinimo }, { "max", opMaximo }, { "pow", opPotencia } };
+
+        size_t n = a.size();
+        for (const Unaria& u : unarias) {
+            if (nomeFuncao == u.nome && n == 1) return unaria(u.operacao, a[0]);
+        }
+        for (const Binaria& b : binarias) {
+            if (nomeFuncao == b.nome && n == 2) return componentes(b.operacao, a[0], a[1]);
+        }
+
+        if (nomeFuncao == "fract" && n == 1) return subtrai(a[0], unaria(opPiso, a[0]));
+        if (nomeFuncao == "exp" && n == 1) return unaria(opExp2, multiplicaComponentes(a[0], valorConstante(1.44269504f)));
+        if (nomeFuncao == "log" && n == 1) return multiplicaComponentes(unaria(opLog2, a[0]), valorConstante(0.69314718f));
+        if (nomeFuncao == "mod" && n == 2) {
+            Valor quociente = unaria(opPiso, componentes(opDivide, a[0], a[1]));
+            return subtrai(a[0], multiplicaComponentes(a[1], quociente));
+        }
+        if (nomeFuncao == "clamp" && n == 3) return componentes(opMinimo, componentes(opMaximo, a[0], a[1]), a[2]);
+        if (nomeFuncao == "mix" && n == 3) return soma(a[0], multiplicaComponentes(subtrai(a[1], a[0]), a[2]));
+        if (nomeFuncao == "step" && n == 2) return componentes(opMenorIgual, a[0], a[1]);
+        if (nomeFuncao == "dot" && n == 2) return produtoEscalar(a[0], a[1]);
+        if (nomeFuncao == "length" && n == 1) return unaria(opRaiz, produtoEscalar(a[0], a[0]));
+        if (nomeFuncao == "distance" && n == 2) {
+            Valor diferenca = subtrai(a[0], a[1]);
+            return unaria(opRaiz, produtoEscalar(diferenca, diferenca));
+        }
+        if (nomeFuncao == "normalize" && n == 1) return normaliza(a[0]);
+        if (nomeFuncao == "reflect" && n == 2) {
+            Valor d = produtoEscalar(a[1], a[0]);
+            return subtrai(a[0], multiplicaComponentes(a[1], multiplicaComponentes(d, valorConstante(2.0f))));
+        }
+        if (nomeFuncao == "cross" && n == 2 && a[0].tipo.tamanho == 3 && a[1].tipo.tamanho == 3) {
+            Valor r = valorNovo(tipoEscalar(3));
+            for (int i = 0; i < 3; i++) {
+                int j = (i + 1) % 3, k = (i + 2) % 3;
+                uint16_t termo = novoTemporario();
+                emite(opMultiplica, r.registros[i], a[0].registros[j], a[1].registros[k]);
+                emite(opMultiplica, termo, a[0].registros[k], a[1].registros[j]);
+                emite(opSubtrai, r.registros[i], r.registros[i], termo);
+            }
+            return r;
+        }
+
+        falha("função não suportada '" + nomeFuncao + "'");
+        return valorConstante(0.0f);
+    }
+
+    void compila()
+    {
+        escopos.push_back(std::map<std::string, Variavel>());
+        if (tipoShader == shaderVertice) {
+            Variavel& posicaoSaida = declara("gl_Position", tipoEscalar(4));
+            VariavelShader interface;
+            interface.nome = "gl_Position";
+            interface.componentes = 4;
+            interface.registro = posicaoSaida.base;
+            shader.saidas.push_back(interface);
+        }
+
+        declaracoesGlobais();
+        if (falhou) {
+            return;
+        }
+
+        auto principal = funcoes.find("main");
+        if (principal == funcoes.end()) {
+            falha("função main não encontrada");
+            return;
+        }
+        chamaFuncao("main", principal->second, std::vector<Valor>());
+    }
+};
+
+// Elimina "t = a op b; d = t" quando t é um temporario usado só nessa copia: a instrução passa a escrever em d.
+static void propagaCopias(std::vector<InstrucaoBytecode>& instrucoes, int inicioTemporarios)
+{
+    for (size_t j = 0; j < instrucoes.size(); j++) {
+        const InstrucaoBytecode copia = instrucoes[j];
+        if (copia.operacao != opMove || (copia.a & operandoConstante) || copia.a < inicioTemporarios) {
+            continue;
+        }
+        uint16_t t = copia.a, d = copia.destino;
+
+        // Ultima instrução que escreveu t, sem leituras de t nem uso de d no caminho.
+        size_t i = j;
+        bool valido = false;
+        while (i > 0) {
+            i--;
+            if (instrucoes[i].destino == t) {
+                valido = true;
+                break;
+            }
+            if (leOperando(instrucoes[i], t) || leOperando(instrucoes[i], d) || instrucoes[i].destino == d) {
+                break;
+            }
+        }
+        if (!valido) {
+            continue;
+        }
+
+        // t não pode ser lido depois da copia (antes de ser escrito de novo).
+        for (size_t k = j + 1; k < instrucoes.size(); k++) {
+            if (leOperando(instrucoes[k], t)) {
+                valido = false;
+                break;
+            }
+            if (instrucoes[k].destino == t) {
+                break;
+            }
+        }
+        if (!valido) {
+            continue;
+        }
+
+        instrucoes[i].destino = d;
+        instrucoes.erase(instrucoes.begin() + j);
+        j = i;
+    }
+}
+
+// Renumera os registradores usados em sequência a partir de 0.
+static bool compactaRegistros(ShaderBytecode& shader)
+{
+    std::vector<int> mapa(topoRegistrosBrutos + 1, -1);
+    std::vector<bool> usado(topoRegistrosBrutos + 1, false);
+
+    for (const std::vector<VariavelShader>* lista : { &shader.entradas, &shader.saidas }) {
+        for (const VariavelShader& v : *lista) {
+            for (int i = 0; i < v.componentes; i++) usado[v.registro + i] = true;
+        }
+    }
+    for (const InstrucaoBytecode& instrucao : shader.instrucoes) {
+        const uint16_t operandos[4] = { instrucao.destino, instrucao.a, instrucao.b, instrucao.c };
+        for (int k = 0; k <= numOperandos(instrucao.operacao); k++) {
+            if (!(operandos[k] & operandoConstante)) usado[operandos[k]] = true;
+        }
+    }
+
+    int total = 0;
+    for (int r = 0; r <= topoRegistrosBrutos; r++) {
+        if (usado[r]) mapa[r] = total++;
+    }
+    if (total > maxRegistrosShader) {
+        return false;
+    }
+
+    auto renumera = [&](uint16_t& registro) {
+        if (!(registro & operandoConstante) && mapa[registro] >= 0) registro = (uint16_t)mapa[registro];
+    };
+    for (InstrucaoBytecode& instrucao : shader.instrucoes) {
+        renumera(instrucao.destino);
+        renumera(instrucao.a);
+        renumera(instrucao.b);
+        renumera(instrucao.c);
+    }
+    for (std::vector<VariavelShader>* lista : { &shader.entradas, &shader.saidas }) {
+        for (VariavelShader& v : *lista) renumera(v.registro);
+    }
+    shader.numRegistros = total;
+    return true;
+}
+
+bool compilaShaderGLSL(const char* fonte, TipoShader tipo, ShaderBytecode& shader, std::string& erro)
+{
+    shader = ShaderBytecode();
+    shader.tipo = tipo;
+
+    Compilador compilador(tipo, shader);
+    if (!separaTokens(fonte, compilador.tokens, erro)) {
+        return false;
+    }
+
+    compilador.compila();
+    if (compilador.falhou) {
+        erro = compilador.mensagem;
+        return false;
+    }
+
+    propagaCopias(shader.instrucoes, compilador.menorTemporario);
+    if (!compactaRegistros(shader)) {
+        erro = "shader usa mais de " + std::to_string(maxRegistrosShader) + " registradores";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Tradutor de um subconjunto do GLSL 330 para o bytecode do InterpretadorGLSL.
+// Suportado: in/out/uniform (com layout(location) e arrays de uniforms), float, int e bool como float,
+// vec2/3/4, mat3/4, construtores, swizzles, operadores aritmeticos, de comparação e ?:, atribuições
+// compostas, funções do usuario (expandidas no ponto da chamada) e as funções embutidas abs, floor,
+// fract, mod, sqrt, inversesqrt, sin, cos, exp, exp2, log, log2, pow, min, max, clamp, mix, step,
+// dot, cross, length, distance, normalize e reflect.
+// Não suportado: if, laços, texturas e recursão.
+
+#include "InterpretadorGLSL.h"
+
+#include <string>
+
+bool compilaShaderGLSL(const char* fonte, TipoShader tipo, ShaderBytecode& shader, std::string& erro);
@@ -0,0 +1,237 @@
+#include "DescarteFrustum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Objetos por tarefa no descarte paralelo.
+static const size_t objetosPorTarefa = 16384;
+
+void redimensionaVolumes(VolumesEnvolventes& volumes, size_t quantidade)
+{
+    volumes.centroX.resize(quantidade, 0.0f);
+    volumes.centroY.resize(quantidade, 0.0f);
+    volumes.centroZ.resize(quantidade, 0.0f);
+    volumes.raio.resize(quantidade, 0.0f);
+    volumes.extensaoX.resize(quantidade, 0.0f);
+    volumes.extensaoY.resize(quantidade, 0.0f);
+    volumes.extensaoZ.resize(quantidade, 0.0f);
+    volumes.quantidade = quantidade;
+}
+
+void defineEsfera(VolumesEnvolventes& volumes, size_t indice, const Vec3& centro, float raio)
+{
+    volumes.centroX[indice] = centro.x;
+    volumes.centroY[indice] = centro.y;
+    volumes.centroZ[indice] = centro.z;
+    volumes.raio[indice] = raio;
+    volumes.extensaoX[indice] = raio;
+    volumes.extensaoY[indice] = raio;
+    volumes.extensaoZ[indice] = raio;
+}
+
+void defineCaixa(VolumesEnvolventes& volumes, size_t indice, const Vec3& minimo, const Vec3& maximo)
+{
+    Vec3 extensao = (maximo - minimo) * 0.5f;
+    volumes.centroX[indice] = (minimo.x + maximo.x) * 0.5f;
+    volumes.centroY[indice] = (minimo.y + maximo.y) * 0.5f;
+    volumes.centroZ[indice] = (minimo.z + maximo.z) * 0.5f;
+    volumes.raio[indice] = comprimento(extensao);
+    volumes.extensaoX[indice] = extensao.x;
+    volumes.extensaoY[indice] = extensao.y;
+    volumes.extensaoZ[indice] = extensao.z;
+}
+
+// Gribb e Hartmann: o ponto está dentro quando -w <= x, y, z <= w no espaço de recorte, ou seja, cada
+// plano é a linha 3 da matriz mais ou menos uma das linhas 0, 1 e 2.
+Frustum extraiFrustum(const Mat4& projecaoVisao)
+{
+    const float* m = projecaoVisao.dados();
+    Vec4 linhas[4];
+    for (int r = 0; r < 4; r++) {
+        linhas[r] = Vec4(m[r], m[4 + r], m[8 + r], m[12 + r]);
+    }
+
+    Frustum frustum;
+    for (int eixo = 0; eixo < 3; eixo++) {
+        frustum.planos[eixo * 2] = linhas[3] + linhas[eixo];
+        frustum.planos[eixo * 2 + 1] = linhas[3] - linhas[eixo];
+    }
+    for (Vec4& plano : frustum.planos) {
+        float comprimentoNormal = std::sqrt(plano.x * plano.x + plano.y * plano.y + plano.z * plano.z);
+        plano = plano * (1.0f / comprimentoNormal);
+    }
+    return frustum;
+}
+
+// Distancia com sinal do centro ao plano mais o quanto o volume avança na direção da normal: a esfera
+// avança o raio e a caixa |a| * ex + |b| * ey + |c| * ez. Negativo = inteiramente fora do plano.
+static size_t descartaEscalar(const Frustum& frustum, const VolumesEnvolventes& volumes, TipoVolume tipo,
+                              size_t inicio, size_t quantidade, uint32_t* visiveis)
+{
+    size_t numVisiveis = 0;
+    for (size_t i = inicio; i < inicio + quantidade; i++) {
+        bool dentro = true;
+        for (const Vec4& p : frustum.planos) {
+            float distancia = p.x * volumes.centroX[i] + p.y * volumes.centroY[i] + p.z * volumes.centroZ[i] + p.w;
+            float alcance = tipo == volumeEsfera ? volumes.raio[i] :
+                std::fabs(p.x) * volumes.extensaoX[i] + std::fabs(p.y) * volumes.extensaoY[i] + std::fabs(p.z) * volumes.extensaoZ[i];
+            if (distancia + alcance < 0.0f) {
+                dentro = false;
+                break;
+            }
+        }
+        if (dentro) {
+            visiveis[numVisiveis++] = (uint32_t)i;
+        }
+    }
+    return numVisiveis;
+}
+
+#if SIMD_X86
+// Para cada mascara de 8 bits: as posições dos bits ligados, em ordem, num byte cada, e quantas são.
+struct TabelaCompactacao {
+    uint64_t posicoes[256];
+    uint8_t contagem[256];
+};
+
+static TabelaCompactacao criaTabelaCompactacao()
+{
+    TabelaCompactacao tabela;
+    for (int mascara = 0; mascara < 256; mascara++) {
+        uint64_t posicoes = 0;
+        int n = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if (mascara & (1 << bit)) {
+                posicoes |= (uint64_t)bit << (n * 8);
+                n++;
+            }
+        }
+        tabela.posicoes[mascara] = posicoes;
+        tabela.contagem[mascara] = (uint8_t)n;
+    }
+    return tabela;
+}
+
+static const TabelaCompactacao tabelaCompactacao = criaTabelaCompactacao();
+
+// A lista é compactada sem desvio: o indice do primeiro objeto mais as posições da tabela vão para a
+// saida num store de 8 indices, e só "contagem" deles avança. O store nunca passa de "quantidade"
+// porque a saida nunca está à frente do objeto atual.
+ALVO_AVX2 static size_t descartaAVX2(const Frustum& frustum, const VolumesEnvolventes& volumes, TipoVolume tipo,
+                                     size_t inicio, size_t quantidade, uint32_t* visiveis)
+{
+    __m256 a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+    for (int k = 0; k < 6; k++) {
+        const Vec4& p = frustum.planos[k];
+        a[k] = _mm256_set1_ps(p.x);
+        b[k] = _mm256_set1_ps(p.y);
+        c[k] = _mm256_set1_ps(p.z);
+        d[k] = _mm256_set1_ps(p.w);
+        absA[k] = _mm256_set1_ps(std::fabs(p.x));
+        absB[k] = _mm256_set1_ps(std::fabs(p.y));
+        absC[k] = _mm256_set1_ps(std::fabs(p.z));
+    }
+
+    const float* cx = volumes.centroX.data() + inicio;
+    const float* cy = volumes.centroY.data() + inicio;
+    const float* cz = volumes.centroZ.data() + inicio;
+    const float* r = volumes.raio.data() + inicio;
+    const float* ex = volumes.extensaoX.data() + inicio;
+    const float* ey = volumes.extensaoY.data() + inicio;
+    const float* ez = volumes.extensaoZ.data() + inicio;
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t numVisiveis = 0;
+    size_t i = 0;
+    for (; i + 8 <= quantidade; i += 8) {
+        __m256 x = _mm256_loadu_ps(cx + i);
+        __m256 y = _mm256_loadu_ps(cy + i);
+        __m256 z = _mm256_loadu_ps(cz + i);
+
+        // Menor (distancia + alcance) entre os 6 planos; o objeto é visivel quando ela não é negativa.
+        __m256 menor;
+        if (tipo == volumeEsfera) {
+            __m256 raio = _mm256_loadu_ps(r + i);
+            menor = _mm256_set1_ps(INFINITY);
+            for (int k = 0; k < 6; k++) {
+                __m256 distancia = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[k], x), _mm256_mul_ps(b[k], y)),
+                                                               _mm256_mul_ps(c[k], z)), d[k]);
+                menor = _mm256_min_ps(menor, _mm256_add_ps(distancia, raio));
+            }
+        }
+        else {
+            __m256 ix = _mm256_loadu_ps(ex + i);
+            __m256 iy = _mm256_loadu_ps(ey + i);
+            __m256 iz = _mm256_loadu_ps(ez + i);
+            menor = _mm256_set1_ps(INFINITY);
+            for (int k = 0; k < 6; k++) {
+                __m256 distancia = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[k], x), _mm256_mul_ps(b[k], y)),
+                                                               _mm256_mul_ps(c[k], z)), d[k]);
+                __m256 alcance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absA[k], ix), _mm256_mul_ps(absB[k], iy)),
+                                               _mm256_mul_ps(absC[k], iz));
+                menor = _mm256_min_ps(menor, _mm256_add_ps(distancia, alcance));
+            }
+        }
+
+        int mascara = _mm256_movemask_ps(_mm256_cmp_ps(menor, zero, _CMP_GE_OQ));
+        __m256i posicoes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&tabelaCompactacao.posicoes[mascara]));
+        __m256i indices = _mm256_add_epi32(posicoes, _mm256_set1_epi32((int)(inicio + i)));
+        _mm256_storeu_si256((__m256i*)(visiveis + numVisiveis), indices);
+        numVisiveis += tabelaCompactacao.contagem[mascara];
+    }
+
+    // Sobra de menos de 8 objetos.
+    return numVisiveis + descartaEscalar(frustum, volumes, tipo, inicio + i, quantidade - i, visiveis + numVisiveis);
+}
+#endif
+
+typedef size_t (*FuncaoDescarte)(const Frustum&, const VolumesEnvolventes&, TipoVolume, size_t, size_t, uint32_t*);
+
+static DespachoSIMD<FuncaoDescarte> despachoDescarte(descartaEscalar, nullptr, IMPLEMENTACAO_X86(descartaAVX2));
+
+size_t descartaFrustum(const Frustum& frustum, const VolumesEnvolventes& volumes, TipoVolume tipo,
+                       size_t inicio, size_t quantidade, uint32_t* visiveis)
+{
+    return despachoDescarte.funcao()(frustum, volumes, tipo, inicio, quantidade, visiveis);
+}
+
+size_t descartaFrustumParalelo(const Frustum& frustum, const VolumesEnvolventes& volumes, TipoVolume tipo,
+                               uint32_t* visiveis, PoolThreads& pool)
+{
+    // Cada bloco escreve a partir da propria posição em "visiveis" (ele nunca tem mais visiveis que
+    // objetos), e depois as listas são juntadas em ordem. Cada bloco só anda para trás, então o
+    // memmove em ordem nunca sobrescreve um bloco que ainda não foi movido.
+    size_t numBlocos = (volumes.quantidade + objetosPorTarefa - 1) / objetosPorTarefa;
+    std::vector<size_t> contagem(numBlocos);
+    FuncaoDescarte descarta = despachoDescarte.funcao();
+    pool.paraCada((unsigned int)numBlocos, [&](unsigned int bloco, unsigned int) {
+        size_t primeiro = bloco * objetosPorTarefa;
+        size_t quantidade = std::min(objetosPorTarefa, volumes.quantidade - primeiro);
+        contagem[bloco] = descarta(frustum, volumes, tipo, primeiro, quantidade, visiveis + primeiro);
+    });
+
+    size_t total = 0;
+    for (size_t bloco = 0; bloco < numBlocos; bloco++) {
+        size_t primeiro = bloco * objetosPorTarefa;
+        if (primeiro != total) {
+            std::memmove(visiveis + total, visiveis + primeiro, contagem[bloco] * sizeof(uint32_t));
+        }
+        total += contagem[bloco];
+    }
+    return total;
+}
+
+NivelSIMD selecionaNivelDescarte(NivelSIMD nivel)
+{
+    return despachoDescarte.seleciona(nivel);
+}
+
+NivelSIMD nivelDescarte()
+{
+    return despachoDescarte.nivel();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Descarte pelo volume de visão (frustum culling): os volumes envolventes dos objetos ficam em estrutura
+// de arrays e cada iteração AVX2 testa 8 objetos contra os 6 planos. O resultado é uma lista compacta com
+// os indices dos objetos visiveis, que o desenho usa no lugar de percorrer todos os objetos.
+// AVX2 ou escalar, escolhido em tempo de execução pelo CPUID (o nivel SSE4.1 usa o escalar).
+
+#include "Matematica.h"
+#include "CPUInfo.h"
+#include "PoolThreads.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum TipoVolume {
+    volumeEsfera,
+    volumeCaixa
+};
+
+// Esfera (centro e raio) e caixa alinhada aos eixos (mesmo centro e meia extensão em cada eixo) de cada objeto.
+struct VolumesEnvolventes {
+    std::vector<float> centroX, centroY, centroZ;
+    std::vector<float> raio;
+    std::vector<float> extensaoX, extensaoY, extensaoZ;
+    size_t quantidade = 0;
+};
+
+// Muda o numero de objetos. Os novos são pontos na origem.
+void redimensionaVolumes(VolumesEnvolventes& volumes, size_t quantidade);
+
+// A esfera também define a caixa que a envolve, e a caixa define a esfera que a envolve, então os dois
+// testes funcionam com qualquer um dos dois.
+void defineEsfera(VolumesEnvolventes& volumes, size_t indice, const Vec3& centro, float raio);
+void defineCaixa(VolumesEnvolventes& volumes, size_t indice, const Vec3& minimo, const Vec3& maximo);
+
+// Planos (a, b, c, d) normalizados e com a normal para dentro: o ponto p está dentro quando a * p.x +
+// b * p.y + c * p.z + d >= 0. Ordem: esquerda, direita, baixo, cima, perto, longe.
+struct Frustum {
+    Vec4 planos[6];
+};
+
+// Planos do frustum de uma matriz projeção * visão (ou projeção * visão * modelo, para volumes locais).
+Frustum extraiFrustum(const Mat4& projecaoVisao);
+
+// Escreve em "visiveis", em ordem crescente, os indices dos objetos [inicio, inicio + quantidade) que não
+// estão inteiramente fora de algum plano, e retorna quantos são. "visiveis" precisa de espaço para
+// "quantidade" indices. O teste é conservador: um volume perto de um canto do frustum pode passar.
+size_t descartaFrustum(const Frustum& frustum, const VolumesEnvolventes& volumes, TipoVolume tipo,
+                       size_t inicio, size_t quantidade, uint32_t* visiveis);
+
+// Mesmo resultado do descartaFrustum para todos os objetos, com blocos de objetos divididos entre as threads.
+size_t descartaFrustumParalelo(const Frustum& frustum, const VolumesEnvolventes& volumes, TipoVolume tipo,
+                               uint32_t* visiveis, PoolThreads& pool);
+
+// Troca a implementação usada (limitada ao que o processador suporta). Retorna o nivel efetivo.
+NivelSIMD selecionaNivelDescarte(NivelSIMD nivel);
+NivelSIMD nivelDescarte();
@@ -0,0 +1,180 @@
+#include <glad/glad.h>
+
+#include "FilaRenderizacao.h"
+
+#include <cstring>
+
+uint64_t codificaChaveDesenho(const PacoteDesenho& pacote)
+{
+    // Profundidade quantizada em 16 bits.
+    float p = pacote.profundidade;
+    if (p < 0.0f) p = 0.0f;
+    if (p > 1.0f) p = 1.0f;
+    uint64_t profundidade = (uint64_t)(p * 65535.0f);
+
+    return ((uint64_t)(pacote.programa & 0xFFFF) << 48)
+         | ((uint64_t)(pacote.VAO & 0xFFFF) << 32)
+         | ((uint64_t)(pacote.textura & 0xFFFF) << 16)
+         | profundidade;
+}
+
+void adicionaPacote(FilaRenderizacao& fila, const PacoteDesenho& pacote)
+{
+    fila.ordem.push_back((uint32_t)fila.pacotes.size());
+    fila.chaves.push_back(codificaChaveDesenho(pacote));
+    fila.pacotes.push_back(pacote);
+}
+
+void ordenaFila(FilaRenderizacao& fila)
+{
+    size_t n = fila.chaves.size();
+    if (n < 2) {
+        return;
+    }
+
+    fila.chavesTemporarias.resize(n);
+    fila.ordemTemporaria.resize(n);
+
+    uint64_t* chaves = fila.chaves.data();
+    uint32_t* ordem = fila.ordem.data();
+    uint64_t* chavesDestino = fila.chavesTemporarias.data();
+    uint32_t* ordemDestino = fila.ordemTemporaria.data();
+
+    // Histogramas dos 8 bytes numa unica leitura das chaves.
+    static thread_local uint32_t histograma[8][256];
+    std::memset(histograma, 0, sizeof(histograma));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t chave = chaves[i];
+        for (int b = 0; b < 8; b++) {
+            histograma[b][(chave >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    for (int b = 0; b < 8; b++) {
+        // Se todas as chaves tem o mesmo byte, a passada não muda nada.
+        uint32_t primeiroByte = (uint32_t)((chaves[0] >> (b * 8)) & 0xFF);
+        if (histograma[b][primeiroByte] == n) {
+            continue;
+        }
+
+        // Soma de prefixos: posição inicial de cada valor do byte.
+        uint32_t soma = 0;
+        for (int v = 0; v < 256; v++) {
+            uint32_t quantidade = histograma[b][v];
+            histograma[b][v] = soma;
+            soma += quantidade;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            uint32_t destino = histograma[b][(chaves[i] >> (b * 8)) & 0xFF]++;
+            chavesDestino[destino] = chaves[i];
+            ordemDestino[destino] = ordem[i];
+        }
+
+        uint64_t* trocaChaves = chaves; chaves = chavesDestino; chavesDestino = trocaChaves;
+        uint32_t* trocaOrdem = ordem; ordem = ordemDestino; ordemDestino = trocaOrdem;
+    }
+
+    // Resultado terminou nos buffers temporarios: troca os vetores.
+    if (chaves != fila.chaves.data()) {
+        fila.chaves.swap(fila.chavesTemporarias);
+        fila.ordem.swap(fila.ordemTemporaria);
+    }
+}
+
+// Percorre a fila na ordem atual; com "enviaGL" falso só conta o que seria enviado.
+static EstatisticasFila percorreFila(const FilaRenderizacao& fila, bool enviaGL)
+{
+    EstatisticasFila estatisticas;
+
+    // Parametros do glMultiDraw* acumulados para o grupo atual.
+    static thread_local std::vector<GLint> primeiros;
+    static thread_local std::vector<GLsizei> contagens;
+    static thread_local std::vector<const void*> deslocamentos;
+
+    // Estado atual (valores invalidos forçam a primeira troca).
+    unsigned int programaAtual = 0xFFFFFFFFu;
+    unsigned int VAOAtual = 0xFFFFFFFFu;
+    unsigned int texturaAtual = 0xFFFFFFFFu;
+
+    size_t n = fila.ordem.size();
+    size_t i = 0;
+    while (i < n) {
+        const PacoteDesenho& pacote = fila.pacotes[fila.ordem[i]];
+
+        if (pacote.programa != programaAtual) {
+            programaAtual = pacote.programa;
+            estatisticas.trocasPrograma++;
+            if (enviaGL) glUseProgram(programaAtual);
+        }
+        if (pacote.VAO != VAOAtual) {
+            VAOAtual = pacote.VAO;
+            estatisticas.trocasVAO++;
+            if (enviaGL) glBindVertexArray(VAOAtual);
+        }
+        if (pacote.textura != texturaAtual) {
+            texturaAtual = pacote.textura;
+            estatisticas.trocasTextura++;
+            if (enviaGL) glBindTexture(GL_TEXTURE_2D, texturaAtual);
+        }
+
+        // Junta os pacotes seguintes com o mesmo estado e o mesmo tipo de desenho.
+        primeiros.clear();
+        contagens.clear();
+        deslocamentos.clear();
+        size_t j = i;
+        while (j < n) {
+            const PacoteDesenho& outro = fila.pacotes[fila.ordem[j]];
+            if (outro.programa != programaAtual || outro.VAO != VAOAtual ||
+                outro.textura != texturaAtual || outro.indexado != pacote.indexado) {
+                break;
+            }
+            primeiros.push_back(outro.primeiro);
+            contagens.push_back(outro.contagem);
+            deslocamentos.push_back((const void*)((size_t)outro.primeiro * sizeof(unsigned int)));
+            j++;
+        }
+
+        estatisticas.chamadasDesenho++;
+        if (enviaGL) {
+            GLsizei grupo = (GLsizei)contagens.size();
+            if (pacote.indexado) {
+                if (grupo == 1) {
+                    glDrawElements(GL_TRIANGLES, contagens[0], GL_UNSIGNED_INT, deslocamentos[0]);
+                }
+                else {
+                    glMultiDrawElements(GL_TRIANGLES, contagens.data(), GL_UNSIGNED_INT, deslocamentos.data(), grupo);
+                }
+            }
+            else {
+                if (grupo == 1) {
+                    glDrawArrays(GL_TRIANGLES, primeiros[0], contagens[0]);
+                }
+                else {
+                    glMultiDrawArrays(GL_TRIANGLES, primeiros.data(), contagens.data(), grupo);
+                }
+            }
+        }
+
+        i = j;
+    }
+
+    return estatisticas;
+}
+
+EstatisticasFila simulaFila(const FilaRenderizacao& fila)
+{
+    return percorreFila(fila, false);
+}
+
+EstatisticasFila executaFila(const FilaRenderizacao& fila)
+{
+    return percorreFila(fila, true);
+}
+
+void limpaFila(FilaRenderizacao& fila)
+{
+    fila.pacotes.clear();
+    fila.chaves.clear();
+    fila.ordem.clear();
+}
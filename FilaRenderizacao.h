@@ -0,0 +1,56 @@
+#pragma once
+
+// Fila de renderização: os desenhos do quadro são acumulados como pacotes, ordenados por uma chave
+// de 64 bits (programa, VAO, textura, profundidade) e enviados agrupando desenhos com o mesmo estado
+// em glMultiDrawArrays/glMultiDrawElements.
+
+#include <cstdint>
+#include <vector>
+
+// Um desenho: estado necessario e intervalo de vertices ou indices.
+struct PacoteDesenho {
+    unsigned int programa = 0;
+    unsigned int VAO = 0;
+    unsigned int textura = 0;       // GL_TEXTURE_2D na unidade 0 (0 = nenhuma).
+    float profundidade = 0.0f;      // 0.0 (perto) a 1.0 (longe); ordena da frente para trás.
+    bool indexado = false;          // Usa o EBO do VAO (indices GL_UNSIGNED_INT).
+    int primeiro = 0;               // Primeiro vertice, ou primeiro indice se indexado.
+    int contagem = 0;               // Numero de vertices ou de indices.
+};
+
+// Contagem de trocas de estado e chamadas ao OpenGL.
+struct EstatisticasFila {
+    unsigned int trocasPrograma = 0;
+    unsigned int trocasVAO = 0;
+    unsigned int trocasTextura = 0;
+    unsigned int chamadasDesenho = 0;
+};
+
+struct FilaRenderizacao {
+    std::vector<PacoteDesenho> pacotes;
+    std::vector<uint64_t> chaves;
+    std::vector<uint32_t> ordem;            // Indices dos pacotes na ordem de envio.
+
+    // Buffers temporarios do radix sort (reaproveitados entre quadros).
+    std::vector<uint64_t> chavesTemporarias;
+    std::vector<uint32_t> ordemTemporaria;
+};
+
+// Monta a chave: programa (bits 48-63), VAO (32-47), textura (16-31) e profundidade (0-15).
+// O estado mais caro de trocar fica nos bits mais altos.
+uint64_t codificaChaveDesenho(const PacoteDesenho& pacote);
+
+// Adiciona um pacote na fila (na ordem do codigo, até ordenaFila ser chamada).
+void adicionaPacote(FilaRenderizacao& fila, const PacoteDesenho& pacote);
+
+// Ordena os pacotes pela chave com radix sort (8 passadas de 8 bits, estavel).
+void ordenaFila(FilaRenderizacao& fila);
+
+// Conta as trocas de estado e os desenhos que executaFila faria, sem chamar o OpenGL.
+EstatisticasFila simulaFila(const FilaRenderizacao& fila);
+
+// Envia os pacotes na ordem atual, agrupando desenhos vizinhos com o mesmo estado.
+EstatisticasFila executaFila(const FilaRenderizacao& fila);
+
+// Esvazia a fila para o proximo quadro (mantem a memoria alocada).
+void limpaFila(FilaRenderizacao& fila);
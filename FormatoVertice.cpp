@@ -0,0 +1,266 @@
+#include <glad/glad.h>
+
+#include "FormatoVertice.h"
+
+#include <cmath>
+#include <cstring>
+
+uint16_t floatParaHalf(float valor)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &valor, sizeof(bits));
+
+    uint32_t sinal = (bits >> 16) & 0x8000u;
+    uint32_t absoluto = bits & 0x7FFFFFFFu;
+
+    // Infinito e NaN.
+    if (absoluto >= 0x7F800000u) {
+        return (uint16_t)(sinal | 0x7C00u | (absoluto > 0x7F800000u ? 0x0200u : 0u));
+    }
+
+    // Maior que o maior half (65504) depois do arredondamento: infinito.
+    if (absoluto >= 0x477FF000u) {
+        return (uint16_t)(sinal | 0x7C00u);
+    }
+
+    // Menor que o menor half normal (2^-14): half subnormal ou zero.
+    if (absoluto < 0x38800000u) {
+        if (absoluto < 0x33000000u) {
+            return (uint16_t)sinal;
+        }
+
+        uint32_t mantissa = (absoluto & 0x007FFFFFu) | 0x00800000u;
+        uint32_t deslocamento = 126u - (absoluto >> 23);
+        uint32_t half = mantissa >> deslocamento;
+        uint32_t resto = mantissa & ((1u << deslocamento) - 1u);
+        uint32_t meio = 1u << (deslocamento - 1u);
+        if (resto > meio || (resto == meio && (half & 1u))) {
+            half++;
+        }
+        return (uint16_t)(sinal | half);
+    }
+
+    // Half normal: troca o bias do expoente (127 -> 15) e arredonda a mantissa de 23 para 10 bits.
+    uint32_t half = (absoluto - 0x38000000u) >> 13;
+    uint32_t resto = absoluto & 0x1FFFu;
+    if (resto > 0x1000u || (resto == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return (uint16_t)(sinal | half);
+}
+
+float halfParaFloat(uint16_t valor)
+{
+    uint32_t sinal = (uint32_t)(valor & 0x8000u) << 16;
+    uint32_t expoente = (valor >> 10) & 0x1Fu;
+    uint32_t mantissa = valor & 0x03FFu;
+    uint32_t bits;
+
+    if (expoente == 0x1Fu) {
+        // Infinito e NaN.
+        bits = sinal | 0x7F800000u | (mantissa << 13);
+    }
+    else if (expoente != 0) {
+        bits = sinal | ((expoente + 112u) << 23) | (mantissa << 13);
+    }
+    else if (mantissa != 0) {
+        // Subnormal: normaliza a mantissa.
+        expoente = 113;
+        while ((mantissa & 0x0400u) == 0) {
+            mantissa <<= 1;
+            expoente--;
+        }
+        bits = sinal | (expoente << 23) | ((mantissa & 0x03FFu) << 13);
+    }
+    else {
+        bits = sinal;
+    }
+
+    float resultado;
+    std::memcpy(&resultado, &bits, sizeof(resultado));
+    return resultado;
+}
+
+// Limita ao intervalo -1.0 a 1.0 e converte para snorm de 10 bits (complemento de dois).
+static uint32_t paraSnorm10(float valor)
+{
+    if (valor > 1.0f) valor = 1.0f;
+    if (valor < -1.0f) valor = -1.0f;
+    int inteiro = (int)std::lround(valor * 511.0f);
+    return (uint32_t)inteiro & 0x3FFu;
+}
+
+static float deSnorm10(uint32_t bits)
+{
+    // Estende o sinal de 10 bits para 32 bits.
+    int inteiro = (int)(bits << 22) >> 22;
+    float valor = (float)inteiro / 511.0f;
+    return valor < -1.0f ? -1.0f : valor;
+}
+
+static float sinalNaoNulo(float valor)
+{
+    return valor >= 0.0f ? 1.0f : -1.0f;
+}
+
+uint32_t codificaNormalOctaedrica(float nx, float ny, float nz)
+{
+    // Projeta a esfera no octaedro |x| + |y| + |z| = 1.
+    float soma = std::fabs(nx) + std::fabs(ny) + std::fabs(nz);
+    if (soma <= 0.0f) {
+        return 0;
+    }
+
+    float ox = nx / soma;
+    float oy = ny / soma;
+
+    // O hemisfério de baixo é dobrado sobre os cantos do quadrado.
+    if (nz < 0.0f) {
+        float dobraX = (1.0f - std::fabs(oy)) * sinalNaoNulo(ox);
+        float dobraY = (1.0f - std::fabs(ox)) * sinalNaoNulo(oy);
+        ox = dobraX;
+        oy = dobraY;
+    }
+
+    // x nos bits 0-9 e y nos bits 10-19 (z e w ficam zerados).
+    return paraSnorm10(ox) | (paraSnorm10(oy) << 10);
+}
+
+void decodificaNormalOctaedrica(uint32_t empacotado, float normal[3])
+{
+    float x = deSnorm10(empacotado & 0x3FFu);
+    float y = deSnorm10((empacotado >> 10) & 0x3FFu);
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    // Desfaz a dobra do hemisfério de baixo (mesma conta do vertex shader).
+    float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    float comprimento = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / comprimento;
+    normal[1] = y / comprimento;
+    normal[2] = z / comprimento;
+}
+
+uint16_t codificaUV(float valor)
+{
+    if (valor < 0.0f) valor = 0.0f;
+    if (valor > 1.0f) valor = 1.0f;
+    return (uint16_t)std::lround(valor * 65535.0f);
+}
+
+float decodificaUV(uint16_t valor)
+{
+    return (float)valor / 65535.0f;
+}
+
+void compactaVertices(const VerticeCompleto* entrada, size_t numVertices, VerticeCompacto* saida)
+{
+    for (size_t i = 0; i < numVertices; i++) {
+        const VerticeCompleto& v = entrada[i];
+        VerticeCompacto& c = saida[i];
+
+        c.posicao[0] = floatParaHalf(v.posicao[0]);
+        c.posicao[1] = floatParaHalf(v.posicao[1]);
+        c.posicao[2] = floatParaHalf(v.posicao[2]);
+        c.posicao[3] = 0;
+        c.normal = codificaNormalOctaedrica(v.normal[0], v.normal[1], v.normal[2]);
+        c.uv[0] = codificaUV(v.uv[0]);
+        c.uv[1] = codificaUV(v.uv[1]);
+    }
+}
+
+void compactaPosicoes(const float* posicoes, size_t numVertices, uint16_t* saida)
+{
+    for (size_t i = 0; i < numVertices; i++) {
+        saida[i * 4 + 0] = floatParaHalf(posicoes[i * 3 + 0]);
+        saida[i * 4 + 1] = floatParaHalf(posicoes[i * 3 + 1]);
+        saida[i * 4 + 2] = floatParaHalf(posicoes[i * 3 + 2]);
+        saida[i * 4 + 3] = 0;
+    }
+}
+
+void configuraAtributosCompletos()
+{
+    // (x, y, z), (nx, ny, nz), (u, v) em float.
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VerticeCompleto), (void*)offsetof(VerticeCompleto, posicao));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VerticeCompleto), (void*)offsetof(VerticeCompleto, normal));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VerticeCompleto), (void*)offsetof(VerticeCompleto, uv));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+void configuraAtributosCompactos()
+{
+    // Half float é convertido para float pelo proprio OpenGL (o shader recebe vec3 normalmente).
+    glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(VerticeCompacto), (void*)offsetof(VerticeCompacto, posicao));
+
+    // 2_10_10_10_REV exige 4 componentes; normalizado, chega no shader no intervalo -1.0 a 1.0.
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(VerticeCompacto), (void*)offsetof(VerticeCompacto, normal));
+
+    // Unsigned short normalizado chega no shader no intervalo 0.0 a 1.0.
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(VerticeCompacto), (void*)offsetof(VerticeCompacto, uv));
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+void geraEsferaVerticesCompletos(std::vector<VerticeCompleto>& vertices, unsigned int fatias, unsigned int aneis)
+{
+    const float pi = 3.14159265358979f;
+
+    vertices.clear();
+    for (unsigned int a = 0; a <= aneis; a++) {
+        float phi = pi * (float)a / (float)aneis;
+        for (unsigned int f = 0; f <= fatias; f++) {
+            float theta = 2.0f * pi * (float)f / (float)fatias;
+
+            VerticeCompleto v;
+            v.normal[0] = std::sin(phi) * std::cos(theta);
+            v.normal[1] = std::cos(phi);
+            v.normal[2] = std::sin(phi) * std::sin(theta);
+            v.posicao[0] = v.normal[0];
+            v.posicao[1] = v.normal[1];
+            v.posicao[2] = v.normal[2];
+            v.uv[0] = (float)f / (float)fatias;
+            v.uv[1] = (float)a / (float)aneis;
+            vertices.push_back(v);
+        }
+    }
+}
+
+// Declarando o vertex shader do formato compacto.
+const char* vertexShaderCompactoSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 1) in vec4 aNormal;\n"
+"layout (location = 2) in vec2 aUV;\n"
+"out vec3 Normal;\n"
+"out vec2 UV;\n"
+"vec3 decodificaOctaedro(vec2 e)\n"
+"{\n"
+"   vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));\n"
+"   float t = max(-n.z, 0.0);\n"
+"   n.x += n.x >= 0.0 ? -t : t;\n"
+"   n.y += n.y >= 0.0 ? -t : t;\n"
+"   return normalize(n);\n"
+"}\n"
+"void main()\n"
+"{\n"
+"   Normal = decodificaOctaedro(aNormal.xy);\n"
+"   UV = aUV;\n"
+"   gl_Position = vec4(aPos.x * 0.5, aPos.y * 0.5, aPos.z * 0.5, 1.0);\n"
+"}\n\0";
+
+// Declarando o fragment shader do formato compacto (iluminação difusa simples).
+const char* fragmentShaderCompactoSource = "#version 330 core\n"
+"in vec3 Normal;\n"
+"in vec2 UV;\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"    float difusa = max(dot(normalize(Normal), normalize(vec3(0.3, 0.6, -0.7))), 0.0);\n"
+"    FragColor = vec4(vec3(UV, 1.0) * (0.2 + 0.8 * difusa), 1.0);\n"
+"}\n\0";
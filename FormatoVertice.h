@@ -0,0 +1,52 @@
+#pragma once
+
+// Formatos de vertice compactos (quantização dos atributos).
+// Posição em half float, normal octaédrica em GL_INT_2_10_10_10_REV e UV normalizado em 16 bits:
+// 16 bytes por vertice em vez dos 32 bytes do formato todo em float.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Vertice completo em float: (x, y, z), (nx, ny, nz), (u, v). 32 bytes.
+struct VerticeCompleto {
+    float posicao[3];
+    float normal[3];
+    float uv[2];
+};
+
+// Vertice compacto. 16 bytes.
+struct VerticeCompacto {
+    uint16_t posicao[4];  // Half float (x, y, z, preenchimento para alinhar em 8 bytes).
+    uint32_t normal;      // Octaedro em 2 componentes snorm de 10 bits (GL_INT_2_10_10_10_REV).
+    uint16_t uv[2];       // Unorm de 16 bits (intervalo 0.0 a 1.0).
+};
+
+// Conversão float <-> half float (IEEE 754 binary16, arredondamento para o par mais proximo).
+uint16_t floatParaHalf(float valor);
+float halfParaFloat(uint16_t valor);
+
+// Normal unitária <-> octaedro empacotado em 2_10_10_10_REV.
+uint32_t codificaNormalOctaedrica(float nx, float ny, float nz);
+void decodificaNormalOctaedrica(uint32_t empacotado, float normal[3]);
+
+// UV no intervalo 0.0 a 1.0 <-> unorm de 16 bits (valores fora do intervalo são limitados).
+uint16_t codificaUV(float valor);
+float decodificaUV(uint16_t valor);
+
+// Converte um array de vertices completos para o formato compacto.
+void compactaVertices(const VerticeCompleto* entrada, size_t numVertices, VerticeCompacto* saida);
+
+// Converte posições (x, y, z) em float para half float com 4 componentes por vertice (w = 0).
+void compactaPosicoes(const float* posicoes, size_t numVertices, uint16_t* saida);
+
+// Configura os atributos do VAO vinculado (locations 0, 1 e 2) para cada formato.
+void configuraAtributosCompletos();
+void configuraAtributosCompactos();
+
+// Esfera unitária com normais e UV, usada para medir o formato compacto.
+void geraEsferaVerticesCompletos(std::vector<VerticeCompleto>& vertices, unsigned int fatias, unsigned int aneis);
+
+// Shaders que leem o formato compacto (decodificam a normal octaédrica).
+extern const char* vertexShaderCompactoSource;
+extern const char* fragmentShaderCompactoSource;
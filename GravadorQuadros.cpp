@@ -0,0 +1,105 @@
+#include "GravadorQuadros.h"
+
+GravadorQuadros::GravadorQuadros(unsigned int numThreads, unsigned int maxPendentes)
+    : maxPendentes(maxPendentes > 0 ? maxPendentes : 1), codificados(0), bytes(0)
+{
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+        if (numThreads == 0) {
+            numThreads = 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++) {
+        trabalhadores.emplace_back(&GravadorQuadros::executaTrabalhador, this);
+    }
+}
+
+GravadorQuadros::~GravadorQuadros()
+{
+    esperaTodos();
+    {
+        std::lock_guard<std::mutex> travado(trava);
+        encerrando = true;
+    }
+    sinalTarefa.notify_all();
+
+    for (std::thread& t : trabalhadores) {
+        t.join();
+    }
+}
+
+std::vector<uint32_t> GravadorQuadros::bufferLivre()
+{
+    std::lock_guard<std::mutex> travado(trava);
+    if (livres.empty()) {
+        return std::vector<uint32_t>();
+    }
+    std::vector<uint32_t> buffer = std::move(livres.back());
+    livres.pop_back();
+    return buffer;
+}
+
+void GravadorQuadros::enfileira(std::vector<uint32_t>&& pixels, int largura, int altura, FormatoImagem formato,
+                                const std::string& caminho, bool linhaZeroEmbaixo)
+{
+    {
+        std::unique_lock<std::mutex> travado(trava);
+        sinalEspaco.wait(travado, [this] { return fila.size() < maxPendentes; });
+
+        QuadroPendente quadro;
+        quadro.pixels = std::move(pixels);
+        quadro.largura = largura;
+        quadro.altura = altura;
+        quadro.formato = formato;
+        quadro.caminho = caminho;
+        quadro.linhaZeroEmbaixo = linhaZeroEmbaixo;
+        fila.push_back(std::move(quadro));
+    }
+    sinalTarefa.notify_one();
+}
+
+void GravadorQuadros::esperaTodos()
+{
+    std::unique_lock<std::mutex> travado(trava);
+    sinalEspaco.wait(travado, [this] { return fila.empty() && emAndamento == 0; });
+}
+
+void GravadorQuadros::executaTrabalhador()
+{
+    // Cada thread reaproveita o proprio vetor de saida entre quadros.
+    std::vector<uint8_t> arquivo;
+
+    for (;;) {
+        QuadroPendente quadro;
+        {
+            std::unique_lock<std::mutex> travado(trava);
+            sinalTarefa.wait(travado, [this] { return encerrando || !fila.empty(); });
+            if (fila.empty()) {
+                return;
+            }
+            quadro = std::move(fila.front());
+            fila.pop_front();
+            emAndamento++;
+        }
+        // Já existe espaço na fila.
+        sinalEspaco.notify_all();
+
+        codificaImagem(quadro.formato, quadro.pixels.data(), quadro.largura, quadro.altura, arquivo, quadro.linhaZeroEmbaixo);
+        if (!quadro.caminho.empty()) {
+            gravaArquivo(quadro.caminho.c_str(), arquivo);
+        }
+        bytes += arquivo.size();
+        codificados++;
+
+        {
+            std::lock_guard<std::mutex> travado(trava);
+            // Guarda no maximo um vetor por quadro que pode estar em andamento; os outros são liberados.
+            if (livres.size() < maxPendentes + trabalhadores.size()) {
+                livres.push_back(std::move(quadro.pixels));
+            }
+            emAndamento--;
+        }
+        sinalEspaco.notify_all();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// Gravação de quadros em segundo plano: o laço de renderização entrega os pixels e segue para o
+// proximo quadro enquanto threads proprias comprimem (PNG/EXR) e gravam os arquivos.
+// Diferente do PoolThreads, onde paraCada só retorna no fim, aqui as tarefas ficam numa fila.
+
+#include "CodificadorImagem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class GravadorQuadros {
+public:
+    // "numThreads" = 0 usa todos os nucleos. Com "maxPendentes" quadros na fila, enfileira espera
+    // (a memoria não cresce sem limite se a codificação for mais lenta que a renderização).
+    explicit GravadorQuadros(unsigned int numThreads = 0, unsigned int maxPendentes = 4);
+    // Termina os quadros que ainda estão na fila.
+    ~GravadorQuadros();
+
+    GravadorQuadros(const GravadorQuadros&) = delete;
+    GravadorQuadros& operator=(const GravadorQuadros&) = delete;
+
+    // Vetor para o proximo quadro: reaproveita os de quadros já codificados (33 MB por quadro em 4K).
+    std::vector<uint32_t> bufferLivre();
+
+    // Fica com os pixels (RGBA8). Caminho vazio só codifica, sem gravar (usado nas medições).
+    void enfileira(std::vector<uint32_t>&& pixels, int largura, int altura, FormatoImagem formato,
+                   const std::string& caminho, bool linhaZeroEmbaixo = true);
+
+    // Espera a fila esvaziar e todas as threads ficarem paradas.
+    void esperaTodos();
+
+    unsigned int numThreads() const { return (unsigned int)trabalhadores.size(); }
+    uint64_t quadrosCodificados() const { return codificados.load(); }
+    uint64_t bytesGerados() const { return bytes.load(); }
+
+private:
+    struct QuadroPendente {
+        std::vector<uint32_t> pixels;
+        int largura, altura;
+        FormatoImagem formato;
+        std::string caminho;
+        bool linhaZeroEmbaixo;
+    };
+
+    void executaTrabalhador();
+
+    std::vector<std::thread> trabalhadores;
+    std::mutex trava;
+    std::condition_variable sinalTarefa;      // Fila ganhou um quadro (ou encerrando).
+    std::condition_variable sinalEspaco;      // Fila perdeu um quadro ou ficou vazia.
+    std::deque<QuadroPendente> fila;
+    std::vector<std::vector<uint32_t>> livres;
+    unsigned int maxPendentes;
+    unsigned int emAndamento = 0;
+    bool encerrando = false;
+
+    std::atomic<uint64_t> codificados;
+    std::atomic<uint64_t> bytes;
+};
@@ -0,0 +1,152 @@
+#include "HierarquiaCena.h"
+
+#include <algorithm>
+#include <iostream>
+
+// Nós por tarefa quando um nivel é dividido entre as threads.
+static const uint32_t nosPorTarefa = 4096;
+
+uint32_t adicionaNo(HierarquiaCena& cena, int32_t pai, const Mat4& local)
+{
+    uint32_t indice = (uint32_t)cena.pai.size();
+    if (pai != semPai && (pai < 0 || (uint32_t)pai >= indice)) {
+        std::cout << "ERRO::HIERARQUIA::PAI_INVALIDO " << pai << std::endl;
+        pai = semPai;
+    }
+
+    cena.pai.push_back(pai);
+    cena.local.push_back(local);
+    cena.mundo.push_back(local);
+    cena.sujo.push_back(1);
+    cena.organizada = false;
+    return indice;
+}
+
+void organizaHierarquia(HierarquiaCena& cena, std::vector<uint32_t>* novoIndice)
+{
+    uint32_t numNos = (uint32_t)cena.pai.size();
+
+    // Filhos de cada nó, contiguos (mesma ordem em que foram adicionados).
+    std::vector<uint32_t> inicioFilhos(numNos + 1, 0);
+    for (uint32_t i = 0; i < numNos; i++) {
+        if (cena.pai[i] != semPai) {
+            inicioFilhos[cena.pai[i] + 1]++;
+        }
+    }
+    for (uint32_t i = 0; i < numNos; i++) {
+        inicioFilhos[i + 1] += inicioFilhos[i];
+    }
+    std::vector<uint32_t> filhos(numNos);
+    std::vector<uint32_t> cursor(inicioFilhos.begin(), inicioFilhos.end() - 1);
+    for (uint32_t i = 0; i < numNos; i++) {
+        if (cena.pai[i] != semPai) {
+            filhos[cursor[cena.pai[i]]++] = i;
+        }
+    }
+
+    // Busca em largura: a ordem de cada nivel sai dos filhos do nivel anterior, na ordem dos pais.
+    std::vector<uint32_t> ordem;
+    ordem.reserve(numNos);
+    for (uint32_t i = 0; i < numNos; i++) {
+        if (cena.pai[i] == semPai) {
+            ordem.push_back(i);
+        }
+    }
+    cena.inicioNivel.assign(1, 0);
+    size_t inicio = 0;
+    while (inicio < ordem.size()) {
+        size_t fim = ordem.size();
+        for (size_t k = inicio; k < fim; k++) {
+            uint32_t no = ordem[k];
+            ordem.insert(ordem.end(), filhos.begin() + inicioFilhos[no], filhos.begin() + inicioFilhos[no + 1]);
+        }
+        cena.inicioNivel.push_back((uint32_t)fim);
+        inicio = fim;
+    }
+
+    std::vector<uint32_t> novo(numNos);
+    for (uint32_t k = 0; k < numNos; k++) {
+        novo[ordem[k]] = k;
+    }
+
+    std::vector<int32_t> pai(numNos);
+    std::vector<Mat4> local(numNos), mundo(numNos);
+    std::vector<uint8_t> sujo(numNos);
+    for (uint32_t k = 0; k < numNos; k++) {
+        uint32_t antigo = ordem[k];
+        pai[k] = cena.pai[antigo] == semPai ? semPai : (int32_t)novo[cena.pai[antigo]];
+        local[k] = cena.local[antigo];
+        mundo[k] = cena.mundo[antigo];
+        sujo[k] = cena.sujo[antigo];
+    }
+    cena.pai.swap(pai);
+    cena.local.swap(local);
+    cena.mundo.swap(mundo);
+    cena.sujo.swap(sujo);
+    cena.organizada = true;
+
+    if (novoIndice) {
+        novoIndice->swap(novo);
+    }
+}
+
+// Atualiza os nós [inicio, fim) de um nivel. O nó fica sujo também quando o pai estava sujo, e é essa
+// marca que os filhos dele leem no nivel seguinte.
+static size_t atualizaFaixa(HierarquiaCena& cena, uint32_t inicio, uint32_t fim)
+{
+    const int32_t* pai = cena.pai.data();
+    const Mat4* local = cena.local.data();
+    Mat4* mundo = cena.mundo.data();
+    uint8_t* sujo = cena.sujo.data();
+
+    size_t recalculadas = 0;
+    for (uint32_t i = inicio; i < fim; i++) {
+        int32_t p = pai[i];
+        if (p == semPai) {
+            if (sujo[i]) {
+                mundo[i] = local[i];
+                recalculadas++;
+            }
+        }
+        else if (sujo[i] | sujo[p]) {
+            mundo[i] = mundo[p] * local[i];
+            sujo[i] = 1;
+            recalculadas++;
+        }
+    }
+    return recalculadas;
+}
+
+size_t atualizaHierarquia(HierarquiaCena& cena, PoolThreads* pool)
+{
+    if (!cena.organizada) {
+        std::cout << "ERRO::HIERARQUIA::NAO_ORGANIZADA" << std::endl;
+        return 0;
+    }
+
+    size_t recalculadas = 0;
+    std::vector<size_t> porThread(pool ? pool->numThreads() : 1, 0);
+    for (uint32_t nivel = 0; nivel < numNiveis(cena); nivel++) {
+        uint32_t inicio = cena.inicioNivel[nivel];
+        uint32_t fim = cena.inicioNivel[nivel + 1];
+
+        // Niveis pequenos não compensam acordar as threads.
+        if (!pool || fim - inicio < 2 * nosPorTarefa) {
+            recalculadas += atualizaFaixa(cena, inicio, fim);
+            continue;
+        }
+
+        // paraCada só retorna com o nivel inteiro pronto, então o proximo nivel já vê todos os pais.
+        unsigned int numTarefas = (fim - inicio + nosPorTarefa - 1) / nosPorTarefa;
+        pool->paraCada(numTarefas, [&](unsigned int tarefa, unsigned int thread) {
+            uint32_t primeiro = inicio + tarefa * nosPorTarefa;
+            porThread[thread] += atualizaFaixa(cena, primeiro, std::min(fim, primeiro + nosPorTarefa));
+        });
+    }
+
+    for (size_t contagem : porThread) {
+        recalculadas += contagem;
+    }
+    std::fill(cena.sujo.begin(), cena.sujo.end(), (uint8_t)0);
+    return recalculadas;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Hierarquia de cena em arrays planos, na ordem de uma busca em largura: os nós de cada nivel ficam
+// contiguos e todo pai vem antes dos filhos. Assim a transformação no mundo é calculada percorrendo os
+// arrays uma vez, nivel por nivel, e os nós de um mesmo nivel podem ser divididos entre threads (cada um
+// só lê o pai, que está num nivel já terminado).
+// Só os nós marcados como sujos e as subarvores deles recalculam a matriz do mundo.
+
+#include "Matematica.h"
+#include "PoolThreads.h"
+
+#include <cstdint>
+#include <vector>
+
+const int32_t semPai = -1;
+
+struct HierarquiaCena {
+    std::vector<int32_t> pai;            // Indice do pai ou semPai. Depois de organizada, pai[i] < i.
+    std::vector<Mat4> local;             // Transformação relativa ao pai.
+    std::vector<Mat4> mundo;             // pai.mundo * local (local nas raizes).
+    std::vector<uint8_t> sujo;           // Local mudou desde a ultima atualização.
+    std::vector<uint32_t> inicioNivel;   // O nivel n ocupa [inicioNivel[n], inicioNivel[n + 1]).
+    bool organizada = true;
+};
+
+// Adiciona um nó filho de "pai" (semPai para uma raiz) e retorna o indice dele. O pai precisa já existir.
+// Depois de adicionar nós é preciso chamar organizaHierarquia antes de atualizar.
+uint32_t adicionaNo(HierarquiaCena& cena, int32_t pai, const Mat4& local);
+
+// Reordena os nós em largura (raizes primeiro, filhos do mesmo pai juntos). Se "novoIndice" não for nulo,
+// recebe a nova posição de cada indice antigo.
+void organizaHierarquia(HierarquiaCena& cena, std::vector<uint32_t>* novoIndice = nullptr);
+
+inline void defineLocal(HierarquiaCena& cena, uint32_t no, const Mat4& local)
+{
+    cena.local[no] = local;
+    cena.sujo[no] = 1;
+}
+
+inline uint32_t numNiveis(const HierarquiaCena& cena)
+{
+    return cena.inicioNivel.empty() ? 0 : (uint32_t)cena.inicioNivel.size() - 1;
+}
+
+// Recalcula o mundo dos nós sujos e dos descendentes deles e limpa as marcas. Com "pool", os niveis
+// grandes são divididos entre as threads. Retorna quantas matrizes foram recalculadas.
+size_t atualizaHierarquia(HierarquiaCena& cena, PoolThreads* pool = nullptr);
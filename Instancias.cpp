@@ -0,0 +1,142 @@
+#include <glad/glad.h>
+
+#include "Instancias.h"
+
+#include <cmath>
+#include <cstddef>
+
+void criaLoteInstancias(LoteInstancias& lote, unsigned int VAO, unsigned int capacidade)
+{
+    lote.capacidade = capacidade;
+    lote.quantidade = 0;
+
+    glGenBuffers(1, &lote.VBOInstancias);
+
+    // Os atributos ficam gravados no VAO, junto com os atributos por vertice.
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, lote.VBOInstancias);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacidade * sizeof(InstanciaTriangulo), NULL, GL_STREAM_DRAW);
+
+    // Matriz 3x4: uma linha vec4 por location.
+    for (unsigned int linha = 0; linha < 3; linha++) {
+        glVertexAttribPointer(locationInstancias + linha, 4, GL_FLOAT, GL_FALSE, sizeof(InstanciaTriangulo),
+                              (void*)(offsetof(InstanciaTriangulo, transformacao) + linha * 4 * sizeof(float)));
+        glEnableVertexAttribArray(locationInstancias + linha);
+
+        // Divisor 1: o atributo avança uma vez por instância, não por vertice.
+        glVertexAttribDivisor(locationInstancias + linha, 1);
+    }
+
+    // Cor RGBA8 normalizada (chega no shader no intervalo 0.0 a 1.0).
+    glVertexAttribPointer(locationInstancias + 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanciaTriangulo),
+                          (void*)offsetof(InstanciaTriangulo, cor));
+    glEnableVertexAttribArray(locationInstancias + 3);
+    glVertexAttribDivisor(locationInstancias + 3, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void atualizaInstancias(LoteInstancias& lote, const InstanciaTriangulo* dados, unsigned int quantidade)
+{
+    if (quantidade > lote.capacidade) {
+        quantidade = lote.capacidade;
+    }
+    lote.quantidade = quantidade;
+
+    glBindBuffer(GL_ARRAY_BUFFER, lote.VBOInstancias);
+
+    // "Orfana" o buffer antigo: o driver entrega memoria nova se a GPU ainda estiver lendo o anterior.
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)lote.capacidade * sizeof(InstanciaTriangulo), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)quantidade * sizeof(InstanciaTriangulo), dados);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstanciaTriangulo* mapeiaInstancias(LoteInstancias& lote, unsigned int quantidade)
+{
+    if (quantidade > lote.capacidade) {
+        quantidade = lote.capacidade;
+    }
+    lote.quantidade = quantidade;
+    if (quantidade == 0) {
+        return nullptr;
+    }
+
+    // INVALIDATE_BUFFER tem o mesmo efeito do glBufferData com NULL: a GPU continua com o buffer antigo.
+    glBindBuffer(GL_ARRAY_BUFFER, lote.VBOInstancias);
+    void* mapeado = glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)quantidade * sizeof(InstanciaTriangulo),
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (!mapeado) {
+        lote.quantidade = 0;
+    }
+    return (InstanciaTriangulo*)mapeado;
+}
+
+bool desmapeiaInstancias(LoteInstancias& lote)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, lote.VBOInstancias);
+    bool ok = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (!ok) {
+        lote.quantidade = 0;
+    }
+    return ok;
+}
+
+void desenhaInstancias(const LoteInstancias& lote, unsigned int VAO, int numVertices)
+{
+    glBindVertexArray(VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, numVertices, (GLsizei)lote.quantidade);
+}
+
+void desenhaInstanciasIndexadas(const LoteInstancias& lote, unsigned int VAO, int numIndices)
+{
+    glBindVertexArray(VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (void*)0, (GLsizei)lote.quantidade);
+}
+
+void destroiLoteInstancias(LoteInstancias& lote)
+{
+    glDeleteBuffers(1, &lote.VBOInstancias);
+    lote.VBOInstancias = 0;
+    lote.capacidade = 0;
+    lote.quantidade = 0;
+}
+
+void defineTransformacao2D(InstanciaTriangulo& instancia, float x, float y, float escala, float angulo)
+{
+    float c = std::cos(angulo) * escala;
+    float s = std::sin(angulo) * escala;
+    float* m = instancia.transformacao;
+
+    // Linha 0, 1 e 2 da matriz (a quarta linha é sempre 0, 0, 0, 1).
+    m[0] = c;    m[1] = -s;   m[2] = 0.0f;  m[3] = x;
+    m[4] = s;    m[5] = c;    m[6] = 0.0f;  m[7] = y;
+    m[8] = 0.0f; m[9] = 0.0f; m[10] = escala; m[11] = 0.0f;
+}
+
+// Declarando o vertex shader das instâncias.
+const char* vertexShaderInstanciasSource = "#version 330 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"layout (location = 3) in vec4 aLinha0;\n"
+"layout (location = 4) in vec4 aLinha1;\n"
+"layout (location = 5) in vec4 aLinha2;\n"
+"layout (location = 6) in vec4 aCor;\n"
+"out vec4 Cor;\n"
+"void main()\n"
+"{\n"
+"   vec4 p = vec4(aPos, 1.0);\n"
+"   gl_Position = vec4(dot(aLinha0, p), dot(aLinha1, p), dot(aLinha2, p), 1.0);\n"
+"   Cor = aCor;\n"
+"}\n\0";
+
+// Declarando o fragment shader das instâncias.
+const char* fragmentShaderInstanciasSource = "#version 330 core\n"
+"in vec4 Cor;\n"
+"out vec4 FragColor;\n"
+"void main()\n"
+"{\n"
+"    FragColor = Cor;\n"
+"}\n\0";
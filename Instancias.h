@@ -0,0 +1,49 @@
+#pragma once
+
+// Desenho instanciado: muitas copias da mesma malha numa unica chamada de desenho.
+// Os dados de cada instância ficam num VBO proprio, lido uma vez por instância (glVertexAttribDivisor).
+
+#include <cstdint>
+
+// Primeira location de atributo usada pelas instâncias (0, 1 e 2 são posição, normal e UV).
+const unsigned int locationInstancias = 3;
+
+// Dados de uma instância: matriz 3x4 (3 linhas de vec4, locations 3 a 5) e cor RGBA8 (location 6). 52 bytes.
+struct InstanciaTriangulo {
+    float transformacao[12];
+    uint8_t cor[4];
+};
+
+// VBO de instâncias associado a um VAO.
+struct LoteInstancias {
+    unsigned int VBOInstancias = 0;
+    unsigned int capacidade = 0;
+    unsigned int quantidade = 0;
+};
+
+// Cria o VBO de instâncias e adiciona os atributos por instância ao VAO.
+void criaLoteInstancias(LoteInstancias& lote, unsigned int VAO, unsigned int capacidade);
+
+// Envia os dados das instâncias (o buffer antigo é descartado para não esperar a GPU).
+void atualizaInstancias(LoteInstancias& lote, const InstanciaTriangulo* dados, unsigned int quantidade);
+
+// Alternativa ao atualizaInstancias sem copia intermediaria: mapeia as "quantidade" primeiras instâncias
+// para escrita, descartando o buffer antigo da mesma forma. Retorna nullptr se o driver não mapear.
+// A memoria pode ser write-combined: escreva em ordem e não leia de volta.
+InstanciaTriangulo* mapeiaInstancias(LoteInstancias& lote, unsigned int quantidade);
+
+// Termina a escrita. Retorna falso se o conteudo foi perdido (raro; as instâncias precisam ser reescritas).
+bool desmapeiaInstancias(LoteInstancias& lote);
+
+// Desenha todas as instâncias do lote com o VAO informado.
+void desenhaInstancias(const LoteInstancias& lote, unsigned int VAO, int numVertices);
+void desenhaInstanciasIndexadas(const LoteInstancias& lote, unsigned int VAO, int numIndices);
+
+void destroiLoteInstancias(LoteInstancias& lote);
+
+// Preenche a matriz 3x4 de uma instância com translação, escala uniforme e rotação no eixo Z.
+void defineTransformacao2D(InstanciaTriangulo& instancia, float x, float y, float escala, float angulo);
+
+// Shaders que aplicam a transformação e a cor de cada instância.
+extern const char* vertexShaderInstanciasSource;
+extern const char* fragmentShaderInstanciasSource;
@@ -0,0 +1,228 @@
+#include "InterpretadorGLSL.h"
+#include "CompiladorGLSL.h"
+
+#include <cmath>
+#include <cstring>
+
+void executaBytecode(const ShaderBytecode& shader, FloatLote* registros)
+{
+    const FloatLote* constantes = shader.constantes.data();
+
+    for (const InstrucaoBytecode& instrucao : shader.instrucoes) {
+        const float* a = (instrucao.a & operandoConstante) ? constantes[instrucao.a & ~operandoConstante].v : registros[instrucao.a].v;
+        const float* b = (instrucao.b & operandoConstante) ? constantes[instrucao.b & ~operandoConstante].v : registros[instrucao.b].v;
+        const float* c = (instrucao.c & operandoConstante) ? constantes[instrucao.c & ~operandoConstante].v : registros[instrucao.c].v;
+
+        // Resultado num temporario: o destino pode ser um dos operandos.
+        FloatLote r;
+        switch (instrucao.operacao) {
+        case opMove:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i]; break;
+        case opSoma:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] + b[i]; break;
+        case opSubtrai:     for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] - b[i]; break;
+        case opMultiplica:  for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] * b[i]; break;
+        case opDivide:      for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] / b[i]; break;
+        case opMinimo:      for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = b[i] < a[i] ? b[i] : a[i]; break;
+        case opMaximo:      for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] < b[i] ? b[i] : a[i]; break;
+        case opPotencia:    for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::pow(a[i], b[i]); break;
+        case opAbsoluto:    for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::fabs(a[i]); break;
+        case opPiso:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::floor(a[i]); break;
+        case opRaiz:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::sqrt(a[i]); break;
+        case opInversoRaiz: for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = 1.0f / std::sqrt(a[i]); break;
+        case opSeno:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::sin(a[i]); break;
+        case opCosseno:     for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::cos(a[i]); break;
+        case opExp2:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::exp2(a[i]); break;
+        case opLog2:        for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::log2(a[i]); break;
+        case opMenor:       for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] < b[i] ? 1.0f : 0.0f; break;
+        case opMenorIgual:  for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] <= b[i] ? 1.0f : 0.0f; break;
+        case opIgual:       for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] == b[i] ? 1.0f : 0.0f; break;
+        case opDiferente:   for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a[i] != b[i] ? 1.0f : 0.0f; break;
+        case opSeleciona:   for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = c[i] != 0.0f ? a[i] : b[i]; break;
+        }
+        registros[instrucao.destino] = r;
+    }
+}
+
+bool compilaProgramaGLSL(ProgramaGLSLCPU& programa, const char* fonteVertex, const char* fonteFragment, std::string& erro)
+{
+    if (!compilaShaderGLSL(fonteVertex, shaderVertice, programa.vertex, erro)) {
+        erro = "vertex shader: " + erro;
+        return false;
+    }
+    if (!compilaShaderGLSL(fonteFragment, shaderFragmento, programa.fragment, erro)) {
+        erro = "fragment shader: " + erro;
+        return false;
+    }
+    if (programa.fragment.saidas.empty()) {
+        erro = "fragment shader sem variavel de saida";
+        return false;
+    }
+
+    // Atributos sem layout(location) recebem a proxima location livre, como no glLinkProgram.
+    bool usada[maxLocationsGLSL] = {};
+    for (const VariavelShader& entrada : programa.vertex.entradas) {
+        if (entrada.location >= 0 && entrada.location < maxLocationsGLSL) usada[entrada.location] = true;
+    }
+    for (VariavelShader& entrada : programa.vertex.entradas) {
+        if (entrada.location < 0) {
+            int livre = 0;
+            while (livre < maxLocationsGLSL && usada[livre]) livre++;
+            entrada.location = livre;
+        }
+        if (entrada.location >= maxLocationsGLSL || entrada.componentes > 4) {
+            erro = "atributo '" + entrada.nome + "' não suportado";
+            return false;
+        }
+        usada[entrada.location] = true;
+    }
+
+    // Varyings: saidas do vertex shader em sequência; as entradas do fragment shader são ligadas pelo nome.
+    programa.numVaryings = 0;
+    programa.varyingSaidas.clear();
+    for (const VariavelShader& saida : programa.vertex.saidas) {
+        if (saida.nome == "gl_Position") {
+            programa.varyingSaidas.push_back(-1);
+            continue;
+        }
+        programa.varyingSaidas.push_back(programa.numVaryings);
+        programa.numVaryings += saida.componentes;
+    }
+    if (programa.numVaryings > maxVaryingsCPU) {
+        erro = "mais de " + std::to_string(maxVaryingsCPU) + " floats de varyings";
+        return false;
+    }
+
+    programa.varyingEntradas.clear();
+    for (const VariavelShader& entrada : programa.fragment.entradas) {
+        int posicao = -1;
+        for (size_t i = 0; i < programa.vertex.saidas.size(); i++) {
+            const VariavelShader& saida = programa.vertex.saidas[i];
+            if (saida.nome == entrada.nome && saida.componentes == entrada.componentes) {
+                posicao = programa.varyingSaidas[i];
+            }
+        }
+        if (posicao < 0) {
+            erro = "varying '" + entrada.nome + "' não é escrita pelo vertex shader";
+            return false;
+        }
+        programa.varyingEntradas.push_back(posicao);
+    }
+    return true;
+}
+
+bool defineUniformGLSL(ProgramaGLSLCPU& programa, const char* nome, const float* valores, int numFloats)
+{
+    bool encontrado = false;
+    for (ShaderBytecode* shader : { &programa.vertex, &programa.fragment }) {
+        for (const VariavelShader& uniform : shader->uniforms) {
+            if (uniform.nome != nome) {
+                continue;
+            }
+            for (int i = 0; i < numFloats && i < uniform.componentes; i++) {
+                shader->constantes[uniform.registro + i] = espalha(valores[i]);
+            }
+            encontrado = true;
+        }
+    }
+    return encontrado;
+}
+
+void defineAtributoGLSL(ProgramaGLSLCPU& programa, unsigned int location, unsigned int componentes, unsigned int deslocamento)
+{
+    if (location < (unsigned int)maxLocationsGLSL) {
+        programa.atributos[location].deslocamento = (int)deslocamento;
+        programa.atributos[location].componentes = (int)componentes;
+    }
+}
+
+// Saidas que o shader não escreve ficam zeradas.
+static void zeraSaidas(const ShaderBytecode& shader, FloatLote* registros)
+{
+    for (const VariavelShader& saida : shader.saidas) {
+        for (int k = 0; k < saida.componentes; k++) {
+            registros[saida.registro + k] = espalha(0.0f);
+        }
+    }
+}
+
+// Vertex shader interpretado: 8 vertices por execução do bytecode.
+static void vertexShaderGLSL(const float* vertices, unsigned int stride, const unsigned int* indices,
+                             unsigned int quantidade, const void* uniforms, VerticeTransformado* saida)
+{
+    const ProgramaGLSLCPU& programa = *static_cast<const ProgramaGLSLCPU*>(uniforms);
+    const ShaderBytecode& shader = programa.vertex;
+    FloatLote registros[maxRegistrosShader];
+
+    for (unsigned int inicio = 0; inicio < quantidade; inicio += fragmentosPorLote) {
+        unsigned int lanes = quantidade - inicio < (unsigned int)fragmentosPorLote ? quantidade - inicio : fragmentosPorLote;
+
+        const float* lidos[fragmentosPorLote];
+        for (unsigned int l = 0; l < lanes; l++) {
+            lidos[l] = &vertices[(size_t)(indices ? indices[inicio + l] : inicio + l) * stride];
+        }
+
+        // Atributos: componentes que faltam valem (0, 0, 0, 1), como no OpenGL.
+        for (const VariavelShader& entrada : shader.entradas) {
+            const AtributoGLSL& atributo = programa.atributos[entrada.location];
+            for (int k = 0; k < entrada.componentes; k++) {
+                FloatLote& r = registros[entrada.registro + k];
+                for (unsigned int l = 0; l < (unsigned int)fragmentosPorLote; l++) {
+                    if (l < lanes && atributo.deslocamento >= 0 && k < atributo.componentes) {
+                        r.v[l] = lidos[l][atributo.deslocamento + k];
+                    }
+                    else {
+                        r.v[l] = k == 3 ? 1.0f : 0.0f;
+                    }
+                }
+            }
+        }
+
+        zeraSaidas(shader, registros);
+        executaBytecode(shader, registros);
+
+        for (size_t s = 0; s < shader.saidas.size(); s++) {
+            const VariavelShader& variavel = shader.saidas[s];
+            int destino = programa.varyingSaidas[s];
+            for (unsigned int l = 0; l < lanes; l++) {
+                float* valores = destino < 0 ? saida[inicio + l].posicao : &saida[inicio + l].varyings[destino];
+                for (int k = 0; k < variavel.componentes; k++) {
+                    valores[k] = registros[variavel.registro + k].v[l];
+                }
+            }
+        }
+    }
+}
+
+// Fragment shader interpretado: o lote de 8 fragmentos vira uma execução do bytecode.
+static void fragmentShaderGLSL(LoteFragmentos& lote, const void* uniforms)
+{
+    const ProgramaGLSLCPU& programa = *static_cast<const ProgramaGLSLCPU*>(uniforms);
+    const ShaderBytecode& shader = programa.fragment;
+    FloatLote registros[maxRegistrosShader];
+
+    for (size_t e = 0; e < shader.entradas.size(); e++) {
+        const VariavelShader& entrada = shader.entradas[e];
+        for (int k = 0; k < entrada.componentes; k++) {
+            registros[entrada.registro + k] = lote.varyings[programa.varyingEntradas[e] + k];
+        }
+    }
+
+    zeraSaidas(shader, registros);
+    executaBytecode(shader, registros);
+
+    // FragColor: componentes que faltam valem (0, 0, 0, 1).
+    const VariavelShader& cor = shader.saidas[0];
+    FloatLote* componentes[4] = { &lote.cor.x, &lote.cor.y, &lote.cor.z, &lote.cor.w };
+    for (int k = 0; k < 4; k++) {
+        *componentes[k] = k < cor.componentes ? registros[cor.registro + k] : espalha(k == 3 ? 1.0f : 0.0f);
+    }
+}
+
+void configuraProgramaCPU(ProgramaGLSLCPU& glsl, ProgramaCPU& programa)
+{
+    programa.vertex = nullptr;
+    programa.vertexLote = vertexShaderGLSL;
+    programa.fragment = nullptr;
+    programa.fragmentLote = fragmentShaderGLSL;
+    programa.numVaryings = glsl.numVaryings;
+    programa.uniforms = &glsl;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// Interpretador de shaders GLSL para o rasterizador em software.
+// O CompiladorGLSL traduz o codigo GLSL para um bytecode de registradores. Cada registrador guarda um
+// float em 8 lanes (8 vertices ou 8 fragmentos) e cada instrução é executada nas 8 lanes de uma vez,
+// então o custo de decodificar a instrução é dividido por 8.
+
+#include "RasterizadorCPU.h"
+#include "ShaderLote.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Operações do bytecode. Todas são escalares por lane: vetores e matrizes viram varias instruções.
+enum OperacaoBytecode : uint16_t {
+    opMove,                                       // d = a
+    opSoma, opSubtrai, opMultiplica, opDivide,    // d = a op b
+    opMinimo, opMaximo, opPotencia,               // d = f(a, b)
+    opAbsoluto, opPiso, opRaiz, opInversoRaiz,    // d = f(a)
+    opSeno, opCosseno, opExp2, opLog2,
+    opMenor, opMenorIgual, opIgual, opDiferente,  // d = 1.0 se verdadeiro, 0.0 se falso
+    opSeleciona                                   // d = c != 0.0 ? a : b
+};
+
+// Operando com este bit lê o banco de constantes (literais e uniforms) em vez de um registrador.
+const uint16_t operandoConstante = 0x8000;
+
+// Registradores que um shader pode usar depois da compilação.
+const int maxRegistrosShader = 512;
+
+struct InstrucaoBytecode {
+    uint16_t operacao;
+    uint16_t destino;
+    uint16_t a, b, c;
+};
+
+enum TipoShader {
+    shaderVertice,
+    shaderFragmento
+};
+
+// Variavel de interface (in, out ou uniform): primeiro registrador (ou posição no banco de constantes).
+struct VariavelShader {
+    std::string nome;
+    int componentes = 0;       // Total de floats (vec4 uLinhas[3] tem 12).
+    int location = -1;         // layout(location = N) dos atributos.
+    uint16_t registro = 0;
+};
+
+struct ShaderBytecode {
+    TipoShader tipo = shaderVertice;
+    std::vector<InstrucaoBytecode> instrucoes;
+    std::vector<FloatLote> constantes;        // Literais e uniforms, iguais nas 8 lanes.
+    std::vector<VariavelShader> entradas;     // Atributos (vertex) ou varyings (fragment).
+    std::vector<VariavelShader> saidas;       // No vertex shader inclui gl_Position.
+    std::vector<VariavelShader> uniforms;
+    int numRegistros = 0;
+};
+
+// Executa o shader nas 8 lanes; as entradas já devem estar nos registradores.
+void executaBytecode(const ShaderBytecode& shader, FloatLote* registros);
+
+// Onde cada location de atributo está no vertice (como o glVertexAttribPointer, em floats).
+const int maxLocationsGLSL = 16;
+
+struct AtributoGLSL {
+    int deslocamento = -1;
+    int componentes = 0;
+};
+
+// Vertex e fragment shader ligados pelas varyings (pelo nome, como no glLinkProgram).
+struct ProgramaGLSLCPU {
+    ShaderBytecode vertex;
+    ShaderBytecode fragment;
+    int numVaryings = 0;
+    std::vector<int> varyingSaidas;       // Para cada saida do vertex shader: posição nas varyings (-1 = gl_Position).
+    std::vector<int> varyingEntradas;     // Para cada entrada do fragment shader: posição nas varyings.
+    AtributoGLSL atributos[maxLocationsGLSL];
+};
+
+// Compila e liga os dois shaders; em caso de erro retorna falso com a mensagem em "erro".
+bool compilaProgramaGLSL(ProgramaGLSLCPU& programa, const char* fonteVertex, const char* fonteFragment, std::string& erro);
+
+// glUniform*fv: "valores" com os floats da variavel (matrizes por coluna). Retorna falso se o uniform não existe.
+bool defineUniformGLSL(ProgramaGLSLCPU& programa, const char* nome, const float* valores, int numFloats);
+
+// glVertexAttribPointer: "deslocamento" e "componentes" em floats dentro do vertice.
+void defineAtributoGLSL(ProgramaGLSLCPU& programa, unsigned int location, unsigned int componentes, unsigned int deslocamento);
+
+// Preenche o ProgramaCPU com os shaders interpretados (uniforms aponta para o ProgramaGLSLCPU).
+void configuraProgramaCPU(ProgramaGLSLCPU& glsl, ProgramaCPU& programa);
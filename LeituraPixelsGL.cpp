@@ -0,0 +1,88 @@
+#include "LeituraPixelsGL.h"
+
+#include <cstring>
+
+void criaLeituraPixels(LeituraPixels& leitura, int largura, int altura)
+{
+    leitura.largura = largura;
+    leitura.altura = altura;
+    leitura.proximo = 0;
+    leitura.pendentes = 0;
+
+    glGenBuffers(buffersLeituraPixels, leitura.buffers);
+    for (unsigned int i = 0; i < buffersLeituraPixels; i++) {
+        leitura.fences[i] = 0;
+        // STREAM_READ: a GPU escreve uma vez e a CPU lê uma vez, o driver coloca o buffer na memoria do sistema.
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, leitura.buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)largura * altura * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool iniciaLeituraPixels(LeituraPixels& leitura)
+{
+    if (leitura.pendentes == buffersLeituraPixels) {
+        return false;
+    }
+
+    unsigned int i = leitura.proximo;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, leitura.buffers[i]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // Com um PBO ligado o ultimo argumento é o deslocamento dentro do buffer.
+    glReadPixels(0, 0, leitura.largura, leitura.altura, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    leitura.fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    leitura.proximo = (i + 1) % buffersLeituraPixels;
+    leitura.pendentes++;
+    return true;
+}
+
+bool terminaLeituraPixels(LeituraPixels& leitura, std::vector<uint32_t>& destino, bool espera)
+{
+    if (leitura.pendentes == 0) {
+        return false;
+    }
+
+    unsigned int i = (leitura.proximo + buffersLeituraPixels - leitura.pendentes) % buffersLeituraPixels;
+
+    // FLUSH_COMMANDS: garante que o fence chegou na GPU, senão a espera poderia não terminar.
+    GLuint64 limite = espera ? 1000000000ull : 0;
+    GLenum estado;
+    do {
+        estado = glClientWaitSync(leitura.fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, limite);
+    } while (espera && estado == GL_TIMEOUT_EXPIRED);
+    if (estado == GL_TIMEOUT_EXPIRED || estado == GL_WAIT_FAILED) {
+        return false;
+    }
+    glDeleteSync(leitura.fences[i]);
+    leitura.fences[i] = 0;
+    leitura.pendentes--;
+
+    size_t bytes = (size_t)leitura.largura * leitura.altura * 4;
+    destino.resize((size_t)leitura.largura * leitura.altura);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, leitura.buffers[i]);
+    const void* mapeado = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT);
+    bool ok = mapeado != nullptr;
+    if (ok) {
+        std::memcpy(destino.data(), mapeado, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return ok;
+}
+
+void destroiLeituraPixels(LeituraPixels& leitura)
+{
+    for (unsigned int i = 0; i < buffersLeituraPixels; i++) {
+        if (leitura.fences[i]) {
+            glDeleteSync(leitura.fences[i]);
+            leitura.fences[i] = 0;
+        }
+    }
+    glDeleteBuffers(buffersLeituraPixels, leitura.buffers);
+    leitura.pendentes = 0;
+    leitura.largura = 0;
+    leitura.altura = 0;
+}
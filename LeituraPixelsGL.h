@@ -0,0 +1,36 @@
+#pragma once
+
+// Leitura do framebuffer do OpenGL sem parar a CPU.
+// O glReadPixels vai para um pixel buffer object (GL_PIXEL_PACK_BUFFER) e retorna na hora: a copia é
+// feita pelo driver depois dos desenhos do quadro. Com 3 PBOs em anel, cada quadro só é mapeado quando
+// o fence mostra que a copia terminou, normalmente 1 ou 2 quadros depois, e nada espera a GPU.
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+// Quadros que podem estar em copia ao mesmo tempo.
+const unsigned int buffersLeituraPixels = 3;
+
+struct LeituraPixels {
+    unsigned int buffers[buffersLeituraPixels] = {};
+    GLsync fences[buffersLeituraPixels] = {};
+    int largura = 0;
+    int altura = 0;
+    unsigned int proximo = 0;         // PBO que recebe o proximo glReadPixels.
+    unsigned int pendentes = 0;       // Copias iniciadas e ainda não lidas (as mais antigas vêm antes de "proximo").
+};
+
+// Cria os PBOs para quadros de "largura" x "altura" em RGBA8.
+void criaLeituraPixels(LeituraPixels& leitura, int largura, int altura);
+
+// Inicia a copia do framebuffer de leitura atual (GL_READ_FRAMEBUFFER), a partir de (0, 0).
+// Retorna falso sem copiar se todos os PBOs ainda têm quadros não lidos.
+bool iniciaLeituraPixels(LeituraPixels& leitura);
+
+// Copia o quadro mais antigo para "destino" (RGBA8, linha 0 embaixo).
+// Sem "espera" retorna falso se a copia ainda não terminou; com "espera" bloqueia até terminar.
+bool terminaLeituraPixels(LeituraPixels& leitura, std::vector<uint32_t>& destino, bool espera);
+
+void destroiLeituraPixels(LeituraPixels& leitura);
@@ -0,0 +1,621 @@
+#pragma once
+
+// Matematica 3D da CPU (câmeras e transformações): Vec3, Vec4, Mat4 e Quat, só em cabeçalho.
+// Mesmas convenções do GLSL: matrizes por coluna, vetor coluna (m * v) e angulos em radianos, então
+// uma Mat4 vai direto para glUniformMatrix4fv(local, 1, GL_FALSE, m.dados()).
+// Os tipos guardam floats alinhados em 16 bytes e as operações usam SSE (x86), AVX2 com FMA quando o
+// compilador os habilita (/arch:AVX2 ou -mavx2 -mfma) e NEON (ARM). Sem SIMD, ou com MATEMATICA_ESCALAR
+// definido antes do include, as operações são escalares e constexpr.
+// Os lotes (transformaLoteVec4 e multiplicaLoteMat4) também escolhem AVX2 em tempo de execução pelo CPUID.
+
+#include "CPUInfo.h"
+
+#include <cmath>
+#include <cstddef>
+
+#if !defined(MATEMATICA_ESCALAR) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATEMATICA_SSE 1
+#else
+#define MATEMATICA_SSE 0
+#endif
+
+#if !defined(MATEMATICA_ESCALAR) && !MATEMATICA_SSE && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define MATEMATICA_NEON 1
+#else
+#define MATEMATICA_NEON 0
+#endif
+
+// FMA: no MSVC vem junto com /arch:AVX2; no GCC/Clang com -mfma (ou -march=native).
+#if MATEMATICA_SSE && (defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#define MATEMATICA_FMA 1
+#else
+#define MATEMATICA_FMA 0
+#endif
+
+#if MATEMATICA_FMA && defined(__AVX2__)
+#define MATEMATICA_AVX2 1
+#else
+#define MATEMATICA_AVX2 0
+#endif
+
+#if MATEMATICA_SSE
+#include <immintrin.h>
+#elif MATEMATICA_NEON
+#include <arm_neon.h>
+#endif
+
+// Operações que só são constexpr na versão escalar (intrinsics não podem ser avaliados na compilação).
+#if MATEMATICA_SSE || MATEMATICA_NEON
+#define MATEMATICA_CONSTEXPR inline
+#else
+#define MATEMATICA_CONSTEXPR constexpr
+#endif
+
+// ---------------------------------------------------------------------------------------------
+// Registro de 4 floats: __m128, float32x4_t ou 4 floats.
+
+#if MATEMATICA_SSE
+typedef __m128 Registro4;
+
+inline Registro4 monta4(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline Registro4 espalha4(float s) { return _mm_set1_ps(s); }
+inline Registro4 soma4(Registro4 a, Registro4 b) { return _mm_add_ps(a, b); }
+inline Registro4 subtrai4(Registro4 a, Registro4 b) { return _mm_sub_ps(a, b); }
+inline Registro4 multiplica4(Registro4 a, Registro4 b) { return _mm_mul_ps(a, b); }
+inline Registro4 divide4(Registro4 a, Registro4 b) { return _mm_div_ps(a, b); }
+inline Registro4 minimo4(Registro4 a, Registro4 b) { return _mm_min_ps(a, b); }
+inline Registro4 maximo4(Registro4 a, Registro4 b) { return _mm_max_ps(a, b); }
+
+// a * b + c (uma instrução com FMA, com um arredondamento só).
+inline Registro4 multiplicaSoma4(Registro4 a, Registro4 b, Registro4 c)
+{
+#if MATEMATICA_FMA
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+// (a[i0], a[i1], a[i2], a[i3])
+template <int i0, int i1, int i2, int i3>
+inline Registro4 embaralha4(Registro4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(i3, i2, i1, i0)); }
+
+// (a[i0], a[i1], b[j2], b[j3])
+template <int i0, int i1, int j2, int j3>
+inline Registro4 combina4(Registro4 a, Registro4 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(j3, j2, i1, i0)); }
+
+inline float somaHorizontal4(Registro4 a)
+{
+    __m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+}
+
+inline float somaTres4(Registro4 a)
+{
+    __m128 t = _mm_add_ss(a, _mm_shuffle_ps(a, a, 1));
+    return _mm_cvtss_f32(_mm_add_ss(t, _mm_movehl_ps(a, a)));
+}
+
+#elif MATEMATICA_NEON
+typedef float32x4_t Registro4;
+
+inline Registro4 monta4(float x, float y, float z, float w) { const float v[4] = { x, y, z, w }; return vld1q_f32(v); }
+inline Registro4 espalha4(float s) { return vdupq_n_f32(s); }
+inline Registro4 soma4(Registro4 a, Registro4 b) { return vaddq_f32(a, b); }
+inline Registro4 subtrai4(Registro4 a, Registro4 b) { return vsubq_f32(a, b); }
+inline Registro4 multiplica4(Registro4 a, Registro4 b) { return vmulq_f32(a, b); }
+inline Registro4 minimo4(Registro4 a, Registro4 b) { return vminq_f32(a, b); }
+inline Registro4 maximo4(Registro4 a, Registro4 b) { return vmaxq_f32(a, b); }
+
+inline Registro4 divide4(Registro4 a, Registro4 b)
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vdivq_f32(a, b);
+#else
+    // ARMv7 não tem divisão: estimativa do inverso e dois passos de Newton-Raphson.
+    Registro4 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+#endif
+}
+
+inline Registro4 multiplicaSoma4(Registro4 a, Registro4 b, Registro4 c)
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vfmaq_f32(c, a, b);
+#else
+    return vmlaq_f32(c, a, b);
+#endif
+}
+
+template <int i0, int i1, int i2, int i3>
+inline Registro4 embaralha4(Registro4 a)
+{
+    float v[4];
+    vst1q_f32(v, a);
+    return monta4(v[i0], v[i1], v[i2], v[i3]);
+}
+
+template <int i0, int i1, int j2, int j3>
+inline Registro4 combina4(Registro4 a, Registro4 b)
+{
+    float va[4], vb[4];
+    vst1q_f32(va, a);
+    vst1q_f32(vb, b);
+    return monta4(va[i0], va[i1], vb[j2], vb[j3]);
+}
+
+inline float somaHorizontal4(Registro4 a)
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vaddvq_f32(a);
+#else
+    float32x2_t t = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+    return vget_lane_f32(vpadd_f32(t, t), 0);
+#endif
+}
+
+inline float somaTres4(Registro4 a) { return vgetq_lane_f32(a, 0) + vgetq_lane_f32(a, 1) + vgetq_lane_f32(a, 2); }
+
+#else
+struct Registro4 {
+    float v[4];
+};
+
+constexpr Registro4 monta4(float x, float y, float z, float w) { return Registro4{ { x, y, z, w } }; }
+constexpr Registro4 espalha4(float s) { return Registro4{ { s, s, s, s } }; }
+constexpr Registro4 soma4(Registro4 a, Registro4 b) { return Registro4{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+constexpr Registro4 subtrai4(Registro4 a, Registro4 b) { return Registro4{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+constexpr Registro4 multiplica4(Registro4 a, Registro4 b) { return Registro4{ { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+constexpr Registro4 divide4(Registro4 a, Registro4 b) { return Registro4{ { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } }; }
+constexpr float minimo1(float a, float b) { return b < a ? b : a; }
+constexpr float maximo1(float a, float b) { return a < b ? b : a; }
+constexpr Registro4 minimo4(Registro4 a, Registro4 b) { return Registro4{ { minimo1(a.v[0], b.v[0]), minimo1(a.v[1], b.v[1]), minimo1(a.v[2], b.v[2]), minimo1(a.v[3], b.v[3]) } }; }
+constexpr Registro4 maximo4(Registro4 a, Registro4 b) { return Registro4{ { maximo1(a.v[0], b.v[0]), maximo1(a.v[1], b.v[1]), maximo1(a.v[2], b.v[2]), maximo1(a.v[3], b.v[3]) } }; }
+constexpr Registro4 multiplicaSoma4(Registro4 a, Registro4 b, Registro4 c) { return soma4(multiplica4(a, b), c); }
+
+template <int i0, int i1, int i2, int i3>
+constexpr Registro4 embaralha4(Registro4 a) { return Registro4{ { a.v[i0], a.v[i1], a.v[i2], a.v[i3] } }; }
+
+template <int i0, int i1, int j2, int j3>
+constexpr Registro4 combina4(Registro4 a, Registro4 b) { return Registro4{ { a.v[i0], a.v[i1], b.v[j2], b.v[j3] } }; }
+
+constexpr float somaHorizontal4(Registro4 a) { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+constexpr float somaTres4(Registro4 a) { return a.v[0] + a.v[1] + a.v[2]; }
+#endif
+
+// ---------------------------------------------------------------------------------------------
+// Tipos
+
+struct alignas(16) Vec4 {
+    float x, y, z, w;
+
+    constexpr Vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+    constexpr Vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+// Ocupa 16 bytes como o Vec4 para usar os mesmos registros; o quarto float é só enchimento e pode
+// ter qualquer valor depois das operações (as somas horizontais o ignoram).
+struct alignas(16) Vec3 {
+    float x, y, z;
+    float enchimento;
+
+    constexpr Vec3() : x(0.0f), y(0.0f), z(0.0f), enchimento(0.0f) {}
+    constexpr Vec3(float x, float y, float z) : x(x), y(y), z(z), enchimento(0.0f) {}
+};
+
+// Rotação (x, y, z) = eixo * sin(angulo / 2), w = cos(angulo / 2). O padrão é a identidade.
+struct alignas(16) Quat {
+    float x, y, z, w;
+
+    constexpr Quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+    constexpr Quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+// Matriz 4x4 por coluna: c[j] é a coluna j, c[j].y é o elemento da linha 1 (m[j][1] no GLSL).
+struct alignas(16) Mat4 {
+    Vec4 c[4];
+
+    constexpr Mat4() : c{} {}
+    constexpr Mat4(const Vec4& c0, const Vec4& c1, const Vec4& c2, const Vec4& c3) : c{ c0, c1, c2, c3 } {}
+
+    // 16 floats por coluna, como o glUniformMatrix4fv espera com transpose = GL_FALSE.
+    const float* dados() const { return &c[0].x; }
+};
+
+constexpr Mat4 identidadeMat4()
+{
+    return Mat4(Vec4(1, 0, 0, 0), Vec4(0, 1, 0, 0), Vec4(0, 0, 1, 0), Vec4(0, 0, 0, 1));
+}
+
+#if MATEMATICA_SSE
+inline Registro4 registro(const Vec4& v) { return _mm_load_ps(&v.x); }
+inline Registro4 registro(const Vec3& v) { return _mm_load_ps(&v.x); }
+inline Registro4 registro(const Quat& q) { return _mm_load_ps(&q.x); }
+inline Vec4 comoVec4(Registro4 r) { Vec4 v; _mm_store_ps(&v.x, r); return v; }
+inline Vec3 comoVec3(Registro4 r) { Vec3 v; _mm_store_ps(&v.x, r); return v; }
+inline Quat comoQuat(Registro4 r) { Quat q; _mm_store_ps(&q.x, r); return q; }
+#elif MATEMATICA_NEON
+inline Registro4 registro(const Vec4& v) { return vld1q_f32(&v.x); }
+inline Registro4 registro(const Vec3& v) { return vld1q_f32(&v.x); }
+inline Registro4 registro(const Quat& q) { return vld1q_f32(&q.x); }
+inline Vec4 comoVec4(Registro4 r) { Vec4 v; vst1q_f32(&v.x, r); return v; }
+inline Vec3 comoVec3(Registro4 r) { Vec3 v; vst1q_f32(&v.x, r); return v; }
+inline Quat comoQuat(Registro4 r) { Quat q; vst1q_f32(&q.x, r); return q; }
+#else
+constexpr Registro4 registro(const Vec4& v) { return monta4(v.x, v.y, v.z, v.w); }
+constexpr Registro4 registro(const Vec3& v) { return monta4(v.x, v.y, v.z, v.enchimento); }
+constexpr Registro4 registro(const Quat& q) { return monta4(q.x, q.y, q.z, q.w); }
+constexpr Vec4 comoVec4(Registro4 r) { return Vec4(r.v[0], r.v[1], r.v[2], r.v[3]); }
+constexpr Vec3 comoVec3(Registro4 r) { return Vec3(r.v[0], r.v[1], r.v[2]); }
+constexpr Quat comoQuat(Registro4 r) { return Quat(r.v[0], r.v[1], r.v[2], r.v[3]); }
+#endif
+
+constexpr Vec4 vec4(const Vec3& v, float w) { return Vec4(v.x, v.y, v.z, w); }
+constexpr Vec3 vec3(const Vec4& v) { return Vec3(v.x, v.y, v.z); }
+
+// Nome do caminho escolhido na compilação.
+constexpr const char* nomeMatematicaSIMD()
+{
+    return MATEMATICA_AVX2 ? "AVX2+FMA" : MATEMATICA_FMA ? "SSE+FMA" : MATEMATICA_SSE ? "SSE" : MATEMATICA_NEON ? "NEON" : "escalar";
+}
+
+// ---------------------------------------------------------------------------------------------
+// Vec4 e Vec3
+
+MATEMATICA_CONSTEXPR Vec4 operator+(const Vec4& a, const Vec4& b) { return comoVec4(soma4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec4 operator-(const Vec4& a, const Vec4& b) { return comoVec4(subtrai4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec4 operator*(const Vec4& a, const Vec4& b) { return comoVec4(multiplica4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec4 operator/(const Vec4& a, const Vec4& b) { return comoVec4(divide4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec4 operator*(const Vec4& a, float s) { return comoVec4(multiplica4(registro(a), espalha4(s))); }
+MATEMATICA_CONSTEXPR Vec4 operator*(float s, const Vec4& a) { return a * s; }
+MATEMATICA_CONSTEXPR Vec4 operator/(const Vec4& a, float s) { return a * (1.0f / s); }
+MATEMATICA_CONSTEXPR Vec4 operator-(const Vec4& a) { return comoVec4(subtrai4(espalha4(0.0f), registro(a))); }
+MATEMATICA_CONSTEXPR Vec4 minimo(const Vec4& a, const Vec4& b) { return comoVec4(minimo4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec4 maximo(const Vec4& a, const Vec4& b) { return comoVec4(maximo4(registro(a), registro(b))); }
+// a * b + c
+MATEMATICA_CONSTEXPR Vec4 multiplicaSoma(const Vec4& a, const Vec4& b, const Vec4& c) { return comoVec4(multiplicaSoma4(registro(a), registro(b), registro(c))); }
+MATEMATICA_CONSTEXPR Vec4 mistura(const Vec4& a, const Vec4& b, float t) { return comoVec4(multiplicaSoma4(subtrai4(registro(b), registro(a)), espalha4(t), registro(a))); }
+MATEMATICA_CONSTEXPR float produtoEscalar(const Vec4& a, const Vec4& b) { return somaHorizontal4(multiplica4(registro(a), registro(b))); }
+inline float comprimento(const Vec4& a) { return std::sqrt(produtoEscalar(a, a)); }
+inline Vec4 normaliza(const Vec4& a) { return a * (1.0f / comprimento(a)); }
+
+MATEMATICA_CONSTEXPR Vec3 operator+(const Vec3& a, const Vec3& b) { return comoVec3(soma4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec3 operator-(const Vec3& a, const Vec3& b) { return comoVec3(subtrai4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec3 operator*(const Vec3& a, const Vec3& b) { return comoVec3(multiplica4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec3 operator*(const Vec3& a, float s) { return comoVec3(multiplica4(registro(a), espalha4(s))); }
+MATEMATICA_CONSTEXPR Vec3 operator*(float s, const Vec3& a) { return a * s; }
+MATEMATICA_CONSTEXPR Vec3 operator/(const Vec3& a, float s) { return a * (1.0f / s); }
+MATEMATICA_CONSTEXPR Vec3 operator-(const Vec3& a) { return comoVec3(subtrai4(espalha4(0.0f), registro(a))); }
+MATEMATICA_CONSTEXPR Vec3 minimo(const Vec3& a, const Vec3& b) { return comoVec3(minimo4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec3 maximo(const Vec3& a, const Vec3& b) { return comoVec3(maximo4(registro(a), registro(b))); }
+MATEMATICA_CONSTEXPR Vec3 multiplicaSoma(const Vec3& a, const Vec3& b, const Vec3& c) { return comoVec3(multiplicaSoma4(registro(a), registro(b), registro(c))); }
+MATEMATICA_CONSTEXPR Vec3 mistura(const Vec3& a, const Vec3& b, float t) { return comoVec3(multiplicaSoma4(subtrai4(registro(b), registro(a)), espalha4(t), registro(a))); }
+MATEMATICA_CONSTEXPR float produtoEscalar(const Vec3& a, const Vec3& b) { return somaTres4(multiplica4(registro(a), registro(b))); }
+inline float comprimento(const Vec3& a) { return std::sqrt(produtoEscalar(a, a)); }
+inline Vec3 normaliza(const Vec3& a) { return a * (1.0f / comprimento(a)); }
+
+// a.yzx * b.zxy - a.zxy * b.yzx
+MATEMATICA_CONSTEXPR Vec3 produtoVetorial(const Vec3& a, const Vec3& b)
+{
+    Registro4 ra = registro(a), rb = registro(b);
+    return comoVec3(subtrai4(multiplica4(embaralha4<1, 2, 0, 3>(ra), embaralha4<2, 0, 1, 3>(rb)),
+                             multiplica4(embaralha4<2, 0, 1, 3>(ra), embaralha4<1, 2, 0, 3>(rb))));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Mat4
+
+// Combinação das colunas: m.c[0] * v.x + m.c[1] * v.y + m.c[2] * v.z + m.c[3] * v.w.
+MATEMATICA_CONSTEXPR Registro4 transformaRegistro(const Mat4& m, Registro4 v)
+{
+    Registro4 r = multiplica4(registro(m.c[0]), embaralha4<0, 0, 0, 0>(v));
+    r = multiplicaSoma4(registro(m.c[1]), embaralha4<1, 1, 1, 1>(v), r);
+    r = multiplicaSoma4(registro(m.c[2]), embaralha4<2, 2, 2, 2>(v), r);
+    return multiplicaSoma4(registro(m.c[3]), embaralha4<3, 3, 3, 3>(v), r);
+}
+
+MATEMATICA_CONSTEXPR Vec4 operator*(const Mat4& m, const Vec4& v) { return comoVec4(transformaRegistro(m, registro(v))); }
+
+// Ponto (w = 1) e direção (w = 0).
+MATEMATICA_CONSTEXPR Vec3 transformaPonto(const Mat4& m, const Vec3& p) { return vec3(m * vec4(p, 1.0f)); }
+MATEMATICA_CONSTEXPR Vec3 transformaDirecao(const Mat4& m, const Vec3& d) { return vec3(m * vec4(d, 0.0f)); }
+
+#if MATEMATICA_SSE
+// Duas colunas do produto por vez: "b" tem as colunas j e j + 1 de B; a0 a a3 têm as colunas de A
+// repetidas nas duas metades. O permute espalha B[j][k] na metade de baixo e B[j + 1][k] na de cima.
+ALVO_AVX2 inline __m256 duasColunasProdutoAVX2(__m256 a0, __m256 a1, __m256 a2, __m256 a3, __m256 b)
+{
+    __m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00));
+    r = _mm256_fmadd_ps(a1, _mm256_permute_ps(b, 0x55), r);
+    r = _mm256_fmadd_ps(a2, _mm256_permute_ps(b, 0xAA), r);
+    return _mm256_fmadd_ps(a3, _mm256_permute_ps(b, 0xFF), r);
+}
+
+ALVO_AVX2 inline void multiplicaMat4AVX2(const Mat4& a, const Mat4& b, Mat4& r)
+{
+    __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a.c[0].x));
+    __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a.c[1].x));
+    __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a.c[2].x));
+    __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a.c[3].x));
+    _mm256_storeu_ps(&r.c[0].x, duasColunasProdutoAVX2(a0, a1, a2, a3, _mm256_loadu_ps(&b.c[0].x)));
+    _mm256_storeu_ps(&r.c[2].x, duasColunasProdutoAVX2(a0, a1, a2, a3, _mm256_loadu_ps(&b.c[2].x)));
+}
+#endif
+
+#if MATEMATICA_AVX2
+inline Mat4 operator*(const Mat4& a, const Mat4& b)
+{
+    Mat4 r;
+    multiplicaMat4AVX2(a, b, r);
+    return r;
+}
+#else
+MATEMATICA_CONSTEXPR Mat4 operator*(const Mat4& a, const Mat4& b)
+{
+    return Mat4(a * b.c[0], a * b.c[1], a * b.c[2], a * b.c[3]);
+}
+#endif
+
+MATEMATICA_CONSTEXPR Mat4 transposta(const Mat4& m)
+{
+#if MATEMATICA_SSE
+    __m128 c0 = registro(m.c[0]), c1 = registro(m.c[1]), c2 = registro(m.c[2]), c3 = registro(m.c[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    return Mat4(comoVec4(c0), comoVec4(c1), comoVec4(c2), comoVec4(c3));
+#else
+    return Mat4(Vec4(m.c[0].x, m.c[1].x, m.c[2].x, m.c[3].x), Vec4(m.c[0].y, m.c[1].y, m.c[2].y, m.c[3].y),
+                Vec4(m.c[0].z, m.c[1].z, m.c[2].z, m.c[3].z), Vec4(m.c[0].w, m.c[1].w, m.c[2].w, m.c[3].w));
+#endif
+}
+
+// Inversa pela matriz adjunta (cofatores), como o glm::inverse, com 4 cofatores por operação.
+// Matriz singular resulta em infinitos/NaN.
+MATEMATICA_CONSTEXPR Mat4 inversa(const Mat4& m)
+{
+    Registro4 c0 = registro(m.c[0]), c1 = registro(m.c[1]), c2 = registro(m.c[2]), c3 = registro(m.c[3]);
+
+    // Por linha r: X(r) = (c2[r], c2[r], c1[r], c1[r]) e Y(r) = (c3[r], c3[r], c3[r], c2[r]).
+    Registro4 x0 = combina4<0, 0, 0, 0>(c2, c1), y0 = embaralha4<0, 0, 0, 2>(combina4<0, 0, 0, 0>(c3, c2));
+    Registro4 x1 = combina4<1, 1, 1, 1>(c2, c1), y1 = embaralha4<0, 0, 0, 2>(combina4<1, 1, 1, 1>(c3, c2));
+    Registro4 x2 = combina4<2, 2, 2, 2>(c2, c1), y2 = embaralha4<0, 0, 0, 2>(combina4<2, 2, 2, 2>(c3, c2));
+    Registro4 x3 = combina4<3, 3, 3, 3>(c2, c1), y3 = embaralha4<0, 0, 0, 2>(combina4<3, 3, 3, 3>(c3, c2));
+
+    // Determinantes 2x2 das linhas p e q: X(p) * Y(q) - Y(p) * X(q).
+    Registro4 f23 = subtrai4(multiplica4(x2, y3), multiplica4(y2, x3));
+    Registro4 f13 = subtrai4(multiplica4(x1, y3), multiplica4(y1, x3));
+    Registro4 f12 = subtrai4(multiplica4(x1, y2), multiplica4(y1, x2));
+    Registro4 f03 = subtrai4(multiplica4(x0, y3), multiplica4(y0, x3));
+    Registro4 f02 = subtrai4(multiplica4(x0, y2), multiplica4(y0, x2));
+    Registro4 f01 = subtrai4(multiplica4(x0, y1), multiplica4(y0, x1));
+
+    // V(r) = (c1[r], c0[r], c0[r], c0[r])
+    Registro4 v0 = embaralha4<0, 2, 2, 2>(combina4<0, 0, 0, 0>(c1, c0));
+    Registro4 v1 = embaralha4<0, 2, 2, 2>(combina4<1, 1, 1, 1>(c1, c0));
+    Registro4 v2 = embaralha4<0, 2, 2, 2>(combina4<2, 2, 2, 2>(c1, c0));
+    Registro4 v3 = embaralha4<0, 2, 2, 2>(combina4<3, 3, 3, 3>(c1, c0));
+
+    Registro4 sinalA = monta4(1.0f, -1.0f, 1.0f, -1.0f);
+    Registro4 sinalB = monta4(-1.0f, 1.0f, -1.0f, 1.0f);
+    Registro4 i0 = multiplica4(soma4(subtrai4(multiplica4(v1, f23), multiplica4(v2, f13)), multiplica4(v3, f12)), sinalA);
+    Registro4 i1 = multiplica4(soma4(subtrai4(multiplica4(v0, f23), multiplica4(v2, f03)), multiplica4(v3, f02)), sinalB);
+    Registro4 i2 = multiplica4(soma4(subtrai4(multiplica4(v0, f13), multiplica4(v1, f03)), multiplica4(v3, f01)), sinalA);
+    Registro4 i3 = multiplica4(soma4(subtrai4(multiplica4(v0, f12), multiplica4(v1, f02)), multiplica4(v2, f01)), sinalB);
+
+    // Determinante: primeira coluna da matriz original pela primeira linha da adjunta.
+    Registro4 linha0 = combina4<0, 2, 0, 2>(combina4<0, 0, 0, 0>(i0, i1), combina4<0, 0, 0, 0>(i2, i3));
+    Registro4 inverso = espalha4(1.0f / somaHorizontal4(multiplica4(c0, linha0)));
+
+    return Mat4(comoVec4(multiplica4(i0, inverso)), comoVec4(multiplica4(i1, inverso)),
+                comoVec4(multiplica4(i2, inverso)), comoVec4(multiplica4(i3, inverso)));
+}
+
+// Versões escalares diretas, sempre constexpr: referencia para os testes e benchmarks do SIMD.
+constexpr Vec4 transformaReferencia(const Mat4& m, const Vec4& v)
+{
+    return Vec4(m.c[0].x * v.x + m.c[1].x * v.y + m.c[2].x * v.z + m.c[3].x * v.w,
+                m.c[0].y * v.x + m.c[1].y * v.y + m.c[2].y * v.z + m.c[3].y * v.w,
+                m.c[0].z * v.x + m.c[1].z * v.y + m.c[2].z * v.z + m.c[3].z * v.w,
+                m.c[0].w * v.x + m.c[1].w * v.y + m.c[2].w * v.z + m.c[3].w * v.w);
+}
+
+constexpr Mat4 multiplicaReferencia(const Mat4& a, const Mat4& b)
+{
+    return Mat4(transformaReferencia(a, b.c[0]), transformaReferencia(a, b.c[1]),
+                transformaReferencia(a, b.c[2]), transformaReferencia(a, b.c[3]));
+}
+
+constexpr Mat4 inversaReferencia(const Mat4& m)
+{
+    // Determinantes 2x2 das colunas 2 e 3 (s) e 0 e 1 (t), expansão de Laplace por blocos.
+    float s0 = m.c[0].x * m.c[1].y - m.c[1].x * m.c[0].y;
+    float s1 = m.c[0].x * m.c[1].z - m.c[1].x * m.c[0].z;
+    float s2 = m.c[0].x * m.c[1].w - m.c[1].x * m.c[0].w;
+    float s3 = m.c[0].y * m.c[1].z - m.c[1].y * m.c[0].z;
+    float s4 = m.c[0].y * m.c[1].w - m.c[1].y * m.c[0].w;
+    float s5 = m.c[0].z * m.c[1].w - m.c[1].z * m.c[0].w;
+    float t5 = m.c[2].z * m.c[3].w - m.c[3].z * m.c[2].w;
+    float t4 = m.c[2].y * m.c[3].w - m.c[3].y * m.c[2].w;
+    float t3 = m.c[2].y * m.c[3].z - m.c[3].y * m.c[2].z;
+    float t2 = m.c[2].x * m.c[3].w - m.c[3].x * m.c[2].w;
+    float t1 = m.c[2].x * m.c[3].z - m.c[3].x * m.c[2].z;
+    float t0 = m.c[2].x * m.c[3].y - m.c[3].x * m.c[2].y;
+    float inv = 1.0f / (s0 * t5 - s1 * t4 + s2 * t3 + s3 * t2 - s4 * t1 + s5 * t0);
+
+    return Mat4(Vec4(( m.c[1].y * t5 - m.c[1].z * t4 + m.c[1].w * t3) * inv,
+                     (-m.c[0].y * t5 + m.c[0].z * t4 - m.c[0].w * t3) * inv,
+                     ( m.c[3].y * s5 - m.c[3].z * s4 + m.c[3].w * s3) * inv,
+                     (-m.c[2].y * s5 + m.c[2].z * s4 - m.c[2].w * s3) * inv),
+                Vec4((-m.c[1].x * t5 + m.c[1].z * t2 - m.c[1].w * t1) * inv,
+                     ( m.c[0].x * t5 - m.c[0].z * t2 + m.c[0].w * t1) * inv,
+                     (-m.c[3].x * s5 + m.c[3].z * s2 - m.c[3].w * s1) * inv,
+                     ( m.c[2].x * s5 - m.c[2].z * s2 + m.c[2].w * s1) * inv),
+                Vec4(( m.c[1].x * t4 - m.c[1].y * t2 + m.c[1].w * t0) * inv,
+                     (-m.c[0].x * t4 + m.c[0].y * t2 - m.c[0].w * t0) * inv,
+                     ( m.c[3].x * s4 - m.c[3].y * s2 + m.c[3].w * s0) * inv,
+                     (-m.c[2].x * s4 + m.c[2].y * s2 - m.c[2].w * s0) * inv),
+                Vec4((-m.c[1].x * t3 + m.c[1].y * t1 - m.c[1].z * t0) * inv,
+                     ( m.c[0].x * t3 - m.c[0].y * t1 + m.c[0].z * t0) * inv,
+                     (-m.c[3].x * s3 + m.c[3].y * s1 - m.c[3].z * s0) * inv,
+                     ( m.c[2].x * s3 - m.c[2].y * s1 + m.c[2].z * s0) * inv));
+}
+
+// Transformações no mesmo formato do GLSL/glm.
+constexpr Mat4 translacao(const Vec3& t)
+{
+    return Mat4(Vec4(1, 0, 0, 0), Vec4(0, 1, 0, 0), Vec4(0, 0, 1, 0), Vec4(t.x, t.y, t.z, 1));
+}
+
+constexpr Mat4 escala(const Vec3& s)
+{
+    return Mat4(Vec4(s.x, 0, 0, 0), Vec4(0, s.y, 0, 0), Vec4(0, 0, s.z, 0), Vec4(0, 0, 0, 1));
+}
+
+// Projeção perspectiva do OpenGL (z da câmera entre -perto e -longe vai para -1 a 1 no NDC).
+inline Mat4 perspectiva(float campoVisaoY, float aspecto, float perto, float longe)
+{
+    float f = 1.0f / std::tan(campoVisaoY * 0.5f);
+    return Mat4(Vec4(f / aspecto, 0, 0, 0), Vec4(0, f, 0, 0),
+                Vec4(0, 0, (longe + perto) / (perto - longe), -1.0f),
+                Vec4(0, 0, 2.0f * longe * perto / (perto - longe), 0));
+}
+
+constexpr Mat4 ortografica(float esquerda, float direita, float baixo, float cima, float perto, float longe)
+{
+    return Mat4(Vec4(2.0f / (direita - esquerda), 0, 0, 0), Vec4(0, 2.0f / (cima - baixo), 0, 0),
+                Vec4(0, 0, -2.0f / (longe - perto), 0),
+                Vec4(-(direita + esquerda) / (direita - esquerda), -(cima + baixo) / (cima - baixo), -(longe + perto) / (longe - perto), 1));
+}
+
+// Matriz de visão (glm::lookAt): a câmera em "olho" olhando para "alvo".
+inline Mat4 olharPara(const Vec3& olho, const Vec3& alvo, const Vec3& cima)
+{
+    Vec3 f = normaliza(alvo - olho);
+    Vec3 s = normaliza(produtoVetorial(f, cima));
+    Vec3 u = produtoVetorial(s, f);
+    return Mat4(Vec4(s.x, u.x, -f.x, 0), Vec4(s.y, u.y, -f.y, 0), Vec4(s.z, u.z, -f.z, 0),
+                Vec4(-produtoEscalar(s, olho), -produtoEscalar(u, olho), produtoEscalar(f, olho), 1));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Quat
+
+// "eixo" normalizado.
+inline Quat quatEixoAngulo(const Vec3& eixo, float angulo)
+{
+    float s = std::sin(angulo * 0.5f);
+    return Quat(eixo.x * s, eixo.y * s, eixo.z * s, std::cos(angulo * 0.5f));
+}
+
+// Produto de Hamilton: aplicar "a * b" a um vetor é aplicar b e depois a.
+MATEMATICA_CONSTEXPR Quat operator*(const Quat& a, const Quat& b)
+{
+    Registro4 rb = registro(b);
+    Registro4 r = multiplica4(espalha4(a.w), rb);
+    r = multiplicaSoma4(multiplica4(espalha4(a.x), embaralha4<3, 2, 1, 0>(rb)), monta4(1.0f, -1.0f, 1.0f, -1.0f), r);
+    r = multiplicaSoma4(multiplica4(espalha4(a.y), embaralha4<2, 3, 0, 1>(rb)), monta4(1.0f, 1.0f, -1.0f, -1.0f), r);
+    r = multiplicaSoma4(multiplica4(espalha4(a.z), embaralha4<1, 0, 3, 2>(rb)), monta4(-1.0f, 1.0f, 1.0f, -1.0f), r);
+    return comoQuat(r);
+}
+
+MATEMATICA_CONSTEXPR Quat conjugado(const Quat& q) { return comoQuat(multiplica4(registro(q), monta4(-1.0f, -1.0f, -1.0f, 1.0f))); }
+MATEMATICA_CONSTEXPR float produtoEscalar(const Quat& a, const Quat& b) { return somaHorizontal4(multiplica4(registro(a), registro(b))); }
+inline Quat normaliza(const Quat& q) { return comoQuat(multiplica4(registro(q), espalha4(1.0f / std::sqrt(produtoEscalar(q, q))))); }
+
+// v' = v + w * t + q.xyz x t, com t = 2 * (q.xyz x v) (quaternion normalizado).
+MATEMATICA_CONSTEXPR Vec3 rotaciona(const Quat& q, const Vec3& v)
+{
+    Vec3 u(q.x, q.y, q.z);
+    Vec3 t = produtoVetorial(u, v) * 2.0f;
+    return multiplicaSoma(t, Vec3(q.w, q.w, q.w), v) + produtoVetorial(u, t);
+}
+
+// Interpolação esferica pelo caminho mais curto; perto de 0 graus vira interpolação linear normalizada.
+inline Quat interpolaEsferica(const Quat& a, const Quat& b, float t)
+{
+    float cosseno = produtoEscalar(a, b);
+    Registro4 rb = registro(b);
+    if (cosseno < 0.0f) {
+        cosseno = -cosseno;
+        rb = subtrai4(espalha4(0.0f), rb);
+    }
+
+    float pesoA = 1.0f - t, pesoB = t;
+    if (cosseno < 0.9995f) {
+        float angulo = std::acos(cosseno);
+        float inversoSeno = 1.0f / std::sin(angulo);
+        pesoA = std::sin(pesoA * angulo) * inversoSeno;
+        pesoB = std::sin(pesoB * angulo) * inversoSeno;
+    }
+    Quat r = comoQuat(multiplicaSoma4(registro(a), espalha4(pesoA), multiplica4(rb, espalha4(pesoB))));
+    return cosseno < 0.9995f ? r : normaliza(r);
+}
+
+// Matriz de rotação do quaternion normalizado.
+constexpr Mat4 matrizRotacao(const Quat& q)
+{
+    return Mat4(Vec4(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.w * q.z), 2.0f * (q.x * q.z - q.w * q.y), 0),
+                Vec4(2.0f * (q.x * q.y - q.w * q.z), 1.0f - 2.0f * (q.x * q.x + q.z * q.z), 2.0f * (q.y * q.z + q.w * q.x), 0),
+                Vec4(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y), 0),
+                Vec4(0, 0, 0, 1));
+}
+
+inline Mat4 rotacao(float angulo, const Vec3& eixo) { return matrizRotacao(quatEixoAngulo(normaliza(eixo), angulo)); }
+
+// ---------------------------------------------------------------------------------------------
+// Lotes
+
+#if MATEMATICA_SSE
+// Dois vetores por iteração: as colunas repetidas nas duas metades e cada componente espalhado na sua metade.
+ALVO_AVX2 inline void transformaLoteVec4AVX2(const Mat4& m, const Vec4* entrada, Vec4* saida, size_t quantidade)
+{
+    __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m.c[0].x));
+    __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m.c[1].x));
+    __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m.c[2].x));
+    __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m.c[3].x));
+
+    size_t i = 0;
+    for (; i + 2 <= quantidade; i += 2) {
+        _mm256_storeu_ps(&saida[i].x, duasColunasProdutoAVX2(c0, c1, c2, c3, _mm256_loadu_ps(&entrada[i].x)));
+    }
+    if (i < quantidade) {
+        saida[i] = m * entrada[i];
+    }
+}
+
+ALVO_AVX2 inline void multiplicaLoteMat4AVX2(const Mat4* a, const Mat4* b, Mat4* saida, size_t quantidade)
+{
+    for (size_t i = 0; i < quantidade; i++) {
+        multiplicaMat4AVX2(a[i], b[i], saida[i]);
+    }
+}
+#endif
+
+// saida[i] = m * entrada[i] ("saida" pode ser a propria "entrada").
+inline void transformaLoteVec4(const Mat4& m, const Vec4* entrada, Vec4* saida, size_t quantidade)
+{
+#if MATEMATICA_SSE
+    if (MATEMATICA_AVX2 || (recursosCPU().avx2 && recursosCPU().fma)) {
+        transformaLoteVec4AVX2(m, entrada, saida, quantidade);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < quantidade; i++) {
+        saida[i] = m * entrada[i];
+    }
+}
+
+// saida[i] = a[i] * b[i]
+inline void multiplicaLoteMat4(const Mat4* a, const Mat4* b, Mat4* saida, size_t quantidade)
+{
+#if MATEMATICA_SSE
+    if (MATEMATICA_AVX2 || (recursosCPU().avx2 && recursosCPU().fma)) {
+        multiplicaLoteMat4AVX2(a, b, saida, quantidade);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < quantidade; i++) {
+        saida[i] = a[i] * b[i];
+    }
+}
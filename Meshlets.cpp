@@ -0,0 +1,287 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+static Vec3 posicaoVertice(const MalhaIndexada& malha, unsigned int v)
+{
+    const float* p = &malha.vertices[(size_t)v * malha.componentes];
+    return Vec3(p[0], p[1], p[2]);
+}
+
+// Esfera (centro da caixa e maior distancia até ele) e cone das normais dos triângulos de um meshlet.
+static void calculaLimites(const MalhaIndexada& malha, const unsigned int* indices, size_t numTriangulos,
+                           Vec3& centro, float& raio, Vec3& eixo, float& corte)
+{
+    Vec3 minimoCaixa(INFINITY, INFINITY, INFINITY), maximoCaixa(-INFINITY, -INFINITY, -INFINITY);
+    for (size_t i = 0; i < numTriangulos * 3; i++) {
+        Vec3 p = posicaoVertice(malha, indices[i]);
+        minimoCaixa = minimo(minimoCaixa, p);
+        maximoCaixa = maximo(maximoCaixa, p);
+    }
+    centro = (minimoCaixa + maximoCaixa) * 0.5f;
+    raio = 0.0f;
+    for (size_t i = 0; i < numTriangulos * 3; i++) {
+        raio = std::max(raio, comprimento(posicaoVertice(malha, indices[i]) - centro));
+    }
+
+    // Eixo: média das normais unitarias; o corte vem da normal mais afastada dele.
+    Vec3 normais[maxTriangulosMeshlet];
+    Vec3 soma(0.0f, 0.0f, 0.0f);
+    size_t numNormais = 0;
+    for (size_t t = 0; t < numTriangulos && numNormais < maxTriangulosMeshlet; t++) {
+        Vec3 p0 = posicaoVertice(malha, indices[t * 3]);
+        Vec3 n = produtoVetorial(posicaoVertice(malha, indices[t * 3 + 1]) - p0, posicaoVertice(malha, indices[t * 3 + 2]) - p0);
+        float area = comprimento(n);
+        if (area > 0.0f) {
+            normais[numNormais] = n / area;
+            soma = soma + normais[numNormais];
+            numNormais++;
+        }
+    }
+    float tamanho = comprimento(soma);
+    eixo = tamanho > 1e-6f ? soma / tamanho : Vec3(0.0f, 0.0f, 1.0f);
+    float menorCosseno = tamanho > 1e-6f ? 1.0f : -1.0f;
+    for (size_t t = 0; t < numNormais; t++) {
+        menorCosseno = std::min(menorCosseno, produtoEscalar(normais[t], eixo));
+    }
+    // Com 90 graus ou mais entre o eixo e alguma normal sempre há um triângulo de frente.
+    corte = menorCosseno <= 0.0f ? 1.0f : std::sqrt(1.0f - menorCosseno * menorCosseno);
+}
+
+void constroiMeshlets(const MalhaIndexada& original, MalhaMeshlets& resultado,
+                      unsigned int maxVertices, unsigned int maxTriangulos, float pesoCone)
+{
+    maxVertices = std::max(3u, maxVertices);
+    maxTriangulos = std::max(1u, std::min(maxTriangulos, maxTriangulosMeshlet));
+    size_t numVertices = original.vertices.size() / original.componentes;
+    size_t numIndices = original.indices.size() - original.indices.size() % 3;
+    size_t numTriangulos = numIndices / 3;
+    const unsigned int* indices = original.indices.data();
+
+    // Lista de adjacência vertice -> triângulos (formato compacto: inicio + contagem).
+    std::vector<unsigned int> triangulosLivres(numVertices, 0);
+    for (size_t i = 0; i < numIndices; i++) {
+        triangulosLivres[indices[i]]++;
+    }
+    std::vector<unsigned int> inicioAdjacencia(numVertices + 1, 0);
+    for (size_t v = 0; v < numVertices; v++) {
+        inicioAdjacencia[v + 1] = inicioAdjacencia[v] + triangulosLivres[v];
+    }
+    std::vector<unsigned int> adjacencia(numIndices);
+    std::vector<unsigned int> preenchidos(numVertices, 0);
+    for (size_t t = 0; t < numTriangulos; t++) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            adjacencia[inicioAdjacencia[v] + preenchidos[v]] = (unsigned int)t;
+            preenchidos[v]++;
+        }
+    }
+
+    // Normal unitaria e centro de cada triângulo, e o raio aproximado de um meshlet cheio (um disco com
+    // "maxTriangulos" triângulos do tamanho médio), que normaliza a distancia na pontuação.
+    std::vector<Vec3> normais(numTriangulos), centros(numTriangulos);
+    double somaArestas = 0.0;
+    for (size_t t = 0; t < numTriangulos; t++) {
+        Vec3 p0 = posicaoVertice(original, indices[t * 3]);
+        Vec3 p1 = posicaoVertice(original, indices[t * 3 + 1]);
+        Vec3 p2 = posicaoVertice(original, indices[t * 3 + 2]);
+        Vec3 n = produtoVetorial(p1 - p0, p2 - p0);
+        float area = comprimento(n);
+        normais[t] = area > 0.0f ? n / area : Vec3(0.0f, 0.0f, 0.0f);
+        centros[t] = (p0 + p1 + p2) * (1.0f / 3.0f);
+        somaArestas += comprimento(p1 - p0) + comprimento(p2 - p1) + comprimento(p0 - p2);
+    }
+    float arestaMedia = numTriangulos > 0 ? (float)(somaArestas / (numTriangulos * 3)) : 1.0f;
+    float raioEsperado = std::max(arestaMedia * 0.4f * std::sqrt((float)maxTriangulos), 1e-20f);
+
+    resultado.malha.componentes = original.componentes;
+    resultado.malha.vertices = original.vertices;
+    resultado.malha.indices.clear();
+    resultado.malha.indices.reserve(numIndices);
+    resultado.meshlets.clear();
+
+    std::vector<char> usado(numTriangulos, 0);
+    std::vector<uint32_t> meshletDoVertice(numVertices, UINT32_MAX);
+    std::vector<unsigned int> localDoVertice(numVertices);
+    std::vector<unsigned int> verticesMeshlet, triangulosMeshlet;
+    std::vector<unsigned int> indicesLocais;
+    verticesMeshlet.reserve(maxVertices);
+    triangulosMeshlet.reserve(maxTriangulos);
+    size_t emitidos = 0, cursor = 0;
+
+    while (emitidos < numTriangulos) {
+        // Semente: o triângulo livre vizinho do meshlet anterior com menos vizinhos livres (os cantos que
+        // ficariam isolados), ou o proximo livre na ordem original.
+        unsigned int semente = UINT_MAX, menorLivres = UINT_MAX;
+        for (unsigned int v : verticesMeshlet) {
+            for (unsigned int a = inicioAdjacencia[v]; a < inicioAdjacencia[v + 1]; a++) {
+                unsigned int t = adjacencia[a];
+                if (usado[t]) {
+                    continue;
+                }
+                unsigned int livres = triangulosLivres[indices[t * 3]] + triangulosLivres[indices[t * 3 + 1]]
+                                    + triangulosLivres[indices[t * 3 + 2]];
+                if (livres < menorLivres) {
+                    menorLivres = livres;
+                    semente = t;
+                }
+            }
+        }
+        if (semente == UINT_MAX) {
+            while (usado[cursor]) {
+                cursor++;
+            }
+            semente = (unsigned int)cursor;
+        }
+
+        uint32_t id = (uint32_t)resultado.meshlets.size();
+        verticesMeshlet.clear();
+        triangulosMeshlet.clear();
+        Vec3 somaNormais(0.0f, 0.0f, 0.0f), somaCentros(0.0f, 0.0f, 0.0f);
+        auto adiciona = [&](unsigned int t) {
+            usado[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                triangulosLivres[v]--;
+                if (meshletDoVertice[v] != id) {
+                    meshletDoVertice[v] = id;
+                    localDoVertice[v] = (unsigned int)verticesMeshlet.size();
+                    verticesMeshlet.push_back(v);
+                }
+            }
+            triangulosMeshlet.push_back(t);
+            somaNormais = somaNormais + normais[t];
+            somaCentros = somaCentros + centros[t];
+        };
+        adiciona(semente);
+
+        // Cresce pelo vizinho com menor pontuação: vertices novos + afastamento da normal média + distancia
+        // ao centro, com um desconto para triângulos que são dos ultimos livres em algum vertice (sem ele
+        // sobram pedaços soltos que viram meshlets de poucos triângulos). Um triângulo que não cabe nos
+        // vertices restantes é ignorado.
+        while (triangulosMeshlet.size() < maxTriangulos) {
+            float tamanho = comprimento(somaNormais);
+            Vec3 eixo = tamanho > 0.0f ? somaNormais / tamanho : Vec3(0.0f, 0.0f, 0.0f);
+            Vec3 centro = somaCentros / (float)triangulosMeshlet.size();
+            unsigned int melhor = UINT_MAX;
+            float melhorPontuacao = INFINITY;
+            for (size_t i = 0; i < verticesMeshlet.size(); i++) {
+                unsigned int v = verticesMeshlet[i];
+                for (unsigned int a = inicioAdjacencia[v]; a < inicioAdjacencia[v + 1]; a++) {
+                    unsigned int t = adjacencia[a];
+                    if (usado[t]) {
+                        continue;
+                    }
+                    unsigned int novos = (meshletDoVertice[indices[t * 3]] != id) + (meshletDoVertice[indices[t * 3 + 1]] != id)
+                                       + (meshletDoVertice[indices[t * 3 + 2]] != id);
+                    if (verticesMeshlet.size() + novos > maxVertices) {
+                        continue;
+                    }
+                    unsigned int livres = std::min(std::min(triangulosLivres[indices[t * 3]], triangulosLivres[indices[t * 3 + 1]]),
+                                                   triangulosLivres[indices[t * 3 + 2]]);
+                    float pontuacao = novos + pesoCone * (1.0f - produtoEscalar(normais[t], eixo))
+                                    + comprimento(centros[t] - centro) / raioEsperado - (livres <= 2 ? 0.5f : 0.0f);
+                    if (pontuacao < melhorPontuacao) {
+                        melhorPontuacao = pontuacao;
+                        melhor = t;
+                    }
+                }
+            }
+            if (melhor == UINT_MAX) {
+                break;
+            }
+            adiciona(melhor);
+        }
+
+        // Indices locais (0 a numVertices - 1) para a otimização de cache ficar no tamanho do meshlet.
+        indicesLocais.clear();
+        for (unsigned int t : triangulosMeshlet) {
+            for (int k = 0; k < 3; k++) {
+                indicesLocais.push_back(localDoVertice[indices[t * 3 + k]]);
+            }
+        }
+        otimizaCacheVertices(indicesLocais.data(), indicesLocais.size(), verticesMeshlet.size());
+
+        Meshlet meshlet;
+        meshlet.primeiroIndice = (unsigned int)resultado.malha.indices.size();
+        meshlet.numTriangulos = (unsigned int)triangulosMeshlet.size();
+        meshlet.numVertices = (unsigned int)verticesMeshlet.size();
+        for (unsigned int local : indicesLocais) {
+            resultado.malha.indices.push_back(verticesMeshlet[local]);
+        }
+        resultado.meshlets.push_back(meshlet);
+        emitidos += triangulosMeshlet.size();
+    }
+
+    // Vertices na ordem do primeiro uso: os de cada meshlet ficam quase todos juntos no VBO.
+    numVertices = otimizaBuscaVertices(resultado.malha.vertices.data(), resultado.malha.componentes, numVertices,
+                                       resultado.malha.indices.data(), resultado.malha.indices.size());
+    resultado.malha.vertices.resize(numVertices * resultado.malha.componentes);
+
+    size_t numMeshlets = resultado.meshlets.size();
+    redimensionaVolumes(resultado.esferas, numMeshlets);
+    resultado.eixoX.resize(numMeshlets);
+    resultado.eixoY.resize(numMeshlets);
+    resultado.eixoZ.resize(numMeshlets);
+    resultado.corteCone.resize(numMeshlets);
+    for (size_t m = 0; m < numMeshlets; m++) {
+        const Meshlet& meshlet = resultado.meshlets[m];
+        Vec3 centro, eixo;
+        float raio, corte;
+        calculaLimites(resultado.malha, resultado.malha.indices.data() + meshlet.primeiroIndice, meshlet.numTriangulos,
+                       centro, raio, eixo, corte);
+        defineEsfera(resultado.esferas, m, centro, raio);
+        resultado.eixoX[m] = eixo.x;
+        resultado.eixoY[m] = eixo.y;
+        resultado.eixoZ[m] = eixo.z;
+        resultado.corteCone[m] = corte;
+    }
+}
+
+// Todos os triângulos estão de costas quando o angulo entre o eixo e a direção camera -> ponto fica abaixo de
+// 90 graus menos a abertura do cone para qualquer ponto da esfera: produtoEscalar(d, eixo) >= corte * |d| +
+// raio * (1 + corte), com d = centro - camera. A comparação estrita faz o corte 1.0 nunca descartar.
+bool meshletDeCostas(const MalhaMeshlets& malha, size_t meshlet, const Vec3& camera)
+{
+    const VolumesEnvolventes& esferas = malha.esferas;
+    Vec3 d(esferas.centroX[meshlet] - camera.x, esferas.centroY[meshlet] - camera.y, esferas.centroZ[meshlet] - camera.z);
+    Vec3 eixo(malha.eixoX[meshlet], malha.eixoY[meshlet], malha.eixoZ[meshlet]);
+    float corte = malha.corteCone[meshlet];
+    return produtoEscalar(d, eixo) > corte * comprimento(d) + esferas.raio[meshlet] * (1.0f + corte);
+}
+
+size_t descartaMeshlets(const MalhaMeshlets& malha, const Frustum& frustum, const Vec3& camera, uint32_t* visiveis)
+{
+    // O frustum é o teste AVX2 das esferas; o cone só roda nos que passaram.
+    size_t numDentro = descartaFrustum(frustum, malha.esferas, volumeEsfera, 0, malha.esferas.quantidade, visiveis);
+    size_t numVisiveis = 0;
+    for (size_t i = 0; i < numDentro; i++) {
+        uint32_t m = visiveis[i];
+        visiveis[numVisiveis] = m;
+        numVisiveis += meshletDeCostas(malha, m, camera) ? 0 : 1;
+    }
+    return numVisiveis;
+}
+
+size_t intervalosMeshlets(const MalhaMeshlets& malha, const uint32_t* visiveis, size_t quantidade,
+                          int* primeiros, int* contagens)
+{
+    size_t numIntervalos = 0;
+    unsigned int fim = UINT_MAX;
+    for (size_t i = 0; i < quantidade; i++) {
+        const Meshlet& meshlet = malha.meshlets[visiveis[i]];
+        unsigned int numIndices = meshlet.numTriangulos * 3;
+        if (meshlet.primeiroIndice == fim) {
+            contagens[numIntervalos - 1] += (int)numIndices;
+        }
+        else {
+            primeiros[numIntervalos] = (int)meshlet.primeiroIndice;
+            contagens[numIntervalos] = (int)numIndices;
+            numIntervalos++;
+        }
+        fim = meshlet.primeiroIndice + numIndices;
+    }
+    return numIntervalos;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Meshlets: a malha é dividida offline em grupos pequenos de triângulos vizinhos (até 64 vertices e 124
+// triângulos), cada um com uma esfera envolvente e um cone com as normais dos seus triângulos. A cada
+// quadro a CPU descarta os meshlets fora do frustum e os que estão inteiramente de costas para a camera,
+// e só os indices dos que sobraram vão para o glDrawElements. Os indices de cada meshlet ficam juntos no
+// EBO, então a lista de desenho é uma lista de intervalos (meshlets visiveis vizinhos viram um só).
+
+#include "OtimizacaoMalha.h"
+#include "DescarteFrustum.h"
+#include "Matematica.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const unsigned int maxVerticesMeshlet = 64;
+const unsigned int maxTriangulosMeshlet = 124;
+
+struct Meshlet {
+    unsigned int primeiroIndice = 0;    // Nos indices da malha (3 por triângulo).
+    unsigned int numTriangulos = 0;
+    unsigned int numVertices = 0;       // Vertices diferentes usados pelos triângulos.
+};
+
+struct MalhaMeshlets {
+    MalhaIndexada malha;                // Os indices de cada meshlet juntos, na ordem dos meshlets.
+    std::vector<Meshlet> meshlets;
+    VolumesEnvolventes esferas;         // Uma esfera por meshlet, no espaço da malha.
+
+    // Cone das normais de cada meshlet: eixo unitario e corte = seno do maior angulo entre o eixo e a
+    // normal de um triângulo. Corte 1.0 quando as normais se espalham demais (o cone nunca descarta).
+    std::vector<float> eixoX, eixoY, eixoZ;
+    std::vector<float> corteCone;
+};
+
+// Agrupa os triângulos da malha (posição nos 3 primeiros componentes) em meshlets, crescendo cada um a
+// partir de um triângulo pelos triângulos vizinhos que acrescentam menos vertices. "pesoCone" dá
+// preferencia a triângulos com normal parecida com a do meshlet: 0 gera meshlets mais compactos (melhores
+// para o frustum), valores maiores geram cones mais estreitos (mais meshlets de costas descartados).
+// Os indices de cada meshlet são otimizados para o cache de vertices e os vertices para a ordem de uso.
+void constroiMeshlets(const MalhaIndexada& original, MalhaMeshlets& resultado,
+                      unsigned int maxVertices = maxVerticesMeshlet, unsigned int maxTriangulos = maxTriangulosMeshlet,
+                      float pesoCone = 0.5f);
+
+// Verdadeiro quando todos os triângulos do meshlet estão de costas para a camera (posição no espaço da
+// malha). Teste conservador: usa a esfera inteira no lugar dos vertices.
+bool meshletDeCostas(const MalhaMeshlets& malha, size_t meshlet, const Vec3& camera);
+
+// Escreve em "visiveis", em ordem crescente, os meshlets dentro do frustum e não inteiramente de costas, e
+// retorna quantos são. O frustum e a camera são os do espaço da malha (extraiFrustum da matriz projeção *
+// visão * modelo e a camera multiplicada pela inversa do modelo). "visiveis" precisa de espaço para todos.
+size_t descartaMeshlets(const MalhaMeshlets& malha, const Frustum& frustum, const Vec3& camera, uint32_t* visiveis);
+
+// Junta os meshlets visiveis (em ordem crescente) em intervalos de indices continuos: "primeiros" e
+// "contagens" recebem o primeiro indice e o numero de indices de cada intervalo (no maximo um por
+// meshlet), prontos para glDrawElements/glMultiDrawElements. Retorna o numero de intervalos.
+size_t intervalosMeshlets(const MalhaMeshlets& malha, const uint32_t* visiveis, size_t quantidade,
+                          int* primeiros, int* contagens);
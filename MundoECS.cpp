@@ -0,0 +1,306 @@
+#include "MundoECS.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const uint32_t alinhamentoArrayECS = 64;
+static const uint32_t semComponente = UINT32_MAX;
+
+static uint32_t alinha(uint32_t valor, uint32_t alinhamento)
+{
+    return (valor + alinhamento - 1) / alinhamento * alinhamento;
+}
+
+// Calcula os deslocamentos para "capacidade" entidades e retorna o fim do ultimo array.
+static uint32_t calculaLayout(const MundoECS& mundo, AssinaturaECS assinatura, uint32_t capacidade, uint32_t* deslocamentos)
+{
+    uint32_t fim = (uint32_t)sizeof(Entidade) * capacidade;
+    for (uint32_t tipo = 0; tipo < maxComponentesECS; tipo++) {
+        if (!(assinatura & bitComponente(tipo))) {
+            deslocamentos[tipo] = semComponente;
+            continue;
+        }
+        uint32_t alinhamento = std::max(mundo.alinhamentos[tipo], alinhamentoArrayECS);
+        deslocamentos[tipo] = alinha(fim, alinhamento);
+        fim = deslocamentos[tipo] + mundo.tamanhos[tipo] * capacidade;
+    }
+    return fim;
+}
+
+static uint32_t buscaArquetipo(MundoECS& mundo, AssinaturaECS assinatura)
+{
+    auto encontrado = mundo.arquetipoDaAssinatura.find(assinatura);
+    if (encontrado != mundo.arquetipoDaAssinatura.end()) {
+        return encontrado->second;
+    }
+
+    std::unique_ptr<ArquetipoECS> arquetipo(new ArquetipoECS());
+    arquetipo->assinatura = assinatura;
+
+    // Maior capacidade que cabe no chunk: parte da conta sem alinhamento e desce até o layout caber.
+    uint32_t bytesPorEntidade = (uint32_t)sizeof(Entidade);
+    for (uint32_t tipo = 0; tipo < maxComponentesECS; tipo++) {
+        if (assinatura & bitComponente(tipo)) {
+            bytesPorEntidade += mundo.tamanhos[tipo];
+        }
+    }
+    uint32_t capacidade = (uint32_t)tamanhoChunkECS / bytesPorEntidade;
+    while (capacidade > 1 && calculaLayout(mundo, assinatura, capacidade, arquetipo->deslocamentos) > tamanhoChunkECS) {
+        capacidade--;
+    }
+    if (calculaLayout(mundo, assinatura, capacidade, arquetipo->deslocamentos) > tamanhoChunkECS) {
+        std::cout << "ERRO::ECS::ARQUETIPO_MAIOR_QUE_O_CHUNK" << std::endl;
+    }
+    arquetipo->capacidade = capacidade;
+
+    uint32_t indice = (uint32_t)mundo.arquetipos.size();
+    mundo.arquetipos.push_back(std::move(arquetipo));
+    mundo.arquetipoDaAssinatura[assinatura] = indice;
+    return indice;
+}
+
+// Reserva a proxima linha livre do arquetipo (zerada) e retorna o chunk e a linha.
+static void reservaLinha(ArquetipoECS& arquetipo, uint32_t& chunk, uint32_t& linha)
+{
+    if (arquetipo.chunks.empty() || arquetipo.chunks.back().quantidade == arquetipo.capacidade) {
+        ChunkECS novo;
+        novo.memoria.reset(new uint8_t[tamanhoChunkECS + alinhamentoArrayECS]);
+        uintptr_t endereco = (uintptr_t)novo.memoria.get();
+        novo.dados = novo.memoria.get() + (alinhamentoArrayECS - endereco % alinhamentoArrayECS) % alinhamentoArrayECS;
+        arquetipo.chunks.push_back(std::move(novo));
+    }
+    chunk = (uint32_t)arquetipo.chunks.size() - 1;
+    ChunkECS& destino = arquetipo.chunks.back();
+    linha = destino.quantidade++;
+    arquetipo.quantidade++;
+}
+
+static void zeraLinha(const MundoECS& mundo, ArquetipoECS& arquetipo, uint32_t chunk, uint32_t linha)
+{
+    uint8_t* dados = arquetipo.chunks[chunk].dados;
+    for (uint32_t tipo = 0; tipo < maxComponentesECS; tipo++) {
+        if (arquetipo.deslocamentos[tipo] != semComponente) {
+            std::memset(dados + arquetipo.deslocamentos[tipo] + (size_t)mundo.tamanhos[tipo] * linha, 0, mundo.tamanhos[tipo]);
+        }
+    }
+}
+
+// Tira a linha do arquetipo trazendo a ultima entidade para o lugar dela.
+static void removeLinha(MundoECS& mundo, ArquetipoECS& arquetipo, uint32_t chunk, uint32_t linha)
+{
+    ChunkECS& ultimoChunk = arquetipo.chunks.back();
+    uint32_t ultimaLinha = ultimoChunk.quantidade - 1;
+    uint32_t indiceUltimoChunk = (uint32_t)arquetipo.chunks.size() - 1;
+
+    if (chunk != indiceUltimoChunk || linha != ultimaLinha) {
+        uint8_t* destino = arquetipo.chunks[chunk].dados;
+        const uint8_t* origem = ultimoChunk.dados;
+        Entidade movida = ((const Entidade*)origem)[ultimaLinha];
+        ((Entidade*)destino)[linha] = movida;
+        for (uint32_t tipo = 0; tipo < maxComponentesECS; tipo++) {
+            uint32_t deslocamento = arquetipo.deslocamentos[tipo];
+            if (deslocamento != semComponente) {
+                uint32_t tamanho = mundo.tamanhos[tipo];
+                std::memcpy(destino + deslocamento + (size_t)tamanho * linha,
+                            origem + deslocamento + (size_t)tamanho * ultimaLinha, tamanho);
+            }
+        }
+        mundo.locais[movida.indice].chunk = chunk;
+        mundo.locais[movida.indice].linha = linha;
+    }
+
+    ultimoChunk.quantidade--;
+    arquetipo.quantidade--;
+    if (ultimoChunk.quantidade == 0) {
+        arquetipo.chunks.pop_back();
+    }
+}
+
+uint32_t registraComponente(MundoECS& mundo, size_t tamanho, size_t alinhamento)
+{
+    if (mundo.tamanhos.size() >= maxComponentesECS) {
+        std::cout << "ERRO::ECS::LIMITE_DE_COMPONENTES" << std::endl;
+        return maxComponentesECS - 1;
+    }
+    mundo.tamanhos.push_back((uint32_t)tamanho);
+    mundo.alinhamentos.push_back((uint32_t)std::max<size_t>(alinhamento, 1));
+    return (uint32_t)mundo.tamanhos.size() - 1;
+}
+
+void criaEntidades(MundoECS& mundo, AssinaturaECS assinatura, size_t quantidade, Entidade* entidades)
+{
+    uint32_t indiceArquetipo = buscaArquetipo(mundo, assinatura);
+    ArquetipoECS& arquetipo = *mundo.arquetipos[indiceArquetipo];
+
+    for (size_t i = 0; i < quantidade; i++) {
+        uint32_t indice;
+        if (!mundo.indicesLivres.empty()) {
+            indice = mundo.indicesLivres.back();
+            mundo.indicesLivres.pop_back();
+        }
+        else {
+            indice = (uint32_t)mundo.locais.size();
+            mundo.locais.push_back(LocalEntidadeECS());
+        }
+
+        LocalEntidadeECS& local = mundo.locais[indice];
+        local.arquetipo = indiceArquetipo;
+        reservaLinha(arquetipo, local.chunk, local.linha);
+        zeraLinha(mundo, arquetipo, local.chunk, local.linha);
+
+        Entidade entidade;
+        entidade.indice = indice;
+        entidade.geracao = local.geracao;
+        ((Entidade*)arquetipo.chunks[local.chunk].dados)[local.linha] = entidade;
+        if (entidades) {
+            entidades[i] = entidade;
+        }
+    }
+    mundo.numEntidades += quantidade;
+}
+
+Entidade criaEntidade(MundoECS& mundo, AssinaturaECS assinatura)
+{
+    Entidade entidade;
+    criaEntidades(mundo, assinatura, 1, &entidade);
+    return entidade;
+}
+
+bool entidadeValida(const MundoECS& mundo, Entidade entidade)
+{
+    return entidade.indice < mundo.locais.size() && mundo.locais[entidade.indice].arquetipo != UINT32_MAX &&
+           mundo.locais[entidade.indice].geracao == entidade.geracao;
+}
+
+void destroiEntidade(MundoECS& mundo, Entidade entidade)
+{
+    if (!entidadeValida(mundo, entidade)) {
+        return;
+    }
+    LocalEntidadeECS& local = mundo.locais[entidade.indice];
+    removeLinha(mundo, *mundo.arquetipos[local.arquetipo], local.chunk, local.linha);
+    local.arquetipo = UINT32_MAX;
+    local.geracao++;
+    mundo.indicesLivres.push_back(entidade.indice);
+    mundo.numEntidades--;
+}
+
+void* componente(MundoECS& mundo, Entidade entidade, uint32_t tipo)
+{
+    if (!entidadeValida(mundo, entidade) || tipo >= maxComponentesECS) {
+        return nullptr;
+    }
+    const LocalEntidadeECS& local = mundo.locais[entidade.indice];
+    ArquetipoECS& arquetipo = *mundo.arquetipos[local.arquetipo];
+    if (arquetipo.deslocamentos[tipo] == semComponente) {
+        return nullptr;
+    }
+    return arquetipo.chunks[local.chunk].dados + arquetipo.deslocamentos[tipo] + (size_t)mundo.tamanhos[tipo] * local.linha;
+}
+
+// Leva a entidade para o arquetipo da nova assinatura copiando os componentes que os dois têm.
+static void mudaArquetipo(MundoECS& mundo, Entidade entidade, AssinaturaECS assinatura)
+{
+    LocalEntidadeECS& local = mundo.locais[entidade.indice];
+    uint32_t indiceDestino = buscaArquetipo(mundo, assinatura);
+    ArquetipoECS& origem = *mundo.arquetipos[local.arquetipo];
+    ArquetipoECS& destino = *mundo.arquetipos[indiceDestino];
+
+    uint32_t chunk, linha;
+    reservaLinha(destino, chunk, linha);
+    zeraLinha(mundo, destino, chunk, linha);
+    uint8_t* dadosDestino = destino.chunks[chunk].dados;
+    const uint8_t* dadosOrigem = origem.chunks[local.chunk].dados;
+    ((Entidade*)dadosDestino)[linha] = entidade;
+    for (uint32_t tipo = 0; tipo < maxComponentesECS; tipo++) {
+        if (origem.deslocamentos[tipo] != semComponente && destino.deslocamentos[tipo] != semComponente) {
+            uint32_t tamanho = mundo.tamanhos[tipo];
+            std::memcpy(dadosDestino + destino.deslocamentos[tipo] + (size_t)tamanho * linha,
+                        dadosOrigem + origem.deslocamentos[tipo] + (size_t)tamanho * local.linha, tamanho);
+        }
+    }
+
+    removeLinha(mundo, origem, local.chunk, local.linha);
+    local.arquetipo = indiceDestino;
+    local.chunk = chunk;
+    local.linha = linha;
+}
+
+void adicionaComponente(MundoECS& mundo, Entidade entidade, uint32_t tipo)
+{
+    if (!entidadeValida(mundo, entidade) || tipo >= mundo.tamanhos.size()) {
+        return;
+    }
+    AssinaturaECS assinatura = mundo.arquetipos[mundo.locais[entidade.indice].arquetipo]->assinatura;
+    if (!(assinatura & bitComponente(tipo))) {
+        mudaArquetipo(mundo, entidade, assinatura | bitComponente(tipo));
+    }
+}
+
+void removeComponente(MundoECS& mundo, Entidade entidade, uint32_t tipo)
+{
+    if (!entidadeValida(mundo, entidade) || tipo >= mundo.tamanhos.size()) {
+        return;
+    }
+    AssinaturaECS assinatura = mundo.arquetipos[mundo.locais[entidade.indice].arquetipo]->assinatura;
+    if (assinatura & bitComponente(tipo)) {
+        mudaArquetipo(mundo, entidade, assinatura & ~bitComponente(tipo));
+    }
+}
+
+void consultaChunks(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui, std::vector<VistaChunk>& chunks)
+{
+    chunks.clear();
+    for (const std::unique_ptr<ArquetipoECS>& arquetipo : mundo.arquetipos) {
+        if ((arquetipo->assinatura & inclui) != inclui || (arquetipo->assinatura & exclui) != 0) {
+            continue;
+        }
+        for (const ChunkECS& chunk : arquetipo->chunks) {
+            VistaChunk vista;
+            vista.dados = chunk.dados;
+            vista.deslocamentos = arquetipo->deslocamentos;
+            vista.quantidade = chunk.quantidade;
+            chunks.push_back(vista);
+        }
+    }
+}
+
+void paraCadaChunk(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui,
+                   const std::function<void(const VistaChunk&)>& funcao)
+{
+    for (const std::unique_ptr<ArquetipoECS>& arquetipo : mundo.arquetipos) {
+        if ((arquetipo->assinatura & inclui) != inclui || (arquetipo->assinatura & exclui) != 0) {
+            continue;
+        }
+        for (const ChunkECS& chunk : arquetipo->chunks) {
+            VistaChunk vista;
+            vista.dados = chunk.dados;
+            vista.deslocamentos = arquetipo->deslocamentos;
+            vista.quantidade = chunk.quantidade;
+            funcao(vista);
+        }
+    }
+}
+
+void paraCadaChunkParalelo(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui, PoolThreads& pool,
+                           const std::function<void(const VistaChunk&, unsigned int)>& funcao)
+{
+    std::vector<VistaChunk> chunks;
+    consultaChunks(mundo, inclui, exclui, chunks);
+    pool.paraCada((unsigned int)chunks.size(), [&](unsigned int tarefa, unsigned int thread) {
+        funcao(chunks[tarefa], thread);
+    });
+}
+
+void paraCadaChunkParalelo(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui, SistemaTarefas& sistema,
+                           const std::function<void(const VistaChunk&, unsigned int)>& funcao)
+{
+    std::vector<VistaChunk> chunks;
+    consultaChunks(mundo, inclui, exclui, chunks);
+    sistema.paraCada(chunks.size(), 1, [&](size_t inicio, size_t fim, unsigned int thread) {
+        for (size_t i = inicio; i < fim; i++) {
+            funcao(chunks[i], thread);
+        }
+    });
+}
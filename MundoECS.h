@@ -0,0 +1,117 @@
+#pragma once
+
+// Entidades e componentes (ECS) com armazenamento por arquetipo: entidades com o mesmo conjunto de
+// componentes ficam nos mesmos chunks de 16 KB e, dentro do chunk, cada componente é um array continuo
+// (estrutura de arrays). Uma consulta percorre os chunks dos arquetipos que têm os componentes pedidos e
+// entrega os arrays inteiros, sem nenhuma indireção por entidade.
+// Componentes são dados simples: são criados zerados e copiados com memcpy quando a entidade muda de arquetipo.
+
+#include "PoolThreads.h"
+#include "SistemaTarefas.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+const size_t tamanhoChunkECS = 16 * 1024;
+const unsigned int maxComponentesECS = 64;
+
+// Bit i ligado = tem o componente do tipo i.
+typedef uint64_t AssinaturaECS;
+
+inline AssinaturaECS bitComponente(uint32_t tipo) { return (AssinaturaECS)1 << tipo; }
+
+struct Entidade {
+    uint32_t indice = UINT32_MAX;
+    uint32_t geracao = 0;       // Muda quando o indice é reaproveitado (copias antigas deixam de valer).
+};
+
+struct ChunkECS {
+    std::unique_ptr<uint8_t[]> memoria;
+    uint8_t* dados = nullptr;   // tamanhoChunkECS bytes alinhados em 64 dentro de "memoria".
+    uint32_t quantidade = 0;
+};
+
+// Layout do chunk: array de Entidade no inicio e depois um array por componente, cada um alinhado em 64 bytes.
+struct ArquetipoECS {
+    AssinaturaECS assinatura = 0;
+    uint32_t capacidade = 0;                        // Entidades por chunk.
+    uint32_t deslocamentos[maxComponentesECS];      // Inicio do array de cada componente (UINT32_MAX = não tem).
+    std::vector<ChunkECS> chunks;                   // Só o ultimo pode estar incompleto.
+    size_t quantidade = 0;
+};
+
+// Onde está cada entidade viva.
+struct LocalEntidadeECS {
+    uint32_t arquetipo = UINT32_MAX;
+    uint32_t chunk = 0;
+    uint32_t linha = 0;
+    uint32_t geracao = 0;
+};
+
+struct MundoECS {
+    std::vector<uint32_t> tamanhos;                 // Por tipo de componente.
+    std::vector<uint32_t> alinhamentos;
+    std::vector<std::unique_ptr<ArquetipoECS>> arquetipos;
+    std::unordered_map<AssinaturaECS, uint32_t> arquetipoDaAssinatura;
+
+    std::vector<LocalEntidadeECS> locais;           // Por indice de entidade.
+    std::vector<uint32_t> indicesLivres;
+    size_t numEntidades = 0;
+};
+
+// Registra um tipo de componente e retorna o seu numero (0 a 63), usado em bitComponente e nas consultas.
+uint32_t registraComponente(MundoECS& mundo, size_t tamanho, size_t alinhamento);
+
+template <typename T>
+uint32_t registraComponente(MundoECS& mundo) { return registraComponente(mundo, sizeof(T), alignof(T)); }
+
+// Cria entidades com os componentes da assinatura (zerados). "entidades" pode ser nulo.
+Entidade criaEntidade(MundoECS& mundo, AssinaturaECS assinatura);
+void criaEntidades(MundoECS& mundo, AssinaturaECS assinatura, size_t quantidade, Entidade* entidades);
+
+bool entidadeValida(const MundoECS& mundo, Entidade entidade);
+
+// A ultima entidade do arquetipo ocupa o lugar da removida, então os chunks continuam sem buracos.
+void destroiEntidade(MundoECS& mundo, Entidade entidade);
+
+// Ponteiro para o componente da entidade, ou nulo se ela não tem o componente (ou não existe mais). O
+// ponteiro deixa de valer quando alguma entidade do mesmo arquetipo é criada, destruida ou muda de arquetipo.
+void* componente(MundoECS& mundo, Entidade entidade, uint32_t tipo);
+
+template <typename T>
+T* componente(MundoECS& mundo, Entidade entidade, uint32_t tipo) { return (T*)componente(mundo, entidade, tipo); }
+
+// Muda a entidade de arquetipo (o componente novo começa zerado).
+void adicionaComponente(MundoECS& mundo, Entidade entidade, uint32_t tipo);
+void removeComponente(MundoECS& mundo, Entidade entidade, uint32_t tipo);
+
+// Um chunk encontrado por uma consulta: os arrays dos componentes têm "quantidade" elementos.
+struct VistaChunk {
+    uint8_t* dados = nullptr;
+    const uint32_t* deslocamentos = nullptr;
+    uint32_t quantidade = 0;
+};
+
+template <typename T>
+T* arrayComponente(const VistaChunk& vista, uint32_t tipo) { return (T*)(vista.dados + vista.deslocamentos[tipo]); }
+
+inline const Entidade* entidadesChunk(const VistaChunk& vista) { return (const Entidade*)vista.dados; }
+
+// Chunks (não vazios) dos arquetipos com todos os componentes de "inclui" e nenhum de "exclui".
+void consultaChunks(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui, std::vector<VistaChunk>& chunks);
+
+// Chama "funcao" uma vez por chunk da consulta. Criar ou destruir entidades dentro dela não é permitido.
+void paraCadaChunk(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui,
+                   const std::function<void(const VistaChunk&)>& funcao);
+
+// O mesmo, com os chunks divididos entre as threads do pool ("thread" indexa dados locais de cada thread).
+void paraCadaChunkParalelo(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui, PoolThreads& pool,
+                           const std::function<void(const VistaChunk&, unsigned int)>& funcao);
+
+// Com o sistema de tarefas: pode ser chamada de dentro de uma tarefa e correr junto com outros grupos.
+void paraCadaChunkParalelo(MundoECS& mundo, AssinaturaECS inclui, AssinaturaECS exclui, SistemaTarefas& sistema,
+                           const std::function<void(const VistaChunk&, unsigned int)>& funcao);
@@ -0,0 +1,417 @@
+#include "NivelDetalhe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+// Limites da cadeia: erro de um nivel em relação ao raio da malha e ao erro do nivel anterior.
+static const float fracaoRaioErroLOD = 0.1f;
+static const float saltoErroLOD = 8.0f;
+
+// Quadrica de erro: soma de (a * x + b * y + c * z + d)² dos planos dos triângulos em volta do vertice,
+// cada um com peso igual à area do triângulo. Guarda os 10 termos da matriz 4x4 simetrica e a soma dos pesos.
+struct Quadrica {
+    double aa, ab, ac, ad, bb, bc, bd, cc, cd, dd;
+    double peso;
+};
+
+static void somaPlano(Quadrica& q, double a, double b, double c, double d, double peso)
+{
+    q.aa += peso * a * a; q.ab += peso * a * b; q.ac += peso * a * c; q.ad += peso * a * d;
+    q.bb += peso * b * b; q.bc += peso * b * c; q.bd += peso * b * d;
+    q.cc += peso * c * c; q.cd += peso * c * d;
+    q.dd += peso * d * d;
+    q.peso += peso;
+}
+
+static void somaQuadrica(Quadrica& q, const Quadrica& outra)
+{
+    q.aa += outra.aa; q.ab += outra.ab; q.ac += outra.ac; q.ad += outra.ad;
+    q.bb += outra.bb; q.bc += outra.bc; q.bd += outra.bd;
+    q.cc += outra.cc; q.cd += outra.cd;
+    q.dd += outra.dd;
+    q.peso += outra.peso;
+}
+
+// Distancia quadratica media (ponderada pela area) do ponto aos planos da quadrica.
+static double avaliaQuadrica(const Quadrica& q, const float* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double erro = q.aa * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x
+                + q.bb * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y
+                + q.cc * z * z + 2.0 * q.cd * z
+                + q.dd;
+    return q.peso > 0.0 ? std::max(erro, 0.0) / q.peso : 0.0;
+}
+
+static Vec3 normalTriangulo(const float* p0, const float* p1, const float* p2)
+{
+    Vec3 e1(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]);
+    Vec3 e2(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]);
+    return Vec3(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+}
+
+// Colapso candidato: o vertice "removido" vai para a posição de "destino". As versões dos dois vertices
+// no momento do calculo invalidam o candidato quando algum deles muda depois.
+struct Colapso {
+    double custo;
+    uint32_t removido, destino;
+    uint32_t versaoRemovido, versaoDestino;
+
+    bool operator>(const Colapso& outro) const { return custo > outro.custo; }
+};
+
+struct EstadoSimplificacao {
+    const float* vertices;
+    unsigned int componentes;
+    std::vector<uint32_t> triangulos;                   // 3 indices por triângulo, atualizados a cada colapso.
+    std::vector<uint8_t> trianguloVivo;
+    std::vector<std::vector<uint32_t>> trianguloDoVertice;
+    std::vector<Quadrica> quadricas;
+    std::vector<uint8_t> travado;
+    std::vector<uint8_t> vivo;
+    std::vector<uint32_t> versao;
+    std::vector<uint32_t> marca;                        // Marcas temporarias por vertice (vizinhos em comum).
+    uint32_t marcaAtual = 0;
+    std::priority_queue<Colapso, std::vector<Colapso>, std::greater<Colapso>> fila;
+};
+
+static const float* posicao(const EstadoSimplificacao& e, uint32_t v)
+{
+    return e.vertices + (size_t)v * e.componentes;
+}
+
+static void enfileiraColapso(EstadoSimplificacao& e, uint32_t removido, uint32_t destino)
+{
+    if (e.travado[removido]) {
+        return;
+    }
+    Quadrica q = e.quadricas[removido];
+    somaQuadrica(q, e.quadricas[destino]);
+    e.fila.push(Colapso{ avaliaQuadrica(q, posicao(e, destino)), removido, destino, e.versao[removido], e.versao[destino] });
+}
+
+// O colapso não pode juntar dois lados da malha (os vertices só podem ter em comum os vizinhos dos
+// triângulos da aresta) nem virar, girar demais ou degenerar algum triângulo que fica.
+static bool colapsoValido(EstadoSimplificacao& e, uint32_t removido, uint32_t destino)
+{
+    e.marcaAtual++;
+    int triangulosAresta = 0;
+    for (uint32_t t : e.trianguloDoVertice[destino]) {
+        if (!e.trianguloVivo[t]) {
+            continue;
+        }
+        const uint32_t* tri = &e.triangulos[t * 3];
+        for (int k = 0; k < 3; k++) {
+            e.marca[tri[k]] = e.marcaAtual;
+        }
+        if (tri[0] == removido || tri[1] == removido || tri[2] == removido) {
+            triangulosAresta++;
+        }
+    }
+
+    e.marcaAtual++;
+    int vizinhosComuns = 0;
+    for (uint32_t t : e.trianguloDoVertice[removido]) {
+        if (!e.trianguloVivo[t]) {
+            continue;
+        }
+        const uint32_t* tri = &e.triangulos[t * 3];
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = tri[k];
+            if (v != removido && v != destino && e.marca[v] == e.marcaAtual - 1) {
+                e.marca[v] = e.marcaAtual;
+                vizinhosComuns++;
+            }
+        }
+    }
+    if (vizinhosComuns > triangulosAresta) {
+        return false;
+    }
+
+    const float* p = posicao(e, destino);
+    for (uint32_t t : e.trianguloDoVertice[removido]) {
+        if (!e.trianguloVivo[t]) {
+            continue;
+        }
+        const uint32_t* tri = &e.triangulos[t * 3];
+        if (tri[0] == destino || tri[1] == destino || tri[2] == destino) {
+            continue;
+        }
+        const float* antes[3];
+        const float* depois[3];
+        for (int k = 0; k < 3; k++) {
+            antes[k] = posicao(e, tri[k]);
+            depois[k] = tri[k] == removido ? p : antes[k];
+        }
+        Vec3 normalAntes = normalTriangulo(antes[0], antes[1], antes[2]);
+        Vec3 normalDepois = normalTriangulo(depois[0], depois[1], depois[2]);
+        // Mais de ~75 graus de rotação já conta como dobra: rotações grandes somadas viram triângulos do avesso.
+        float d = normalAntes.x * normalDepois.x + normalAntes.y * normalDepois.y + normalAntes.z * normalDepois.z;
+        float comprimentoDepois = comprimento(normalDepois);
+        if (comprimentoDepois < 1e-12f || d < 0.25f * comprimento(normalAntes) * comprimentoDepois) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t colapsa(EstadoSimplificacao& e, uint32_t removido, uint32_t destino)
+{
+    size_t removidos = 0;
+    for (uint32_t t : e.trianguloDoVertice[removido]) {
+        if (!e.trianguloVivo[t]) {
+            continue;
+        }
+        uint32_t* tri = &e.triangulos[t * 3];
+        if (tri[0] == destino || tri[1] == destino || tri[2] == destino) {
+            e.trianguloVivo[t] = 0;
+            removidos++;
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            if (tri[k] == removido) {
+                tri[k] = destino;
+            }
+        }
+        e.trianguloDoVertice[destino].push_back(t);
+    }
+    e.trianguloDoVertice[removido].clear();
+    somaQuadrica(e.quadricas[destino], e.quadricas[removido]);
+    e.vivo[removido] = 0;
+    e.versao[destino]++;
+
+    // A quadrica do destino mudou: recalcula os colapsos com todos os vizinhos, nos dois sentidos.
+    e.marcaAtual++;
+    for (uint32_t t : e.trianguloDoVertice[destino]) {
+        if (!e.trianguloVivo[t]) {
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = e.triangulos[t * 3 + k];
+            if (v != destino && e.marca[v] != e.marcaAtual) {
+                e.marca[v] = e.marcaAtual;
+                enfileiraColapso(e, v, destino);
+                enfileiraColapso(e, destino, v);
+            }
+        }
+    }
+    return removidos;
+}
+
+// Um colapso por vez até cada um dos alvos (decrescentes), guardando os indices e o erro ao passar por
+// cada alvo; assim todos os niveis saem de uma passada só e o erro é sempre medido contra a malha original.
+static void simplificaEmNiveis(const MalhaIndexada& malha, const size_t* alvos, int numAlvos,
+                               std::vector<unsigned int>* indices, float* erros)
+{
+    size_t numVertices = malha.vertices.size() / malha.componentes;
+    size_t numTriangulos = malha.indices.size() / 3;
+
+    EstadoSimplificacao e;
+    e.vertices = malha.vertices.data();
+    e.componentes = malha.componentes;
+    e.triangulos.assign(malha.indices.begin(), malha.indices.begin() + numTriangulos * 3);
+    e.trianguloVivo.assign(numTriangulos, 1);
+    e.trianguloDoVertice.resize(numVertices);
+    e.quadricas.assign(numVertices, Quadrica{});
+    e.travado.assign(numVertices, 0);
+    e.vivo.assign(numVertices, 1);
+    e.versao.assign(numVertices, 0);
+    e.marca.assign(numVertices, 0);
+
+    // Quadricas dos planos dos triângulos (os degenerados não têm plano e não contam).
+    for (size_t t = 0; t < numTriangulos; t++) {
+        const uint32_t* tri = &e.triangulos[t * 3];
+        for (int k = 0; k < 3; k++) {
+            e.trianguloDoVertice[tri[k]].push_back((uint32_t)t);
+        }
+        const float* p0 = posicao(e, tri[0]);
+        Vec3 normal = normalTriangulo(p0, posicao(e, tri[1]), posicao(e, tri[2]));
+        float dobroArea = comprimento(normal);
+        if (dobroArea <= 0.0f) {
+            continue;
+        }
+        normal = normal * (1.0f / dobroArea);
+        double d = -(normal.x * p0[0] + normal.y * p0[1] + normal.z * p0[2]);
+        for (int k = 0; k < 3; k++) {
+            somaPlano(e.quadricas[tri[k]], normal.x, normal.y, normal.z, d, dobroArea * 0.5);
+        }
+    }
+
+    // Bordas: arestas (menor, maior) que aparecem em um triângulo só.
+    std::vector<uint64_t> arestas;
+    arestas.reserve(numTriangulos * 3);
+    for (size_t t = 0; t < numTriangulos; t++) {
+        for (int k = 0; k < 3; k++) {
+            uint32_t a = e.triangulos[t * 3 + k], b = e.triangulos[t * 3 + (k + 1) % 3];
+            arestas.push_back((uint64_t)std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(arestas.begin(), arestas.end());
+    for (size_t i = 0; i < arestas.size();) {
+        size_t j = i;
+        while (j < arestas.size() && arestas[j] == arestas[i]) {
+            j++;
+        }
+        if (j - i == 1) {
+            e.travado[(uint32_t)(arestas[i] >> 32)] = 1;
+            e.travado[(uint32_t)arestas[i]] = 1;
+        }
+        i = j;
+    }
+
+    // Costuras: vertices com exatamente a mesma posição de outro.
+    std::vector<uint32_t> porPosicao(numVertices);
+    for (uint32_t v = 0; v < numVertices; v++) {
+        porPosicao[v] = v;
+    }
+    std::sort(porPosicao.begin(), porPosicao.end(), [&](uint32_t a, uint32_t b) {
+        return std::lexicographical_compare(posicao(e, a), posicao(e, a) + 3, posicao(e, b), posicao(e, b) + 3);
+    });
+    for (size_t i = 1; i < numVertices; i++) {
+        if (std::memcmp(posicao(e, porPosicao[i]), posicao(e, porPosicao[i - 1]), 3 * sizeof(float)) == 0) {
+            e.travado[porPosicao[i]] = 1;
+            e.travado[porPosicao[i - 1]] = 1;
+        }
+    }
+
+    // Com a orientação consistente cada aresta interna aparece como (a, b) num triângulo e (b, a) no
+    // outro; só a de a < b entra, nos dois sentidos.
+    for (size_t t = 0; t < numTriangulos; t++) {
+        for (int k = 0; k < 3; k++) {
+            uint32_t a = e.triangulos[t * 3 + k], b = e.triangulos[t * 3 + (k + 1) % 3];
+            if (a < b) {
+                enfileiraColapso(e, a, b);
+                enfileiraColapso(e, b, a);
+            }
+        }
+    }
+
+    size_t triangulosVivos = numTriangulos;
+    double maiorErro = 0.0;
+    for (int nivel = 0; nivel < numAlvos; nivel++) {
+        while (triangulosVivos > alvos[nivel] && !e.fila.empty()) {
+            Colapso c = e.fila.top();
+            e.fila.pop();
+            if (!e.vivo[c.removido] || !e.vivo[c.destino] || c.versaoRemovido != e.versao[c.removido] ||
+                c.versaoDestino != e.versao[c.destino]) {
+                continue;
+            }
+            if (!colapsoValido(e, c.removido, c.destino)) {
+                continue;
+            }
+            triangulosVivos -= colapsa(e, c.removido, c.destino);
+            maiorErro = std::max(maiorErro, c.custo);
+        }
+
+        indices[nivel].clear();
+        indices[nivel].reserve(triangulosVivos * 3);
+        for (size_t t = 0; t < numTriangulos; t++) {
+            if (e.trianguloVivo[t]) {
+                indices[nivel].insert(indices[nivel].end(), e.triangulos.begin() + t * 3, e.triangulos.begin() + t * 3 + 3);
+            }
+        }
+        erros[nivel] = (float)std::sqrt(maiorErro);
+    }
+}
+
+float simplificaMalha(const MalhaIndexada& malha, size_t triangulosAlvo, std::vector<unsigned int>& indices)
+{
+    float erro;
+    simplificaEmNiveis(malha, &triangulosAlvo, 1, &indices, &erro);
+    return erro;
+}
+
+void geraCadeiaLOD(const MalhaIndexada& original, MalhaLOD& lod, int numNiveis, float reducao)
+{
+    numNiveis = std::max(1, std::min(numNiveis, maxNiveisLOD));
+    size_t numVertices = original.vertices.size() / original.componentes;
+
+    size_t alvos[maxNiveisLOD];
+    alvos[0] = original.indices.size() / 3;
+    for (int nivel = 1; nivel < numNiveis; nivel++) {
+        alvos[nivel] = (size_t)(alvos[nivel - 1] * reducao);
+    }
+    std::vector<std::vector<unsigned int>> indicesNivel(numNiveis);
+    float erroNivel[maxNiveisLOD];
+    indicesNivel[0] = original.indices;
+    erroNivel[0] = 0.0f;
+    simplificaEmNiveis(original, alvos + 1, numNiveis - 1, indicesNivel.data() + 1, erroNivel + 1);
+
+    // Raio da malha original, para comparar com o erro dos niveis.
+    Vec3 minimo(INFINITY, INFINITY, INFINITY), maximo(-INFINITY, -INFINITY, -INFINITY);
+    for (unsigned int indice : original.indices) {
+        const float* p = &original.vertices[(size_t)indice * original.componentes];
+        minimo = Vec3(std::min(minimo.x, p[0]), std::min(minimo.y, p[1]), std::min(minimo.z, p[2]));
+        maximo = Vec3(std::max(maximo.x, p[0]), std::max(maximo.y, p[1]), std::max(maximo.z, p[2]));
+    }
+    lod.raio = original.indices.empty() ? 0.0f : comprimento(maximo - minimo) * 0.5f;
+
+    // Para no primeiro nivel que já quase não reduz a malha (só sobraram colapsos invalidos) ou que já
+    // amassou a forma: quando os bons colapsos acabam o simplificador ainda chega ao alvo, mas o erro salta
+    // muito acima do nivel anterior ou vira uma fração grande do tamanho do objeto.
+    int usados = 1;
+    while (usados < numNiveis && indicesNivel[usados].size() <= indicesNivel[usados - 1].size() * 9 / 10 &&
+           erroNivel[usados] <= fracaoRaioErroLOD * lod.raio &&
+           (usados == 1 || erroNivel[usados] <= saltoErroLOD * erroNivel[usados - 1])) {
+        usados++;
+    }
+    indicesNivel.resize(usados);
+
+    lod.malha.componentes = original.componentes;
+    lod.malha.vertices = original.vertices;
+    lod.malha.indices.clear();
+    lod.numNiveis = (int)indicesNivel.size();
+    for (int nivel = 0; nivel < lod.numNiveis; nivel++) {
+        std::vector<unsigned int>& indices = indicesNivel[nivel];
+        otimizaCacheVertices(indices.data(), indices.size(), numVertices);
+        lod.niveis[nivel].primeiroIndice = (unsigned int)lod.malha.indices.size();
+        lod.niveis[nivel].numIndices = (unsigned int)indices.size();
+        lod.niveis[nivel].erro = erroNivel[nivel];
+        lod.malha.indices.insert(lod.malha.indices.end(), indices.begin(), indices.end());
+    }
+
+    // Vertices na ordem do primeiro uso: o nivel 0 define a ordem e os outros leem subconjuntos dela.
+    numVertices = otimizaBuscaVertices(lod.malha.vertices.data(), lod.malha.componentes, numVertices,
+                                       lod.malha.indices.data(), lod.malha.indices.size());
+    lod.malha.vertices.resize(numVertices * lod.malha.componentes);
+}
+
+float escalaErroTela(float campoVisaoY, int alturaTela)
+{
+    return alturaTela / (2.0f * std::tan(campoVisaoY * 0.5f));
+}
+
+int selecionaLOD(const MalhaLOD& lod, float distancia, float escala, float escalaTela, float limitePixels,
+                 int nivelAnterior, float histerese)
+{
+    if (lod.numNiveis == 0) {
+        return 0;
+    }
+    // Pixels por unidade de erro da malha nessa distancia.
+    float pixels = escala * escalaTela / std::max(distancia, 1e-4f);
+    int nivel = std::max(0, std::min(nivelAnterior, lod.numNiveis - 1));
+    while (nivel > 0 && lod.niveis[nivel].erro * pixels > limitePixels) {
+        nivel--;
+    }
+    while (nivel + 1 < lod.numNiveis && lod.niveis[nivel + 1].erro * pixels <= limitePixels * (1.0f - histerese)) {
+        nivel++;
+    }
+    return nivel;
+}
+
+void selecionaLODs(const MalhaLOD& lod, const VolumesEnvolventes& volumes, const uint32_t* objetos, size_t quantidade,
+                   const Vec3& camera, float escalaTela, float limitePixels, float histerese, uint8_t* niveis)
+{
+    float inversoRaio = lod.raio > 0.0f ? 1.0f / lod.raio : 1.0f;
+    for (size_t k = 0; k < quantidade; k++) {
+        uint32_t i = objetos[k];
+        float dx = volumes.centroX[i] - camera.x;
+        float dy = volumes.centroY[i] - camera.y;
+        float dz = volumes.centroZ[i] - camera.z;
+        float distancia = std::sqrt(dx * dx + dy * dy + dz * dz) - volumes.raio[i];
+        niveis[i] = (uint8_t)selecionaLOD(lod, distancia, volumes.raio[i] * inversoRaio, escalaTela, limitePixels, niveis[i], histerese);
+    }
+}
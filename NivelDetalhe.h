@@ -0,0 +1,57 @@
+#pragma once
+
+// Niveis de detalhe (LOD): a malha é simplificada offline em varios niveis, cada um com mais ou menos a
+// metade dos triângulos do anterior, e todos os niveis ficam nos mesmos VBO e EBO (os vertices são os da
+// malha original e cada nivel é um intervalo de indices). Em tempo de execução cada objeto usa o nivel
+// mais simples cujo erro, projetado na tela, fica abaixo de um limite em pixels.
+
+#include "OtimizacaoMalha.h"
+#include "DescarteFrustum.h"
+#include "Matematica.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const int maxNiveisLOD = 8;
+
+// Simplifica a malha (posição nos 3 primeiros componentes) por colapso de arestas com a metrica de erro
+// quadrico de Garland e Heckbert até sobrarem no maximo "triangulosAlvo" triângulos, ou até nenhum colapso
+// ser possivel. Cada aresta colapsa para um dos seus vertices, então os indices resultantes apontam para os
+// vertices da propria malha. Vertices da borda e vertices com a mesma posição de outro (costuras de
+// UV/normal) não são removidos. Retorna o erro do resultado (distancia aproximada, nas unidades da malha).
+float simplificaMalha(const MalhaIndexada& malha, size_t triangulosAlvo, std::vector<unsigned int>& indices);
+
+struct NivelLOD {
+    unsigned int primeiroIndice = 0;
+    unsigned int numIndices = 0;
+    float erro = 0.0f;      // Nas unidades da malha; cresce com o nivel.
+};
+
+struct MalhaLOD {
+    MalhaIndexada malha;    // Vertices compartilhados e os indices de todos os niveis, um depois do outro.
+    NivelLOD niveis[maxNiveisLOD];
+    int numNiveis = 0;
+    float raio = 0.0f;      // Meia diagonal da caixa da malha (mesmo raio do defineCaixa).
+};
+
+// Nivel 0 é a malha original; cada nivel seguinte tem "reducao" vezes os triângulos do anterior. Para
+// antes de "numNiveis" quando a simplificação já não reduz a malha, ou quando o erro de um nivel salta
+// muito acima do anterior ou passa de uma fração do raio (a forma começou a ser amassada). Os indices de
+// cada nivel são otimizados para o cache de vertices e os vertices para a ordem de uso.
+void geraCadeiaLOD(const MalhaIndexada& original, MalhaLOD& lod, int numNiveis = 4, float reducao = 0.5f);
+
+// Pixels por unidade de erro a distancia 1 da camera: altura / (2 * tan(campoVisaoY / 2)).
+float escalaErroTela(float campoVisaoY, int alturaTela);
+
+// Nivel de um objeto a "distancia" da camera (desenhado com "escala" vezes o tamanho da malha). Vai para
+// um nivel mais detalhado assim que o erro na tela passa de "limitePixels", mas só vai para um mais simples
+// quando o erro dele fica abaixo de limitePixels * (1 - histerese), para não trocar de nivel a cada quadro
+// quando o objeto está perto do limite.
+int selecionaLOD(const MalhaLOD& lod, float distancia, float escala, float escalaTela, float limitePixels,
+                 int nivelAnterior, float histerese = 0.25f);
+
+// selecionaLOD para cada objeto da lista: distancia da camera até a esfera de "volumes" e escala =
+// raio do objeto / raio da malha. "niveis" tem um nivel por objeto (indice do objeto), lido e atualizado.
+void selecionaLODs(const MalhaLOD& lod, const VolumesEnvolventes& volumes, const uint32_t* objetos, size_t quantidade,
+                   const Vec3& camera, float escalaTela, float limitePixels, float histerese, uint8_t* niveis);
@@ -0,0 +1,410 @@
+#include "OclusaoCPU.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Vertice na tela do buffer: x e y em pixels (centro do pixel (i, j) em (i + 0.5, j + 0.5)) e profundidade
+// de 0.0 a 1.0.
+struct VerticeTela {
+    float x, y, z;
+};
+
+// Arestas e plano da profundidade do triângulo: o pixel está dentro quando a[i] * x + b[i] * y + c[i] >= 0
+// para as 3 arestas, e a profundidade nele é zA * x + zB * y + zC.
+struct TrianguloOclusao {
+    float a[3], b[3], c[3];
+    float zA, zB, zC;
+    int minX, minY, maxX, maxY;
+};
+
+// Faces da caixa com os cantos (bit 0 = x, bit 1 = y, bit 2 = z maximos) no sentido anti-horario vistos de fora.
+static const int facesCaixa[6][4] = {
+    { 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+    { 0, 1, 5, 4 }, { 2, 6, 7, 3 },
+    { 0, 2, 3, 1 }, { 4, 5, 7, 6 }
+};
+
+static Vec3 cantoCaixa(const Vec3& minimo, const Vec3& maximo, int canto)
+{
+    return Vec3(canto & 1 ? maximo.x : minimo.x, canto & 2 ? maximo.y : minimo.y, canto & 4 ? maximo.z : minimo.z);
+}
+
+// Falso quando o ponto está atrás do plano perto (z < -w no espaço de recorte), onde a divisão por w
+// não dá mais a posição na tela.
+static bool projeta(const BufferOclusao& buffer, const Mat4& matriz, const Vec3& p, VerticeTela& v)
+{
+    Vec4 recorte = matriz * Vec4(p.x, p.y, p.z, 1.0f);
+    if (recorte.z < -recorte.w || recorte.w <= 0.0f) {
+        return false;
+    }
+    float inversoW = 1.0f / recorte.w;
+    v.x = (recorte.x * inversoW * 0.5f + 0.5f) * buffer.largura;
+    v.y = (recorte.y * inversoW * 0.5f + 0.5f) * buffer.altura;
+    v.z = recorte.z * inversoW * 0.5f + 0.5f;
+    return true;
+}
+
+// Falso quando o triângulo não cobre nenhum pixel do buffer, é degenerado, ou (com "descartaTras") está de costas.
+static bool preparaTriangulo(const BufferOclusao& buffer, const VerticeTela* v, bool descartaTras, TrianguloOclusao& t)
+{
+    for (int i = 0; i < 3; i++) {
+        const VerticeTela& v1 = v[(i + 1) % 3];
+        const VerticeTela& v2 = v[(i + 2) % 3];
+        t.a[i] = v1.y - v2.y;
+        t.b[i] = v2.x - v1.x;
+        t.c[i] = v1.x * v2.y - v1.y * v2.x;
+    }
+    // Duas vezes a area com sinal; positiva no sentido anti-horario.
+    float area = t.a[0] * v[0].x + t.b[0] * v[0].y + t.c[0];
+    if (descartaTras && area <= 0.0f) {
+        return false;
+    }
+    if (std::fabs(area) < 1e-6f) {
+        return false;
+    }
+    if (area < 0.0f) {
+        for (int i = 0; i < 3; i++) {
+            t.a[i] = -t.a[i];
+            t.b[i] = -t.b[i];
+            t.c[i] = -t.c[i];
+        }
+        area = -area;
+    }
+
+    float inversoArea = 1.0f / area;
+    t.zA = (t.a[0] * v[0].z + t.a[1] * v[1].z + t.a[2] * v[2].z) * inversoArea;
+    t.zB = (t.b[0] * v[0].z + t.b[1] * v[1].z + t.b[2] * v[2].z) * inversoArea;
+    t.zC = (t.c[0] * v[0].z + t.c[1] * v[1].z + t.c[2] * v[2].z) * inversoArea;
+
+    float minX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+    float maxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+    float minY = std::min(v[0].y, std::min(v[1].y, v[2].y));
+    float maxY = std::max(v[0].y, std::max(v[1].y, v[2].y));
+    // Limitado antes da conversão: perto do plano perto as coordenadas podem passar do alcance de um int.
+    t.minX = (int)std::max(0.0f, std::floor(minX));
+    t.minY = (int)std::max(0.0f, std::floor(minY));
+    t.maxX = (int)std::min((float)(buffer.largura - 1), std::floor(maxX));
+    t.maxY = (int)std::min((float)(buffer.altura - 1), std::floor(maxY));
+    return t.minX <= t.maxX && t.minY <= t.maxY;
+}
+
+// Retângulo de pixels e menor profundidade da caixa projetada. Falso quando algum canto está atrás do
+// plano perto.
+static bool projetaCaixa(const BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo,
+                         int& x0, int& y0, int& x1, int& y1, float& menorZ)
+{
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    menorZ = INFINITY;
+    for (int canto = 0; canto < 8; canto++) {
+        VerticeTela v;
+        if (!projeta(buffer, buffer.projecaoVisao, cantoCaixa(minimo, maximo, canto), v)) {
+            return false;
+        }
+        minX = std::min(minX, v.x);
+        minY = std::min(minY, v.y);
+        maxX = std::max(maxX, v.x);
+        maxY = std::max(maxY, v.y);
+        menorZ = std::min(menorZ, v.z);
+    }
+    // Limitado a um pixel fora do buffer de cada lado antes da conversão para int.
+    x0 = (int)std::max(-1.0f, std::floor(minX));
+    y0 = (int)std::max(-1.0f, std::floor(minY));
+    x1 = (int)std::min((float)buffer.largura, std::floor(maxX));
+    y1 = (int)std::min((float)buffer.altura, std::floor(maxY));
+    return true;
+}
+
+// Corta o retângulo no buffer. Falso quando não sobra nenhum pixel.
+static bool limitaRetangulo(const BufferOclusao& buffer, int& x0, int& y0, int& x1, int& y1)
+{
+    if (x1 < 0 || y1 < 0 || x0 >= buffer.largura || y0 >= buffer.altura) {
+        return false;
+    }
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, buffer.largura - 1);
+    y1 = std::min(y1, buffer.altura - 1);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------
+// Kernels: rasterização de um triângulo preparado e teste de uma caixa.
+
+static void rasterizaEscalar(BufferOclusao& buffer, const TrianguloOclusao& t)
+{
+    for (int y = t.minY; y <= t.maxY; y++) {
+        float py = y + 0.5f;
+        float linha0 = t.b[0] * py + t.c[0];
+        float linha1 = t.b[1] * py + t.c[1];
+        float linha2 = t.b[2] * py + t.c[2];
+        float linhaZ = t.zB * py + t.zC;
+        float* profundidade = buffer.profundidade.data() + (size_t)y * buffer.largura;
+        for (int x = t.minX; x <= t.maxX; x++) {
+            float px = x + 0.5f;
+            float e0 = t.a[0] * px + linha0;
+            float e1 = t.a[1] * px + linha1;
+            float e2 = t.a[2] * px + linha2;
+            if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+                profundidade[x] = std::min(profundidade[x], t.zA * px + linhaZ);
+            }
+        }
+    }
+}
+
+// Visivel quando algum pixel do retângulo (já dentro do buffer) tem profundidade >= menorZ.
+static bool testaRetanguloEscalar(const BufferOclusao& buffer, int x0, int y0, int x1, int y1, float menorZ)
+{
+    for (int y = y0; y <= y1; y++) {
+        const float* profundidade = buffer.profundidade.data() + (size_t)y * buffer.largura;
+        for (int x = x0; x <= x1; x++) {
+            if (profundidade[x] >= menorZ) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool testaEscalar(const BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo)
+{
+    int x0, y0, x1, y1;
+    float menorZ;
+    if (!projetaCaixa(buffer, minimo, maximo, x0, y0, x1, y1, menorZ) || !limitaRetangulo(buffer, x0, y0, x1, y1)) {
+        return true;
+    }
+    return testaRetanguloEscalar(buffer, x0, y0, x1, y1, menorZ);
+}
+
+#if SIMD_X86
+// Grupos de 8 pixels alinhados a partir do multiplo de 8 abaixo de minX (a largura é multipla de 8, então
+// o ultimo grupo nunca passa da linha). Pixels fora da caixa do triângulo falham o teste das arestas, e as
+// contas são as mesmas do escalar, na mesma ordem.
+ALVO_AVX2 static void rasterizaAVX2(BufferOclusao& buffer, const TrianguloOclusao& t)
+{
+    const __m256 deslocamento = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 a0 = _mm256_set1_ps(t.a[0]), a1 = _mm256_set1_ps(t.a[1]), a2 = _mm256_set1_ps(t.a[2]);
+    __m256 zA = _mm256_set1_ps(t.zA);
+    int inicioX = t.minX & ~7;
+
+    for (int y = t.minY; y <= t.maxY; y++) {
+        float py = y + 0.5f;
+        __m256 linha0 = _mm256_set1_ps(t.b[0] * py + t.c[0]);
+        __m256 linha1 = _mm256_set1_ps(t.b[1] * py + t.c[1]);
+        __m256 linha2 = _mm256_set1_ps(t.b[2] * py + t.c[2]);
+        __m256 linhaZ = _mm256_set1_ps(t.zB * py + t.zC);
+        float* profundidade = buffer.profundidade.data() + (size_t)y * buffer.largura;
+        for (int x = inicioX; x <= t.maxX; x += 8) {
+            __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), deslocamento);
+            __m256 e0 = _mm256_add_ps(_mm256_mul_ps(a0, px), linha0);
+            __m256 e1 = _mm256_add_ps(_mm256_mul_ps(a1, px), linha1);
+            __m256 e2 = _mm256_add_ps(_mm256_mul_ps(a2, px), linha2);
+            __m256 dentro = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+                                          _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+            if (_mm256_testz_ps(dentro, dentro)) {
+                continue;
+            }
+            __m256 z = _mm256_add_ps(_mm256_mul_ps(zA, px), linhaZ);
+            __m256 atual = _mm256_loadu_ps(profundidade + x);
+            _mm256_storeu_ps(profundidade + x, _mm256_blendv_ps(atual, _mm256_min_ps(atual, z), dentro));
+        }
+    }
+}
+
+ALVO_AVX2 static bool testaRetanguloAVX2(const BufferOclusao& buffer, int x0, int y0, int x1, int y1, float menorZ)
+{
+    const __m256i colunas = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 z = _mm256_set1_ps(menorZ);
+    int inicioX = x0 & ~7;
+
+    // Mascaras das colunas dentro de [x0, x1] para cada grupo de 8; só o primeiro e o ultimo são parciais.
+    for (int y = y0; y <= y1; y++) {
+        const float* profundidade = buffer.profundidade.data() + (size_t)y * buffer.largura;
+        for (int x = inicioX; x <= x1; x += 8) {
+            __m256i coluna = _mm256_add_epi32(colunas, _mm256_set1_epi32(x));
+            __m256i noRetangulo = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(x0), coluna),
+                                                      _mm256_cmpgt_epi32(_mm256_set1_epi32(x1 + 1), coluna));
+            __m256 atras = _mm256_cmp_ps(_mm256_loadu_ps(profundidade + x), z, _CMP_GE_OQ);
+            if (!_mm256_testz_ps(atras, _mm256_castsi256_ps(noRetangulo))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+ALVO_AVX2 static float menorHorizontal(__m256 v)
+{
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+
+ALVO_AVX2 static float maiorHorizontal(__m256 v)
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+}
+
+// Os 8 cantos da caixa são projetados juntos, um por lane (mesma numeração de cantoCaixa).
+ALVO_AVX2 static bool testaAVX2(const BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo)
+{
+    const float* m = buffer.projecaoVisao.dados();
+    __m256 px = _mm256_setr_ps(minimo.x, maximo.x, minimo.x, maximo.x, minimo.x, maximo.x, minimo.x, maximo.x);
+    __m256 py = _mm256_setr_ps(minimo.y, minimo.y, maximo.y, maximo.y, minimo.y, minimo.y, maximo.y, maximo.y);
+    __m256 pz = _mm256_setr_ps(minimo.z, minimo.z, minimo.z, minimo.z, maximo.z, maximo.z, maximo.z, maximo.z);
+    __m256 recorte[4];
+    for (int r = 0; r < 4; r++) {
+        recorte[r] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[r]), px), _mm256_mul_ps(_mm256_set1_ps(m[4 + r]), py)),
+                                                 _mm256_mul_ps(_mm256_set1_ps(m[8 + r]), pz)), _mm256_set1_ps(m[12 + r]));
+    }
+
+    // Algum canto atrás do plano perto: visivel.
+    __m256 atras = _mm256_or_ps(_mm256_cmp_ps(recorte[2], _mm256_sub_ps(_mm256_setzero_ps(), recorte[3]), _CMP_LT_OQ),
+                                _mm256_cmp_ps(recorte[3], _mm256_setzero_ps(), _CMP_LE_OQ));
+    if (_mm256_movemask_ps(atras)) {
+        return true;
+    }
+
+    const __m256 meio = _mm256_set1_ps(0.5f);
+    __m256 inversoW = _mm256_div_ps(_mm256_set1_ps(1.0f), recorte[3]);
+    __m256 x = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(recorte[0], inversoW), meio), meio), _mm256_set1_ps((float)buffer.largura));
+    __m256 y = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(recorte[1], inversoW), meio), meio), _mm256_set1_ps((float)buffer.altura));
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(recorte[2], inversoW), meio), meio);
+
+    int x0 = (int)std::max(-1.0f, std::floor(menorHorizontal(x)));
+    int y0 = (int)std::max(-1.0f, std::floor(menorHorizontal(y)));
+    int x1 = (int)std::min((float)buffer.largura, std::floor(maiorHorizontal(x)));
+    int y1 = (int)std::min((float)buffer.altura, std::floor(maiorHorizontal(y)));
+    if (!limitaRetangulo(buffer, x0, y0, x1, y1)) {
+        return true;
+    }
+    return testaRetanguloAVX2(buffer, x0, y0, x1, y1, menorHorizontal(z));
+}
+#endif
+
+typedef void (*FuncaoRasterizaOclusao)(BufferOclusao&, const TrianguloOclusao&);
+typedef bool (*FuncaoTestaOclusao)(const BufferOclusao&, const Vec3&, const Vec3&);
+
+static DespachoSIMD<FuncaoRasterizaOclusao> despachoRasteriza(rasterizaEscalar, nullptr, IMPLEMENTACAO_X86(rasterizaAVX2));
+static DespachoSIMD<FuncaoTestaOclusao> despachoTesta(testaEscalar, nullptr, IMPLEMENTACAO_X86(testaAVX2));
+
+// ---------------------------------------------------------------------------------------------------
+
+void redimensionaOclusao(BufferOclusao& buffer, int largura, int altura)
+{
+    buffer.largura = (largura + 7) & ~7;
+    buffer.altura = altura;
+    buffer.profundidade.assign((size_t)buffer.largura * altura, 1.0f);
+}
+
+void limpaOclusao(BufferOclusao& buffer, const Mat4& projecaoVisao)
+{
+    std::fill(buffer.profundidade.begin(), buffer.profundidade.end(), 1.0f);
+    buffer.projecaoVisao = projecaoVisao;
+    buffer.triangulosOclusores = 0;
+    buffer.caixasTestadas = 0;
+    buffer.caixasOcultas = 0;
+}
+
+void rasterizaOclusor(BufferOclusao& buffer, const float* vertices, unsigned int stride, const uint32_t* indices,
+                      size_t numIndices, const Mat4& modelo)
+{
+    Mat4 matriz = buffer.projecaoVisao * modelo;
+    for (size_t i = 0; i + 3 <= numIndices; i += 3) {
+        VerticeTela v[3];
+        bool projetado = true;
+        for (int k = 0; k < 3; k++) {
+            const float* p = vertices + (size_t)indices[i + k] * stride;
+            projetado = projetado && projeta(buffer, matriz, Vec3(p[0], p[1], p[2]), v[k]);
+        }
+        TrianguloOclusao t;
+        if (projetado && preparaTriangulo(buffer, v, false, t)) {
+            despachoRasteriza.funcao()(buffer, t);
+            buffer.triangulosOclusores++;
+        }
+    }
+}
+
+void rasterizaCaixaOclusora(BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo)
+{
+    VerticeTela cantos[8];
+    bool projetado[8];
+    for (int canto = 0; canto < 8; canto++) {
+        projetado[canto] = projeta(buffer, buffer.projecaoVisao, cantoCaixa(minimo, maximo, canto), cantos[canto]);
+    }
+
+    for (const int* face : facesCaixa) {
+        if (!projetado[face[0]] || !projetado[face[1]] || !projetado[face[2]] || !projetado[face[3]]) {
+            continue;
+        }
+        for (int metade = 0; metade < 2; metade++) {
+            VerticeTela v[3] = { cantos[face[0]], cantos[face[metade + 1]], cantos[face[metade + 2]] };
+            TrianguloOclusao t;
+            if (preparaTriangulo(buffer, v, true, t)) {
+                despachoRasteriza.funcao()(buffer, t);
+                buffer.triangulosOclusores++;
+            }
+        }
+    }
+}
+
+bool caixaVisivelOclusao(const BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo)
+{
+    return despachoTesta.funcao()(buffer, minimo, maximo);
+}
+
+size_t descartaOclusao(BufferOclusao& buffer, const VolumesEnvolventes& volumes, const uint32_t* candidatos,
+                       size_t quantidade, uint32_t* visiveis)
+{
+    size_t numVisiveis = 0;
+    for (size_t k = 0; k < quantidade; k++) {
+        uint32_t i = candidatos[k];
+        Vec3 centro(volumes.centroX[i], volumes.centroY[i], volumes.centroZ[i]);
+        Vec3 extensao(volumes.extensaoX[i], volumes.extensaoY[i], volumes.extensaoZ[i]);
+        if (caixaVisivelOclusao(buffer, centro - extensao, centro + extensao)) {
+            visiveis[numVisiveis++] = i;
+        }
+    }
+    buffer.caixasTestadas += (uint32_t)quantidade;
+    buffer.caixasOcultas += (uint32_t)(quantidade - numVisiveis);
+    return numVisiveis;
+}
+
+size_t escolheOclusores(const VolumesEnvolventes& volumes, const uint32_t* candidatos, size_t quantidade,
+                        const Vec3& camera, size_t maximo, uint32_t* oclusores)
+{
+    std::vector<std::pair<float, uint32_t>> pontuacao(quantidade);
+    for (size_t k = 0; k < quantidade; k++) {
+        uint32_t i = candidatos[k];
+        float dx = volumes.centroX[i] - camera.x;
+        float dy = volumes.centroY[i] - camera.y;
+        float dz = volumes.centroZ[i] - camera.z;
+        float distancia2 = std::max(dx * dx + dy * dy + dz * dz, 1e-6f);
+        // Negativa para o partial_sort deixar as maiores na frente.
+        pontuacao[k] = std::make_pair(-volumes.raio[i] * volumes.raio[i] / distancia2, i);
+    }
+
+    size_t numOclusores = std::min(maximo, quantidade);
+    std::partial_sort(pontuacao.begin(), pontuacao.begin() + numOclusores, pontuacao.end());
+    for (size_t k = 0; k < numOclusores; k++) {
+        oclusores[k] = pontuacao[k].second;
+    }
+    return numOclusores;
+}
+
+NivelSIMD selecionaNivelOclusao(NivelSIMD nivel)
+{
+    despachoTesta.seleciona(nivel);
+    return despachoRasteriza.seleciona(nivel);
+}
+
+NivelSIMD nivelOclusao()
+{
+    return despachoRasteriza.nivel();
+}
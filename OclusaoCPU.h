@@ -0,0 +1,64 @@
+#pragma once
+
+// Descarte por oclusão em software: alguns objetos grandes e proximos (os oclusores) são rasterizados
+// só em profundidade num buffer pequeno (256 x 128 por padrão) e a caixa de cada objeto candidato é
+// projetada e comparada com esse buffer antes do desenho. Objetos inteiramente atrás dos oclusores não
+// chegam à fila de desenhos. O teste é feito nos centros dos pixels do buffer pequeno, então é aproximado
+// nas bordas dos oclusores (um objeto quase todo escondido pode sumir um quadro antes do certo).
+// AVX2 (8 pixels por instrução) ou escalar, escolhido em tempo de execução pelo CPUID.
+
+#include "DescarteFrustum.h"
+#include "Matematica.h"
+#include "CPUInfo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const int larguraOclusaoPadrao = 256;
+const int alturaOclusaoPadrao = 128;
+
+struct BufferOclusao {
+    int largura = 0;                    // Multiplo de 8.
+    int altura = 0;
+    std::vector<float> profundidade;    // Linha 0 embaixo; 0.0 (perto) a 1.0 (longe).
+    Mat4 projecaoVisao;
+
+    // Contagem desde o ultimo limpaOclusao.
+    uint32_t triangulosOclusores = 0;   // Triângulos que chegaram a ser rasterizados.
+    uint32_t caixasTestadas = 0;
+    uint32_t caixasOcultas = 0;
+};
+
+// A largura é arredondada para cima para um multiplo de 8.
+void redimensionaOclusao(BufferOclusao& buffer, int largura = larguraOclusaoPadrao, int altura = alturaOclusaoPadrao);
+
+// Começo do quadro: profundidade 1.0 em todo o buffer, camera do quadro e contagens zeradas.
+void limpaOclusao(BufferOclusao& buffer, const Mat4& projecaoVisao);
+
+// Rasteriza a malha (posição nos 3 primeiros floats de cada vertice, "stride" floats por vertice) com a
+// matriz de modelo. Os dois lados dos triângulos são desenhados. Triângulos que cruzam o plano perto são
+// ignorados (um oclusor a menos nunca esconde um objeto visivel).
+void rasterizaOclusor(BufferOclusao& buffer, const float* vertices, unsigned int stride, const uint32_t* indices,
+                      size_t numIndices, const Mat4& modelo);
+
+// Caixa alinhada aos eixos como oclusor (prédios, paredes): só as faces viradas para a camera.
+void rasterizaCaixaOclusora(BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo);
+
+// Falso quando a caixa está inteiramente atrás do que já foi rasterizado. Caixas que cruzam o plano perto
+// ou saem do buffer contam como visiveis.
+bool caixaVisivelOclusao(const BufferOclusao& buffer, const Vec3& minimo, const Vec3& maximo);
+
+// Escreve em "visiveis", na mesma ordem, os candidatos cuja caixa (volumes) não está escondida, e
+// retorna quantos são. Pode ser chamada com visiveis == candidatos.
+size_t descartaOclusao(BufferOclusao& buffer, const VolumesEnvolventes& volumes, const uint32_t* candidatos,
+                       size_t quantidade, uint32_t* visiveis);
+
+// Os até "maximo" candidatos que ocupam o maior angulo visto da camera (raio² / distancia²), que são os
+// que mais escondem para cada triângulo rasterizado. Retorna quantos foram escritos em "oclusores".
+size_t escolheOclusores(const VolumesEnvolventes& volumes, const uint32_t* candidatos, size_t quantidade,
+                        const Vec3& camera, size_t maximo, uint32_t* oclusores);
+
+// Troca a implementação usada (limitada ao que o processador suporta). Retorna o nivel efetivo.
+NivelSIMD selecionaNivelOclusao(NivelSIMD nivel);
+NivelSIMD nivelOclusao();
@@ -0,0 +1,322 @@
+#include "OtimizacaoMalha.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+float calculaACMR(const unsigned int* indices, size_t numIndices, size_t numVertices, unsigned int tamanhoCache)
+{
+    if (numIndices < 3) {
+        return 0.0f;
+    }
+
+    // Cache FIFO: guarda o "instante" em que cada vertice entrou no cache.
+    std::vector<size_t> entradaCache(numVertices, 0);
+    size_t instante = tamanhoCache + 1;
+    size_t faltas = 0;
+
+    for (size_t i = 0; i < numIndices; i++) {
+        unsigned int v = indices[i];
+
+        // O vertice saiu do cache se entraram "tamanhoCache" vertices depois dele.
+        if (instante - entradaCache[v] > tamanhoCache) {
+            entradaCache[v] = instante;
+            instante++;
+            faltas++;
+        }
+    }
+
+    return (float)faltas / (float)(numIndices / 3);
+}
+
+// Pesos do algoritmo do Forsyth ("Linear-Speed Vertex Cache Optimisation").
+static const float pesoDecaimentoCache = 1.5f;
+static const float pesoUltimoTriangulo = 0.75f;
+static const float pesoValencia = 2.0f;
+static const float expoenteValencia = 0.5f;
+
+static float pontuacaoVertice(int posicaoCache, unsigned int triangulosRestantes, unsigned int tamanhoCache)
+{
+    // Vertice sem triângulos pendentes nunca mais será usado.
+    if (triangulosRestantes == 0) {
+        return -1.0f;
+    }
+
+    float pontuacao = 0.0f;
+
+    if (posicaoCache >= 0) {
+        if (posicaoCache < 3) {
+            // Vertices do ultimo triângulo desenhado recebem um peso fixo,
+            // para não favorecer tiras longas e finas.
+            pontuacao = pesoUltimoTriangulo;
+        }
+        else {
+            float escala = 1.0f / (float)(tamanhoCache - 3);
+            pontuacao = std::pow(1.0f - (float)(posicaoCache - 3) * escala, pesoDecaimentoCache);
+        }
+    }
+
+    // Vertices com poucos triângulos restantes são priorizados para sair logo da lista.
+    pontuacao += pesoValencia * std::pow((float)triangulosRestantes, -expoenteValencia);
+
+    return pontuacao;
+}
+
+void otimizaCacheVertices(unsigned int* indices, size_t numIndices, size_t numVertices, unsigned int tamanhoCache)
+{
+    size_t numTriangulos = numIndices / 3;
+    if (numTriangulos == 0 || tamanhoCache < 4) {
+        return;
+    }
+
+    // Lista de adjacência vertice -> triângulos (formato compacto: inicio + contagem).
+    std::vector<unsigned int> triangulosRestantes(numVertices, 0);
+    for (size_t i = 0; i < numIndices; i++) {
+        triangulosRestantes[indices[i]]++;
+    }
+
+    std::vector<unsigned int> inicioAdjacencia(numVertices + 1, 0);
+    for (size_t v = 0; v < numVertices; v++) {
+        inicioAdjacencia[v + 1] = inicioAdjacencia[v] + triangulosRestantes[v];
+    }
+
+    std::vector<unsigned int> adjacencia(numIndices);
+    std::vector<unsigned int> preenchidos(numVertices, 0);
+    for (size_t t = 0; t < numTriangulos; t++) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            adjacencia[inicioAdjacencia[v] + preenchidos[v]] = (unsigned int)t;
+            preenchidos[v]++;
+        }
+    }
+
+    // Pontuação inicial de vertices e triângulos.
+    std::vector<int> posicaoCache(numVertices, -1);
+    std::vector<float> pontuacaoVertices(numVertices);
+    for (size_t v = 0; v < numVertices; v++) {
+        pontuacaoVertices[v] = pontuacaoVertice(-1, triangulosRestantes[v], tamanhoCache);
+    }
+
+    std::vector<float> pontuacaoTriangulos(numTriangulos);
+    std::vector<char> trianguloEmitido(numTriangulos, 0);
+    for (size_t t = 0; t < numTriangulos; t++) {
+        pontuacaoTriangulos[t] = pontuacaoVertices[indices[t * 3 + 0]]
+                               + pontuacaoVertices[indices[t * 3 + 1]]
+                               + pontuacaoVertices[indices[t * 3 + 2]];
+    }
+
+    // Cache LRU simulado (3 posições extras para os vertices que acabaram de entrar).
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> novoCache;
+    cache.reserve(tamanhoCache + 3);
+    novoCache.reserve(tamanhoCache + 3);
+
+    std::vector<unsigned int> resultado(numIndices);
+    size_t proximoNaoEmitido = 0;
+    size_t melhorTriangulo = 0;
+
+    // Primeiro triângulo: o de maior pontuação.
+    for (size_t t = 1; t < numTriangulos; t++) {
+        if (pontuacaoTriangulos[t] > pontuacaoTriangulos[melhorTriangulo]) {
+            melhorTriangulo = t;
+        }
+    }
+
+    for (size_t emitidos = 0; emitidos < numTriangulos; emitidos++) {
+        // Quando nenhum triângulo do cache serve, procura o proximo ainda não emitido.
+        if (melhorTriangulo == (size_t)-1) {
+            while (trianguloEmitido[proximoNaoEmitido]) {
+                proximoNaoEmitido++;
+            }
+            melhorTriangulo = proximoNaoEmitido;
+        }
+
+        const unsigned int* tri = &indices[melhorTriangulo * 3];
+        resultado[emitidos * 3 + 0] = tri[0];
+        resultado[emitidos * 3 + 1] = tri[1];
+        resultado[emitidos * 3 + 2] = tri[2];
+        trianguloEmitido[melhorTriangulo] = 1;
+
+        // Remove o triângulo das listas de adjacência dos seus vertices.
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = tri[k];
+            unsigned int* lista = &adjacencia[inicioAdjacencia[v]];
+            unsigned int n = triangulosRestantes[v];
+            for (unsigned int a = 0; a < n; a++) {
+                if (lista[a] == melhorTriangulo) {
+                    lista[a] = lista[n - 1];
+                    break;
+                }
+            }
+            triangulosRestantes[v]--;
+        }
+
+        // Os vertices do triângulo vão para o topo do cache, o resto é empurrado.
+        novoCache.clear();
+        novoCache.push_back(tri[0]);
+        novoCache.push_back(tri[1]);
+        novoCache.push_back(tri[2]);
+        for (size_t c = 0; c < cache.size(); c++) {
+            unsigned int v = cache[c];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                novoCache.push_back(v);
+            }
+        }
+
+        // Vertices que caíram para fora do cache perdem a posição (e os seus triângulos a pontuação de cache).
+        for (size_t c = tamanhoCache; c < novoCache.size(); c++) {
+            unsigned int v = novoCache[c];
+            posicaoCache[v] = -1;
+
+            float novaPontuacao = pontuacaoVertice(-1, triangulosRestantes[v], tamanhoCache);
+            float diferenca = novaPontuacao - pontuacaoVertices[v];
+            pontuacaoVertices[v] = novaPontuacao;
+
+            const unsigned int* lista = &adjacencia[inicioAdjacencia[v]];
+            for (unsigned int a = 0; a < triangulosRestantes[v]; a++) {
+                pontuacaoTriangulos[lista[a]] += diferenca;
+            }
+        }
+        if (novoCache.size() > tamanhoCache) {
+            novoCache.resize(tamanhoCache);
+        }
+        cache.swap(novoCache);
+
+        // Atualiza as pontuações dos vertices no cache e dos seus triângulos.
+        for (size_t c = 0; c < cache.size(); c++) {
+            unsigned int v = cache[c];
+            posicaoCache[v] = (int)c;
+
+            float novaPontuacao = pontuacaoVertice((int)c, triangulosRestantes[v], tamanhoCache);
+            float diferenca = novaPontuacao - pontuacaoVertices[v];
+            pontuacaoVertices[v] = novaPontuacao;
+
+            const unsigned int* lista = &adjacencia[inicioAdjacencia[v]];
+            for (unsigned int a = 0; a < triangulosRestantes[v]; a++) {
+                pontuacaoTriangulos[lista[a]] += diferenca;
+            }
+        }
+
+        // O proximo triângulo é o melhor entre os que tocam vertices do cache.
+        melhorTriangulo = (size_t)-1;
+        float melhorPontuacao = -1.0f;
+        for (size_t c = 0; c < cache.size(); c++) {
+            unsigned int v = cache[c];
+            const unsigned int* lista = &adjacencia[inicioAdjacencia[v]];
+            for (unsigned int a = 0; a < triangulosRestantes[v]; a++) {
+                unsigned int t = lista[a];
+                if (pontuacaoTriangulos[t] > melhorPontuacao) {
+                    melhorPontuacao = pontuacaoTriangulos[t];
+                    melhorTriangulo = t;
+                }
+            }
+        }
+    }
+
+    std::memcpy(indices, resultado.data(), numIndices * sizeof(unsigned int));
+}
+
+size_t otimizaBuscaVertices(float* vertices, unsigned int componentes, size_t numVertices, unsigned int* indices, size_t numIndices)
+{
+    const unsigned int semNovoIndice = 0xFFFFFFFFu;
+    std::vector<unsigned int> remapeamento(numVertices, semNovoIndice);
+    std::vector<float> reordenados(numVertices * componentes);
+    unsigned int proximo = 0;
+
+    // Cada vertice recebe um novo indice na ordem do primeiro uso.
+    for (size_t i = 0; i < numIndices; i++) {
+        unsigned int v = indices[i];
+        if (remapeamento[v] == semNovoIndice) {
+            remapeamento[v] = proximo;
+            std::memcpy(&reordenados[(size_t)proximo * componentes], &vertices[(size_t)v * componentes], componentes * sizeof(float));
+            proximo++;
+        }
+        indices[i] = remapeamento[v];
+    }
+
+    std::memcpy(vertices, reordenados.data(), (size_t)proximo * componentes * sizeof(float));
+    return proximo;
+}
+
+void otimizaMalha(MalhaIndexada& malha)
+{
+    size_t numVertices = malha.vertices.size() / malha.componentes;
+
+    otimizaCacheVertices(malha.indices.data(), malha.indices.size(), numVertices);
+    numVertices = otimizaBuscaVertices(malha.vertices.data(), malha.componentes, numVertices, malha.indices.data(), malha.indices.size());
+    malha.vertices.resize(numVertices * malha.componentes);
+}
+
+void geraMalhaGrade(MalhaIndexada& malha, unsigned int colunas, unsigned int linhas)
+{
+    malha.componentes = 3;
+    malha.vertices.clear();
+    malha.indices.clear();
+
+    // Grade no plano XY dentro do intervalo NDC (-1.0 a 1.0).
+    for (unsigned int y = 0; y <= linhas; y++) {
+        for (unsigned int x = 0; x <= colunas; x++) {
+            malha.vertices.push_back(-1.0f + 2.0f * (float)x / (float)colunas);
+            malha.vertices.push_back(-1.0f + 2.0f * (float)y / (float)linhas);
+            malha.vertices.push_back(0.0f);
+        }
+    }
+
+    // Dois triângulos por celula, linha por linha (ordem "ingênua").
+    for (unsigned int y = 0; y < linhas; y++) {
+        for (unsigned int x = 0; x < colunas; x++) {
+            unsigned int a = y * (colunas + 1) + x;
+            unsigned int b = a + 1;
+            unsigned int c = a + (colunas + 1);
+            unsigned int d = c + 1;
+
+            malha.indices.push_back(a); malha.indices.push_back(b); malha.indices.push_back(c);
+            malha.indices.push_back(b); malha.indices.push_back(d); malha.indices.push_back(c);
+        }
+    }
+}
+
+void geraMalhaEsfera(MalhaIndexada& malha, unsigned int fatias, unsigned int aneis)
+{
+    const float pi = 3.14159265358979f;
+
+    malha.componentes = 3;
+    malha.vertices.clear();
+    malha.indices.clear();
+
+    for (unsigned int a = 0; a <= aneis; a++) {
+        float phi = pi * (float)a / (float)aneis;
+        for (unsigned int f = 0; f <= fatias; f++) {
+            float theta = 2.0f * pi * (float)f / (float)fatias;
+            malha.vertices.push_back(std::sin(phi) * std::cos(theta));
+            malha.vertices.push_back(std::cos(phi));
+            malha.vertices.push_back(std::sin(phi) * std::sin(theta));
+        }
+    }
+
+    for (unsigned int a = 0; a < aneis; a++) {
+        for (unsigned int f = 0; f < fatias; f++) {
+            unsigned int v0 = a * (fatias + 1) + f;
+            unsigned int v1 = v0 + 1;
+            unsigned int v2 = v0 + (fatias + 1);
+            unsigned int v3 = v2 + 1;
+
+            malha.indices.push_back(v0); malha.indices.push_back(v2); malha.indices.push_back(v1);
+            malha.indices.push_back(v1); malha.indices.push_back(v2); malha.indices.push_back(v3);
+        }
+    }
+}
+
+void embaralhaTriangulos(unsigned int* indices, size_t numIndices, unsigned int semente)
+{
+    size_t numTriangulos = numIndices / 3;
+
+    // Fisher-Yates com um gerador linear simples (resultado igual em qualquer plataforma).
+    for (size_t t = numTriangulos; t > 1; t--) {
+        semente = semente * 1664525u + 1013904223u;
+        size_t outro = (semente >> 8) % t;
+        for (int k = 0; k < 3; k++) {
+            std::swap(indices[(t - 1) * 3 + k], indices[outro * 3 + k]);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Otimizações de malhas indexadas (Element Buffer Object - EBO).
+// A GPU guarda os ultimos vertices transformados num cache pequeno (post-transform cache),
+// entao a ordem dos indices decide quantas vezes o vertex shader roda para o mesmo vertice.
+
+#include <vector>
+#include <cstddef>
+
+// Tamanho de cache usado por padrão na otimização e na medição do ACMR.
+const unsigned int tamanhoCachePadrao = 32;
+
+// Malha com vertices intercalados e indices de triângulos.
+struct MalhaIndexada {
+    std::vector<float> vertices;         // "componentes" floats por vertice.
+    std::vector<unsigned int> indices;   // 3 indices por triângulo.
+    unsigned int componentes = 3;
+};
+
+// Calcula o ACMR (Average Cache Miss Ratio): vertices transformados por triângulo
+// simulando um cache FIFO com "tamanhoCache" entradas. 0.5 é o ideal numa grade, 3.0 é o pior caso.
+float calculaACMR(const unsigned int* indices, size_t numIndices, size_t numVertices, unsigned int tamanhoCache = tamanhoCachePadrao);
+
+// Reordena os triângulos para aproveitar o cache pós-transformação (algoritmo de Tom Forsyth).
+void otimizaCacheVertices(unsigned int* indices, size_t numIndices, size_t numVertices, unsigned int tamanhoCache = tamanhoCachePadrao);
+
+// Reordena os vertices na ordem em que são usados pelos indices (melhora a leitura do VBO).
+// Atualiza os indices e retorna o numero de vertices usados (vertices não referenciados são removidos).
+size_t otimizaBuscaVertices(float* vertices, unsigned int componentes, size_t numVertices, unsigned int* indices, size_t numIndices);
+
+// Aplica as duas otimizações acima numa malha.
+void otimizaMalha(MalhaIndexada& malha);
+
+// Malhas de teste para medir o ACMR.
+void geraMalhaGrade(MalhaIndexada& malha, unsigned int colunas, unsigned int linhas);
+void geraMalhaEsfera(MalhaIndexada& malha, unsigned int fatias, unsigned int aneis);
+
+// Embaralha a ordem dos triângulos (simula uma malha exportada sem cuidado).
+void embaralhaTriangulos(unsigned int* indices, size_t numIndices, unsigned int semente);
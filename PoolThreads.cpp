@@ -0,0 +1,138 @@
+#include "PoolThreads.h"
+
+PoolThreads::PoolThreads(unsigned int numThreads)
+    : restantes(0)
+{
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+        if (numThreads == 0) {
+            numThreads = 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++) {
+        filas.emplace_back(new FilaTarefas());
+    }
+
+    // A thread 0 é quem chama paraCada; as outras ficam esperando trabalho.
+    for (unsigned int i = 1; i < numThreads; i++) {
+        trabalhadores.emplace_back(&PoolThreads::executaTrabalhador, this, i);
+    }
+}
+
+PoolThreads::~PoolThreads()
+{
+    {
+        std::lock_guard<std::mutex> trava(travaGeral);
+        encerrando = true;
+    }
+    sinalInicio.notify_all();
+
+    for (std::thread& t : trabalhadores) {
+        t.join();
+    }
+}
+
+bool PoolThreads::pegaTarefa(unsigned int thread, unsigned int& tarefa)
+{
+    // Primeiro a propria fila, pelo fim (tarefas recentes, dados ainda no cache).
+    {
+        FilaTarefas& fila = *filas[thread];
+        std::lock_guard<std::mutex> trava(fila.trava);
+        if (!fila.tarefas.empty()) {
+            tarefa = fila.tarefas.back();
+            fila.tarefas.pop_back();
+            return true;
+        }
+    }
+
+    // Depois rouba do inicio das filas das outras threads.
+    unsigned int n = numThreads();
+    for (unsigned int i = 1; i < n; i++) {
+        FilaTarefas& vitima = *filas[(thread + i) % n];
+        std::lock_guard<std::mutex> trava(vitima.trava);
+        if (!vitima.tarefas.empty()) {
+            tarefa = vitima.tarefas.front();
+            vitima.tarefas.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PoolThreads::executaTarefas(unsigned int thread)
+{
+    unsigned int tarefa;
+    while (pegaTarefa(thread, tarefa)) {
+        (*funcaoAtual)(tarefa, thread);
+
+        // A ultima tarefa acorda quem chamou paraCada.
+        if (restantes.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> trava(travaGeral);
+            sinalFim.notify_all();
+        }
+    }
+}
+
+void PoolThreads::executaTrabalhador(unsigned int indice)
+{
+    uint64_t ultimaGeracao = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> trava(travaGeral);
+            sinalInicio.wait(trava, [&] { return encerrando || geracao != ultimaGeracao; });
+            if (encerrando) {
+                return;
+            }
+            ultimaGeracao = geracao;
+        }
+
+        executaTarefas(indice);
+    }
+}
+
+void PoolThreads::paraCada(unsigned int numTarefas, const std::function<void(unsigned int, unsigned int)>& funcao)
+{
+    if (numTarefas == 0) {
+        return;
+    }
+
+    // Sem outras threads: executa direto.
+    if (trabalhadores.empty()) {
+        for (unsigned int t = 0; t < numTarefas; t++) {
+            funcao(t, 0);
+        }
+        return;
+    }
+
+    funcaoAtual = &funcao;
+    restantes.store(numTarefas);
+
+    // Distribui as tarefas em blocos contiguos, um por thread.
+    unsigned int n = numThreads();
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int inicio = (unsigned int)((uint64_t)numTarefas * i / n);
+        unsigned int fim = (unsigned int)((uint64_t)numTarefas * (i + 1) / n);
+        FilaTarefas& fila = *filas[i];
+        std::lock_guard<std::mutex> trava(fila.trava);
+        // Empilhadas ao contrario: a thread dona tira do fim e executa em ordem crescente.
+        for (unsigned int t = fim; t > inicio; t--) {
+            fila.tarefas.push_back(t - 1);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> trava(travaGeral);
+        geracao++;
+    }
+    sinalInicio.notify_all();
+
+    // Quem chamou também trabalha, depois espera as tarefas roubadas terminarem.
+    executaTarefas(0);
+
+    std::unique_lock<std::mutex> trava(travaGeral);
+    sinalFim.wait(trava, [&] { return restantes.load() == 0; });
+    funcaoAtual = nullptr;
+}
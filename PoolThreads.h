@@ -0,0 +1,48 @@
+#pragma once
+
+// Pool de threads com roubo de trabalho (work stealing).
+// Cada thread tem sua propria fila de tarefas; quando a fila esvazia, ela rouba tarefas das outras.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PoolThreads {
+public:
+    // "numThreads" inclui a thread que chama paraCada (0 = numero de nucleos da maquina).
+    explicit PoolThreads(unsigned int numThreads = 0);
+    ~PoolThreads();
+
+    unsigned int numThreads() const { return (unsigned int)filas.size(); }
+
+    // Executa funcao(tarefa, thread) para cada tarefa em [0, numTarefas) e espera todas terminarem.
+    // "thread" vai de 0 a numThreads() - 1 e serve para indexar dados locais de cada thread.
+    void paraCada(unsigned int numTarefas, const std::function<void(unsigned int, unsigned int)>& funcao);
+
+private:
+    struct FilaTarefas {
+        std::mutex trava;
+        std::deque<unsigned int> tarefas;
+    };
+
+    void executaTrabalhador(unsigned int indice);
+    bool pegaTarefa(unsigned int thread, unsigned int& tarefa);
+    void executaTarefas(unsigned int thread);
+
+    std::vector<std::thread> trabalhadores;
+    std::vector<std::unique_ptr<FilaTarefas>> filas;
+
+    std::mutex travaGeral;
+    std::condition_variable sinalInicio;
+    std::condition_variable sinalFim;
+    const std::function<void(unsigned int, unsigned int)>* funcaoAtual = nullptr;
+    uint64_t geracao = 0;
+    std::atomic<unsigned int> restantes;
+    bool encerrando = false;
+};
@@ -0,0 +1,618 @@
+#include "RasterizadorCPU.h"
+#include "CoberturaSIMD.h"
+#include "ShaderLote.h"
+
+#include <cmath>
+#include <algorithm>
+
+void redimensionaFramebuffer(FramebufferCPU& framebuffer, int largura, int altura)
+{
+    framebuffer.largura = largura;
+    framebuffer.altura = altura;
+    framebuffer.cor.assign((size_t)largura * altura, 0);
+    framebuffer.profundidade.assign((size_t)largura * altura, 1.0f);
+
+    framebuffer.blocosX = (largura + tamanhoBlocoZ - 1) / tamanhoBlocoZ;
+    framebuffer.blocosY = (altura + tamanhoBlocoZ - 1) / tamanhoBlocoZ;
+    framebuffer.tilesX = (largura + tamanhoTileZ - 1) / tamanhoTileZ;
+    framebuffer.tilesY = (altura + tamanhoTileZ - 1) / tamanhoTileZ;
+    framebuffer.minimoBloco.assign((size_t)framebuffer.blocosX * framebuffer.blocosY, 1.0f);
+    framebuffer.maximoBloco.assign((size_t)framebuffer.blocosX * framebuffer.blocosY, 1.0f);
+    framebuffer.maximoTile.assign((size_t)framebuffer.tilesX * framebuffer.tilesY, 1.0f);
+}
+
+uint32_t empacotaCor(const float cor[4])
+{
+    uint32_t resultado = 0;
+    for (int c = 0; c < 4; c++) {
+        float v = cor[c];
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        resultado |= (uint32_t)(v * 255.0f + 0.5f) << (c * 8);
+    }
+    return resultado;
+}
+
+void limpaFramebuffer(FramebufferCPU& framebuffer, float r, float g, float b, float a, float profundidade)
+{
+    const float cor[4] = { r, g, b, a };
+    std::fill(framebuffer.cor.begin(), framebuffer.cor.end(), empacotaCor(cor));
+    std::fill(framebuffer.profundidade.begin(), framebuffer.profundidade.end(), profundidade);
+    std::fill(framebuffer.minimoBloco.begin(), framebuffer.minimoBloco.end(), profundidade);
+    std::fill(framebuffer.maximoBloco.begin(), framebuffer.maximoBloco.end(), profundidade);
+    std::fill(framebuffer.maximoTile.begin(), framebuffer.maximoTile.end(), profundidade);
+}
+
+// Distancia (com sinal) do vertice a cada plano: -fatorX * w <= x <= fatorX * w (o mesmo em y) e -w <= z <= w.
+static float distanciaPlano(const VerticeTransformado& v, int plano, const BandaGuarda& banda)
+{
+    const float* p = v.posicao;
+    switch (plano) {
+    case 0: return banda.fatorX * p[3] + p[0];
+    case 1: return banda.fatorX * p[3] - p[0];
+    case 2: return banda.fatorY * p[3] + p[1];
+    case 3: return banda.fatorY * p[3] - p[1];
+    case 4: return p[3] + p[2];
+    default: return p[3] - p[2];
+    }
+}
+
+BandaGuarda calculaBandaGuarda(int largura, int altura, bool habilitada)
+{
+    // NDC -f a f vai de (0.5 - f / 2) * largura a (0.5 + f / 2) * largura pixels.
+    BandaGuarda banda = { 1.0f, 1.0f };
+    if (habilitada) {
+        banda.fatorX = std::max(1.0f, 2.0f * limiteBandaGuarda / (float)largura - 1.0f);
+        banda.fatorY = std::max(1.0f, 2.0f * limiteBandaGuarda / (float)altura - 1.0f);
+    }
+    return banda;
+}
+
+static void interpolaVertice(const VerticeTransformado& a, const VerticeTransformado& b, float t, int numVaryings, VerticeTransformado& saida)
+{
+    for (int k = 0; k < 4; k++) {
+        saida.posicao[k] = a.posicao[k] + (b.posicao[k] - a.posicao[k]) * t;
+    }
+    for (int k = 0; k < numVaryings; k++) {
+        saida.varyings[k] = a.varyings[k] + (b.varyings[k] - a.varyings[k]) * t;
+    }
+}
+
+int recortaTriangulo(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c,
+                     int numVaryings, const BandaGuarda& banda, unsigned int planos, VerticeTransformado saida[][3])
+{
+    // Poligono recortado (Sutherland-Hodgman): cada plano pode adicionar um vertice.
+    VerticeTransformado poligonoA[9], poligonoB[9];
+    VerticeTransformado* entrada = poligonoA;
+    VerticeTransformado* resultado = poligonoB;
+    int numEntrada = 3;
+    entrada[0] = a;
+    entrada[1] = b;
+    entrada[2] = c;
+
+    for (int plano = 0; plano < 6 && numEntrada > 0; plano++) {
+        if (!(planos & (1u << plano))) {
+            continue;
+        }
+        int numResultado = 0;
+        for (int i = 0; i < numEntrada; i++) {
+            const VerticeTransformado& atual = entrada[i];
+            const VerticeTransformado& proximo = entrada[(i + 1) % numEntrada];
+            float dAtual = distanciaPlano(atual, plano, banda);
+            float dProximo = distanciaPlano(proximo, plano, banda);
+
+            if (dAtual >= 0.0f) {
+                resultado[numResultado++] = atual;
+            }
+            // A aresta cruza o plano: adiciona o ponto de intersecção. Interpola sempre do vertice de dentro
+            // para o de fora, assim os dois triangulos de uma aresta compartilhada (que a percorrem em
+            // sentidos opostos) geram exatamente o mesmo vertice, sem frestas nem pixels duplicados.
+            if ((dAtual >= 0.0f) != (dProximo >= 0.0f)) {
+                if (dAtual >= 0.0f) {
+                    interpolaVertice(atual, proximo, dAtual / (dAtual - dProximo), numVaryings, resultado[numResultado++]);
+                }
+                else {
+                    interpolaVertice(proximo, atual, dProximo / (dProximo - dAtual), numVaryings, resultado[numResultado++]);
+                }
+            }
+        }
+        std::swap(entrada, resultado);
+        numEntrada = numResultado;
+    }
+
+    // Triangula o poligono convexo em leque.
+    int numTriangulos = 0;
+    for (int i = 1; i + 1 < numEntrada; i++) {
+        saida[numTriangulos][0] = entrada[0];
+        saida[numTriangulos][1] = entrada[i];
+        saida[numTriangulos][2] = entrada[i + 1];
+        numTriangulos++;
+    }
+    return numTriangulos;
+}
+
+// Plano f(x, y) = p[0] * x + p[1] * y + p[2] que passa pelos valores f0, f1 e f2 nos 3 vertices.
+static void calculaPlano(const float x[3], const float y[3], const float f[3], float inverso2Area, float plano[3])
+{
+    float dx1 = x[1] - x[0], dy1 = y[1] - y[0];
+    float dx2 = x[2] - x[0], dy2 = y[2] - y[0];
+    float df1 = f[1] - f[0], df2 = f[2] - f[0];
+
+    plano[0] = (df1 * dy2 - df2 * dy1) * inverso2Area;
+    plano[1] = (df2 * dx1 - df1 * dx2) * inverso2Area;
+    plano[2] = f[0] - plano[0] * x[0] - plano[1] * y[0];
+}
+
+bool preparaTriangulo(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c,
+                      int numVaryings, int largura, int altura, TrianguloPreparado& triangulo, int margemSubpixel)
+{
+    const VerticeTransformado* v[3] = { &a, &b, &c };
+    const float escalaSubpixel = (float)(1 << bitsSubpixel);
+    int64_t X[3], Y[3];
+    float x[3], y[3], z[3], invW[3];
+
+    // Divisão de perspectiva e transformação de viewport (NDC -1.0 a 1.0 -> pixels), arredondada para
+    // 1/256 de pixel. Os planos dos atributos usam as mesmas posições arredondadas.
+    for (int i = 0; i < 3; i++) {
+        invW[i] = 1.0f / v[i]->posicao[3];
+        float xTela = (v[i]->posicao[0] * invW[i] * 0.5f + 0.5f) * (float)largura;
+        float yTela = (v[i]->posicao[1] * invW[i] * 0.5f + 0.5f) * (float)altura;
+        // Fora da banda de guarda (ou NaN) não cabe em 16.8: só acontece com vertices em w = 0.
+        if (!(std::fabs(xTela) <= 2.0f * limiteBandaGuarda && std::fabs(yTela) <= 2.0f * limiteBandaGuarda)) {
+            return false;
+        }
+        X[i] = std::lrint(xTela * escalaSubpixel);
+        Y[i] = std::lrint(yTela * escalaSubpixel);
+        x[i] = (float)X[i] / escalaSubpixel;
+        y[i] = (float)Y[i] / escalaSubpixel;
+        z[i] = v[i]->posicao[2] * invW[i] * 0.5f + 0.5f;
+    }
+
+    // Duas vezes a area com sinal (exata em ponto fixo); sentido horario é invertido para as arestas ficarem
+    // positivas dentro.
+    int64_t area2 = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+    if (area2 == 0) {
+        return false;
+    }
+    if (area2 < 0) {
+        std::swap(v[1], v[2]);
+        std::swap(X[1], X[2]);
+        std::swap(Y[1], Y[2]);
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        std::swap(invW[1], invW[2]);
+        area2 = -area2;
+    }
+
+    // Caixa envolvente limitada à tela (pixels cujo centro, ou uma amostra, pode estar dentro).
+    const int64_t meioPixel = 1 << (bitsSubpixel - 1);
+    int64_t minXf = std::min(X[0], std::min(X[1], X[2])) - margemSubpixel;
+    int64_t maxXf = std::max(X[0], std::max(X[1], X[2])) + margemSubpixel;
+    int64_t minYf = std::min(Y[0], std::min(Y[1], Y[2])) - margemSubpixel;
+    int64_t maxYf = std::max(Y[0], std::max(Y[1], Y[2])) + margemSubpixel;
+    triangulo.minX = (int)std::max<int64_t>(0, (minXf - meioPixel + (1 << bitsSubpixel) - 1) >> bitsSubpixel);
+    triangulo.minY = (int)std::max<int64_t>(0, (minYf - meioPixel + (1 << bitsSubpixel) - 1) >> bitsSubpixel);
+    triangulo.maxX = (int)std::min<int64_t>(largura - 1, (maxXf - meioPixel) >> bitsSubpixel);
+    triangulo.maxY = (int)std::min<int64_t>(altura - 1, (maxYf - meioPixel) >> bitsSubpixel);
+    if (triangulo.minX > triangulo.maxX || triangulo.minY > triangulo.maxY) {
+        return false;
+    }
+
+    // Arestas 0->1, 1->2 e 2->0: E = (Yi - Yj) * (Xc - Xi) + (Xj - Xi) * (Yc - Yi), com o centro do pixel
+    // Xc = 256 * px + 128. Separando os termos de px e py ficam só somas e multiplicações de inteiros.
+    for (int e = 0; e < 3; e++) {
+        int i = e;
+        int j = (e + 1) % 3;
+        int64_t A = Y[i] - Y[j];
+        int64_t B = X[j] - X[i];
+
+        // Aresta esquerda (desce) ou de topo (horizontal, andando para a esquerda): pixels sobre ela
+        // (E == 0) são do triângulo; nas outras o teste vira E > 0, ou seja, E - 1 >= 0.
+        bool topoEsquerda = (A > 0) || (A == 0 && B < 0);
+
+        triangulo.arestaA[e] = A << bitsSubpixel;
+        triangulo.arestaB[e] = B << bitsSubpixel;
+        triangulo.arestaC[e] = A * (meioPixel - X[i]) + B * (meioPixel - Y[i]) - (topoEsquerda ? 0 : 1);
+    }
+
+    // Planos dos atributos.
+    float inverso2Area = escalaSubpixel * escalaSubpixel / (float)area2;
+    calculaPlano(x, y, z, inverso2Area, triangulo.planoZ);
+    calculaPlano(x, y, invW, inverso2Area, triangulo.planoInvW);
+
+    triangulo.numVaryings = numVaryings;
+    for (int k = 0; k < numVaryings; k++) {
+        float f[3];
+        for (int i = 0; i < 3; i++) {
+            f[i] = v[i]->varyings[k] * invW[i];
+        }
+        calculaPlano(x, y, f, inverso2Area, triangulo.planoVaryings[k]);
+    }
+
+    return true;
+}
+
+// Valor da aresta no centro do pixel (px, py).
+static inline int64_t valorAresta(const TrianguloPreparado& triangulo, int e, int px, int py)
+{
+    return triangulo.arestaA[e] * px + triangulo.arestaB[e] * py + triangulo.arestaC[e];
+}
+
+// GL_LESS ou GL_LEQUAL.
+static inline bool passaProfundidade(float z, float atual, const EstadoRasterizacao& estado)
+{
+    return estado.profundidadeMenorIgual ? z <= atual : z < atual;
+}
+
+// Menor e maior z do triângulo nos centros dos pixels de [x0, x1] x [y0, y1].
+// O plano é avaliado com a mesma formula usada por pixel; como ela é monotona em x e em y,
+// os cantos dão limites exatos dos valores calculados nos pixels.
+static void limitesZ(const TrianguloPreparado& triangulo, int x0, int y0, int x1, int y1, float& zMin, float& zMax)
+{
+    const float* p = triangulo.planoZ;
+    float cx0 = (float)x0 + 0.5f, cx1 = (float)x1 + 0.5f;
+    float cy0 = (float)y0 + 0.5f, cy1 = (float)y1 + 0.5f;
+    float z00 = p[0] * cx0 + p[1] * cy0 + p[2];
+    float z10 = p[0] * cx1 + p[1] * cy0 + p[2];
+    float z01 = p[0] * cx0 + p[1] * cy1 + p[2];
+    float z11 = p[0] * cx1 + p[1] * cy1 + p[2];
+    zMin = std::min(std::min(z00, z10), std::min(z01, z11));
+    zMax = std::max(std::max(z00, z10), std::max(z01, z11));
+}
+
+// Recalcula o minimo e o maximo do bloco depois de escrever nele.
+static void atualizaBlocoZ(FramebufferCPU& framebuffer, int blocoX, int blocoY)
+{
+    int x0 = blocoX * tamanhoBlocoZ, x1 = std::min(x0 + tamanhoBlocoZ, framebuffer.largura);
+    int y0 = blocoY * tamanhoBlocoZ, y1 = std::min(y0 + tamanhoBlocoZ, framebuffer.altura);
+    float minimo = framebuffer.profundidade[(size_t)y0 * framebuffer.largura + x0];
+    float maximo = minimo;
+    for (int y = y0; y < y1; y++) {
+        const float* linha = &framebuffer.profundidade[(size_t)y * framebuffer.largura];
+        for (int x = x0; x < x1; x++) {
+            minimo = std::min(minimo, linha[x]);
+            maximo = std::max(maximo, linha[x]);
+        }
+    }
+    size_t bloco = (size_t)blocoY * framebuffer.blocosX + blocoX;
+    framebuffer.minimoBloco[bloco] = minimo;
+    framebuffer.maximoBloco[bloco] = maximo;
+}
+
+// O maximo do tile é o maior maximo dos seus blocos.
+static void atualizaTileZ(FramebufferCPU& framebuffer, int tileX, int tileY)
+{
+    const int blocosPorTile = tamanhoTileZ / tamanhoBlocoZ;
+    int bx0 = tileX * blocosPorTile, bx1 = std::min(bx0 + blocosPorTile, framebuffer.blocosX);
+    int by0 = tileY * blocosPorTile, by1 = std::min(by0 + blocosPorTile, framebuffer.blocosY);
+    float maximo = framebuffer.maximoBloco[(size_t)by0 * framebuffer.blocosX + bx0];
+    for (int by = by0; by < by1; by++) {
+        for (int bx = bx0; bx < bx1; bx++) {
+            maximo = std::max(maximo, framebuffer.maximoBloco[(size_t)by * framebuffer.blocosX + bx]);
+        }
+    }
+    framebuffer.maximoTile[(size_t)tileY * framebuffer.tilesX + tileX] = maximo;
+}
+
+// Sombreia os pixels da mascara do bloco com o fragment shader vetorizado, em lotes de 4x2 pixels.
+// Retorna verdadeiro se escreveu profundidade.
+static bool sombreiaBlocoLotes(const TrianguloPreparado& triangulo, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                               FramebufferCPU& framebuffer, int bx, int by, uint64_t mascara, bool testaPixels,
+                               uint64_t& fragmentos, uint64_t& testados)
+{
+    const float* planoZ = triangulo.planoZ;
+    const float* planoInvW = triangulo.planoInvW;
+    bool escreveZ = estado.testeProfundidade && estado.escreveProfundidade;
+    bool alterado = false;
+    LoteFragmentos lote;
+
+    for (int linha = 0; linha < 8; linha += 2) {
+        for (int coluna = 0; coluna < 8; coluna += 4) {
+            uint32_t vivos = 0;
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                int bit = (linha + linhaLane(l)) * 8 + coluna + colunaLane(l);
+                vivos |= (uint32_t)((mascara >> bit) & 1) << l;
+            }
+            if (vivos == 0) {
+                continue;
+            }
+
+            // Todas as lanes são interpoladas (as que estão fora do triângulo servem para as derivadas).
+            // Mesmas formulas do caminho de um pixel, então o resultado é igual.
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                lote.x.v[l] = (float)(bx + coluna + colunaLane(l)) + 0.5f;
+                lote.y.v[l] = (float)(by + linha + linhaLane(l)) + 0.5f;
+            }
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                lote.z.v[l] = planoZ[0] * lote.x.v[l] + planoZ[1] * lote.y.v[l] + planoZ[2];
+            }
+
+            size_t pixels[fragmentosPorLote];
+            uint32_t empacotadas[fragmentosPorLote];
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                if (!(vivos & (1u << l))) {
+                    continue;
+                }
+                testados++;
+                pixels[l] = (size_t)(by + linha + linhaLane(l)) * framebuffer.largura + bx + coluna + colunaLane(l);
+                if (testaPixels && !passaProfundidade(lote.z.v[l], framebuffer.profundidade[pixels[l]], estado)) {
+                    vivos &= ~(1u << l);
+                }
+            }
+            if (vivos == 0) {
+                continue;
+            }
+
+            if (estado.escreveCor) {
+                // Interpolação com correção de perspectiva: (varying/w) / (1/w).
+                FloatLote w;
+                for (int l = 0; l < fragmentosPorLote; l++) {
+                    w.v[l] = 1.0f / (planoInvW[0] * lote.x.v[l] + planoInvW[1] * lote.y.v[l] + planoInvW[2]);
+                }
+                for (int k = 0; k < triangulo.numVaryings; k++) {
+                    const float* p = triangulo.planoVaryings[k];
+                    for (int l = 0; l < fragmentosPorLote; l++) {
+                        lote.varyings[k].v[l] = (p[0] * lote.x.v[l] + p[1] * lote.y.v[l] + p[2]) * w.v[l];
+                    }
+                }
+
+                lote.vivos = vivos;
+                programa.fragmentLote(lote, programa.uniforms);
+
+                // empacotaCor das 8 lanes de uma vez.
+                const FloatLote* canais[4] = { &lote.cor.x, &lote.cor.y, &lote.cor.z, &lote.cor.w };
+                for (int l = 0; l < fragmentosPorLote; l++) {
+                    empacotadas[l] = 0;
+                }
+                for (int c = 0; c < 4; c++) {
+                    for (int l = 0; l < fragmentosPorLote; l++) {
+                        float v = canais[c]->v[l];
+                        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+                        empacotadas[l] |= (uint32_t)(v * 255.0f + 0.5f) << (c * 8);
+                    }
+                }
+            }
+
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                if (!(vivos & (1u << l))) {
+                    continue;
+                }
+                if (estado.escreveCor) {
+                    framebuffer.cor[pixels[l]] = empacotadas[l];
+                }
+                if (escreveZ) {
+                    framebuffer.profundidade[pixels[l]] = lote.z.v[l];
+                    alterado = true;
+                }
+                fragmentos++;
+            }
+        }
+    }
+
+    return alterado;
+}
+
+void rasterizaTriangulo(const TrianguloPreparado& triangulo, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                        FramebufferCPU& framebuffer, const RetanguloCPU& recorte, EstatisticasRasterizacao& estatisticas)
+{
+    int minX = std::max(triangulo.minX, recorte.x0);
+    int minY = std::max(triangulo.minY, recorte.y0);
+    int maxX = std::min(triangulo.maxX, recorte.x1 - 1);
+    int maxY = std::min(triangulo.maxY, recorte.y1 - 1);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    const int64_t* A = triangulo.arestaA;
+    const int64_t* B = triangulo.arestaB;
+    int numVaryings = triangulo.numVaryings;
+    bool usaHierarquia = estado.testeProfundidade && estado.hierarquiaZ;
+    bool escreveZ = estado.testeProfundidade && estado.escreveProfundidade;
+    uint64_t fragmentos = 0;
+    uint64_t testados = 0;
+
+    float varyings[maxVaryingsCPU];
+    float cor[4];
+
+    // Tiles de 64x64 da profundidade hierarquica: o triângulo inteiro atrás do maximo do tile é descartado.
+    for (int ty = minY / tamanhoTileZ; ty <= maxY / tamanhoTileZ; ty++) {
+        for (int tx = minX / tamanhoTileZ; tx <= maxX / tamanhoTileZ; tx++) {
+            int tMinX = std::max(minX, tx * tamanhoTileZ), tMaxX = std::min(maxX, tx * tamanhoTileZ + tamanhoTileZ - 1);
+            int tMinY = std::max(minY, ty * tamanhoTileZ), tMaxY = std::min(maxY, ty * tamanhoTileZ + tamanhoTileZ - 1);
+
+            if (usaHierarquia) {
+                float zMin, zMax;
+                limitesZ(triangulo, tMinX, tMinY, tMaxX, tMaxY, zMin, zMax);
+                if (!passaProfundidade(zMin, framebuffer.maximoTile[(size_t)ty * framebuffer.tilesX + tx], estado)) {
+                    estatisticas.tilesDescartadosZ++;
+                    continue;
+                }
+            }
+            bool tileAlterado = false;
+
+            // Blocos de 8x8 alinhados na tela. As arestas são inteiras e exatas, então o resultado não depende
+            // de onde o bloco começa (tiles dão o mesmo resultado da tela inteira). Como E é linear, o canto do
+            // bloco onde E é maximo decide se o bloco inteiro está fora, e o canto onde é minimo decide se está
+            // inteiro dentro.
+            for (int by = tMinY & ~7; by <= tMaxY; by += 8) {
+                for (int bx = tMinX & ~7; bx <= tMaxX; bx += 8) {
+                    bool fora = false;
+                    bool inteiro = true;
+                    for (int e = 0; e < 3; e++) {
+                        if (valorAresta(triangulo, e, bx + (A[e] > 0 ? 7 : 0), by + (B[e] > 0 ? 7 : 0)) < 0) {
+                            fora = true;
+                            break;
+                        }
+                        if (valorAresta(triangulo, e, bx + (A[e] > 0 ? 0 : 7), by + (B[e] > 0 ? 0 : 7)) < 0) {
+                            inteiro = false;
+                        }
+                    }
+                    if (fora) {
+                        continue;
+                    }
+
+                    // Bloco atrás do maximo: nenhum pixel passaria. Bloco na frente do minimo: todos passam.
+                    bool testaPixels = estado.testeProfundidade;
+                    size_t blocoZ = (size_t)(by / tamanhoBlocoZ) * framebuffer.blocosX + bx / tamanhoBlocoZ;
+                    if (usaHierarquia) {
+                        float zMin, zMax;
+                        limitesZ(triangulo, std::max(bx, tMinX), std::max(by, tMinY), std::min(bx + 7, tMaxX), std::min(by + 7, tMaxY), zMin, zMax);
+                        if (!passaProfundidade(zMin, framebuffer.maximoBloco[blocoZ], estado)) {
+                            estatisticas.blocosDescartadosZ++;
+                            continue;
+                        }
+                        testaPixels = !passaProfundidade(zMax, framebuffer.minimoBloco[blocoZ], estado);
+                    }
+
+                    uint64_t mascara = inteiro ? ~0ull : coberturaBloco8x8(triangulo, bx, by);
+                    mascara &= mascaraRetanguloBloco(bx, by, tMinX, tMinY, tMaxX, tMaxY);
+                    bool blocoAlterado = false;
+
+                    if (programa.fragmentLote != nullptr) {
+                        blocoAlterado = sombreiaBlocoLotes(triangulo, programa, estado, framebuffer, bx, by, mascara, testaPixels,
+                                                           fragmentos, testados);
+                    }
+                    else {
+                        while (mascara != 0) {
+                            int bit = primeiroBitLigado(mascara);
+                            mascara &= mascara - 1;
+                            testados++;
+
+                            int px = bx + (bit & 7);
+                            int py = by + (bit >> 3);
+                            float cx = (float)px + 0.5f;
+                            float cy = (float)py + 0.5f;
+                            size_t pixel = (size_t)py * framebuffer.largura + px;
+
+                            float z = triangulo.planoZ[0] * cx + triangulo.planoZ[1] * cy + triangulo.planoZ[2];
+                            if (testaPixels && !passaProfundidade(z, framebuffer.profundidade[pixel], estado)) {
+                                continue;
+                            }
+
+                            if (estado.escreveCor) {
+                                // Interpolação com correção de perspectiva: (varying/w) / (1/w).
+                                float w = 1.0f / (triangulo.planoInvW[0] * cx + triangulo.planoInvW[1] * cy + triangulo.planoInvW[2]);
+                                for (int k = 0; k < numVaryings; k++) {
+                                    const float* p = triangulo.planoVaryings[k];
+                                    varyings[k] = (p[0] * cx + p[1] * cy + p[2]) * w;
+                                }
+
+                                programa.fragment(varyings, programa.uniforms, cor);
+                                framebuffer.cor[pixel] = empacotaCor(cor);
+                            }
+                            if (escreveZ) {
+                                framebuffer.profundidade[pixel] = z;
+                                blocoAlterado = true;
+                            }
+                            fragmentos++;
+                        }
+                    }
+
+                    if (blocoAlterado) {
+                        atualizaBlocoZ(framebuffer, bx / tamanhoBlocoZ, by / tamanhoBlocoZ);
+                        tileAlterado = true;
+                    }
+                }
+            }
+
+            if (tileAlterado) {
+                atualizaTileZ(framebuffer, tx, ty);
+            }
+        }
+    }
+
+    estatisticas.fragmentos += fragmentos;
+    estatisticas.fragmentosTestados += testados;
+}
+
+unsigned int planosCruzados(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c,
+                            const BandaGuarda& banda)
+{
+    unsigned int planos = 0;
+    for (int plano = 0; plano < 6; plano++) {
+        if (distanciaPlano(a, plano, banda) < 0.0f || distanciaPlano(b, plano, banda) < 0.0f || distanciaPlano(c, plano, banda) < 0.0f) {
+            planos |= 1u << plano;
+        }
+    }
+    return planos;
+}
+
+bool trianguloForaVolume(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c)
+{
+    // Contra a tela (não a banda de guarda): o que está todo fora dela não aparece.
+    const BandaGuarda tela = { 1.0f, 1.0f };
+    for (int plano = 0; plano < 6; plano++) {
+        if (distanciaPlano(a, plano, tela) < 0.0f && distanciaPlano(b, plano, tela) < 0.0f && distanciaPlano(c, plano, tela) < 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void transformaVertices(const ProgramaCPU& programa, const float* vertices, unsigned int stride,
+                        const unsigned int* indices, unsigned int quantidade, VerticeTransformado* saida)
+{
+    if (programa.vertexLote) {
+        programa.vertexLote(vertices, stride, indices, quantidade, programa.uniforms, saida);
+        return;
+    }
+    for (unsigned int k = 0; k < quantidade; k++) {
+        size_t i = indices ? indices[k] : k;
+        programa.vertex(&vertices[i * stride], programa.uniforms, saida[k].posicao, saida[k].varyings);
+    }
+}
+
+void desenhaTriangulosCPU(FramebufferCPU& framebuffer, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                          const float* vertices, unsigned int stride, unsigned int numVertices,
+                          const unsigned int* indices, unsigned int numIndices,
+                          EstatisticasRasterizacao* estatisticas)
+{
+    EstatisticasRasterizacao locais;
+    if (estatisticas == nullptr) {
+        estatisticas = &locais;
+    }
+
+    // Vertex shader: uma vez por vertice do VBO.
+    std::vector<VerticeTransformado> transformados(numVertices);
+    transformaVertices(programa, vertices, stride, nullptr, numVertices, transformados.data());
+    estatisticas->invocacoesVertex += numVertices;
+
+    unsigned int numElementos = indices ? numIndices : numVertices;
+    RetanguloCPU telaInteira = { 0, 0, framebuffer.largura, framebuffer.altura };
+    BandaGuarda banda = calculaBandaGuarda(framebuffer.largura, framebuffer.altura, estado.bandaGuarda);
+    VerticeTransformado recortados[7][3];
+    TrianguloPreparado triangulo;
+
+    for (unsigned int i = 0; i + 2 < numElementos; i += 3) {
+        const VerticeTransformado& a = transformados[indices ? indices[i + 0] : i + 0];
+        const VerticeTransformado& b = transformados[indices ? indices[i + 1] : i + 1];
+        const VerticeTransformado& c = transformados[indices ? indices[i + 2] : i + 2];
+        estatisticas->triangulos++;
+
+        if (trianguloForaVolume(a, b, c)) {
+            estatisticas->triangulosDescartados++;
+            continue;
+        }
+
+        // Triângulo dentro da banda de guarda e entre perto e longe dispensa o recorte.
+        unsigned int planos = planosCruzados(a, b, c, banda);
+        if (planos == 0) {
+            if (preparaTriangulo(a, b, c, programa.numVaryings, framebuffer.largura, framebuffer.altura, triangulo)) {
+                rasterizaTriangulo(triangulo, programa, estado, framebuffer, telaInteira, *estatisticas);
+            }
+            else {
+                estatisticas->triangulosDescartados++;
+            }
+            continue;
+        }
+
+        estatisticas->triangulosRecortados++;
+        int numRecortados = recortaTriangulo(a, b, c, programa.numVaryings, banda, planos, recortados);
+        for (int t = 0; t < numRecortados; t++) {
+            if (preparaTriangulo(recortados[t][0], recortados[t][1], recortados[t][2], programa.numVaryings,
+                                 framebuffer.largura, framebuffer.altura, triangulo)) {
+                rasterizaTriangulo(triangulo, programa, estado, framebuffer, telaInteira, *estatisticas);
+            }
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+// Rasterizador em software (CPU): executa o mesmo pipeline do OpenGL (vertex shader, recorte,
+// rasterização e fragment shader) escrevendo num framebuffer em memoria. Usado onde não existe GPU.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Maximo de floats passados do vertex shader para o fragment shader ("out"/"in" do GLSL).
+const int maxVaryingsCPU = 8;
+
+// Lados (em pixels) dos blocos e dos tiles do buffer de profundidade hierarquico.
+const int tamanhoBlocoZ = 8;
+const int tamanhoTileZ = 64;
+
+// Vertices em ponto fixo 16.8 na tela: bits de fração (1/256 de pixel) e limite da banda de guarda em pixels.
+// Com coordenadas até 2^14 as equações das arestas cabem com folga em 64 bits.
+const int bitsSubpixel = 8;
+const float limiteBandaGuarda = 16384.0f;
+
+// MSAA 4x (RasterizadorMSAA.h): posição de cada amostra em 1/256 de pixel a partir do centro, na grade
+// rotacionada padrão das GPUs, e a maior distancia de uma amostra ao centro em x ou y.
+const int amostrasMSAA = 4;
+const int posicaoAmostraMSAA[amostrasMSAA][2] = { { -32, -96 }, { 96, -32 }, { -96, 32 }, { 32, 96 } };
+const int margemAmostrasMSAA = 96;
+
+// Framebuffer em memoria. A linha 0 é a de baixo, como no OpenGL (glReadPixels).
+struct FramebufferCPU {
+    int largura = 0;
+    int altura = 0;
+    std::vector<uint32_t> cor;           // RGBA8, R no byte menos significativo.
+    std::vector<float> profundidade;     // 0.0 (perto) a 1.0 (longe).
+
+    // Profundidade hierarquica: minimo e maximo de cada bloco de 8x8 e maximo de cada tile de 64x64.
+    // Um triângulo mais longe que o maximo de um tile ou bloco é descartado sem testar os pixels.
+    int blocosX = 0, blocosY = 0;
+    int tilesX = 0, tilesY = 0;
+    std::vector<float> minimoBloco;
+    std::vector<float> maximoBloco;
+    std::vector<float> maximoTile;
+};
+
+void redimensionaFramebuffer(FramebufferCPU& framebuffer, int largura, int altura);
+void limpaFramebuffer(FramebufferCPU& framebuffer, float r, float g, float b, float a, float profundidade = 1.0f);
+
+// Converte uma cor RGBA em float (0.0 a 1.0) para RGBA8.
+uint32_t empacotaCor(const float cor[4]);
+
+// Equivalentes em C++ dos shaders GLSL.
+// Vertex shader: lê os atributos do vertice e escreve gl_Position e as varyings.
+// Fragment shader: lê as varyings interpoladas e escreve FragColor.
+typedef void (*ShaderVerticeCPU)(const float* atributos, const void* uniforms, float* posicao, float* varyings);
+typedef void (*ShaderFragmentoCPU)(const float* varyings, const void* uniforms, float* cor);
+
+// Fragment shader vetorizado: sombreia 8 fragmentos de uma vez (ShaderLote.h).
+struct LoteFragmentos;
+typedef void (*ShaderFragmentoLoteCPU)(LoteFragmentos& lote, const void* uniforms);
+
+// Vertex shader em lote: transforma "quantidade" vertices de uma vez (ShaderLote.h e InterpretadorGLSL.h).
+// O vertice k é o indices[k] do VBO (com "indices" nulo, o vertice k); o resultado vai para saida[k].
+struct VerticeTransformado;
+typedef void (*ShaderVerticeLoteCPU)(const float* vertices, unsigned int stride, const unsigned int* indices,
+                                     unsigned int quantidade, const void* uniforms, VerticeTransformado* saida);
+
+struct ProgramaCPU {
+    ShaderVerticeCPU vertex = nullptr;
+    ShaderVerticeLoteCPU vertexLote = nullptr;       // Quando existe, é usado no lugar de "vertex".
+    ShaderFragmentoCPU fragment = nullptr;
+    ShaderFragmentoLoteCPU fragmentLote = nullptr;   // Quando existe, é usado no lugar de "fragment".
+    int numVaryings = 0;
+    const void* uniforms = nullptr;
+};
+
+// Estado fixo do pipeline (equivalente ao glEnable(GL_DEPTH_TEST) e glDepthMask).
+struct EstadoRasterizacao {
+    bool testeProfundidade = false;
+    bool escreveProfundidade = true;
+    bool profundidadeMenorIgual = false;  // GL_LEQUAL em vez de GL_LESS (passada de cor depois do pre-pass).
+    bool escreveCor = true;               // glColorMask; falso no pre-pass de profundidade.
+    bool hierarquiaZ = true;              // Descarta tiles e blocos pelo buffer de profundidade hierarquico.
+    bool bandaGuarda = true;              // Falso recorta em x e y tudo que sai da tela (para comparação).
+    bool multiAmostragem = false;         // Caixas envolventes e bins incluem as amostras do MSAA 4x.
+};
+
+// Contadores acumulados pelos desenhos.
+struct EstatisticasRasterizacao {
+    uint64_t triangulos = 0;              // Triângulos recebidos.
+    uint64_t invocacoesVertex = 0;        // Execuções do vertex shader.
+    uint64_t triangulosRecortados = 0;    // Triângulos que cruzaram perto/longe ou a banda de guarda.
+    uint64_t triangulosDescartados = 0;   // Fora da tela ou com area zero.
+    uint64_t fragmentos = 0;              // Fragmentos que passaram no teste de profundidade.
+    uint64_t fragmentosTestados = 0;      // Pixels cobertos que chegaram ao teste por pixel.
+    uint64_t tilesDescartadosZ = 0;       // Tiles de 64x64 descartados pela profundidade hierarquica.
+    uint64_t blocosDescartadosZ = 0;      // Blocos de 8x8 descartados pela profundidade hierarquica.
+};
+
+// Vertice depois do vertex shader (coordenadas de recorte + varyings).
+struct VerticeTransformado {
+    float posicao[4];
+    float varyings[maxVaryingsCPU];
+};
+
+// Retângulo de pixels [x0, x1) x [y0, y1) onde a rasterização pode escrever.
+struct RetanguloCPU {
+    int x0, y0, x1, y1;
+};
+
+// Triângulo pronto para rasterizar: equações das arestas e planos dos atributos em coordenadas de tela.
+struct TrianguloPreparado {
+    // Arestas calculadas dos vertices em 16.8: E(px, py) = A * px + B * py + C no centro do pixel (px, py).
+    // São inteiros exatos, então uma aresta compartilhada tem valores opostos nos dois triângulos (sem frestas
+    // nem pixels repetidos). A regra topo-esquerda já está em C: o pixel está dentro quando E >= 0.
+    int64_t arestaA[3], arestaB[3], arestaC[3];
+    float planoZ[3];                             // z(x, y) = p[0] * x + p[1] * y + p[2]
+    float planoInvW[3];                          // 1/w, para interpolação com correção de perspectiva.
+    float planoVaryings[maxVaryingsCPU][3];      // varying/w
+    int numVaryings;
+    int minX, minY, maxX, maxY;                  // Caixa envolvente em pixels (inclusiva).
+};
+
+// Desenha triângulos (GL_TRIANGLES) lendo vertices intercalados com "stride" floats por vertice.
+// Com "indices" nulo os vertices são lidos em sequência (como glDrawArrays).
+void desenhaTriangulosCPU(FramebufferCPU& framebuffer, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                          const float* vertices, unsigned int stride, unsigned int numVertices,
+                          const unsigned int* indices, unsigned int numIndices,
+                          EstatisticasRasterizacao* estatisticas = nullptr);
+
+// Banda de guarda em coordenadas de recorte: o vertice está dentro quando |x| <= fatorX * w e |y| <= fatorY * w.
+// Triângulos dentro dela só são recortados em perto e longe; o que sai da tela é descartado pela caixa envolvente.
+struct BandaGuarda {
+    float fatorX, fatorY;
+};
+
+// Banda de guarda do framebuffer (com "habilitada" falso é a propria tela).
+BandaGuarda calculaBandaGuarda(int largura, int altura, bool habilitada);
+
+// Etapas do pipeline, expostas para os estagios paralelos.
+// Executa o vertex shader nos vertices indices[0 .. quantidade) (com "indices" nulo, nos primeiros "quantidade").
+void transformaVertices(const ProgramaCPU& programa, const float* vertices, unsigned int stride,
+                        const unsigned int* indices, unsigned int quantidade, VerticeTransformado* saida);
+
+// Bits (1 << plano) dos planos cruzados: 0 a 3 são os lados da banda de guarda, 4 e 5 perto e longe.
+// Zero quando o triângulo pode ser preparado sem recorte.
+unsigned int planosCruzados(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c,
+                            const BandaGuarda& banda);
+
+// Verdadeiro se os 3 vertices estão fora do mesmo plano (triângulo invisivel).
+bool trianguloForaVolume(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c);
+
+// Recorta o triângulo nos "planos" indicados; retorna o numero de triângulos gerados em "saida" (até 7).
+int recortaTriangulo(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c,
+                     int numVaryings, const BandaGuarda& banda, unsigned int planos, VerticeTransformado saida[][3]);
+
+// Converte para coordenadas de tela, arredonda para 16.8 e monta as equações; retorna falso para triângulos
+// sem area (depois do arredondamento) ou fora da tela. A caixa envolvente inclui os pixels com algum ponto
+// a até "margemSubpixel" (1/256 de pixel) do centro dentro do triângulo (as amostras do MSAA).
+bool preparaTriangulo(const VerticeTransformado& a, const VerticeTransformado& b, const VerticeTransformado& c,
+                      int numVaryings, int largura, int altura, TrianguloPreparado& triangulo, int margemSubpixel = 0);
+
+// Rasteriza os pixels do triângulo dentro de "recorte", somando os fragmentos em "estatisticas".
+// O recorte deve ser alinhado aos tiles de 64x64 (ou a tela inteira) para threads diferentes
+// não atualizarem o mesmo tile da profundidade hierarquica.
+void rasterizaTriangulo(const TrianguloPreparado& triangulo, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                        FramebufferCPU& framebuffer, const RetanguloCPU& recorte, EstatisticasRasterizacao& estatisticas);
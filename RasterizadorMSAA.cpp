@@ -0,0 +1,569 @@
+#include "RasterizadorMSAA.h"
+#include "CoberturaSIMD.h"
+#include "ShaderLote.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Todos os pixels de cada tile apontam para o plano 0, constante em "profundidade".
+static void reiniciaProfundidade(FramebufferMSAA& framebuffer, float profundidade)
+{
+    std::fill(framebuffer.entradaProfundidade.begin(), framebuffer.entradaProfundidade.end(), 0);
+    for (int ty = 0; ty < framebuffer.tilesY; ty++) {
+        for (int tx = 0; tx < framebuffer.tilesX; tx++) {
+            ProfundidadeTile& tile = framebuffer.profundidadeTile[(size_t)ty * framebuffer.tilesX + tx];
+            uint32_t pixels = (uint32_t)(std::min(tamanhoTileZ, framebuffer.largura - tx * tamanhoTileZ) *
+                                         std::min(tamanhoTileZ, framebuffer.altura - ty * tamanhoTileZ));
+            tile.planos.assign({ 0.0f, 0.0f, profundidade });
+            tile.usos.assign(1, pixels);
+            tile.planosLivres.clear();
+            tile.amostras.clear();
+            tile.amostrasLivres.clear();
+        }
+    }
+}
+
+void redimensionaFramebufferMSAA(FramebufferMSAA& framebuffer, int largura, int altura)
+{
+    size_t numPixels = (size_t)largura * altura;
+    framebuffer.largura = largura;
+    framebuffer.altura = altura;
+    framebuffer.cor.assign(numPixels, 0);
+    framebuffer.entradaAmostras.assign(numPixels, pixelComprimido);
+    framebuffer.entradaProfundidade.assign(numPixels, 0);
+
+    framebuffer.blocosX = (largura + tamanhoBlocoZ - 1) / tamanhoBlocoZ;
+    framebuffer.blocosY = (altura + tamanhoBlocoZ - 1) / tamanhoBlocoZ;
+    framebuffer.maximoBloco.assign((size_t)framebuffer.blocosX * framebuffer.blocosY, 1.0f);
+
+    framebuffer.tilesX = (largura + tamanhoTileZ - 1) / tamanhoTileZ;
+    framebuffer.tilesY = (altura + tamanhoTileZ - 1) / tamanhoTileZ;
+    framebuffer.amostrasTile.assign((size_t)framebuffer.tilesX * framebuffer.tilesY, AmostrasTile());
+    framebuffer.profundidadeTile.assign((size_t)framebuffer.tilesX * framebuffer.tilesY, ProfundidadeTile());
+    reiniciaProfundidade(framebuffer, 1.0f);
+}
+
+void limpaFramebufferMSAA(FramebufferMSAA& framebuffer, float r, float g, float b, float a, float profundidade)
+{
+    const float cor[4] = { r, g, b, a };
+    std::fill(framebuffer.cor.begin(), framebuffer.cor.end(), empacotaCor(cor));
+    std::fill(framebuffer.entradaAmostras.begin(), framebuffer.entradaAmostras.end(), pixelComprimido);
+    reiniciaProfundidade(framebuffer, profundidade);
+    std::fill(framebuffer.maximoBloco.begin(), framebuffer.maximoBloco.end(), profundidade);
+    for (AmostrasTile& amostras : framebuffer.amostrasTile) {
+        amostras.cores.clear();
+        amostras.livres.clear();
+    }
+}
+
+size_t bytesCorMSAA(const FramebufferMSAA& framebuffer)
+{
+    size_t bytes = framebuffer.cor.size() * sizeof(uint32_t) + framebuffer.entradaAmostras.size() * sizeof(uint16_t);
+    for (const AmostrasTile& amostras : framebuffer.amostrasTile) {
+        bytes += amostras.cores.size() * sizeof(uint32_t) + amostras.livres.size() * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+size_t bytesProfundidadeMSAA(const FramebufferMSAA& framebuffer)
+{
+    size_t bytes = framebuffer.entradaProfundidade.size() * sizeof(uint16_t) + framebuffer.maximoBloco.size() * sizeof(float);
+    for (const ProfundidadeTile& tile : framebuffer.profundidadeTile) {
+        bytes += (tile.planos.size() + tile.amostras.size()) * sizeof(float) + tile.usos.size() * sizeof(uint32_t)
+               + (tile.planosLivres.size() + tile.amostrasLivres.size()) * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+size_t pixelsExpandidosMSAA(const FramebufferMSAA& framebuffer)
+{
+    return framebuffer.entradaAmostras.size()
+         - (size_t)std::count(framebuffer.entradaAmostras.begin(), framebuffer.entradaAmostras.end(), pixelComprimido);
+}
+
+size_t pixelsProfundidadeExpandidaMSAA(const FramebufferMSAA& framebuffer)
+{
+    return (size_t)std::count_if(framebuffer.entradaProfundidade.begin(), framebuffer.entradaProfundidade.end(),
+                                 [](uint16_t entrada) { return (entrada & profundidadeExpandida) != 0; });
+}
+
+// GL_LESS ou GL_LEQUAL.
+static inline bool passaProfundidade(float z, float atual, const EstadoRasterizacao& estado)
+{
+    return estado.profundidadeMenorIgual ? z <= atual : z < atual;
+}
+
+static inline AmostrasTile& amostrasDoPixel(FramebufferMSAA& framebuffer, int px, int py)
+{
+    return framebuffer.amostrasTile[(size_t)(py / tamanhoTileZ) * framebuffer.tilesX + px / tamanhoTileZ];
+}
+
+// Escreve "cor" nas amostras da "mascara". O pixel só é expandido quando as amostras ficam com cores diferentes,
+// e volta a ser comprimido quando as 4 ficam iguais.
+static void escreveAmostras(FramebufferMSAA& framebuffer, int px, int py, unsigned int mascara, uint32_t cor)
+{
+    size_t pixel = (size_t)py * framebuffer.largura + px;
+    uint16_t& entrada = framebuffer.entradaAmostras[pixel];
+
+    if (mascara == (1u << amostrasMSAA) - 1) {
+        framebuffer.cor[pixel] = cor;
+        if (entrada != pixelComprimido) {
+            amostrasDoPixel(framebuffer, px, py).livres.push_back(entrada);
+            entrada = pixelComprimido;
+        }
+        return;
+    }
+
+    AmostrasTile& amostras = amostrasDoPixel(framebuffer, px, py);
+    if (entrada == pixelComprimido) {
+        if (framebuffer.cor[pixel] == cor) {
+            return;
+        }
+        if (!amostras.livres.empty()) {
+            entrada = amostras.livres.back();
+            amostras.livres.pop_back();
+        }
+        else {
+            entrada = (uint16_t)(amostras.cores.size() / amostrasMSAA);
+            amostras.cores.resize(amostras.cores.size() + amostrasMSAA);
+        }
+        std::fill_n(&amostras.cores[(size_t)entrada * amostrasMSAA], amostrasMSAA, framebuffer.cor[pixel]);
+    }
+    uint32_t* cores = &amostras.cores[(size_t)entrada * amostrasMSAA];
+    bool iguais = true;
+    for (int s = 0; s < amostrasMSAA; s++) {
+        if (mascara & (1u << s)) {
+            cores[s] = cor;
+        }
+        iguais = iguais && cores[s] == cor;
+    }
+
+    // Triângulos vizinhos da mesma cor completaram o pixel.
+    if (iguais) {
+        framebuffer.cor[pixel] = cor;
+        amostras.livres.push_back(entrada);
+        entrada = pixelComprimido;
+    }
+}
+
+// Posição da amostra em pixels, relativa ao centro do pixel (exata: a divisão é por potencia de 2).
+static inline float deslocamentoAmostra(int amostra, int eixo)
+{
+    return (float)posicaoAmostraMSAA[amostra][eixo] / (float)(1 << bitsSubpixel);
+}
+
+static inline size_t tileDoPixel(const FramebufferMSAA& framebuffer, int px, int py)
+{
+    return (size_t)(py / tamanhoTileZ) * framebuffer.tilesX + px / tamanhoTileZ;
+}
+
+// Profundidade das 4 amostras do pixel (com a entrada dele no tile). Nos pixels comprimidos sai do plano
+// com as mesmas operações da rasterização, então o triângulo que escreveu o plano lê exatamente os mesmos valores.
+static inline void leProfundidades(const ProfundidadeTile& tile, uint16_t entrada, int px, int py, float z[amostrasMSAA])
+{
+    if (entrada & profundidadeExpandida) {
+        std::copy_n(&tile.amostras[(size_t)(entrada & ~profundidadeExpandida) * amostrasMSAA], amostrasMSAA, z);
+        return;
+    }
+    const float* plano = &tile.planos[(size_t)entrada * 3];
+    float cx = (float)px + 0.5f, cy = (float)py + 0.5f;
+    for (int s = 0; s < amostrasMSAA; s++) {
+        z[s] = plano[0] * (cx + deslocamentoAmostra(s, 0)) + plano[1] * (cy + deslocamentoAmostra(s, 1)) + plano[2];
+    }
+}
+
+static void liberaPlano(ProfundidadeTile& tile, uint16_t plano)
+{
+    if (--tile.usos[plano] == 0) {
+        tile.planosLivres.push_back(plano);
+    }
+}
+
+// Plano de profundidade do triângulo sendo rasterizado, alocado no tile na primeira vez que cobre um pixel inteiro.
+struct PlanoTriangulo {
+    const float* planoZ = nullptr;
+    size_t tile = SIZE_MAX;
+    uint16_t plano = 0;
+};
+
+// Escreve as profundidades "z" nas amostras da "mascara". Com as 4 amostras o pixel passa a apontar para o
+// plano do triângulo (e devolve as amostras, se estava expandido); com menos é expandido.
+static void escreveProfundidades(FramebufferMSAA& framebuffer, size_t indiceTile, int px, int py, unsigned int mascara,
+                                 const float z[amostrasMSAA], PlanoTriangulo& plano)
+{
+    ProfundidadeTile& tile = framebuffer.profundidadeTile[indiceTile];
+    uint16_t& entrada = framebuffer.entradaProfundidade[(size_t)py * framebuffer.largura + px];
+
+    if (mascara == (1u << amostrasMSAA) - 1) {
+        if (plano.tile != indiceTile) {
+            if (!tile.planosLivres.empty()) {
+                plano.plano = tile.planosLivres.back();
+                tile.planosLivres.pop_back();
+            }
+            else {
+                plano.plano = (uint16_t)tile.usos.size();
+                tile.usos.push_back(0);
+                tile.planos.resize(tile.planos.size() + 3);
+            }
+            std::copy_n(plano.planoZ, 3, &tile.planos[(size_t)plano.plano * 3]);
+            tile.usos[plano.plano] = 0;
+            plano.tile = indiceTile;
+        }
+        if (entrada & profundidadeExpandida) {
+            tile.amostrasLivres.push_back(entrada & ~profundidadeExpandida);
+        }
+        else {
+            liberaPlano(tile, entrada);
+        }
+        entrada = plano.plano;
+        tile.usos[plano.plano]++;
+        return;
+    }
+
+    if (!(entrada & profundidadeExpandida)) {
+        float atuais[amostrasMSAA];
+        leProfundidades(tile, entrada, px, py, atuais);
+        uint16_t nova;
+        if (!tile.amostrasLivres.empty()) {
+            nova = tile.amostrasLivres.back();
+            tile.amostrasLivres.pop_back();
+        }
+        else {
+            nova = (uint16_t)(tile.amostras.size() / amostrasMSAA);
+            tile.amostras.resize(tile.amostras.size() + amostrasMSAA);
+        }
+        std::copy_n(atuais, amostrasMSAA, &tile.amostras[(size_t)nova * amostrasMSAA]);
+        liberaPlano(tile, entrada);
+        entrada = nova | profundidadeExpandida;
+    }
+    float* amostras = &tile.amostras[(size_t)(entrada & ~profundidadeExpandida) * amostrasMSAA];
+    for (int s = 0; s < amostrasMSAA; s++) {
+        if (mascara & (1u << s)) {
+            amostras[s] = z[s];
+        }
+    }
+}
+
+// Recalcula o maximo de profundidade do bloco de 8x8 depois de escrever nele.
+static void atualizaBlocoMSAA(FramebufferMSAA& framebuffer, int blocoX, int blocoY)
+{
+    int x0 = blocoX * tamanhoBlocoZ, x1 = std::min(x0 + tamanhoBlocoZ, framebuffer.largura);
+    int y0 = blocoY * tamanhoBlocoZ, y1 = std::min(y0 + tamanhoBlocoZ, framebuffer.altura);
+    const ProfundidadeTile& tile = framebuffer.profundidadeTile[tileDoPixel(framebuffer, x0, y0)];
+    float maximo = 0.0f;
+    float z[amostrasMSAA];
+    for (int y = y0; y < y1; y++) {
+        const uint16_t* entradas = &framebuffer.entradaProfundidade[(size_t)y * framebuffer.largura];
+        for (int x = x0; x < x1; x++) {
+            leProfundidades(tile, entradas[x], x, y, z);
+            for (int s = 0; s < amostrasMSAA; s++) {
+                maximo = std::max(maximo, z[s]);
+            }
+        }
+    }
+    framebuffer.maximoBloco[(size_t)blocoY * framebuffer.blocosX + blocoX] = maximo;
+}
+
+// Fragment shader no centro dos pixels "vivos" do lote de 4x2 pixels com canto em (x0, y0).
+static void sombreiaLote(const TrianguloPreparado& triangulo, const ProgramaCPU& programa, int x0, int y0, uint32_t vivos,
+                         uint32_t cores[fragmentosPorLote])
+{
+    if (programa.fragmentLote != nullptr) {
+        LoteFragmentos lote;
+        for (int l = 0; l < fragmentosPorLote; l++) {
+            lote.x.v[l] = (float)(x0 + colunaLane(l)) + 0.5f;
+            lote.y.v[l] = (float)(y0 + linhaLane(l)) + 0.5f;
+            lote.z.v[l] = triangulo.planoZ[0] * lote.x.v[l] + triangulo.planoZ[1] * lote.y.v[l] + triangulo.planoZ[2];
+        }
+        FloatLote w;
+        for (int l = 0; l < fragmentosPorLote; l++) {
+            w.v[l] = 1.0f / (triangulo.planoInvW[0] * lote.x.v[l] + triangulo.planoInvW[1] * lote.y.v[l] + triangulo.planoInvW[2]);
+        }
+        for (int k = 0; k < triangulo.numVaryings; k++) {
+            const float* p = triangulo.planoVaryings[k];
+            for (int l = 0; l < fragmentosPorLote; l++) {
+                lote.varyings[k].v[l] = (p[0] * lote.x.v[l] + p[1] * lote.y.v[l] + p[2]) * w.v[l];
+            }
+        }
+
+        lote.vivos = vivos;
+        programa.fragmentLote(lote, programa.uniforms);
+        for (int l = 0; l < fragmentosPorLote; l++) {
+            const float cor[4] = { lote.cor.x.v[l], lote.cor.y.v[l], lote.cor.z.v[l], lote.cor.w.v[l] };
+            cores[l] = empacotaCor(cor);
+        }
+        return;
+    }
+
+    float varyings[maxVaryingsCPU];
+    float cor[4];
+    for (int l = 0; l < fragmentosPorLote; l++) {
+        if (!(vivos & (1u << l))) {
+            continue;
+        }
+        float cx = (float)(x0 + colunaLane(l)) + 0.5f;
+        float cy = (float)(y0 + linhaLane(l)) + 0.5f;
+        float w = 1.0f / (triangulo.planoInvW[0] * cx + triangulo.planoInvW[1] * cy + triangulo.planoInvW[2]);
+        for (int k = 0; k < triangulo.numVaryings; k++) {
+            const float* p = triangulo.planoVaryings[k];
+            varyings[k] = (p[0] * cx + p[1] * cy + p[2]) * w;
+        }
+        programa.fragment(varyings, programa.uniforms, cor);
+        cores[l] = empacotaCor(cor);
+    }
+}
+
+void rasterizaTrianguloMSAA(const TrianguloPreparado& triangulo, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                            FramebufferMSAA& framebuffer, const RetanguloCPU& recorte, EstatisticasRasterizacao& estatisticas)
+{
+    int minX = std::max(triangulo.minX, recorte.x0);
+    int minY = std::max(triangulo.minY, recorte.y0);
+    int maxX = std::min(triangulo.maxX, recorte.x1 - 1);
+    int maxY = std::min(triangulo.maxY, recorte.y1 - 1);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    const int64_t* A = triangulo.arestaA;
+    const int64_t* B = triangulo.arestaB;
+    const float* planoZ = triangulo.planoZ;
+    bool usaHierarquia = estado.testeProfundidade && estado.hierarquiaZ;
+    bool escreveZ = estado.testeProfundidade && estado.escreveProfundidade;
+    uint64_t fragmentos = 0;
+    uint64_t testados = 0;
+
+    // Arestas em cada amostra: as do centro deslocadas de (dx, dy)/256 pixel, ainda inteiras e exatas.
+    // "folga" é o quanto uma aresta pode crescer do centro do pixel até a amostra mais favoravel.
+    TrianguloPreparado amostras[amostrasMSAA];
+    float deslocamentoX[amostrasMSAA], deslocamentoY[amostrasMSAA];
+    for (int s = 0; s < amostrasMSAA; s++) {
+        amostras[s] = triangulo;
+        for (int e = 0; e < 3; e++) {
+            amostras[s].arestaC[e] += (A[e] >> bitsSubpixel) * posicaoAmostraMSAA[s][0] + (B[e] >> bitsSubpixel) * posicaoAmostraMSAA[s][1];
+        }
+        deslocamentoX[s] = deslocamentoAmostra(s, 0);
+        deslocamentoY[s] = deslocamentoAmostra(s, 1);
+    }
+    int64_t folga[3];
+    for (int e = 0; e < 3; e++) {
+        folga[e] = ((std::abs(A[e]) + std::abs(B[e])) >> bitsSubpixel) * margemAmostrasMSAA;
+    }
+    const float menorDeslocamento = -(float)margemAmostrasMSAA / (float)(1 << bitsSubpixel);
+    const float maiorDeslocamento = (float)margemAmostrasMSAA / (float)(1 << bitsSubpixel);
+    PlanoTriangulo plano;
+    plano.planoZ = planoZ;
+
+    for (int by = minY & ~7; by <= maxY; by += 8) {
+        for (int bx = minX & ~7; bx <= maxX; bx += 8) {
+            // Como no rasterizador sem MSAA, mas com a folga das amostras: o canto onde a aresta é maxima decide
+            // se o bloco está fora, e o canto onde é minima se todas as amostras estão dentro.
+            bool fora = false;
+            bool inteiro = true;
+            for (int e = 0; e < 3 && !fora; e++) {
+                int64_t maximo = A[e] * (bx + (A[e] > 0 ? 7 : 0)) + B[e] * (by + (B[e] > 0 ? 7 : 0)) + triangulo.arestaC[e];
+                int64_t minimo = A[e] * (bx + (A[e] > 0 ? 0 : 7)) + B[e] * (by + (B[e] > 0 ? 0 : 7)) + triangulo.arestaC[e];
+                fora = maximo + folga[e] < 0;
+                inteiro = inteiro && minimo - folga[e] >= 0;
+            }
+            if (fora) {
+                continue;
+            }
+
+            int x0 = std::max(bx, minX), x1 = std::min(bx + 7, maxX);
+            int y0 = std::max(by, minY), y1 = std::min(by + 7, maxY);
+            size_t blocoZ = (size_t)(by / tamanhoBlocoZ) * framebuffer.blocosX + bx / tamanhoBlocoZ;
+            if (usaHierarquia) {
+                // Menor z nas amostras do bloco: o plano nos cantos do retângulo que contém todas as amostras,
+                // com as mesmas operações usadas por amostra (a formula é monotona em x e em y).
+                float xs[2] = { ((float)x0 + 0.5f) + menorDeslocamento, ((float)x1 + 0.5f) + maiorDeslocamento };
+                float ys[2] = { ((float)y0 + 0.5f) + menorDeslocamento, ((float)y1 + 0.5f) + maiorDeslocamento };
+                float zMin = planoZ[0] * xs[planoZ[0] > 0.0f ? 0 : 1] + planoZ[1] * ys[planoZ[1] > 0.0f ? 0 : 1] + planoZ[2];
+                if (!passaProfundidade(zMin, framebuffer.maximoBloco[blocoZ], estado)) {
+                    estatisticas.blocosDescartadosZ++;
+                    continue;
+                }
+            }
+
+            // O bloco de 8x8 fica dentro de um tile de 64x64 das areas de amostras.
+            size_t indiceTile = tileDoPixel(framebuffer, bx, by);
+            const ProfundidadeTile& tileZ = framebuffer.profundidadeTile[indiceTile];
+
+            uint64_t retangulo = mascaraRetanguloBloco(bx, by, minX, minY, maxX, maxY);
+            uint64_t cobertura[amostrasMSAA];
+            uint64_t uniao = 0;
+            for (int s = 0; s < amostrasMSAA; s++) {
+                cobertura[s] = inteiro ? retangulo : coberturaBloco8x8(amostras[s], bx, by) & retangulo;
+                uniao |= cobertura[s];
+            }
+            if (uniao == 0) {
+                continue;
+            }
+            bool blocoAlterado = false;
+
+            // Lotes de 4x2 pixels: teste de profundidade por amostra, um fragment shader por pixel.
+            for (int linha = 0; linha < 8; linha += 2) {
+                for (int coluna = 0; coluna < 8; coluna += 4) {
+                    uint32_t vivos = 0;
+                    unsigned int mascaras[fragmentosPorLote];
+                    float z[fragmentosPorLote][amostrasMSAA];
+
+                    for (int l = 0; l < fragmentosPorLote; l++) {
+                        int bit = (linha + linhaLane(l)) * 8 + coluna + colunaLane(l);
+                        if (!((uniao >> bit) & 1)) {
+                            continue;
+                        }
+                        testados++;
+
+                        int px = bx + coluna + colunaLane(l);
+                        int py = by + linha + linhaLane(l);
+                        float cx = (float)px + 0.5f;
+                        float cy = (float)py + 0.5f;
+                        float atuais[amostrasMSAA];
+                        if (estado.testeProfundidade) {
+                            leProfundidades(tileZ, framebuffer.entradaProfundidade[(size_t)py * framebuffer.largura + px], px, py, atuais);
+                        }
+                        unsigned int mascara = 0;
+                        for (int s = 0; s < amostrasMSAA; s++) {
+                            if (!((cobertura[s] >> bit) & 1)) {
+                                continue;
+                            }
+                            z[l][s] = planoZ[0] * (cx + deslocamentoX[s]) + planoZ[1] * (cy + deslocamentoY[s]) + planoZ[2];
+                            if (!estado.testeProfundidade || passaProfundidade(z[l][s], atuais[s], estado)) {
+                                mascara |= 1u << s;
+                            }
+                        }
+                        if (mascara != 0) {
+                            mascaras[l] = mascara;
+                            vivos |= 1u << l;
+                        }
+                    }
+                    if (vivos == 0) {
+                        continue;
+                    }
+
+                    uint32_t cores[fragmentosPorLote];
+                    if (estado.escreveCor) {
+                        sombreiaLote(triangulo, programa, bx + coluna, by + linha, vivos, cores);
+                    }
+
+                    for (int l = 0; l < fragmentosPorLote; l++) {
+                        if (!(vivos & (1u << l))) {
+                            continue;
+                        }
+                        int px = bx + coluna + colunaLane(l);
+                        int py = by + linha + linhaLane(l);
+                        if (escreveZ) {
+                            escreveProfundidades(framebuffer, indiceTile, px, py, mascaras[l], z[l], plano);
+                            blocoAlterado = true;
+                        }
+                        if (estado.escreveCor) {
+                            escreveAmostras(framebuffer, px, py, mascaras[l], cores[l]);
+                        }
+                        fragmentos++;
+                    }
+                }
+            }
+
+            if (blocoAlterado) {
+                atualizaBlocoMSAA(framebuffer, bx / tamanhoBlocoZ, by / tamanhoBlocoZ);
+            }
+        }
+    }
+
+    estatisticas.fragmentos += fragmentos;
+    estatisticas.fragmentosTestados += testados;
+}
+
+void desenhaTriangulosTilesMSAA(FramebufferMSAA& framebuffer, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                                const float* vertices, unsigned int stride, unsigned int numVertices,
+                                const unsigned int* indices, unsigned int numIndices,
+                                PoolThreads& pool, BinsTiles& bins,
+                                EstatisticasRasterizacao* estatisticas)
+{
+    // Caixas envolventes e bins com as amostras fora do centro dos pixels.
+    EstadoRasterizacao estadoMSAA = estado;
+    estadoMSAA.multiAmostragem = true;
+    distribuiTriangulosTiles(framebuffer.largura, framebuffer.altura, programa, estadoMSAA, vertices, stride, numVertices,
+                             indices, numIndices, pool, bins, estatisticas);
+
+    // Os tiles da rasterização contêm tiles inteiros das areas de amostras, então cada area tem uma thread só.
+    bins.estatisticasPorThread.assign(pool.numThreads(), EstatisticasRasterizacao());
+    pool.paraCada((unsigned int)(bins.tilesX * bins.tilesY), [&](unsigned int tile, unsigned int thread) {
+        RetanguloCPU recorte = retanguloTile(bins, tile, framebuffer.largura, framebuffer.altura);
+        EstatisticasRasterizacao& locais = bins.estatisticasPorThread[thread];
+        for (uint32_t i = bins.inicioTile[tile]; i < bins.inicioTile[tile + 1]; i++) {
+            rasterizaTrianguloMSAA(*bins.listaTriangulos[i], programa, estadoMSAA, framebuffer, recorte, locais);
+        }
+    });
+
+    somaEstatisticasTiles(bins, estatisticas);
+}
+
+// Media das 4 amostras RGBA8, arredondada.
+static uint32_t mediaAmostras(const uint32_t* amostras)
+{
+    uint32_t resultado = 0;
+    for (int c = 0; c < 4; c++) {
+        uint32_t soma = 2;
+        for (int s = 0; s < amostrasMSAA; s++) {
+            soma += (amostras[s] >> (c * 8)) & 0xFF;
+        }
+        resultado |= (soma / amostrasMSAA) << (c * 8);
+    }
+    return resultado;
+}
+
+static const uint32_t* amostrasPixel(const FramebufferMSAA& framebuffer, size_t pixel)
+{
+    int px = (int)(pixel % framebuffer.largura);
+    int py = (int)(pixel / framebuffer.largura);
+    const AmostrasTile& amostras = framebuffer.amostrasTile[(size_t)(py / tamanhoTileZ) * framebuffer.tilesX + px / tamanhoTileZ];
+    return &amostras.cores[(size_t)framebuffer.entradaAmostras[pixel] * amostrasMSAA];
+}
+
+void resolveMSAA(const FramebufferMSAA& framebuffer, FramebufferCPU& destino)
+{
+    if (destino.largura != framebuffer.largura || destino.altura != framebuffer.altura) {
+        redimensionaFramebuffer(destino, framebuffer.largura, framebuffer.altura);
+    }
+
+    const uint32_t* cor = framebuffer.cor.data();
+    const uint16_t* entradas = framebuffer.entradaAmostras.data();
+    uint32_t* saida = destino.cor.data();
+    size_t numPixels = framebuffer.cor.size();
+    size_t p = 0;
+
+#if SIMD_X86
+    // SSE2 (presente em todo x86-64): 4 pixels comprimidos são copiados de uma vez; nos expandidos as
+    // 4 amostras são somadas em 16 bits por canal.
+    const __m128i comprimidos = _mm_set1_epi16((short)pixelComprimido);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i arredonda = _mm_set1_epi16(2);
+    for (; p + 4 <= numPixels; p += 4) {
+        __m128i entrada = _mm_loadl_epi64((const __m128i*)&entradas[p]);
+        if ((_mm_movemask_epi8(_mm_cmpeq_epi16(entrada, comprimidos)) & 0xFF) == 0xFF) {
+            _mm_storeu_si128((__m128i*)&saida[p], _mm_loadu_si128((const __m128i*)&cor[p]));
+            continue;
+        }
+        for (size_t q = p; q < p + 4; q++) {
+            if (entradas[q] == pixelComprimido) {
+                saida[q] = cor[q];
+                continue;
+            }
+            __m128i amostras = _mm_loadu_si128((const __m128i*)amostrasPixel(framebuffer, q));
+            __m128i soma = _mm_add_epi16(_mm_unpacklo_epi8(amostras, zero), _mm_unpackhi_epi8(amostras, zero));
+            soma = _mm_add_epi16(soma, _mm_srli_si128(soma, 8));
+            soma = _mm_srli_epi16(_mm_add_epi16(soma, arredonda), 2);
+            saida[q] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(soma, zero));
+        }
+    }
+#endif
+
+    for (; p < numPixels; p++) {
+        saida[p] = entradas[p] == pixelComprimido ? cor[p] : mediaAmostras(amostrasPixel(framebuffer, p));
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Multiamostragem (MSAA 4x) no rasterizador em software.
+// Cobertura e profundidade são calculadas em 4 amostras por pixel, mas o fragment shader roda uma vez
+// por pixel (no centro) e a cor vai para as amostras cobertas. A maioria dos pixels é coberta inteira por
+// um triângulo e guarda uma cor só (pixel comprimido); só os pixels de borda guardam as 4 cores, numa
+// area separada de cada tile. A profundidade é comprimida do mesmo jeito: o pixel coberto inteiro aponta
+// para o plano de profundidade do triângulo, guardado uma vez por tile, e só os de borda guardam as 4
+// profundidades. No fim do quadro o resolve tira a media das amostras.
+
+#include "RasterizadorCPU.h"
+#include "RasterizadorTiles.h"
+
+#include <cstdint>
+#include <vector>
+
+// Entrada de amostras dos pixels comprimidos.
+const uint16_t pixelComprimido = 0xFFFF;
+
+// Cores dos pixels expandidos de um tile de 64x64: 4 cores por entrada. Pixels que voltam a ser cobertos
+// inteiros devolvem a entrada para "livres", então um tile nunca passa de 4096 entradas.
+struct AmostrasTile {
+    std::vector<uint32_t> cores;
+    std::vector<uint16_t> livres;
+};
+
+// Bit da entrada de profundidade dos pixels expandidos (sem ele a entrada é o numero do plano).
+const uint16_t profundidadeExpandida = 0x8000;
+
+// Profundidade de um tile de 64x64: os planos z = a * x + b * y + c dos pixels comprimidos (com o numero de
+// pixels que usam cada plano) e as 4 profundidades dos pixels expandidos. Planos sem uso e entradas de
+// pixels que voltam a ser comprimidos vão para as listas de livres, então nenhum dos dois passa de 4096.
+struct ProfundidadeTile {
+    std::vector<float> planos;                // 3 por plano.
+    std::vector<uint32_t> usos;
+    std::vector<uint16_t> planosLivres;
+    std::vector<float> amostras;              // 4 por entrada.
+    std::vector<uint16_t> amostrasLivres;
+};
+
+struct FramebufferMSAA {
+    int largura = 0;
+    int altura = 0;
+    std::vector<uint32_t> cor;                // Cor das 4 amostras do pixel comprimido (RGBA8).
+    std::vector<uint16_t> entradaAmostras;    // Entrada do pixel nas AmostrasTile do tile dele, ou pixelComprimido.
+    std::vector<uint16_t> entradaProfundidade;    // Plano do pixel no ProfundidadeTile do tile dele, ou entrada das amostras.
+
+    // Maior profundidade das amostras de cada bloco de 8x8: blocos inteiros atrás dela são descartados.
+    int blocosX = 0, blocosY = 0;
+    std::vector<float> maximoBloco;
+
+    // Uma area de cores e uma de profundidade por tile de 64x64 da profundidade hierarquica (cada tile só
+    // é escrito por uma thread).
+    int tilesX = 0, tilesY = 0;
+    std::vector<AmostrasTile> amostrasTile;
+    std::vector<ProfundidadeTile> profundidadeTile;
+};
+
+void redimensionaFramebufferMSAA(FramebufferMSAA& framebuffer, int largura, int altura);
+void limpaFramebufferMSAA(FramebufferMSAA& framebuffer, float r, float g, float b, float a, float profundidade = 1.0f);
+
+// Bytes usados pelas cores e pela profundidade (comprimidas, entradas e expandidas em uso).
+size_t bytesCorMSAA(const FramebufferMSAA& framebuffer);
+size_t bytesProfundidadeMSAA(const FramebufferMSAA& framebuffer);
+
+// Pixels que guardam as 4 cores e pixels que guardam as 4 profundidades.
+size_t pixelsExpandidosMSAA(const FramebufferMSAA& framebuffer);
+size_t pixelsProfundidadeExpandidaMSAA(const FramebufferMSAA& framebuffer);
+
+// Rasteriza o triângulo (preparado com margemAmostrasMSAA) dentro de "recorte", alinhado aos tiles de 64x64.
+void rasterizaTrianguloMSAA(const TrianguloPreparado& triangulo, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                            FramebufferMSAA& framebuffer, const RetanguloCPU& recorte, EstatisticasRasterizacao& estatisticas);
+
+// Mesmo desenho do desenhaTriangulosTiles, no framebuffer com multiamostragem.
+void desenhaTriangulosTilesMSAA(FramebufferMSAA& framebuffer, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                                const float* vertices, unsigned int stride, unsigned int numVertices,
+                                const unsigned int* indices, unsigned int numIndices,
+                                PoolThreads& pool, BinsTiles& bins,
+                                EstatisticasRasterizacao* estatisticas = nullptr);
+
+// Resolve: media das amostras de cada pixel na cor de "destino" (redimensionado se preciso). SSE2 nos pixels
+// expandidos; os comprimidos são só copiados.
+void resolveMSAA(const FramebufferMSAA& framebuffer, FramebufferCPU& destino);
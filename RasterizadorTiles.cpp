@@ -0,0 +1,233 @@
+#include "RasterizadorTiles.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Triângulos por tarefa da frente.
+static const unsigned int triangulosPorTarefa = 512;
+
+static_assert(tamanhoTile % tamanhoTileZ == 0, "tiles da rasterização devem conter tiles inteiros da profundidade hierarquica");
+
+// Coloca o triângulo nos tiles da caixa envolvente que não estão inteiramente fora de alguma aresta.
+// Com "margemSubpixel" o teste vale para qualquer amostra a essa distancia do centro dos pixels.
+static void distribuiTriangulo(const TrianguloPreparado& triangulo, uint32_t indice, int tilesX, int margemSubpixel,
+                               BinsTiles::BlocoFrente& bloco)
+{
+    int tx0 = triangulo.minX / tamanhoTile;
+    int ty0 = triangulo.minY / tamanhoTile;
+    int tx1 = triangulo.maxX / tamanhoTile;
+    int ty1 = triangulo.maxY / tamanhoTile;
+    bool umTile = (tx0 == tx1 && ty0 == ty1);
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            if (!umTile) {
+                // Testa a aresta no pixel do tile mais "dentro" dela; se ainda for negativa, o tile é vazio.
+                bool fora = false;
+                for (int e = 0; e < 3 && !fora; e++) {
+                    int64_t A = triangulo.arestaA[e];
+                    int64_t B = triangulo.arestaB[e];
+                    int px = tx * tamanhoTile + (A > 0 ? tamanhoTile - 1 : 0);
+                    int py = ty * tamanhoTile + (B > 0 ? tamanhoTile - 1 : 0);
+                    int64_t folga = ((std::abs(A) + std::abs(B)) >> bitsSubpixel) * margemSubpixel;
+                    fora = A * px + B * py + triangulo.arestaC[e] + folga < 0;
+                }
+                if (fora) {
+                    continue;
+                }
+            }
+
+            uint32_t tile = (uint32_t)(ty * tilesX + tx);
+            bloco.tilesDosPares.push_back(tile);
+            bloco.triangulosDosPares.push_back(indice);
+            bloco.contagemPorTile[tile]++;
+        }
+    }
+}
+
+void distribuiTriangulosTiles(int largura, int altura, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                              const float* vertices, unsigned int stride, unsigned int numVertices,
+                              const unsigned int* indices, unsigned int numIndices,
+                              PoolThreads& pool, BinsTiles& bins,
+                              EstatisticasRasterizacao* estatisticas)
+{
+    bins.tilesX = (largura + tamanhoTile - 1) / tamanhoTile;
+    bins.tilesY = (altura + tamanhoTile - 1) / tamanhoTile;
+    unsigned int numTiles = (unsigned int)(bins.tilesX * bins.tilesY);
+    BandaGuarda banda = calculaBandaGuarda(largura, altura, estado.bandaGuarda);
+    int margemSubpixel = estado.multiAmostragem ? margemAmostrasMSAA : 0;
+
+    // 1. Vertex shader, recorte, preparação e distribuição nos tiles, em blocos contiguos de triângulos
+    // (mantem a ordem de envio).
+    unsigned int numElementos = indices ? numIndices : numVertices;
+    unsigned int numTriangulos = numElementos / 3;
+    unsigned int numBlocos = (numTriangulos + triangulosPorTarefa - 1) / triangulosPorTarefa;
+    if (bins.blocos.size() < numBlocos) {
+        bins.blocos.resize(numBlocos);
+    }
+
+    pool.paraCada(numBlocos, [&](unsigned int tarefa, unsigned int) {
+        BinsTiles::BlocoFrente& bloco = bins.blocos[tarefa];
+        bloco.triangulos.clear();
+        bloco.tilesDosPares.clear();
+        bloco.triangulosDosPares.clear();
+        bloco.contagemPorTile.assign(numTiles, 0);
+        bloco.estatisticas = EstatisticasRasterizacao();
+
+        VerticeTransformado recortados[7][3];
+        unsigned int primeiro = tarefa * triangulosPorTarefa;
+        unsigned int fim = std::min(numTriangulos, (tarefa + 1) * triangulosPorTarefa);
+        unsigned int numCantos = (fim - primeiro) * 3;
+
+        // Vertex shader só nos vertices que faltaram no cache; o bloco guarda uma copia de cada um, então
+        // um vertice que sai do cache e volta é transformado de novo (como na GPU).
+        if (indices) {
+            uint32_t indiceEntrada[tamanhoCacheTransformados];
+            uint32_t posicaoEntrada[tamanhoCacheTransformados];
+            std::fill(indiceEntrada, indiceEntrada + tamanhoCacheTransformados, UINT32_MAX);
+
+            bloco.indicesVertices.clear();
+            bloco.cantos.resize(numCantos);
+            for (unsigned int k = 0; k < numCantos; k++) {
+                unsigned int indice = indices[primeiro * 3 + k];
+                unsigned int entrada = indice % tamanhoCacheTransformados;
+                if (indiceEntrada[entrada] != indice) {
+                    indiceEntrada[entrada] = indice;
+                    posicaoEntrada[entrada] = (uint32_t)bloco.indicesVertices.size();
+                    bloco.indicesVertices.push_back(indice);
+                }
+                bloco.cantos[k] = posicaoEntrada[entrada];
+            }
+
+            bloco.vertices.resize(bloco.indicesVertices.size());
+            transformaVertices(programa, vertices, stride, bloco.indicesVertices.data(), (unsigned int)bloco.indicesVertices.size(), bloco.vertices.data());
+            bloco.estatisticas.invocacoesVertex += bloco.indicesVertices.size();
+        }
+        else {
+            // Sem indices cada canto é um vertice diferente.
+            bloco.vertices.resize(numCantos);
+            transformaVertices(programa, &vertices[(size_t)primeiro * 3 * stride], stride, nullptr, numCantos, bloco.vertices.data());
+            bloco.estatisticas.invocacoesVertex += numCantos;
+        }
+
+        for (unsigned int t = primeiro; t < fim; t++) {
+            unsigned int i = (t - primeiro) * 3;
+            const VerticeTransformado& a = bloco.vertices[indices ? bloco.cantos[i + 0] : i + 0];
+            const VerticeTransformado& b = bloco.vertices[indices ? bloco.cantos[i + 1] : i + 1];
+            const VerticeTransformado& c = bloco.vertices[indices ? bloco.cantos[i + 2] : i + 2];
+            bloco.estatisticas.triangulos++;
+
+            if (trianguloForaVolume(a, b, c)) {
+                bloco.estatisticas.triangulosDescartados++;
+                continue;
+            }
+
+            int numRecortados = 1;
+            const VerticeTransformado* v[7][3] = { { &a, &b, &c } };
+            unsigned int planos = planosCruzados(a, b, c, banda);
+            if (planos != 0) {
+                bloco.estatisticas.triangulosRecortados++;
+                numRecortados = recortaTriangulo(a, b, c, programa.numVaryings, banda, planos, recortados);
+                for (int r = 0; r < numRecortados; r++) {
+                    v[r][0] = &recortados[r][0];
+                    v[r][1] = &recortados[r][1];
+                    v[r][2] = &recortados[r][2];
+                }
+            }
+
+            for (int r = 0; r < numRecortados; r++) {
+                TrianguloPreparado triangulo;
+                if (!preparaTriangulo(*v[r][0], *v[r][1], *v[r][2], programa.numVaryings, largura, altura, triangulo, margemSubpixel)) {
+                    bloco.estatisticas.triangulosDescartados++;
+                    continue;
+                }
+                bloco.triangulos.push_back(triangulo);
+            }
+        }
+
+        // Os indices só são distribuidos depois que o vetor de triângulos parou de crescer.
+        for (size_t t = 0; t < bloco.triangulos.size(); t++) {
+            distribuiTriangulo(bloco.triangulos[t], (uint32_t)t, bins.tilesX, margemSubpixel, bloco);
+        }
+    });
+
+    // 2. Posição de cada bloco dentro da lista de cada tile (tile maior, bloco menor: ordem de envio preservada).
+    bins.inicioTile.assign(numTiles + 1, 0);
+    uint32_t total = 0;
+    for (unsigned int tile = 0; tile < numTiles; tile++) {
+        bins.inicioTile[tile] = total;
+        for (unsigned int b = 0; b < numBlocos; b++) {
+            uint32_t contagem = bins.blocos[b].contagemPorTile[tile];
+            bins.blocos[b].contagemPorTile[tile] = total;
+            total += contagem;
+        }
+    }
+    bins.inicioTile[numTiles] = total;
+    bins.listaTriangulos.resize(total);
+
+    pool.paraCada(numBlocos, [&](unsigned int tarefa, unsigned int) {
+        BinsTiles::BlocoFrente& bloco = bins.blocos[tarefa];
+        for (size_t p = 0; p < bloco.tilesDosPares.size(); p++) {
+            uint32_t destino = bloco.contagemPorTile[bloco.tilesDosPares[p]]++;
+            bins.listaTriangulos[destino] = &bloco.triangulos[bloco.triangulosDosPares[p]];
+        }
+    });
+
+    if (estatisticas) {
+        for (unsigned int b = 0; b < numBlocos; b++) {
+            const EstatisticasRasterizacao& e = bins.blocos[b].estatisticas;
+            estatisticas->triangulos += e.triangulos;
+            estatisticas->invocacoesVertex += e.invocacoesVertex;
+            estatisticas->triangulosRecortados += e.triangulosRecortados;
+            estatisticas->triangulosDescartados += e.triangulosDescartados;
+        }
+    }
+}
+
+RetanguloCPU retanguloTile(const BinsTiles& bins, unsigned int tile, int largura, int altura)
+{
+    int tx = (int)(tile % bins.tilesX);
+    int ty = (int)(tile / bins.tilesX);
+    RetanguloCPU retangulo = {
+        tx * tamanhoTile, ty * tamanhoTile,
+        std::min((tx + 1) * tamanhoTile, largura), std::min((ty + 1) * tamanhoTile, altura)
+    };
+    return retangulo;
+}
+
+void somaEstatisticasTiles(const BinsTiles& bins, EstatisticasRasterizacao* estatisticas)
+{
+    if (estatisticas == nullptr) {
+        return;
+    }
+    for (const EstatisticasRasterizacao& e : bins.estatisticasPorThread) {
+        estatisticas->fragmentos += e.fragmentos;
+        estatisticas->fragmentosTestados += e.fragmentosTestados;
+        estatisticas->tilesDescartadosZ += e.tilesDescartadosZ;
+        estatisticas->blocosDescartadosZ += e.blocosDescartadosZ;
+    }
+}
+
+void desenhaTriangulosTiles(FramebufferCPU& framebuffer, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                            const float* vertices, unsigned int stride, unsigned int numVertices,
+                            const unsigned int* indices, unsigned int numIndices,
+                            PoolThreads& pool, BinsTiles& bins,
+                            EstatisticasRasterizacao* estatisticas)
+{
+    distribuiTriangulosTiles(framebuffer.largura, framebuffer.altura, programa, estado, vertices, stride, numVertices,
+                             indices, numIndices, pool, bins, estatisticas);
+
+    // 3. Rasterização: um tile por tarefa; as threads livres roubam os tiles que sobraram.
+    // Os tiles do framebuffer são multiplos dos tiles da profundidade hierarquica, então cada thread
+    // só atualiza a hierarquia dentro do proprio tile.
+    bins.estatisticasPorThread.assign(pool.numThreads(), EstatisticasRasterizacao());
+    pool.paraCada((unsigned int)(bins.tilesX * bins.tilesY), [&](unsigned int tile, unsigned int thread) {
+        RetanguloCPU recorte = retanguloTile(bins, tile, framebuffer.largura, framebuffer.altura);
+        EstatisticasRasterizacao& locais = bins.estatisticasPorThread[thread];
+        for (uint32_t i = bins.inicioTile[tile]; i < bins.inicioTile[tile + 1]; i++) {
+            rasterizaTriangulo(*bins.listaTriangulos[i], programa, estado, framebuffer, recorte, locais);
+        }
+    });
+
+    somaEstatisticasTiles(bins, estatisticas);
+}
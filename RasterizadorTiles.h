@@ -0,0 +1,65 @@
+#pragma once
+
+// Rasterização em tiles com varias threads.
+// Frente: vertex shader e preparação dos triângulos em paralelo, em blocos contiguos de triângulos; cada
+// triângulo é colocado na lista (bin) de cada tile de 64x64 pixels que ele toca.
+// Cada bloco só transforma os vertices que seus triângulos usam, procurando os indices num cache de
+// vertices transformados de mapeamento direto (como o post-transform cache da GPU).
+// Fundo: cada tile é rasterizado inteiro por uma unica thread, então o framebuffer não precisa de travas.
+
+#include "RasterizadorCPU.h"
+#include "PoolThreads.h"
+
+#include <vector>
+
+// Lado do tile em pixels.
+const int tamanhoTile = 64;
+
+// Entradas do cache de vertices transformados (o indice i fica na entrada i % tamanhoCacheTransformados).
+const unsigned int tamanhoCacheTransformados = 32;
+
+// Memoria reaproveitada entre desenhos (evita alocar a cada quadro).
+struct BinsTiles {
+    int tilesX = 0;
+    int tilesY = 0;
+
+    // Um bloco por tarefa da frente: vertices transformados, triângulos preparados e pares (tile, triângulo) gerados.
+    struct BlocoFrente {
+        std::vector<unsigned int> indicesVertices;      // Vertices do VBO que faltaram no cache, na ordem da transformação.
+        std::vector<uint32_t> cantos;                   // Posição em "vertices" de cada canto dos triângulos do bloco.
+        std::vector<VerticeTransformado> vertices;
+        std::vector<TrianguloPreparado> triangulos;
+        std::vector<uint32_t> tilesDosPares;
+        std::vector<uint32_t> triangulosDosPares;
+        std::vector<uint32_t> contagemPorTile;
+        EstatisticasRasterizacao estatisticas;
+    };
+    std::vector<BlocoFrente> blocos;
+
+    // Listas finais: triângulos do tile t em listaTriangulos[inicioTile[t] .. inicioTile[t + 1]).
+    std::vector<uint32_t> inicioTile;
+    std::vector<const TrianguloPreparado*> listaTriangulos;
+
+    std::vector<EstatisticasRasterizacao> estatisticasPorThread;
+};
+
+// Mesmo resultado do desenhaTriangulosCPU, usando todas as threads do pool.
+void desenhaTriangulosTiles(FramebufferCPU& framebuffer, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                            const float* vertices, unsigned int stride, unsigned int numVertices,
+                            const unsigned int* indices, unsigned int numIndices,
+                            PoolThreads& pool, BinsTiles& bins,
+                            EstatisticasRasterizacao* estatisticas = nullptr);
+
+// Só a frente (passos 1 e 2): vertex shader, recorte, preparação e bins, somando as estatisticas da frente.
+// Usada pelos rasterizadores que percorrem os bins por conta propria (RasterizadorMSAA.h).
+void distribuiTriangulosTiles(int largura, int altura, const ProgramaCPU& programa, const EstadoRasterizacao& estado,
+                              const float* vertices, unsigned int stride, unsigned int numVertices,
+                              const unsigned int* indices, unsigned int numIndices,
+                              PoolThreads& pool, BinsTiles& bins,
+                              EstatisticasRasterizacao* estatisticas = nullptr);
+
+// Pixels do tile (os da borda direita e de cima podem ser menores).
+RetanguloCPU retanguloTile(const BinsTiles& bins, unsigned int tile, int largura, int altura);
+
+// Soma em "estatisticas" os contadores da rasterização de cada thread (bins.estatisticasPorThread).
+void somaEstatisticasTiles(const BinsTiles& bins, EstatisticasRasterizacao* estatisticas);
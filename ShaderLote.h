@@ -0,0 +1,171 @@
+#pragma once
+
+// Shaders vetorizados para o rasterizador em software.
+// Os fragmentos são sombreados em lotes de 8 (dois quads de 2x2 pixels) e os vertices em lotes de 8
+// vertices, guardados como estrutura de arrays: cada valor do shader é um FloatLote com um float por
+// lane. As operações são laços fixos de 8 floats alinhados, que o compilador transforma em instruções SSE/AVX.
+
+#include "RasterizadorCPU.h"
+
+#include <cmath>
+#include <cstdint>
+
+const int fragmentosPorLote = 8;
+
+// Posição de cada lane no retângulo de 4x2 pixels do lote: lanes 0-3 são o quad da esquerda e 4-7 o da
+// direita; dentro do quad o bit 0 é a coluna e o bit 1 a linha (como a GPU agrupa os pixels).
+inline int colunaLane(int lane) { return (lane >> 2) * 2 + (lane & 1); }
+inline int linhaLane(int lane) { return (lane >> 1) & 1; }
+
+// Um float por fragmento do lote.
+struct alignas(32) FloatLote {
+    float v[fragmentosPorLote];
+};
+
+// O mesmo valor em todos os fragmentos (uniform ou constante).
+inline FloatLote espalha(float valor)
+{
+    FloatLote r;
+    for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = valor;
+    return r;
+}
+
+inline FloatLote operator+(const FloatLote& a, const FloatLote& b) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a.v[i] + b.v[i]; return r; }
+inline FloatLote operator-(const FloatLote& a, const FloatLote& b) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a.v[i] - b.v[i]; return r; }
+inline FloatLote operator*(const FloatLote& a, const FloatLote& b) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a.v[i] * b.v[i]; return r; }
+inline FloatLote operator/(const FloatLote& a, const FloatLote& b) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a.v[i] / b.v[i]; return r; }
+inline FloatLote operator+(const FloatLote& a, float b) { return a + espalha(b); }
+inline FloatLote operator-(const FloatLote& a, float b) { return a - espalha(b); }
+inline FloatLote operator*(const FloatLote& a, float b) { return a * espalha(b); }
+inline FloatLote operator*(float a, const FloatLote& b) { return espalha(a) * b; }
+inline FloatLote operator-(const FloatLote& a) { return espalha(0.0f) - a; }
+
+// Funções do GLSL (min, max, clamp, mix, sqrt, pow) com nomes em português para não colidir com a std.
+inline FloatLote minimo(const FloatLote& a, const FloatLote& b) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+inline FloatLote maximo(const FloatLote& a, const FloatLote& b) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+inline FloatLote limita(const FloatLote& a, float menor, float maior) { return minimo(maximo(a, espalha(menor)), espalha(maior)); }
+inline FloatLote mistura(const FloatLote& a, const FloatLote& b, const FloatLote& t) { return a + (b - a) * t; }
+inline FloatLote raiz(const FloatLote& a) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::sqrt(a.v[i]); return r; }
+inline FloatLote potencia(const FloatLote& a, float expoente) { FloatLote r; for (int i = 0; i < fragmentosPorLote; i++) r.v[i] = std::pow(a.v[i], expoente); return r; }
+
+// pow com expoente inteiro por quadrados sucessivos (vetoriza, ao contrario do std::pow).
+inline FloatLote potenciaInteira(const FloatLote& base, unsigned int expoente)
+{
+    FloatLote a = base;
+    FloatLote r = espalha(1.0f);
+    while (expoente != 0) {
+        if (expoente & 1) r = r * a;
+        a = a * a;
+        expoente >>= 1;
+    }
+    return r;
+}
+
+// dFdx e dFdy: diferença entre os pixels vizinhos do mesmo quad (derivada "grossa", igual nos 4 pixels).
+inline FloatLote derivadaX(const FloatLote& a)
+{
+    FloatLote r;
+    for (int q = 0; q < fragmentosPorLote; q += 4) {
+        float d = a.v[q + 1] - a.v[q];
+        r.v[q] = r.v[q + 1] = r.v[q + 2] = r.v[q + 3] = d;
+    }
+    return r;
+}
+
+inline FloatLote derivadaY(const FloatLote& a)
+{
+    FloatLote r;
+    for (int q = 0; q < fragmentosPorLote; q += 4) {
+        float d = a.v[q + 2] - a.v[q];
+        r.v[q] = r.v[q + 1] = r.v[q + 2] = r.v[q + 3] = d;
+    }
+    return r;
+}
+
+// vec2, vec3 e vec4 do GLSL sobre o lote.
+struct Vec2Lote {
+    FloatLote x, y;
+};
+
+struct Vec3Lote {
+    FloatLote x, y, z;
+};
+
+struct Vec4Lote {
+    FloatLote x, y, z, w;
+};
+
+inline Vec3Lote operator+(const Vec3Lote& a, const Vec3Lote& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Vec3Lote operator-(const Vec3Lote& a, const Vec3Lote& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vec3Lote operator*(const Vec3Lote& a, const FloatLote& s) { return { a.x * s, a.y * s, a.z * s }; }
+inline Vec3Lote operator*(const Vec3Lote& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline Vec3Lote espalha(float x, float y, float z) { return { espalha(x), espalha(y), espalha(z) }; }
+
+inline FloatLote produtoEscalar(const Vec3Lote& a, const Vec3Lote& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3Lote normaliza(const Vec3Lote& a) { return a * (espalha(1.0f) / raiz(produtoEscalar(a, a))); }
+
+// Entrada e saida do fragment shader vetorizado.
+struct LoteFragmentos {
+    FloatLote x, y;                         // gl_FragCoord.xy (centro dos pixels).
+    FloatLote z;                            // gl_FragCoord.z
+    FloatLote varyings[maxVaryingsCPU];     // Interpoladas com correção de perspectiva.
+    Vec4Lote cor;                           // FragColor.
+    uint32_t vivos;                         // Bit por lane; as outras só existem para as derivadas.
+};
+
+// Interface dos shaders: uma struct com o tipo "Uniforms" e
+//     static void executa(LoteFragmentos& lote, const Uniforms* uniforms);
+// executaShaderLote<Shader> é o ponteiro colocado em ProgramaCPU::fragmentLote. O corpo do shader é
+// expandido inline junto com as operações acima, então vira codigo vetorizado sem chamadas por pixel.
+template <class Shader>
+void executaShaderLote(LoteFragmentos& lote, const void* uniforms)
+{
+    Shader::executa(lote, static_cast<const typename Shader::Uniforms*>(uniforms));
+}
+
+// Entrada e saida do vertex shader vetorizado: 8 vertices, atributos transpostos para estrutura de arrays.
+const int maxAtributosLote = 16;
+
+struct LoteVertices {
+    FloatLote atributos[maxAtributosLote];  // Floats de cada vertice, na ordem em que estão no VBO.
+    Vec4Lote posicao;                       // gl_Position.
+    FloatLote varyings[maxVaryingsCPU];
+};
+
+// Interface: uma struct com o tipo "Uniforms", as constantes "numAtributos" (floats lidos do vertice) e
+// "numVaryings", e
+//     static void executa(LoteVertices& lote, const Uniforms* uniforms);
+// executaShaderVerticeLote<Shader> é o ponteiro colocado em ProgramaCPU::vertexLote.
+template <class Shader>
+void executaShaderVerticeLote(const float* vertices, unsigned int stride, const unsigned int* indices,
+                              unsigned int quantidade, const void* uniforms, VerticeTransformado* saida)
+{
+    static_assert(Shader::numAtributos <= maxAtributosLote && Shader::numVaryings <= maxVaryingsCPU, "shader de vertice grande demais");
+    LoteVertices lote;
+
+    for (unsigned int inicio = 0; inicio < quantidade; inicio += fragmentosPorLote) {
+        unsigned int lanes = quantidade - inicio < (unsigned int)fragmentosPorLote ? quantidade - inicio : fragmentosPorLote;
+
+        // Lanes que sobram no ultimo lote repetem o ultimo vertice.
+        for (unsigned int l = 0; l < (unsigned int)fragmentosPorLote; l++) {
+            unsigned int k = inicio + (l < lanes ? l : lanes - 1);
+            const float* v = &vertices[(size_t)(indices ? indices[k] : k) * stride];
+            for (int a = 0; a < Shader::numAtributos; a++) {
+                lote.atributos[a].v[l] = v[a];
+            }
+        }
+
+        Shader::executa(lote, static_cast<const typename Shader::Uniforms*>(uniforms));
+
+        for (unsigned int l = 0; l < lanes; l++) {
+            VerticeTransformado& t = saida[inicio + l];
+            t.posicao[0] = lote.posicao.x.v[l];
+            t.posicao[1] = lote.posicao.y.v[l];
+            t.posicao[2] = lote.posicao.z.v[l];
+            t.posicao[3] = lote.posicao.w.v[l];
+            for (int k = 0; k < Shader::numVaryings; k++) {
+                t.varyings[k] = lote.varyings[k].v[l];
+            }
+        }
+    }
+}
@@ -0,0 +1,381 @@
+#include "SistemaTarefas.h"
+
+#include <algorithm>
+
+struct Tarefa {
+    FuncaoTarefa funcao = nullptr;
+    void (*funcaoInterna)(Tarefa&, unsigned int) = nullptr;    // Usada no lugar de "funcao" pelo paraCada.
+    void* dados = nullptr;
+    size_t inicio = 0, fim = 0;
+    ContadorTarefas* contador = nullptr;
+    Tarefa* proximaDependente = nullptr;
+    std::atomic<bool> ocupada;
+
+    Tarefa() : ocupada(false) {}
+};
+
+struct SistemaTarefas::DadosThread {
+    FilaChaseLev fila;
+    std::unique_ptr<Tarefa[]> tarefas;      // Anel com capacidadeTarefasThread tarefas.
+    uint32_t proximaTarefa = 0;
+    uint32_t semente;                       // Escolha da primeira vitima de roubo.
+    std::atomic<uint64_t> executadas;
+    std::atomic<uint64_t> roubadas;
+
+    explicit DadosThread(uint32_t semente)
+        : fila(capacidadeTarefasThread * 2), tarefas(new Tarefa[capacidadeTarefasThread]), semente(semente),
+          executadas(0), roubadas(0)
+    {
+    }
+};
+
+// Sistema e indice da thread atual (trabalhadores); as outras threads contam como a thread 0.
+static thread_local const SistemaTarefas* sistemaDaThread = nullptr;
+static thread_local unsigned int indiceDaThread = 0;
+
+FilaChaseLev::FilaChaseLev(unsigned int capacidade)
+    : topo(0), base(0)
+{
+    unsigned int potencia = 1;
+    while (potencia < capacidade) {
+        potencia *= 2;
+    }
+    tarefas.reset(new std::atomic<Tarefa*>[potencia]);
+    for (unsigned int i = 0; i < potencia; i++) {
+        tarefas[i].store(nullptr, std::memory_order_relaxed);
+    }
+    mascara = potencia - 1;
+}
+
+bool FilaChaseLev::empilha(Tarefa* tarefa)
+{
+    int64_t b = base.load(std::memory_order_relaxed);
+    int64_t t = topo.load(std::memory_order_acquire);
+    if (b - t > mascara) {
+        return false;
+    }
+    tarefas[b & mascara].store(tarefa, std::memory_order_relaxed);
+    base.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Tarefa* FilaChaseLev::desempilha()
+{
+    int64_t b = base.load(std::memory_order_relaxed) - 1;
+    base.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = topo.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // Vazia.
+        base.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Tarefa* tarefa = tarefas[b & mascara].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Ultima tarefa: disputa com quem está roubando.
+        if (!topo.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            tarefa = nullptr;
+        }
+        base.store(b + 1, std::memory_order_relaxed);
+    }
+    return tarefa;
+}
+
+Tarefa* FilaChaseLev::rouba()
+{
+    int64_t t = topo.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = base.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Tarefa* tarefa = tarefas[t & mascara].load(std::memory_order_relaxed);
+    if (!topo.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return tarefa;
+}
+
+SistemaTarefas::SistemaTarefas(unsigned int numThreads)
+    : tarefasNasFilas(0), dormindo(0), encerrando(false)
+{
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+        if (numThreads == 0) {
+            numThreads = 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++) {
+        threads.emplace_back(new DadosThread(i * 2654435761u + 1));
+    }
+
+    // A thread 0 é quem criou o sistema; as outras procuram tarefas e dormem quando não acham.
+    for (unsigned int i = 1; i < numThreads; i++) {
+        trabalhadores.emplace_back(&SistemaTarefas::executaTrabalhador, this, i);
+    }
+}
+
+SistemaTarefas::~SistemaTarefas()
+{
+    encerrando.store(true);
+    {
+        std::lock_guard<std::mutex> trava(travaSono);
+        sinalTarefa.notify_all();
+    }
+
+    for (std::thread& t : trabalhadores) {
+        t.join();
+    }
+}
+
+unsigned int SistemaTarefas::threadAtual() const
+{
+    return sistemaDaThread == this ? indiceDaThread : 0;
+}
+
+Tarefa* SistemaTarefas::alocaTarefa(unsigned int thread)
+{
+    // A proxima posição livre do anel; com o anel cheio de tarefas em andamento, ajuda a terminar alguma.
+    DadosThread& dados = *threads[thread];
+    while (true) {
+        Tarefa* tarefa = &dados.tarefas[dados.proximaTarefa++ % capacidadeTarefasThread];
+        if (!tarefa->ocupada.load(std::memory_order_acquire)) {
+            tarefa->ocupada.store(true, std::memory_order_relaxed);
+            tarefa->funcao = nullptr;
+            tarefa->funcaoInterna = nullptr;
+            tarefa->proximaDependente = nullptr;
+            return tarefa;
+        }
+        if (!executaUma(thread)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SistemaTarefas::agenda(Tarefa* tarefa, unsigned int thread)
+{
+    // Fila cheia: executa aqui mesmo.
+    if (!threads[thread]->fila.empilha(tarefa)) {
+        executa(tarefa, thread);
+        return;
+    }
+
+    tarefasNasFilas.fetch_add(1);
+    if (dormindo.load() > 0) {
+        std::lock_guard<std::mutex> trava(travaSono);
+        sinalTarefa.notify_one();
+    }
+}
+
+void SistemaTarefas::termina(Tarefa* tarefa, unsigned int thread)
+{
+    ContadorTarefas* contador = tarefa->contador;
+    tarefa->ocupada.store(false, std::memory_order_release);
+    if (!contador) {
+        return;
+    }
+
+    // Fora do ultimo decremento não precisa de trava. O ultimo é feito com a trava, e espera passa pela
+    // trava antes de retornar, então o contador não some enquanto ainda é usado aqui.
+    uint32_t pendentes = contador->pendentes.load(std::memory_order_relaxed);
+    while (pendentes > 1) {
+        if (contador->pendentes.compare_exchange_weak(pendentes, pendentes - 1, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+
+    Tarefa* liberadas = nullptr;
+    {
+        std::lock_guard<std::mutex> trava(contador->trava);
+        if (contador->pendentes.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            liberadas = contador->dependentes;
+            contador->dependentes = nullptr;
+        }
+    }
+    while (liberadas) {
+        Tarefa* proxima = liberadas->proximaDependente;
+        liberadas->proximaDependente = nullptr;
+        agenda(liberadas, thread);
+        liberadas = proxima;
+    }
+}
+
+void SistemaTarefas::executa(Tarefa* tarefa, unsigned int thread)
+{
+    if (tarefa->funcaoInterna) {
+        tarefa->funcaoInterna(*tarefa, thread);
+    }
+    else {
+        tarefa->funcao(tarefa->dados, thread);
+    }
+    threads[thread]->executadas.fetch_add(1, std::memory_order_relaxed);
+    termina(tarefa, thread);
+}
+
+bool SistemaTarefas::executaUma(unsigned int thread)
+{
+    // Primeiro a propria fila (tarefas recentes, dados ainda no cache), depois rouba das outras a partir
+    // de uma vitima aleatoria.
+    DadosThread& dados = *threads[thread];
+    Tarefa* tarefa = dados.fila.desempilha();
+    if (!tarefa) {
+        unsigned int n = numThreads();
+        dados.semente = dados.semente * 1664525u + 1013904223u;
+        unsigned int primeira = (dados.semente >> 8) % n;
+        for (unsigned int i = 0; i < n && !tarefa; i++) {
+            unsigned int vitima = (primeira + i) % n;
+            if (vitima != thread) {
+                tarefa = threads[vitima]->fila.rouba();
+            }
+        }
+        if (!tarefa) {
+            return false;
+        }
+        dados.roubadas.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    tarefasNasFilas.fetch_sub(1, std::memory_order_relaxed);
+    executa(tarefa, thread);
+    return true;
+}
+
+void SistemaTarefas::executaTrabalhador(unsigned int indice)
+{
+    sistemaDaThread = this;
+    indiceDaThread = indice;
+
+    // Sem tarefa: algumas tentativas cedendo o processador, depois dorme até uma tarefa ser agendada.
+    const int tentativasAntesDeDormir = 64;
+    int tentativas = 0;
+    while (!encerrando.load(std::memory_order_relaxed)) {
+        if (executaUma(indice)) {
+            tentativas = 0;
+            continue;
+        }
+        if (++tentativas < tentativasAntesDeDormir) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> trava(travaSono);
+        dormindo.fetch_add(1);
+        if (tarefasNasFilas.load() <= 0 && !encerrando.load()) {
+            sinalTarefa.wait(trava);
+        }
+        dormindo.fetch_sub(1);
+        tentativas = 0;
+    }
+}
+
+void SistemaTarefas::submete(FuncaoTarefa funcao, void* dados, ContadorTarefas* contador, ContadorTarefas* dependencia)
+{
+    unsigned int thread = threadAtual();
+    Tarefa* tarefa = alocaTarefa(thread);
+    tarefa->funcao = funcao;
+    tarefa->dados = dados;
+    tarefa->contador = contador;
+    if (contador) {
+        contador->pendentes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (dependencia) {
+        std::lock_guard<std::mutex> trava(dependencia->trava);
+        if (dependencia->pendentes.load(std::memory_order_acquire) > 0) {
+            tarefa->proximaDependente = dependencia->dependentes;
+            dependencia->dependentes = tarefa;
+            return;
+        }
+    }
+    agenda(tarefa, thread);
+}
+
+void SistemaTarefas::espera(ContadorTarefas& contador)
+{
+    unsigned int thread = threadAtual();
+    while (contador.pendentes.load(std::memory_order_acquire) > 0) {
+        if (!executaUma(thread)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Quem fez o ultimo decremento pode ainda estar com a trava (ver termina).
+    std::lock_guard<std::mutex> trava(contador.trava);
+}
+
+// Dados de um paraCada, compartilhados por todas as tarefas dele.
+struct DadosParaCada {
+    const std::function<void(size_t, size_t, unsigned int)>* funcao;
+    size_t tamanhoBloco;
+    SistemaTarefas* sistema;
+};
+
+void SistemaTarefas::executaIntervalo(Tarefa& tarefa, unsigned int thread)
+{
+    const DadosParaCada& dados = *(const DadosParaCada*)tarefa.dados;
+    size_t inicio = tarefa.inicio, fim = tarefa.fim;
+
+    // Agenda a metade de cima (em blocos inteiros) enquanto sobrar mais de um bloco; quem roubar essa
+    // metade continua dividindo do lado dele.
+    while (fim - inicio > dados.tamanhoBloco) {
+        size_t numBlocos = (fim - inicio + dados.tamanhoBloco - 1) / dados.tamanhoBloco;
+        size_t meio = inicio + numBlocos / 2 * dados.tamanhoBloco;
+        Tarefa* metade = dados.sistema->alocaTarefa(thread);
+        metade->funcaoInterna = executaIntervalo;
+        metade->dados = tarefa.dados;
+        metade->inicio = meio;
+        metade->fim = fim;
+        metade->contador = tarefa.contador;
+        tarefa.contador->pendentes.fetch_add(1, std::memory_order_relaxed);
+        dados.sistema->agenda(metade, thread);
+        fim = meio;
+    }
+    (*dados.funcao)(inicio, fim, thread);
+}
+
+void SistemaTarefas::paraCada(size_t quantidade, size_t tamanhoBloco,
+                              const std::function<void(size_t, size_t, unsigned int)>& funcao)
+{
+    if (quantidade == 0) {
+        return;
+    }
+
+    DadosParaCada dados;
+    dados.funcao = &funcao;
+    dados.tamanhoBloco = std::max<size_t>(tamanhoBloco, 1);
+    dados.sistema = this;
+
+    // A primeira tarefa roda aqui mesmo e vai dividindo o intervalo.
+    unsigned int thread = threadAtual();
+    ContadorTarefas contador;
+    contador.pendentes.store(1);
+    Tarefa* tarefa = alocaTarefa(thread);
+    tarefa->funcaoInterna = executaIntervalo;
+    tarefa->dados = &dados;
+    tarefa->inicio = 0;
+    tarefa->fim = quantidade;
+    tarefa->contador = &contador;
+    executa(tarefa, thread);
+    espera(contador);
+}
+
+uint64_t SistemaTarefas::tarefasExecutadas() const
+{
+    uint64_t total = 0;
+    for (const std::unique_ptr<DadosThread>& dados : threads) {
+        total += dados->executadas.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t SistemaTarefas::tarefasRoubadas() const
+{
+    uint64_t total = 0;
+    for (const std::unique_ptr<DadosThread>& dados : threads) {
+        total += dados->roubadas.load(std::memory_order_relaxed);
+    }
+    return total;
+}
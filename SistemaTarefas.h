@@ -0,0 +1,104 @@
+#pragma once
+
+// Sistema de tarefas para o quadro: cada thread tem uma fila Chase-Lev (a dona empilha e desempilha pelo
+// fim sem trava; as outras roubam pelo inicio com um compare-exchange). Tarefas avisam um contador quando
+// terminam, e uma tarefa pode depender de um contador: só entra numa fila quando ele zera. Quem espera
+// um contador executa outras tarefas enquanto isso, então tarefas podem criar e esperar outras tarefas.
+// Diferente do PoolThreads (um paraCada por vez, filas com trava), aqui varios grupos de tarefas correm
+// juntos e o paraCada divide o intervalo ao meio a cada roubo, o que serve para tarefas bem pequenas.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tarefas em andamento que cada thread pode ter criado ao mesmo tempo (a 4097ª espera a mais antiga terminar).
+const unsigned int capacidadeTarefasThread = 4096;
+
+typedef void (*FuncaoTarefa)(void* dados, unsigned int thread);
+
+struct Tarefa;
+
+// Conta as tarefas pendentes de um grupo. Só pode ser reaproveitado depois de zerar (espera).
+struct ContadorTarefas {
+    std::atomic<uint32_t> pendentes;
+    std::mutex trava;
+    Tarefa* dependentes = nullptr;      // Tarefas que esperam o contador zerar para entrar numa fila.
+
+    ContadorTarefas() : pendentes(0) {}
+};
+
+// Fila de roubo de trabalho de Chase e Lev (com as ordens de memoria de Lê et al., 2013), capacidade fixa.
+class FilaChaseLev {
+public:
+    explicit FilaChaseLev(unsigned int capacidade);
+
+    // Só a thread dona. empilha retorna falso com a fila cheia.
+    bool empilha(Tarefa* tarefa);
+    Tarefa* desempilha();
+
+    // Qualquer thread. Nulo com a fila vazia ou quando outra thread levou a tarefa antes.
+    Tarefa* rouba();
+
+private:
+    std::atomic<int64_t> topo;
+    std::atomic<int64_t> base;
+    std::unique_ptr<std::atomic<Tarefa*>[]> tarefas;
+    int64_t mascara;
+};
+
+class SistemaTarefas {
+public:
+    // "numThreads" inclui a thread que cria o sistema (0 = numero de nucleos da maquina). Só ela e as
+    // proprias tarefas podem chamar submete, espera e paraCada.
+    explicit SistemaTarefas(unsigned int numThreads = 0);
+    ~SistemaTarefas();
+
+    SistemaTarefas(const SistemaTarefas&) = delete;
+    SistemaTarefas& operator=(const SistemaTarefas&) = delete;
+
+    unsigned int numThreads() const { return (unsigned int)threads.size(); }
+
+    // Agenda funcao(dados, thread). "contador" (opcional) sobe agora e desce quando a tarefa termina; com
+    // "dependencia" a tarefa só começa depois que esse contador zerar.
+    void submete(FuncaoTarefa funcao, void* dados, ContadorTarefas* contador = nullptr,
+                 ContadorTarefas* dependencia = nullptr);
+
+    // Executa tarefas (desta thread ou roubadas) até o contador zerar.
+    void espera(ContadorTarefas& contador);
+
+    // funcao(inicio, fim, thread) em blocos de até "tamanhoBloco" elementos de [0, quantidade), e espera.
+    // O intervalo é dividido ao meio recursivamente: as threads que roubam levam as metades maiores.
+    void paraCada(size_t quantidade, size_t tamanhoBloco, const std::function<void(size_t, size_t, unsigned int)>& funcao);
+
+    // Contagem desde a criação (para as medições).
+    uint64_t tarefasExecutadas() const;
+    uint64_t tarefasRoubadas() const;
+
+private:
+    struct DadosThread;
+
+    Tarefa* alocaTarefa(unsigned int thread);
+    void agenda(Tarefa* tarefa, unsigned int thread);
+    void termina(Tarefa* tarefa, unsigned int thread);
+    void executa(Tarefa* tarefa, unsigned int thread);
+    bool executaUma(unsigned int thread);
+    void executaTrabalhador(unsigned int indice);
+    unsigned int threadAtual() const;
+    static void executaIntervalo(Tarefa& tarefa, unsigned int thread);
+
+    std::vector<std::unique_ptr<DadosThread>> threads;
+    std::vector<std::thread> trabalhadores;
+
+    // Trabalhadores sem tarefa dormem aqui (o contador de pendentes evita perder um aviso).
+    std::atomic<int64_t> tarefasNasFilas;
+    std::atomic<unsigned int> dormindo;
+    std::mutex travaSono;
+    std::condition_variable sinalTarefa;
+    std::atomic<bool> encerrando;
+};
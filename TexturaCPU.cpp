@@ -0,0 +1,156 @@
+#include "TexturaCPU.h"
+
+#include <cmath>
+#include <algorithm>
+
+void criaTexturaCPU(TexturaCPU& textura, const uint32_t* texels, int largura, int altura)
+{
+    textura.niveis.clear();
+
+    NivelTexturaCPU base;
+    base.largura = largura;
+    base.altura = altura;
+    base.texels.assign(texels, texels + (size_t)largura * altura);
+    textura.niveis.push_back(base);
+
+    while (largura > 1 || altura > 1) {
+        const NivelTexturaCPU& anterior = textura.niveis.back();
+        NivelTexturaCPU nivel;
+        nivel.largura = std::max(largura / 2, 1);
+        nivel.altura = std::max(altura / 2, 1);
+        nivel.texels.resize((size_t)nivel.largura * nivel.altura);
+
+        for (int y = 0; y < nivel.altura; y++) {
+            for (int x = 0; x < nivel.largura; x++) {
+                int x0 = std::min(x * 2, largura - 1), x1 = std::min(x * 2 + 1, largura - 1);
+                int y0 = std::min(y * 2, altura - 1), y1 = std::min(y * 2 + 1, altura - 1);
+                uint32_t amostras[4] = {
+                    anterior.texels[(size_t)y0 * largura + x0], anterior.texels[(size_t)y0 * largura + x1],
+                    anterior.texels[(size_t)y1 * largura + x0], anterior.texels[(size_t)y1 * largura + x1]
+                };
+
+                uint32_t media = 0;
+                for (int c = 0; c < 4; c++) {
+                    uint32_t soma = 2;
+                    for (uint32_t amostra : amostras) {
+                        soma += (amostra >> (c * 8)) & 0xFF;
+                    }
+                    media |= (soma / 4) << (c * 8);
+                }
+                nivel.texels[(size_t)y * nivel.largura + x] = media;
+            }
+        }
+
+        largura = nivel.largura;
+        altura = nivel.altura;
+        textura.niveis.push_back(std::move(nivel));
+    }
+}
+
+// Filtro bilinear com GL_REPEAT num nivel.
+static void amostraBilinear(const NivelTexturaCPU& nivel, float u, float v, float cor[4])
+{
+    // Parte fracionaria primeiro (GL_REPEAT sem divisão inteira); o texel à esquerda pode ser o -1.
+    float tx = (u - std::floor(u)) * (float)nivel.largura - 0.5f;
+    float ty = (v - std::floor(v)) * (float)nivel.altura - 0.5f;
+    float fx = std::floor(tx);
+    float fy = std::floor(ty);
+    float pesoX = tx - fx;
+    float pesoY = ty - fy;
+
+    int x0 = (int)fx, y0 = (int)fy;
+    int x1 = x0 + 1, y1 = y0 + 1;
+    if (x0 < 0) x0 += nivel.largura;
+    if (y0 < 0) y0 += nivel.altura;
+    if (x1 >= nivel.largura) x1 -= nivel.largura;
+    if (y1 >= nivel.altura) y1 -= nivel.altura;
+
+    uint32_t t00 = nivel.texels[(size_t)y0 * nivel.largura + x0];
+    uint32_t t10 = nivel.texels[(size_t)y0 * nivel.largura + x1];
+    uint32_t t01 = nivel.texels[(size_t)y1 * nivel.largura + x0];
+    uint32_t t11 = nivel.texels[(size_t)y1 * nivel.largura + x1];
+
+    for (int c = 0; c < 4; c++) {
+        float a = (float)((t00 >> (c * 8)) & 0xFF);
+        float b = (float)((t10 >> (c * 8)) & 0xFF);
+        float d = (float)((t01 >> (c * 8)) & 0xFF);
+        float e = (float)((t11 >> (c * 8)) & 0xFF);
+        float baixo = a + (b - a) * pesoX;
+        float cima = d + (e - d) * pesoX;
+        cor[c] = (baixo + (cima - baixo) * pesoY) * (1.0f / 255.0f);
+    }
+}
+
+void amostraTextura(const TexturaCPU& textura, float u, float v, float cor[4])
+{
+    amostraBilinear(textura.niveis[0], u, v, cor);
+}
+
+Vec4Lote amostraTexturaLote(const TexturaCPU& textura, const Vec2Lote& uv)
+{
+    const NivelTexturaCPU& base = textura.niveis[0];
+    int ultimoNivel = (int)textura.niveis.size() - 1;
+
+    // Tamanho do pixel em texels: o maior dos dois eixos da tela.
+    FloatLote dudx = derivadaX(uv.x) * (float)base.largura, dvdx = derivadaX(uv.y) * (float)base.altura;
+    FloatLote dudy = derivadaY(uv.x) * (float)base.largura, dvdy = derivadaY(uv.y) * (float)base.altura;
+    FloatLote rho = maximo(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+
+    // Um nivel por quad: log2(sqrt(rho)), arredondado para o mais proximo.
+    const NivelTexturaCPU* niveis[fragmentosPorLote];
+    FloatLote largura, altura;
+    for (int q = 0; q < fragmentosPorLote; q += 4) {
+        float lod = 0.5f * std::log2(std::max(rho.v[q], 1e-12f));
+        int n = std::min(std::max((int)std::floor(lod + 0.5f), 0), ultimoNivel);
+        for (int i = q; i < q + 4; i++) {
+            niveis[i] = &textura.niveis[n];
+            largura.v[i] = (float)textura.niveis[n].largura;
+            altura.v[i] = (float)textura.niveis[n].altura;
+        }
+    }
+
+    // Endereços e pesos em SIMD; só a leitura dos 4 texels de cada lane é escalar.
+    FloatLote tx, ty, pesoX, pesoY;
+    for (int i = 0; i < fragmentosPorLote; i++) {
+        tx.v[i] = (uv.x.v[i] - std::floor(uv.x.v[i])) * largura.v[i] - 0.5f;
+        ty.v[i] = (uv.y.v[i] - std::floor(uv.y.v[i])) * altura.v[i] - 0.5f;
+        float fx = std::floor(tx.v[i]);
+        float fy = std::floor(ty.v[i]);
+        pesoX.v[i] = tx.v[i] - fx;
+        pesoY.v[i] = ty.v[i] - fy;
+        tx.v[i] = fx;
+        ty.v[i] = fy;
+    }
+
+    uint32_t t00[fragmentosPorLote], t10[fragmentosPorLote], t01[fragmentosPorLote], t11[fragmentosPorLote];
+    for (int i = 0; i < fragmentosPorLote; i++) {
+        const NivelTexturaCPU& nivel = *niveis[i];
+        int x0 = (int)tx.v[i], y0 = (int)ty.v[i];
+        int x1 = x0 + 1, y1 = y0 + 1;
+        if (x0 < 0) x0 += nivel.largura;
+        if (y0 < 0) y0 += nivel.altura;
+        if (x1 >= nivel.largura) x1 -= nivel.largura;
+        if (y1 >= nivel.altura) y1 -= nivel.altura;
+
+        t00[i] = nivel.texels[(size_t)y0 * nivel.largura + x0];
+        t10[i] = nivel.texels[(size_t)y0 * nivel.largura + x1];
+        t01[i] = nivel.texels[(size_t)y1 * nivel.largura + x0];
+        t11[i] = nivel.texels[(size_t)y1 * nivel.largura + x1];
+    }
+
+    Vec4Lote cor;
+    FloatLote* canais[4] = { &cor.x, &cor.y, &cor.z, &cor.w };
+    for (int c = 0; c < 4; c++) {
+        FloatLote& canal = *canais[c];
+        for (int i = 0; i < fragmentosPorLote; i++) {
+            float a = (float)((t00[i] >> (c * 8)) & 0xFF);
+            float b = (float)((t10[i] >> (c * 8)) & 0xFF);
+            float d = (float)((t01[i] >> (c * 8)) & 0xFF);
+            float e = (float)((t11[i] >> (c * 8)) & 0xFF);
+            float baixo = a + (b - a) * pesoX.v[i];
+            float cima = d + (e - d) * pesoX.v[i];
+            canal.v[i] = (baixo + (cima - baixo) * pesoY.v[i]) * (1.0f / 255.0f);
+        }
+    }
+    return cor;
+}
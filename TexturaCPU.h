@@ -0,0 +1,28 @@
+#pragma once
+
+// Texturas do rasterizador em software: RGBA8 com mipmaps, GL_REPEAT e filtro bilinear.
+
+#include "ShaderLote.h"
+
+#include <cstdint>
+#include <vector>
+
+struct NivelTexturaCPU {
+    int largura = 0;
+    int altura = 0;
+    std::vector<uint32_t> texels;       // RGBA8, R no byte menos significativo.
+};
+
+struct TexturaCPU {
+    std::vector<NivelTexturaCPU> niveis;   // Nivel 0 é a imagem original (como glGenerateMipmap).
+};
+
+// Copia a imagem e gera os mipmaps (media de 2x2 texels) até 1x1.
+void criaTexturaCPU(TexturaCPU& textura, const uint32_t* texels, int largura, int altura);
+
+// texture() de um pixel, sem derivadas: sempre o nivel 0.
+void amostraTextura(const TexturaCPU& textura, float u, float v, float cor[4]);
+
+// texture() de um lote: cada quad escolhe o nivel pelas derivadas das coordenadas
+// (GL_LINEAR_MIPMAP_NEAREST), por isso as lanes fora do triângulo também precisam de uv.
+Vec4Lote amostraTexturaLote(const TexturaCPU& textura, const Vec2Lote& uv);
@@ -0,0 +1,224 @@
+#include "TransformacoesSoA.h"
+
+#include <cstring>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+void redimensionaTransformacoes(TransformacoesSoA& transformacoes, size_t quantidade)
+{
+    TransformacoesSoA& t = transformacoes;
+    t.posicaoX.resize(quantidade, 0.0f);
+    t.posicaoY.resize(quantidade, 0.0f);
+    t.posicaoZ.resize(quantidade, 0.0f);
+    t.rotacaoX.resize(quantidade, 0.0f);
+    t.rotacaoY.resize(quantidade, 0.0f);
+    t.rotacaoZ.resize(quantidade, 0.0f);
+    t.rotacaoW.resize(quantidade, 1.0f);
+    t.escalaX.resize(quantidade, 1.0f);
+    t.escalaY.resize(quantidade, 1.0f);
+    t.escalaZ.resize(quantidade, 1.0f);
+    t.cor.resize(quantidade, 0xFFFFFFFFu);
+    t.quantidade = quantidade;
+}
+
+void defineTransformacao(TransformacoesSoA& transformacoes, size_t indice, const Vec3& posicao, const Quat& rotacao, const Vec3& escala)
+{
+    TransformacoesSoA& t = transformacoes;
+    t.posicaoX[indice] = posicao.x;
+    t.posicaoY[indice] = posicao.y;
+    t.posicaoZ[indice] = posicao.z;
+    t.rotacaoX[indice] = rotacao.x;
+    t.rotacaoY[indice] = rotacao.y;
+    t.rotacaoZ[indice] = rotacao.z;
+    t.rotacaoW[indice] = rotacao.w;
+    t.escalaX[indice] = escala.x;
+    t.escalaY[indice] = escala.y;
+    t.escalaZ[indice] = escala.z;
+}
+
+Mat4 matrizTransformacao(const TransformacoesSoA& transformacoes, size_t indice)
+{
+    const TransformacoesSoA& t = transformacoes;
+    Quat q(t.rotacaoX[indice], t.rotacaoY[indice], t.rotacaoZ[indice], t.rotacaoW[indice]);
+    return translacao(Vec3(t.posicaoX[indice], t.posicaoY[indice], t.posicaoZ[indice])) * matrizRotacao(q) *
+           escala(Vec3(t.escalaX[indice], t.escalaY[indice], t.escalaZ[indice]));
+}
+
+// Rotação do quaternion com as colunas multiplicadas pela escala e a translação na quarta coluna.
+// Os produtos usam x2 = 2x (e assim por diante) para economizar as multiplicações por 2.
+static void compoeUma(const TransformacoesSoA& t, size_t o, InstanciaTriangulo& destino)
+{
+    float x2 = t.rotacaoX[o] + t.rotacaoX[o], y2 = t.rotacaoY[o] + t.rotacaoY[o], z2 = t.rotacaoZ[o] + t.rotacaoZ[o];
+    float xx = t.rotacaoX[o] * x2, yy = t.rotacaoY[o] * y2, zz = t.rotacaoZ[o] * z2;
+    float xy = t.rotacaoX[o] * y2, xz = t.rotacaoX[o] * z2, yz = t.rotacaoY[o] * z2;
+    float wx = t.rotacaoW[o] * x2, wy = t.rotacaoW[o] * y2, wz = t.rotacaoW[o] * z2;
+    float sx = t.escalaX[o], sy = t.escalaY[o], sz = t.escalaZ[o];
+
+    float* m = destino.transformacao;
+    m[0] = (1.0f - (yy + zz)) * sx; m[1] = (xy - wz) * sy;          m[2] = (xz + wy) * sz;           m[3] = t.posicaoX[o];
+    m[4] = (xy + wz) * sx;          m[5] = (1.0f - (xx + zz)) * sy; m[6] = (yz - wx) * sz;           m[7] = t.posicaoY[o];
+    m[8] = (xz - wy) * sx;          m[9] = (yz + wx) * sy;          m[10] = (1.0f - (xx + yy)) * sz; m[11] = t.posicaoZ[o];
+    std::memcpy(destino.cor, &t.cor[o], 4);
+}
+
+static void compoeEscalar(const TransformacoesSoA& t, size_t inicio, size_t quantidade, InstanciaTriangulo* destino)
+{
+    for (size_t i = 0; i < quantidade; i++) {
+        compoeUma(t, inicio + i, destino[i]);
+    }
+}
+
+static void compoeListaEscalar(const TransformacoesSoA& t, const uint32_t* indices, size_t quantidade, InstanciaTriangulo* destino)
+{
+    for (size_t i = 0; i < quantidade; i++) {
+        compoeUma(t, indices[i], destino[i]);
+    }
+}
+
+#if SIMD_X86
+// Compõe 8 objetos, um por lane: os 12 elementos das matrizes são calculados com um registro por elemento
+// e depois transpostos para um registro por objeto. Os elementos 0 a 7 saem de uma transposição 8x8 e
+// os elementos 8 a 11 de uma 4x8; com a cor, cada instância de 52 bytes fica com um store de 32 bytes,
+// um de 16 e um de 4, em ordem crescente de endereço. Os stores são o gargalo quando o destino está na
+// cache (3 por objeto); com 1 milhão de objetos o limite é a banda de memoria.
+ALVO_AVX2 static inline void compoeOito(__m256 qx, __m256 qy, __m256 qz, __m256 qw, __m256 sx, __m256 sy, __m256 sz,
+                                        __m256 px, __m256 py, __m256 pz, const uint32_t* cores, InstanciaTriangulo* d)
+{
+    const __m256 um = _mm256_set1_ps(1.0f);
+    __m256 x2 = _mm256_add_ps(qx, qx), y2 = _mm256_add_ps(qy, qy), z2 = _mm256_add_ps(qz, qz);
+    __m256 xx = _mm256_mul_ps(qx, x2), yy = _mm256_mul_ps(qy, y2), zz = _mm256_mul_ps(qz, z2);
+    __m256 xy = _mm256_mul_ps(qx, y2), xz = _mm256_mul_ps(qx, z2), yz = _mm256_mul_ps(qy, z2);
+    __m256 wx = _mm256_mul_ps(qw, x2), wy = _mm256_mul_ps(qw, y2), wz = _mm256_mul_ps(qw, z2);
+
+    __m256 e[12];
+    e[0] = _mm256_mul_ps(_mm256_sub_ps(um, _mm256_add_ps(yy, zz)), sx);
+    e[1] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+    e[2] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+    e[3] = px;
+    e[4] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+    e[5] = _mm256_mul_ps(_mm256_sub_ps(um, _mm256_add_ps(xx, zz)), sy);
+    e[6] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+    e[7] = py;
+    e[8] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+    e[9] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+    e[10] = _mm256_mul_ps(_mm256_sub_ps(um, _mm256_add_ps(xx, yy)), sz);
+    e[11] = pz;
+
+    // Transposição 8x8 dos elementos 0 a 7: linhas[k] fica com os elementos do objeto k.
+    __m256 a0 = _mm256_unpacklo_ps(e[0], e[1]), a1 = _mm256_unpackhi_ps(e[0], e[1]);
+    __m256 a2 = _mm256_unpacklo_ps(e[2], e[3]), a3 = _mm256_unpackhi_ps(e[2], e[3]);
+    __m256 a4 = _mm256_unpacklo_ps(e[4], e[5]), a5 = _mm256_unpackhi_ps(e[4], e[5]);
+    __m256 a6 = _mm256_unpacklo_ps(e[6], e[7]), a7 = _mm256_unpackhi_ps(e[6], e[7]);
+    __m256 b0 = _mm256_shuffle_ps(a0, a2, 0x44), b1 = _mm256_shuffle_ps(a0, a2, 0xEE);
+    __m256 b2 = _mm256_shuffle_ps(a1, a3, 0x44), b3 = _mm256_shuffle_ps(a1, a3, 0xEE);
+    __m256 b4 = _mm256_shuffle_ps(a4, a6, 0x44), b5 = _mm256_shuffle_ps(a4, a6, 0xEE);
+    __m256 b6 = _mm256_shuffle_ps(a5, a7, 0x44), b7 = _mm256_shuffle_ps(a5, a7, 0xEE);
+    __m256 linhas[8];
+    linhas[0] = _mm256_permute2f128_ps(b0, b4, 0x20);
+    linhas[1] = _mm256_permute2f128_ps(b1, b5, 0x20);
+    linhas[2] = _mm256_permute2f128_ps(b2, b6, 0x20);
+    linhas[3] = _mm256_permute2f128_ps(b3, b7, 0x20);
+    linhas[4] = _mm256_permute2f128_ps(b0, b4, 0x31);
+    linhas[5] = _mm256_permute2f128_ps(b1, b5, 0x31);
+    linhas[6] = _mm256_permute2f128_ps(b2, b6, 0x31);
+    linhas[7] = _mm256_permute2f128_ps(b3, b7, 0x31);
+
+    // Transposição 4x8 dos elementos 8 a 11: a metade baixa de resto[k] é o objeto k e a alta o objeto k + 4.
+    __m256 c0 = _mm256_unpacklo_ps(e[8], e[9]), c1 = _mm256_unpackhi_ps(e[8], e[9]);
+    __m256 c2 = _mm256_unpacklo_ps(e[10], e[11]), c3 = _mm256_unpackhi_ps(e[10], e[11]);
+    __m256 resto[4];
+    resto[0] = _mm256_shuffle_ps(c0, c2, 0x44);
+    resto[1] = _mm256_shuffle_ps(c0, c2, 0xEE);
+    resto[2] = _mm256_shuffle_ps(c1, c3, 0x44);
+    resto[3] = _mm256_shuffle_ps(c1, c3, 0xEE);
+
+    for (int k = 0; k < 4; k++) {
+        _mm256_storeu_ps(d[k].transformacao, linhas[k]);
+        _mm_storeu_ps(d[k].transformacao + 8, _mm256_castps256_ps128(resto[k]));
+        std::memcpy(d[k].cor, cores + k, 4);
+    }
+    for (int k = 0; k < 4; k++) {
+        _mm256_storeu_ps(d[k + 4].transformacao, linhas[k + 4]);
+        _mm_storeu_ps(d[k + 4].transformacao + 8, _mm256_extractf128_ps(resto[k], 1));
+        std::memcpy(d[k + 4].cor, cores + k + 4, 4);
+    }
+}
+
+ALVO_AVX2 static void compoeAVX2(const TransformacoesSoA& t, size_t inicio, size_t quantidade, InstanciaTriangulo* destino)
+{
+    // Ponteiros locais: os stores no destino poderiam apontar para dentro dos vetores e forçariam o
+    // compilador a reler data() de cada vetor a cada iteração.
+    const float* px = t.posicaoX.data() + inicio;
+    const float* py = t.posicaoY.data() + inicio;
+    const float* pz = t.posicaoZ.data() + inicio;
+    const float* rx = t.rotacaoX.data() + inicio;
+    const float* ry = t.rotacaoY.data() + inicio;
+    const float* rz = t.rotacaoZ.data() + inicio;
+    const float* rw = t.rotacaoW.data() + inicio;
+    const float* ex = t.escalaX.data() + inicio;
+    const float* ey = t.escalaY.data() + inicio;
+    const float* ez = t.escalaZ.data() + inicio;
+    const uint32_t* cores = t.cor.data() + inicio;
+
+    size_t i = 0;
+    for (; i + 8 <= quantidade; i += 8) {
+        compoeOito(_mm256_loadu_ps(rx + i), _mm256_loadu_ps(ry + i), _mm256_loadu_ps(rz + i), _mm256_loadu_ps(rw + i),
+                   _mm256_loadu_ps(ex + i), _mm256_loadu_ps(ey + i), _mm256_loadu_ps(ez + i),
+                   _mm256_loadu_ps(px + i), _mm256_loadu_ps(py + i), _mm256_loadu_ps(pz + i), cores + i, destino + i);
+    }
+
+    // Sobra de menos de 8 objetos.
+    compoeEscalar(t, inicio + i, quantidade - i, destino + i);
+}
+
+// Mesmo kernel com os componentes lidos por gather nos indices da lista.
+ALVO_AVX2 static void compoeListaAVX2(const TransformacoesSoA& t, const uint32_t* indices, size_t quantidade, InstanciaTriangulo* destino)
+{
+    size_t i = 0;
+    for (; i + 8 <= quantidade; i += 8) {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(indices + i));
+        alignas(32) uint32_t cores[8];
+        _mm256_store_si256((__m256i*)cores, _mm256_i32gather_epi32((const int*)t.cor.data(), o, 4));
+        compoeOito(_mm256_i32gather_ps(t.rotacaoX.data(), o, 4), _mm256_i32gather_ps(t.rotacaoY.data(), o, 4),
+                   _mm256_i32gather_ps(t.rotacaoZ.data(), o, 4), _mm256_i32gather_ps(t.rotacaoW.data(), o, 4),
+                   _mm256_i32gather_ps(t.escalaX.data(), o, 4), _mm256_i32gather_ps(t.escalaY.data(), o, 4),
+                   _mm256_i32gather_ps(t.escalaZ.data(), o, 4), _mm256_i32gather_ps(t.posicaoX.data(), o, 4),
+                   _mm256_i32gather_ps(t.posicaoY.data(), o, 4), _mm256_i32gather_ps(t.posicaoZ.data(), o, 4),
+                   cores, destino + i);
+    }
+
+    for (; i < quantidade; i++) {
+        compoeUma(t, indices[i], destino[i]);
+    }
+}
+#endif
+
+typedef void (*FuncaoComposicao)(const TransformacoesSoA&, size_t, size_t, InstanciaTriangulo*);
+typedef void (*FuncaoComposicaoLista)(const TransformacoesSoA&, const uint32_t*, size_t, InstanciaTriangulo*);
+
+static DespachoSIMD<FuncaoComposicao> despachoComposicao(compoeEscalar, nullptr, IMPLEMENTACAO_X86(compoeAVX2));
+static DespachoSIMD<FuncaoComposicaoLista> despachoComposicaoLista(compoeListaEscalar, nullptr,
+                                                                   IMPLEMENTACAO_X86(compoeListaAVX2));
+
+void compoeInstancias(const TransformacoesSoA& transformacoes, size_t inicio, size_t quantidade, InstanciaTriangulo* destino)
+{
+    despachoComposicao.funcao()(transformacoes, inicio, quantidade, destino);
+}
+
+void compoeInstanciasLista(const TransformacoesSoA& transformacoes, const uint32_t* indices, size_t quantidade, InstanciaTriangulo* destino)
+{
+    despachoComposicaoLista.funcao()(transformacoes, indices, quantidade, destino);
+}
+
+NivelSIMD selecionaNivelTransformacoes(NivelSIMD nivel)
+{
+    despachoComposicaoLista.seleciona(nivel);
+    return despachoComposicao.seleciona(nivel);
+}
+
+NivelSIMD nivelTransformacoes()
+{
+    return despachoComposicao.nivel();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Transformações de muitos objetos em estrutura de arrays (SoA): cada componente da posição, da rotação
+// (quaternion) e da escala fica num array proprio. Assim 8 objetos seguidos enchem um registro AVX2 por
+// componente e a composição translação * rotação * escala calcula 8 matrizes 3x4 por iteração, escritas
+// direto no formato de InstanciaTriangulo (por exemplo no VBO mapeado por mapeiaInstancias).
+// AVX2 ou escalar, escolhido em tempo de execução pelo CPUID (o nivel SSE4.1 usa o escalar).
+
+#include "Instancias.h"
+#include "Matematica.h"
+#include "CPUInfo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TransformacoesSoA {
+    std::vector<float> posicaoX, posicaoY, posicaoZ;
+    std::vector<float> rotacaoX, rotacaoY, rotacaoZ, rotacaoW;   // Quaternion normalizado.
+    std::vector<float> escalaX, escalaY, escalaZ;
+    std::vector<uint32_t> cor;                                   // RGBA8 na ordem dos bytes de InstanciaTriangulo::cor.
+    size_t quantidade = 0;
+};
+
+// Muda o numero de objetos. Os novos começam na origem, sem rotação, com escala 1 e cor branca.
+void redimensionaTransformacoes(TransformacoesSoA& transformacoes, size_t quantidade);
+
+void defineTransformacao(TransformacoesSoA& transformacoes, size_t indice, const Vec3& posicao, const Quat& rotacao, const Vec3& escala);
+
+// Matriz translação * rotação * escala do objeto, calculada com o Matematica.h (referencia para os kernels).
+Mat4 matrizTransformacao(const TransformacoesSoA& transformacoes, size_t indice);
+
+// Escreve a matriz 3x4 (3 primeiras linhas de translação * rotação * escala) e a cor dos objetos
+// [inicio, inicio + quantidade) em destino[0], destino[1], ... Cada instância é escrita inteira e em ordem,
+// sem ler o destino, então ele pode ser memoria de um VBO mapeado (write-combined).
+void compoeInstancias(const TransformacoesSoA& transformacoes, size_t inicio, size_t quantidade, InstanciaTriangulo* destino);
+
+// Igual, só para os objetos da lista (por exemplo a de visiveis do descartaFrustum): destino[k] recebe o
+// objeto indices[k].
+void compoeInstanciasLista(const TransformacoesSoA& transformacoes, const uint32_t* indices, size_t quantidade, InstanciaTriangulo* destino);
+
+// Troca a implementação usada (limitada ao que o processador suporta). Retorna o nivel efetivo.
+NivelSIMD selecionaNivelTransformacoes(NivelSIMD nivel);
+NivelSIMD nivelTransformacoes();
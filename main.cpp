@@ -1,28 +1,52 @@
-// Use a verso do GLFW compativel com 64 bits.
+// Use a versão do GLFW compativel com 64 bits.
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 // Usado para escrever no console com C++
 #include <iostream>
-
-// Declarao de funes deve ocorrer antes do Main.
+#include <cstring>
+#include <algorithm>
+
+// Otimização dos indices (cache de vertices), formatos de vertice compactos, fila de desenhos,
+// rasterizador em software, captura de tela e benchmarks.
+#include "OtimizacaoMalha.h"
+#include "FormatoVertice.h"
+#include "FilaRenderizacao.h"
+#include "BackendCPU.h"
+#include "ShaderLote.h"
+#include "LeituraPixelsGL.h"
+#include "GravadorQuadros.h"
+#include "Benchmark.h"
+#include "BVH.h"
+#include "OclusaoCPU.h"
+#include "Meshlets.h"
+#include "MundoECS.h"
+
+// Declaração de funções deve ocorrer antes do Main.
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void processInput(GLFWwindow* window);
 void inputTeclas(GLFWwindow* window);
+void capturaTela(GLFWwindow* window, GravadorQuadros& gravador);
+void gravaCapturas(GravadorQuadros& gravador, bool espera);
 void compilaVertexShader(int vs);
 void compilaFragmentShader(int fs);
 void vinculaProgramShader(int ps);
+int renderizaNaCPU(bool interpretaGLSL);
 
-// Declarao da resoluo da janela
+// Declaração da resolução da janela
 const unsigned int larguraJanela = 800;
 const unsigned int alturaJanela = 600;
 
-// Buffer com os vertices do tringulo. (Vertex Buffer Object - VBO)
+// Buffer com os vertices do triângulo. (Vertex Buffer Object - VBO)
 unsigned int VBO;
 
 // Buffer com os arrays de vertices. (Vertex Array Object - VAO)
 unsigned int VAO;
 
+// Buffer com os indices dos vertices de cada triângulo. (Element Buffer Object - EBO)
+unsigned int EBO;
+
 // Declarando e compilando um vertex shader.
 const char* vertexShaderSource = "#version 330 core\n"
 "layout (location = 0) in vec3 aPos;\n"
@@ -39,13 +63,87 @@ const char* fragmentShaderSource = "#version 330 core\n"
 "    FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);\n"
 "}\n\0";
 
-// Declarando a variavel que ser utilizada pelo vertex shader vazio.
+// Equivalente em C++ do vertex shader, usado pelo rasterizador em software.
+void vertexShaderCPU(const float* aPos, const void* /*uniforms*/, float* gl_Position, float* /*varyings*/)
+{
+    gl_Position[0] = aPos[0];
+    gl_Position[1] = aPos[1];
+    gl_Position[2] = aPos[2];
+    gl_Position[3] = 1.0f;
+}
+
+// O mesmo vertex shader na versão vetorizada (8 vertices por chamada).
+struct VertexShaderLoteCPU {
+    struct Uniforms {};
+    static const int numAtributos = 3;
+    static const int numVaryings = 0;
+
+    static void executa(LoteVertices& lote, const Uniforms* /*uniforms*/)
+    {
+        lote.posicao.x = lote.atributos[0];
+        lote.posicao.y = lote.atributos[1];
+        lote.posicao.z = lote.atributos[2];
+        lote.posicao.w = espalha(1.0f);
+    }
+};
+
+// Equivalente em C++ do fragment shader, usado pelo rasterizador em software.
+void fragmentShaderCPU(const float* /*varyings*/, const void* /*uniforms*/, float* FragColor)
+{
+    FragColor[0] = 1.0f;
+    FragColor[1] = 1.0f;
+    FragColor[2] = 1.0f;
+    FragColor[3] = 1.0f;
+}
+
+// O mesmo fragment shader na versão vetorizada (8 fragmentos por chamada).
+struct FragmentShaderLoteCPU {
+    struct Uniforms {};
+
+    static void executa(LoteFragmentos& lote, const Uniforms* /*uniforms*/)
+    {
+        lote.cor.x = espalha(1.0f);
+        lote.cor.y = espalha(1.0f);
+        lote.cor.z = espalha(1.0f);
+        lote.cor.w = espalha(1.0f);
+    }
+};
+
+// Declarando a variavel que será utilizada pelo vertex shader vazio.
 unsigned int vertexShader;
 
-// Declarando a variavel que ser utilizada pelo fragment shader vazio.
+// Declarando a variavel que será utilizada pelo fragment shader vazio.
 unsigned int fragmentShader;
 
-// Declarando a variavel que ser utilizada na juno dos shaders (Vertex + Fragment).
+// Fila com os desenhos do quadro (ordenados por estado antes de enviar ao OpenGL).
+FilaRenderizacao filaDesenhos;
+
+// PBOs da captura de tela (F12).
+LeituraPixels leituraTela;
+
+// Caixas dos objetos da cena e a BVH sobre elas (seleção com o clique do mouse).
+VolumesEnvolventes volumesCena;
+BVH bvhCena;
+
+// Profundidade dos oclusores do quadro (256x128), testada antes de cada desenho entrar na fila.
+BufferOclusao oclusaoCena;
+
+// Meshlets do triângulo (64 vertices / 124 triângulos no maximo), descartados por frustum e cone a cada quadro.
+MalhaMeshlets meshletsCena;
+
+// Componente dos objetos desenhados: estado do OpenGL, meshlets da malha e volume em volumesCena.
+struct ObjetoCena {
+    unsigned int programa;
+    unsigned int VAO;
+    const MalhaMeshlets* meshlets;
+    uint32_t volume;
+};
+
+// Entidades da cena (chunks de 16 KB por arquetipo); o desenho percorre os chunks com ObjetoCena.
+MundoECS mundoCena;
+uint32_t tipoObjetoCena;
+
+// Declarando a variavel que será utilizada na junção dos shaders (Vertex + Fragment).
 // Resulta num ProgramShader
 unsigned int shaderProgram;
 
@@ -57,36 +155,64 @@ float vertices[] = {
     0.0f, 0.5f,  0.0f  // Centro Superior
 };
 
+// Indices dos vertices usados por cada triângulo (vertices compartilhados não são duplicados).
+unsigned int indices[] = {
+    0, 1, 2
+};
+
 
-int main()
+int main(int argc, char* argv[])
 {
-    // Funo responsavel por inicializar o GLFW.
+    // Modo benchmark: roda os testes de desempenho sem abrir janela.
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0)
+    {
+        executaBenchmarks();
+        return 0;
+    }
+
+    // Modo CPU: desenha no rasterizador em software (maquinas sem GPU).
+    if (argc > 1 && std::strcmp(argv[1], "--cpu") == 0)
+    {
+        return renderizaNaCPU(false);
+    }
+
+    // Modo CPU com os shaders GLSL interpretados no lugar dos equivalentes em C++.
+    if (argc > 1 && std::strcmp(argv[1], "--cpu-glsl") == 0)
+    {
+        return renderizaNaCPU(true);
+    }
+
+    // Modo benchmark da GPU: roda os testes que precisam de contexto OpenGL e fecha a janela.
+    bool benchmarkGL = (argc > 1 && std::strcmp(argv[1], "--benchmark-gl") == 0);
+
+    // Função responsavel por inicializar o GLFW.
     glfwInit();
 
-    // Funo responsavel por definir a verso a ser executada. (3.x)
+    // Função responsavel por definir a versão a ser executada. (3.x)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 
-    // Funo responsavel por definir a verso a ser executada. (x.3)
+    // Função responsavel por definir a versão a ser executada. (x.3)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 
-    // Funo resposavel por definir o perfil do glfw
+    // Função resposavel por definir o perfil do glfw
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     // Definindo ponteiro da janela.
     GLFWwindow* JanelaPrincipal = glfwCreateWindow(larguraJanela, alturaJanela, "Apendendo OpenGL", NULL, NULL);
 
-    // Tratamento de erro na criao da janela.
+    // Tratamento de erro na criação da janela.
     if (JanelaPrincipal == NULL)
     {
         // Mensagem de erro ao criar janela.
         std::cout << "Erro ao criar janela com OpenGL" << std::endl;
 
-        // Finalizar criao de janela com glfw;
+        // Finalizar criação de janela com glfw;
         glfwTerminate();
     }
 
     glfwMakeContextCurrent(JanelaPrincipal);
     glfwSetFramebufferSizeCallback(JanelaPrincipal, framebuffer_size_callback);
+    glfwSetMouseButtonCallback(JanelaPrincipal, mouse_button_callback);
 
     // Passa para o Glad os ponteiros do OpenGL.
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -94,6 +220,13 @@ int main()
         std::cout << "Erro ao inicializar o Glad" << std::endl;
     }
 
+    if (benchmarkGL)
+    {
+        executaBenchmarksGL();
+        glfwTerminate();
+        return 0;
+    }
+
     // VERTEX SHADER
     // Criando o Vertex Shader vazio.
     vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -104,7 +237,7 @@ int main()
     // Compila o shader fornecido.
     glCompileShader(vertexShader);
 
-    // Funo que testa se ocorreu erro durante compilao.
+    // Função que testa se ocorreu erro durante compilação.
     compilaVertexShader(vertexShader);
 
     // FRAGMENT SHADER
@@ -117,48 +250,94 @@ int main()
     // Compila o shader fornecido.
     glCompileShader(fragmentShader);
 
-    // Funo que testa se ocorreu erro durante compilao.
+    // Função que testa se ocorreu erro durante compilação.
     compilaFragmentShader(fragmentShader);
 
     // PROGRAM SHADER
-    // ProgramShader vazio (Utilizado na juno do vertex e fragment).
+    // ProgramShader vazio (Utilizado na junção do vertex e fragment).
     shaderProgram = glCreateProgram();
 
-    // Funo que associa um shader a programas de shader
+    // Função que associa um shader a programas de shader
     glAttachShader(shaderProgram, vertexShader);
 
-    // Funo que associa um shader a programas de shader
+    // Função que associa um shader a programas de shader
     glAttachShader(shaderProgram, fragmentShader);
 
     // Vincula todos os shaders no programa.
     glLinkProgram(shaderProgram);
 
-    // Funo que testa se ocorreu erro durante vinculao de shader em um programa.
+    // Função que testa se ocorreu erro durante vinculação de shader em um programa.
     vinculaProgramShader(shaderProgram);
 
     // Comando para exluir os shader depois que vinculados a um programa.
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
-    // Funo que gera o buffer.
+    // Função que gera o buffer.
     glGenVertexArrays(1, &VAO);  // VAO - Vertex Array Object
 
-    // Funo que gera o buffer (Quantidade e referncia).
+    // Função que gera o buffer (Quantidade e referência).
     glGenBuffers(1, &VBO);  // VBO - Vertex Buffer Object
-
-    // O objetos de vetor de vertices  usado para automatizar o envio de objetos para o desenho.
-    // Funo que gera o buffer.
+    glGenBuffers(1, &EBO);  // EBO - Element Buffer Object
+
+    // Divide a malha em meshlets (feito uma vez no carregamento). Os indices de cada meshlet ficam juntos e
+    // otimizados para o cache de vertices da GPU, e os vertices na ordem de uso; o resultado volta para os
+    // arrays enviados ao VBO e ao EBO (mesmo tamanho, nenhum vertice do triângulo fica sem uso).
+    size_t numVertices = sizeof(vertices) / (3 * sizeof(float));
+    size_t numIndices = sizeof(indices) / sizeof(unsigned int);
+    MalhaIndexada malhaTriangulo;
+    malhaTriangulo.vertices.assign(vertices, vertices + numVertices * 3);
+    malhaTriangulo.indices.assign(indices, indices + numIndices);
+    constroiMeshlets(malhaTriangulo, meshletsCena);
+    std::copy(meshletsCena.malha.vertices.begin(), meshletsCena.malha.vertices.end(), vertices);
+    std::copy(meshletsCena.malha.indices.begin(), meshletsCena.malha.indices.end(), indices);
+    // Listas do descarte de meshlets, que crescem até o maior numero de meshlets de um objeto da cena.
+    std::vector<uint32_t> meshletsVisiveis;
+    std::vector<int> primeirosIntervalos, contagensIntervalos;
+
+    // Caixa do triângulo para a seleção pelo mouse (um objeto só, mas o caminho é o mesmo de uma cena grande).
+    Vec3 minimo(vertices[0], vertices[1], vertices[2]);
+    Vec3 maximo = minimo;
+    for (size_t v = 1; v < numVertices; v++) {
+        Vec3 p(vertices[v * 3], vertices[v * 3 + 1], vertices[v * 3 + 2]);
+        minimo = Vec3(std::min(minimo.x, p.x), std::min(minimo.y, p.y), std::min(minimo.z, p.z));
+        maximo = Vec3(std::max(maximo.x, p.x), std::max(maximo.y, p.y), std::max(maximo.z, p.z));
+    }
+    redimensionaVolumes(volumesCena, 1);
+    defineCaixa(volumesCena, 0, minimo, maximo);
+    constroiBVH(bvhCena, volumesCena);
+    redimensionaOclusao(oclusaoCena);
+
+    // O triângulo como entidade da cena.
+    tipoObjetoCena = registraComponente<ObjetoCena>(mundoCena);
+    Entidade triangulo = criaEntidade(mundoCena, bitComponente(tipoObjetoCena));
+    ObjetoCena* objetoTriangulo = componente<ObjetoCena>(mundoCena, triangulo, tipoObjetoCena);
+    objetoTriangulo->programa = shaderProgram;
+    objetoTriangulo->VAO = VAO;
+    objetoTriangulo->meshlets = &meshletsCena;
+    objetoTriangulo->volume = 0;
+
+    // Converte as posições para half float (8 bytes por vertice em vez de 12).
+    uint16_t verticesHalf[sizeof(vertices) / (3 * sizeof(float)) * 4];
+    compactaPosicoes(vertices, numVertices, verticesHalf);
+
+    // O objetos de vetor de vertices é usado para automatizar o envio de objetos para o desenho.
+    // Função que gera o buffer.
     glBindVertexArray(VAO);  // VAO - Vertex Array Object
 
-    // Funo que vinculo o objeto de buffer ao proprio buffer do OpenGL (VBO  enviado para GL_ARRAY_BUFFER).
+    // Função que vinculo o objeto de buffer ao proprio buffer do OpenGL (VBO é enviado para GL_ARRAY_BUFFER).
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-    // Funo que aloca memoria e envia os dados ao buffer.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // Função que aloca memoria e envia os dados ao buffer.
+    glBufferData(GL_ARRAY_BUFFER, sizeof(verticesHalf), verticesHalf, GL_STATIC_DRAW);
+
+    // O EBO fica gravado no VAO enquanto o VAO estiver vinculado.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Comando especifica ao OpenGL como ele deve ler o Array dos vertices ao desenhar o triangulo.
-    // (x, y, z), (x, y, z), (x, y, z). 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    // (x, y, z, w), (x, y, z, w), (x, y, z, w) em half float; o "w" só alinha o vertice em 8 bytes.
+    glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, 4 * sizeof(uint16_t), (void*)0);
 
     // Especifica ao OpenGL como ele deve interpretar dos dados do buffer (Array).
     glEnableVertexAttribArray(0);
@@ -169,30 +348,73 @@ int main()
     // 
     glBindVertexArray(0);
 
-    // Exibe janela at clicar no de frechar (sem que se feche automatica).
-    // Loop de renderizao.
+    // Codifica e grava as capturas de tela sem travar o loop de renderização.
+    GravadorQuadros gravadorCapturas(1);
+
+    // Exibe janela até clicar no de frechar (sem que se feche automatica).
+    // Loop de renderização.
     while (!glfwWindowShouldClose(JanelaPrincipal))
     {
-        // Funo de detectar tecla ESC.
+        // Função de detectar tecla ESC.
         processInput(JanelaPrincipal);
 
-        // Funo de detectar teclas "asd".
+        // Função de detectar teclas "asd".
         inputTeclas(JanelaPrincipal);
 
-        // Define o buffer preto por padro.
+        // Define o buffer preto por padrão.
         //glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         //glClear(GL_COLOR_BUFFER_BIT);
 
-        // Comando para usar o objeto de programa.
-        glUseProgram(shaderProgram);
-
-
-        // O objetos de vetor de vertices  usado para automatizar o envio de objetos para o desenho.
-        // Funo que gera o buffer.
-        glBindVertexArray(VAO);  // VAO - Vertex Array Object
-
-        // 
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        // Oclusores do quadro (rasterizaCaixaOclusora/rasterizaOclusor) antes dos testes; o triângulo
+        // está em NDC, então a matriz projeção * visão é a identidade. A cena não tem nenhum oclusor além
+        // dele, então o teste sempre passa, mas é o mesmo caminho de uma cena grande.
+        limpaOclusao(oclusaoCena, identidadeMat4());
+
+        // Cada entidade com ObjetoCena vira pacotes de desenho (por enquanto só o triângulo).
+        paraCadaChunk(mundoCena, bitComponente(tipoObjetoCena), 0, [&](const VistaChunk& chunk)
+        {
+            const ObjetoCena* objetos = arrayComponente<ObjetoCena>(chunk, tipoObjetoCena);
+            for (uint32_t objeto = 0; objeto < chunk.quantidade; objeto++) {
+                uint32_t volume = objetos[objeto].volume;
+                if (descartaOclusao(oclusaoCena, volumesCena, &volume, 1, &volume) == 0)
+                {
+                    continue;
+                }
+
+                // Meshlets fora do frustum ou de costas ficam fora do desenho. Sem projeção não há camera de
+                // verdade; para o cone ela fica em +z, o lado da face da frente (anti-horária) no espaço da visão.
+                const MalhaMeshlets& meshlets = *objetos[objeto].meshlets;
+                if (meshletsVisiveis.size() < meshlets.meshlets.size()) {
+                    meshletsVisiveis.resize(meshlets.meshlets.size());
+                    primeirosIntervalos.resize(meshlets.meshlets.size());
+                    contagensIntervalos.resize(meshlets.meshlets.size());
+                }
+                size_t numMeshlets = descartaMeshlets(meshlets, extraiFrustum(identidadeMat4()), Vec3(0.0f, 0.0f, 1.0f),
+                                                      meshletsVisiveis.data());
+                size_t numIntervalos = intervalosMeshlets(meshlets, meshletsVisiveis.data(), numMeshlets,
+                                                          primeirosIntervalos.data(), contagensIntervalos.data());
+
+                // Um pacote de desenho por intervalo de indices: programa, VAO (com o EBO) e intervalo. Intervalos
+                // com o mesmo estado viram um glMultiDrawElements na fila.
+                for (size_t i = 0; i < numIntervalos; i++) {
+                    PacoteDesenho pacote;
+                    pacote.programa = objetos[objeto].programa;
+                    pacote.VAO = objetos[objeto].VAO;
+                    pacote.indexado = true;
+                    pacote.primeiro = primeirosIntervalos[i];
+                    pacote.contagem = contagensIntervalos[i];
+                    adicionaPacote(filaDesenhos, pacote);
+                }
+            }
+        });
+
+        // Ordena por estado, envia (glUseProgram, glBindVertexArray e os desenhos) e esvazia a fila.
+        ordenaFila(filaDesenhos);
+        executaFila(filaDesenhos);
+        limpaFila(filaDesenhos);
+
+        // Função da tecla F12 (captura de tela em PNG).
+        capturaTela(JanelaPrincipal, gravadorCapturas);
 
         // Responsavel por manipular o buffer da janela.
         glfwSwapBuffers(JanelaPrincipal);
@@ -208,15 +430,20 @@ int main()
     // Comandos opcionais para desalocar memoria.
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
     glDeleteProgram(shaderProgram);
+    if (leituraTela.largura > 0) {
+        gravaCapturas(gravadorCapturas, true);
+        destroiLeituraPixels(leituraTela);
+    }
 
-    // Finalizar criao de janela com glfw;
+    // Finalizar criação de janela com glfw;
     glfwTerminate();
 
     return 0;
 }
 
-// Cria um processo para detectar input de teclas dentro do loop de renderizao.
+// Cria um processo para detectar input de teclas dentro do loop de renderização.
 void inputTeclas(GLFWwindow* window) {
 
     // Le se a tecla escape (ESC) foi pressionada.
@@ -245,7 +472,52 @@ void inputTeclas(GLFWwindow* window) {
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
-// Cria um processo para detectar input de teclas dentro do loop de renderizao.
+// F12 copia o back buffer para um PBO; o PNG é codificado em segundo plano quando a copia termina
+// (alguns quadros depois), então a captura não trava o loop de renderização.
+void capturaTela(GLFWwindow* window, GravadorQuadros& gravador) {
+    static bool teclaPressionada = false;
+
+    gravaCapturas(gravador, false);
+
+    bool pressionada = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+    if (pressionada && !teclaPressionada) {
+        int largura, altura;
+        glfwGetFramebufferSize(window, &largura, &altura);
+        if (leituraTela.largura != largura || leituraTela.altura != altura) {
+            if (leituraTela.largura > 0) {
+                // A janela mudou de tamanho com capturas ainda em copia: termina antes de apagar os PBOs.
+                gravaCapturas(gravador, true);
+                destroiLeituraPixels(leituraTela);
+            }
+            criaLeituraPixels(leituraTela, largura, altura);
+        }
+        glReadBuffer(GL_BACK);
+        iniciaLeituraPixels(leituraTela);
+    }
+    teclaPressionada = pressionada;
+}
+
+// Envia para o gravador as capturas cuja copia terminou (com "espera", todas as pendentes).
+void gravaCapturas(GravadorQuadros& gravador, bool espera) {
+    static int numeroCaptura = 0;
+    // Fica com o vetor até uma copia terminar; vem dos quadros já gravados em vez de ser alocado a cada F12.
+    static std::vector<uint32_t> pixels;
+
+    while (leituraTela.pendentes > 0) {
+        if (pixels.empty()) {
+            pixels = gravador.bufferLivre();
+        }
+        if (!terminaLeituraPixels(leituraTela, pixels, espera)) {
+            break;
+        }
+        std::string caminho = "captura" + std::to_string(numeroCaptura++) + ".png";
+        gravador.enfileira(std::move(pixels), leituraTela.largura, leituraTela.altura, imagemPNG, caminho);
+        pixels.clear();
+        std::cout << "Captura de tela: " << caminho << std::endl;
+    }
+}
+
+// Cria um processo para detectar input de teclas dentro do loop de renderização.
 void processInput(GLFWwindow* window) {
     // Le se a tecla escape (ESC) foi pressionada.
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -253,6 +525,31 @@ void processInput(GLFWwindow* window) {
     }
 }
 
+// Clique esquerdo: lança um raio pela posição do cursor e mostra o objeto atingido. O triângulo já está
+// em NDC, então a matriz projeção * visão é a identidade.
+void mouse_button_callback(GLFWwindow* window, int button, int action, int /*mods*/)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) {
+        return;
+    }
+    double cursorX, cursorY;
+    int largura, altura;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    glfwGetWindowSize(window, &largura, &altura);
+    if (largura <= 0 || altura <= 0) {
+        return;
+    }
+
+    Raio raio = raioDoCursor(cursorX, cursorY, largura, altura, identidadeMat4());
+    int32_t objeto = intersectaRaioBVH(bvhCena, volumesCena, raio);
+    if (objeto >= 0) {
+        std::cout << "Objeto selecionado: " << objeto << std::endl;
+    }
+    else {
+        std::cout << "Nenhum objeto selecionado" << std::endl;
+    }
+}
+
 // Redimensiona janela.
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
@@ -260,7 +557,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 }
 
 void compilaVertexShader(int vs) {
-    // Tratando erros durante a compilao de shaders
+    // Tratando erros durante a compilação de shaders
     int  successoCompilacaoVertex;
     char infoLogVertex[512];
 
@@ -271,13 +568,13 @@ void compilaVertexShader(int vs) {
         // Envia mensagem para o log
         glGetShaderInfoLog(vs, 512, NULL, infoLogVertex);
 
-        // Imprime mensagem de erro de compilao e informaes do log.
-        std::cout << "Erro durante a compilao do Vertex Shader \n" << infoLogVertex << std::endl;
+        // Imprime mensagem de erro de compilação e informações do log.
+        std::cout << "Erro durante a compilação do Vertex Shader \n" << infoLogVertex << std::endl;
     }
 }
 
 void compilaFragmentShader(int fs) {
-    // Tratando erros durante a compilao de shaders
+    // Tratando erros durante a compilação de shaders
     int  successoCompilacaoFragment;
     char infoLogFragment[512];
 
@@ -288,13 +585,13 @@ void compilaFragmentShader(int fs) {
         // Envia mensagem para o log
         glGetShaderInfoLog(fs, 512, NULL, infoLogFragment);
 
-        // Imprime mensagem de erro de compilao e informaes do log.
-        std::cout << "Erro durante a compilao do Fragment Shader \n" << infoLogFragment << std::endl;
+        // Imprime mensagem de erro de compilação e informações do log.
+        std::cout << "Erro durante a compilação do Fragment Shader \n" << infoLogFragment << std::endl;
     }
 }
 
 void vinculaProgramShader(int ps) {
-    // Tratando erros durante a vinculao de shaders
+    // Tratando erros durante a vinculação de shaders
     int  successoPrograma;
     char infoLogPrograma[512];
 
@@ -304,9 +601,57 @@ void vinculaProgramShader(int ps) {
         // Envia mensagem para o log
         glGetProgramInfoLog(ps, 512, NULL, infoLogPrograma);
 
-        // Imprime mensagem de erro vinculao e informaes do log.
-        std::cout << "Erro durante a vinculao do Program Shader \n" << infoLogPrograma << std::endl;
+        // Imprime mensagem de erro vinculação e informações do log.
+        std::cout << "Erro durante a vinculação do Program Shader \n" << infoLogPrograma << std::endl;
+    }
+}
+
+// Desenha o mesmo triângulo (vertices[], indices[] e os shaders) com o backend em software.
+// Com "interpretaGLSL" os shaders em C++ não são passados e o backend executa o GLSL.
+int renderizaNaCPU(bool interpretaGLSL)
+{
+    BackendCPU backend;
+    backend.defineViewport(larguraJanela, alturaJanela);
+
+    // Mesma disposição do VAO: location 0 com (x, y, z).
+    DescricaoMalha malha;
+    malha.vertices = vertices;
+    malha.numVertices = sizeof(vertices) / (3 * sizeof(float));
+    malha.stride = 3;
+    malha.atributos[0].location = 0;
+    malha.atributos[0].componentes = 3;
+    malha.atributos[0].deslocamento = 0;
+    malha.numAtributos = 1;
+    malha.indices = indices;
+    malha.numIndices = sizeof(indices) / sizeof(unsigned int);
+
+    DescricaoPrograma programa;
+    programa.fonteVertex = vertexShaderSource;
+    programa.fonteFragment = fragmentShaderSource;
+    if (!interpretaGLSL) {
+        programa.vertexCPU = vertexShaderCPU;
+        programa.vertexLoteCPU = executaShaderVerticeLote<VertexShaderLoteCPU>;
+        programa.fragmentCPU = fragmentShaderCPU;
+        programa.fragmentLoteCPU = executaShaderLote<FragmentShaderLoteCPU>;
     }
+
+    unsigned int idMalha = backend.criaMalha(malha);
+    unsigned int idPrograma = backend.criaPrograma(programa);
+
+    // Renderiza alguns quadros para medir o tempo.
+    const int quadros = 100;
+    double inicio = tempoAtualMs();
+    for (int q = 0; q < quadros; q++) {
+        backend.limpa(0.0f, 0.0f, 0.0f, 1.0f);
+        backend.desenha(idPrograma, idMalha);
+        backend.finalizaQuadro();
+    }
+    double tempo = (tempoAtualMs() - inicio) / quadros;
+
+    std::cout << "Backend " << backend.nome() << ": " << larguraJanela << "x" << alturaJanela << ", "
+              << tempo << " ms por quadro, " << backend.estatisticas().fragmentos / quadros << " fragmentos por quadro" << std::endl;
+
+    return 0;
 }
 
 //---------------------------------------------------------